@@ -0,0 +1,178 @@
+#include "BigReaderLock.h"
+#include <cassert>
+#include <climits>
+
+#if defined(__linux__)
+    #include <linux/futex.h>
+    #include <sched.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futexes need plain 32 bit atomic words");
+
+BigReaderLock::BigReaderLock([[maybe_unused]] OSInterface& osInterface)
+{
+    for (ReaderSlot_t& slot : readerSlots)
+    {
+        slot.readers.store(0, std::memory_order_relaxed);
+    }
+    writer.store(0, std::memory_order_relaxed);
+
+    this->writerWaiters.semaphore = nullptr;
+    this->readersWaiter.semaphore = nullptr;
+    this->writerWaiters.waiters.store(0, std::memory_order_relaxed);
+    this->readersWaiter.waiters.store(0, std::memory_order_relaxed);
+#if !defined(__linux__)
+    this->writerWaiters.semaphore = osInterface.osCreateBinarySemaphore();
+    assert(this->writerWaiters.semaphore != nullptr && "Semaphore creation failed");
+    this->readersWaiter.semaphore = osInterface.osCreateBinarySemaphore();
+    assert(this->readersWaiter.semaphore != nullptr && "Semaphore creation failed");
+#endif
+}
+
+BigReaderLock::~BigReaderLock()
+{
+    delete writerWaiters.semaphore;
+    delete readersWaiter.semaphore;
+}
+
+bool BigReaderLock::readLock(uint32_t& outputSlot, const uint32_t timeoutMs)
+{
+    const uint32_t slot     = readerSlotIndex();
+    const auto     deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (true)
+    {
+        // Pairs with writeLock(): either the writer sees this reader, or this reader sees the writer.
+        readerSlots[slot].readers.fetch_add(1, std::memory_order_seq_cst);
+        if (writer.load(std::memory_order_seq_cst) == 0)
+        {
+            outputSlot = slot;
+            return true;
+        }
+
+        leave(slot);
+        if (!waitWhileEquals(writer, 1, deadline, writerWaiters))
+        {
+            return false;
+        }
+    }
+}
+
+void BigReaderLock::readUnlock(const uint32_t slot)
+{
+    leave(slot);
+}
+
+bool BigReaderLock::writeLock(const uint32_t timeoutMs)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    uint32_t expected = 0;
+    while (!writer.compare_exchange_weak(expected, 1, std::memory_order_seq_cst))
+    {
+        if (!waitWhileEquals(writer, 1, deadline, writerWaiters))
+        {
+            return false;
+        }
+        expected = 0;
+    }
+
+    for (ReaderSlot_t& slot : readerSlots)
+    {
+        for (uint32_t readers; (readers = slot.readers.load(std::memory_order_seq_cst)) != 0;)
+        {
+            if (!waitWhileEquals(slot.readers, readers, deadline, readersWaiter))
+            {
+                writeUnlock();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void BigReaderLock::writeUnlock()
+{
+    writer.store(0, std::memory_order_seq_cst);
+    wake(writer, writerWaiters);
+}
+
+uint32_t BigReaderLock::readerSlotIndex()
+{
+#if defined(__linux__)
+    if (const int cpu = sched_getcpu(); cpu >= 0)
+    {
+        return static_cast<uint32_t>(cpu) % READER_SLOTS;
+    }
+#endif
+    static std::atomic<uint32_t> nextSlot{0};
+    thread_local const uint32_t  slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+    return slot;
+}
+
+void BigReaderLock::leave(const uint32_t slot)
+{
+    // Only the last reader of a counter wakes a writer, which is the only one waiting on it.
+    if (readerSlots[slot].readers.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+        writer.load(std::memory_order_seq_cst) != 0)
+    {
+        wake(readerSlots[slot].readers, readersWaiter);
+    }
+}
+
+bool BigReaderLock::waitWhileEquals(const std::atomic<uint32_t>& word, const uint32_t value,
+                                    const std::chrono::steady_clock::time_point deadline,
+                                    [[maybe_unused]] WaitQueue_t& queue)
+{
+#if defined(__linux__)
+    while (word.load(std::memory_order_seq_cst) == value)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return false;
+        }
+        const auto     remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        const timespec timeout   = {static_cast<time_t>(remaining / 1000000000),
+                                    static_cast<long>(remaining % 1000000000)};
+        syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), FUTEX_WAIT_PRIVATE, value, &timeout, nullptr, 0);
+    }
+    return true;
+#else
+    // Pairs with wake(): either the waker sees this waiter, or this waiter sees the changed word.
+    queue.waiters.fetch_add(1, std::memory_order_seq_cst);
+    while (word.load(std::memory_order_seq_cst) == value)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            queue.waiters.fetch_sub(1, std::memory_order_seq_cst);
+            return false;
+        }
+        const auto remainingMs = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+        queue.semaphore->wait(static_cast<uint32_t>(remainingMs));
+    }
+
+    // A binary semaphore wakes a single thread, so the other waiters are woken in turn.
+    if (queue.waiters.fetch_sub(1, std::memory_order_seq_cst) > 1)
+    {
+        queue.semaphore->signal();
+    }
+    return true;
+#endif
+}
+
+void BigReaderLock::wake(std::atomic<uint32_t>& word, [[maybe_unused]] WaitQueue_t& queue)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+    if (queue.waiters.load(std::memory_order_seq_cst) != 0)
+    {
+        queue.semaphore->signal();
+    }
+#endif
+}
@@ -0,0 +1,126 @@
+#include "EpochManager.h"
+
+EpochManager::EpochManager()
+{
+    for (ReaderSlot_t& slot : readerSlots)
+    {
+        slot.readers[0].store(0, std::memory_order_relaxed);
+        slot.readers[1].store(0, std::memory_order_relaxed);
+    }
+    currentEpoch.store(0, std::memory_order_relaxed);
+    incoming.store(nullptr, std::memory_order_relaxed);
+    retiredCount.store(0, std::memory_order_relaxed);
+    collecting.clear(std::memory_order_relaxed);
+    retiredInEpoch[0] = nullptr;
+    retiredInEpoch[1] = nullptr;
+}
+
+EpochManager::~EpochManager()
+{
+    reclaim(incoming.load(std::memory_order_acquire));
+    reclaim(retiredInEpoch[0]);
+    reclaim(retiredInEpoch[1]);
+}
+
+uint32_t EpochManager::enter()
+{
+    const uint32_t epoch = currentEpoch.load(std::memory_order_relaxed);
+    readerSlots[readerSlotIndex()].readers[epoch].fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in collect(): either the writer sees this reader, or this reader sees the unlinks.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch;
+}
+
+void EpochManager::exit(const uint32_t epoch)
+{
+    readerSlots[readerSlotIndex()].readers[epoch].fetch_sub(1, std::memory_order_release);
+}
+
+void EpochManager::retire(void* object, const ReclaimFunction_t reclaimFunction, void* context)
+{
+    RetiredObject_t* retiredObject = new RetiredObject_t{object, reclaimFunction, context, nullptr};
+    retiredCount.fetch_add(1, std::memory_order_relaxed);
+    retiredObject->next = incoming.load(std::memory_order_relaxed);
+    while (!incoming.compare_exchange_weak(retiredObject->next, retiredObject, std::memory_order_release,
+                                           std::memory_order_relaxed))
+    {
+    }
+    collect();
+}
+
+void EpochManager::collect()
+{
+    if (retiredCount.load(std::memory_order_relaxed) < RECLAIM_THRESHOLD)
+    {
+        return;
+    }
+
+    // Only one thread collects at a time, the others leave their objects to it.
+    if (collecting.test_and_set(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // The objects retired so far are unlinked, so they are reachable only by readers that are already running.
+    // Attaching them to the current epoch is what orders their retirement with the epoch flips.
+    const uint32_t   epoch   = currentEpoch.load(std::memory_order_relaxed);
+    RetiredObject_t* objects = incoming.exchange(nullptr, std::memory_order_acquire);
+    while (objects != nullptr)
+    {
+        RetiredObject_t* next = objects->next;
+        objects->next         = retiredInEpoch[epoch];
+        retiredInEpoch[epoch] = objects;
+        objects               = next;
+    }
+
+    // Pairs with the fence in enter(): a reader missed here sees every unlink made before.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // The objects of the previous epoch were retired before the flip to the current one. Once the readers of the
+    // previous epoch have left, the remaining readers started after the flip and cannot reach them. No reader is left
+    // in the previous epoch either, so it can become the current one again.
+    RetiredObject_t* releasable = nullptr;
+    if (!hasReaders(epoch ^ 1))
+    {
+        releasable                = retiredInEpoch[epoch ^ 1];
+        retiredInEpoch[epoch ^ 1] = nullptr;
+        currentEpoch.store(epoch ^ 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    collecting.clear(std::memory_order_release);
+
+    retiredCount.fetch_sub(reclaim(releasable), std::memory_order_relaxed);
+}
+
+uint32_t EpochManager::readerSlotIndex()
+{
+    static std::atomic<uint32_t> nextSlot{0};
+    thread_local const uint32_t  slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+    return slot;
+}
+
+bool EpochManager::hasReaders(const uint32_t epoch) const
+{
+    for (const ReaderSlot_t& slot : readerSlots)
+    {
+        if (slot.readers[epoch].load(std::memory_order_acquire) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t EpochManager::reclaim(RetiredObject_t* objects)
+{
+    size_t count = 0;
+    while (objects != nullptr)
+    {
+        RetiredObject_t* next = objects->next;
+        objects->reclaimFunction(objects->context, objects->object);
+        delete objects;
+        objects = next;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,104 @@
+#include "LockStatistics.h"
+#include <algorithm>
+#include <chrono>
+
+LockStatistics::LockStatistics()
+{
+    for (AtomicSideStats_t& side : sides)
+    {
+        side.acquisitions.store(0, std::memory_order_relaxed);
+        side.timeouts.store(0, std::memory_order_relaxed);
+        side.maxWaitUs.store(0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; i++)
+        {
+            side.waitHistogram[i].store(0, std::memory_order_relaxed);
+            side.holdHistogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t LockStatistics::now()
+{
+    if constexpr (!ENABLED)
+    {
+        return 0;
+    }
+    const auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(sinceEpoch).count());
+}
+
+void LockStatistics::recordAcquisition(const LockSide_t side, const uint64_t waitStartUs, const uint64_t acquiredUs)
+{
+    if constexpr (!ENABLED)
+    {
+        return;
+    }
+    AtomicSideStats_t& stats  = sides[side];
+    const uint64_t     waitUs = acquiredUs - waitStartUs;
+    stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    stats.waitHistogram[bucketOf(waitUs)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t maxWaitUs = stats.maxWaitUs.load(std::memory_order_relaxed);
+    while (waitUs > maxWaitUs && !stats.maxWaitUs.compare_exchange_weak(maxWaitUs, waitUs, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LockStatistics::recordRelease(const LockSide_t side, const uint64_t acquiredUs)
+{
+    if constexpr (!ENABLED)
+    {
+        return;
+    }
+    sides[side].holdHistogram[bucketOf(now() - acquiredUs)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockStatistics::recordTimeout(const LockSide_t side)
+{
+    sides[side].timeouts.fetch_add(1, std::memory_order_relaxed);
+}
+
+LockStats_t LockStatistics::getStats() const
+{
+    LockStats_t      stats         = {};
+    LockSideStats_t* outputSides[] = {&stats.readers, &stats.writers};
+    for (uint32_t s = 0; s < 2; s++)
+    {
+        outputSides[s]->acquisitions = sides[s].acquisitions.load(std::memory_order_relaxed);
+        outputSides[s]->timeouts     = sides[s].timeouts.load(std::memory_order_relaxed);
+        outputSides[s]->maxWaitUs    = sides[s].maxWaitUs.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; i++)
+        {
+            outputSides[s]->waitHistogram[i] = sides[s].waitHistogram[i].load(std::memory_order_relaxed);
+            outputSides[s]->holdHistogram[i] = sides[s].holdHistogram[i].load(std::memory_order_relaxed);
+        }
+    }
+    return stats;
+}
+
+uint32_t LockStatistics::bucketOf(const uint64_t durationUs)
+{
+    uint32_t bucket = 0;
+    for (uint64_t bound = 1; durationUs >= bound && bucket < LOCK_STATS_HISTOGRAM_BUCKETS - 1; bound *= 4)
+    {
+        bucket++;
+    }
+    return bucket;
+}
+
+void LockStatistics::accumulate(LockStats_t& total, const LockStats_t& stats)
+{
+    LockSideStats_t*       totalSides[] = {&total.readers, &total.writers};
+    const LockSideStats_t* statsSides[] = {&stats.readers, &stats.writers};
+    for (uint32_t s = 0; s < 2; s++)
+    {
+        totalSides[s]->acquisitions += statsSides[s]->acquisitions;
+        totalSides[s]->timeouts += statsSides[s]->timeouts;
+        totalSides[s]->maxWaitUs = std::max(totalSides[s]->maxWaitUs, statsSides[s]->maxWaitUs);
+        for (uint32_t i = 0; i < LOCK_STATS_HISTOGRAM_BUCKETS; i++)
+        {
+            totalSides[s]->waitHistogram[i] += statsSides[s]->waitHistogram[i];
+            totalSides[s]->holdHistogram[i] += statsSides[s]->holdHistogram[i];
+        }
+    }
+}
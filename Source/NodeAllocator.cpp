@@ -0,0 +1,172 @@
+#include "NodeAllocator.h"
+#include <algorithm>
+#include <cstdlib>
+
+MallocNodeAllocator::MallocNodeAllocator()
+{
+    usedBytes.store(0, std::memory_order_relaxed);
+    allocations.store(0, std::memory_order_relaxed);
+}
+
+void* MallocNodeAllocator::allocate(const size_t size)
+{
+    void* block = malloc(size);
+    if (block != nullptr)
+    {
+        usedBytes.fetch_add(size, std::memory_order_relaxed);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return block;
+}
+
+void MallocNodeAllocator::deallocate(void* block, const size_t size)
+{
+    free(block);
+    usedBytes.fetch_sub(size, std::memory_order_relaxed);
+    allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool MallocNodeAllocator::releasesInBulk() const
+{
+    return false;
+}
+
+NodeAllocatorStats_t MallocNodeAllocator::getStats() const
+{
+    NodeAllocatorStats_t stats = {};
+    stats.usedBytes            = usedBytes.load(std::memory_order_relaxed);
+    stats.reservedBytes        = stats.usedBytes;
+    stats.allocations          = allocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ArenaNodeAllocator::ArenaNodeAllocator(const size_t arenaSize)
+{
+    this->arenaSize   = std::max(arenaSize, SIZE_CLASSES[NUM_SIZE_CLASSES - 1]);
+    this->arenaCursor = nullptr;
+    this->arenaLeft   = 0;
+    this->usedBytes   = 0;
+    this->freeBytes   = 0;
+    this->largeBytes  = 0;
+    this->allocations = 0;
+    std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
+}
+
+ArenaNodeAllocator::~ArenaNodeAllocator()
+{
+    for (void* arena : arenas)
+    {
+        free(arena);
+    }
+    for (void* block : largeBlocks)
+    {
+        free(block);
+    }
+}
+
+void* ArenaNodeAllocator::allocate(const size_t size)
+{
+    const std::lock_guard lock(mutex);
+
+    const size_t classIndex = sizeClassIndex(size);
+    if (classIndex == NUM_SIZE_CLASSES)
+    {
+        void* block = malloc(size);
+        if (block != nullptr)
+        {
+            largeBlocks.push_back(block);
+            largeBytes += size;
+            usedBytes += size;
+            allocations++;
+        }
+        return block;
+    }
+
+    const size_t classSize = SIZE_CLASSES[classIndex];
+    void*        block     = freeLists[classIndex];
+    if (block != nullptr)
+    {
+        freeLists[classIndex] = freeLists[classIndex]->next;
+        freeBytes -= classSize;
+    }
+    else
+    {
+        if (arenaLeft < classSize)
+        {
+            // The tail of the current arena is lost, which is at most the size of the largest class.
+            void* arena = malloc(arenaSize);
+            if (arena == nullptr)
+            {
+                return nullptr;
+            }
+            arenas.push_back(arena);
+            arenaCursor = static_cast<uint8_t*>(arena);
+            arenaLeft   = arenaSize;
+        }
+        block = arenaCursor;
+        arenaCursor += classSize;
+        arenaLeft -= classSize;
+    }
+
+    usedBytes += classSize;
+    allocations++;
+    return block;
+}
+
+void ArenaNodeAllocator::deallocate(void* block, const size_t size)
+{
+    const std::lock_guard lock(mutex);
+
+    const size_t classIndex = sizeClassIndex(size);
+    if (classIndex == NUM_SIZE_CLASSES)
+    {
+        if (const auto position = std::find(largeBlocks.begin(), largeBlocks.end(), block);
+            position != largeBlocks.end())
+        {
+            largeBlocks.erase(position);
+        }
+        free(block);
+        largeBytes -= size;
+        usedBytes -= size;
+        allocations--;
+        return;
+    }
+
+    auto* freeBlock       = static_cast<FreeBlock*>(block);
+    freeBlock->next       = freeLists[classIndex];
+    freeLists[classIndex] = freeBlock;
+    usedBytes -= SIZE_CLASSES[classIndex];
+    freeBytes += SIZE_CLASSES[classIndex];
+    allocations--;
+}
+
+bool ArenaNodeAllocator::releasesInBulk() const
+{
+    return true;
+}
+
+NodeAllocatorStats_t ArenaNodeAllocator::getStats() const
+{
+    const std::lock_guard lock(mutex);
+
+    NodeAllocatorStats_t stats = {};
+    stats.arenas               = arenas.size();
+    stats.reservedBytes        = arenas.size() * arenaSize + largeBytes;
+    stats.usedBytes            = usedBytes;
+    stats.freeBytes            = freeBytes;
+    stats.allocations          = allocations;
+    stats.largeAllocations     = largeBlocks.size();
+    return stats;
+}
+
+size_t ArenaNodeAllocator::sizeClassOf(const size_t size)
+{
+    const size_t classIndex = sizeClassIndex(size);
+    return classIndex < NUM_SIZE_CLASSES ? SIZE_CLASSES[classIndex] : 0;
+}
+
+size_t ArenaNodeAllocator::sizeClassIndex(const size_t size)
+{
+    return static_cast<size_t>(std::lower_bound(std::begin(SIZE_CLASSES), std::end(SIZE_CLASSES), size) -
+                               std::begin(SIZE_CLASSES));
+}
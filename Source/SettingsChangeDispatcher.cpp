@@ -0,0 +1,272 @@
+#include "SettingsChangeDispatcher.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+extern const uint32_t SETTINGS_STORAGE_MUTEX_TIMEOUT_MS; // Defined in SettingsStorage.cpp
+
+SettingsChangeDispatcher::SettingsChangeDispatcher(OSInterface& osInterface, const KeyCollector_t keyCollector,
+                                                   void* keyCollectorContext)
+{
+    this->keyCollector        = keyCollector;
+    this->keyCollectorContext = keyCollectorContext;
+    this->nextSubscriptionId  = INVALID_SUBSCRIPTION + 1;
+    this->subscriptionsCount.store(0, std::memory_order_relaxed);
+
+    this->subscriptionsMutex = osInterface.osCreateMutex();
+    assert(this->subscriptionsMutex != nullptr && "Mutex creation failed");
+    this->pendingMutex = osInterface.osCreateMutex();
+    assert(this->pendingMutex != nullptr && "Mutex creation failed");
+    this->deliveryMutex = osInterface.osCreateMutex();
+    assert(this->deliveryMutex != nullptr && "Mutex creation failed");
+    this->pendingSemaphore = osInterface.osCreateBinarySemaphore();
+    assert(this->pendingSemaphore != nullptr && "Semaphore creation failed");
+}
+
+SettingsChangeDispatcher::~SettingsChangeDispatcher()
+{
+    subscriptions.iterateOverAll(freeSubscriberListCallback, nullptr);
+    delete pendingSemaphore;
+    delete deliveryMutex;
+    delete pendingMutex;
+    delete subscriptionsMutex;
+}
+
+bool SettingsChangeDispatcher::lock(OSInterface_Mutex* mutex)
+{
+    return mutex->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS);
+}
+
+uint32_t SettingsChangeDispatcher::subscribe(const char* keyPrefix, const ChangeCallback_t callback, void* userData)
+{
+    if (!lock(subscriptionsMutex))
+    {
+        return INVALID_SUBSCRIPTION;
+    }
+    const Subscriber_t subscriber = {nextSubscriptionId++, callback, userData};
+    const int          prefixLen  = static_cast<int>(strlen(keyPrefix));
+    if (prefixLen == 0)
+    {
+        allKeysSubscribers.push_back(subscriber);
+    }
+    else
+    {
+        SubscriberList_t* subscribers = subscriptions.search(keyPrefix, prefixLen);
+        if (subscribers == nullptr)
+        {
+            subscribers = new SubscriberList_t();
+            subscriptions.insert(keyPrefix, prefixLen, subscribers);
+        }
+        subscribers->push_back(subscriber);
+    }
+    subscriptionPrefixes.emplace(subscriber.id, keyPrefix);
+    subscriptionsCount.fetch_add(1, std::memory_order_relaxed);
+    subscriptionsMutex->signal();
+    return subscriber.id;
+}
+
+SettingsChangeDispatcher::UnsubscribeResult_t SettingsChangeDispatcher::unsubscribe(const uint32_t subscriptionId)
+{
+    // A delivery that matched the subscription may be running, so it is waited for before the subscription is removed.
+    // The callbacks already hold the delivery mutex.
+    const bool waitDelivery = deliveringDispatcher != this;
+    if (waitDelivery && !lock(deliveryMutex))
+    {
+        return UNSUBSCRIBE_TIMEOUT;
+    }
+    if (!lock(subscriptionsMutex))
+    {
+        if (waitDelivery)
+        {
+            deliveryMutex->signal();
+        }
+        return UNSUBSCRIBE_TIMEOUT;
+    }
+
+    const auto prefix = subscriptionPrefixes.find(subscriptionId);
+    if (prefix == subscriptionPrefixes.end())
+    {
+        subscriptionsMutex->signal();
+        if (waitDelivery)
+        {
+            deliveryMutex->signal();
+        }
+        return SUBSCRIPTION_NOT_FOUND;
+    }
+
+    const int         prefixLen   = static_cast<int>(prefix->second.size());
+    SubscriberList_t* subscribers = prefixLen == 0 ? &allKeysSubscribers
+                                                   : subscriptions.search(prefix->second.c_str(), prefixLen);
+    std::erase_if(*subscribers, [subscriptionId](const Subscriber_t& subscriber)
+                  { return subscriber.id == subscriptionId; });
+    if (subscribers->empty() && subscribers != &allKeysSubscribers)
+    {
+        subscriptions.deleteValue(prefix->second.c_str(), prefixLen);
+        delete subscribers;
+    }
+    subscriptionPrefixes.erase(prefix);
+    subscriptionsCount.fetch_sub(1, std::memory_order_relaxed);
+    subscriptionsMutex->signal();
+    if (waitDelivery)
+    {
+        deliveryMutex->signal();
+    }
+    return UNSUBSCRIBED;
+}
+
+bool SettingsChangeDispatcher::hasSubscribers() const
+{
+    return subscriptionsCount.load(std::memory_order_relaxed) != 0;
+}
+
+bool SettingsChangeDispatcher::notifyChange(const void* setting)
+{
+    if (!lock(pendingMutex))
+    {
+        return false;
+    }
+    const bool wasEmpty = pending.empty();
+    pending.insert(setting);
+    pendingMutex->signal();
+    if (wasEmpty)
+    {
+        pendingSemaphore->signal();
+    }
+    return true;
+}
+
+bool SettingsChangeDispatcher::dispatch(const uint32_t timeoutMs)
+{
+    if (!pendingSemaphore->wait(timeoutMs))
+    {
+        return false;
+    }
+
+    // The changes of a burst are let to gather, so they are delivered together. The semaphore is not signaled again
+    // while changes are pending, so this waits for the whole delay, which never exceeds the time the caller accepts to
+    // wait.
+    const uint32_t coalescingMs = std::min<uint32_t>(CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS, timeoutMs);
+    if (coalescingMs > 0)
+    {
+        pendingSemaphore->wait(coalescingMs);
+    }
+
+    if (!lock(pendingMutex))
+    {
+        // The changes are still pending, but the semaphore was taken, so it is signaled for the next call.
+        pendingSemaphore->signal();
+        return false;
+    }
+    const std::vector<const void*> changed(pending.begin(), pending.end());
+    pending.clear();
+    pendingMutex->signal();
+
+    return deliver(changed);
+}
+
+bool SettingsChangeDispatcher::deliver(const std::vector<const void*>& changed)
+{
+    // The keys of the settings registered since the last delivery are collected once, on the first change of one.
+    std::vector<const char*> changedKeys;
+    std::vector<const void*> unknown;
+    changedKeys.reserve(changed.size());
+    bool keysCollectionTried = false;
+    bool keysCollected       = false;
+    for (const void* setting : changed)
+    {
+        auto key = keys.find(setting);
+        if (key == keys.end() && !keysCollectionTried)
+        {
+            keysCollectionTried = true;
+            keysCollected       = keyCollector(keyCollectorContext, keys);
+            key                 = keys.find(setting);
+        }
+        if (key != keys.end())
+        {
+            changedKeys.push_back(key->second);
+        }
+        else if (!keysCollected)
+        {
+            // The keys could not be collected in time, so the change is kept for the next delivery.
+            unknown.push_back(setting);
+        }
+    }
+    std::sort(changedKeys.begin(), changedKeys.end(),
+              [](const char* left, const char* right) { return strcmp(left, right) < 0; });
+
+    if (!lock(deliveryMutex))
+    {
+        requeue(changed);
+        return false;
+    }
+    if (!lock(subscriptionsMutex))
+    {
+        deliveryMutex->signal();
+        requeue(changed);
+        return false;
+    }
+    std::map<uint32_t, Delivery_t> deliveries;
+    for (const char* key : changedKeys)
+    {
+        addDelivery(deliveries, allKeysSubscribers, key);
+        MatchCallbackData_t data = {&deliveries, key};
+        subscriptions.iterateOverPrefixesOf(key, static_cast<int>(strlen(key)), matchSubscribersCallback, &data);
+    }
+    subscriptionsMutex->signal();
+
+    deliveringDispatcher = this;
+    for (const auto& [id, subscriberDelivery] : deliveries)
+    {
+        subscriberDelivery.callback(subscriberDelivery.userData, subscriberDelivery.keys.data(),
+                                    subscriberDelivery.keys.size());
+    }
+    deliveringDispatcher = nullptr;
+    deliveryMutex->signal();
+
+    requeue(unknown);
+    return unknown.empty();
+}
+
+void SettingsChangeDispatcher::requeue(const std::vector<const void*>& changes)
+{
+    // The changes are dropped if the pending changes cannot be locked in time either.
+    if (changes.empty() || !lock(pendingMutex))
+    {
+        return;
+    }
+    const bool wasEmpty = pending.empty();
+    pending.insert(changes.begin(), changes.end());
+    pendingMutex->signal();
+    if (wasEmpty)
+    {
+        pendingSemaphore->signal();
+    }
+}
+
+void SettingsChangeDispatcher::addDelivery(std::map<uint32_t, Delivery_t>& deliveries,
+                                           const SubscriberList_t& subscribers, const char* key)
+{
+    for (const Subscriber_t& subscriber : subscribers)
+    {
+        Delivery_t& subscriberDelivery = deliveries[subscriber.id];
+        subscriberDelivery.callback    = subscriber.callback;
+        subscriberDelivery.userData    = subscriber.userData;
+        subscriberDelivery.keys.push_back(key);
+    }
+}
+
+int SettingsChangeDispatcher::matchSubscribersCallback(void* data, [[maybe_unused]] const unsigned char* key,
+                                                       [[maybe_unused]] uint32_t key_len, void* value)
+{
+    const auto& [deliveries, changedKey] = *static_cast<MatchCallbackData_t*>(data);
+    addDelivery(*deliveries, *static_cast<const SubscriberList_t*>(value), changedKey);
+    return 0;
+}
+
+int SettingsChangeDispatcher::freeSubscriberListCallback([[maybe_unused]] void* data,
+                                                         [[maybe_unused]] const unsigned char* key,
+                                                         [[maybe_unused]] uint32_t key_len, void* value)
+{
+    delete static_cast<SubscriberList_t*>(value);
+    return 0;
+}
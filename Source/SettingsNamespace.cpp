@@ -0,0 +1,146 @@
+#include "SettingsNamespace.h"
+
+SettingsNamespace::SettingsNamespace(const SettingsStorage& settingsStorage, const char* prefix)
+{
+    this->settingsStorage = &settingsStorage;
+    this->prefix.assign(prefix != nullptr ? prefix : "", prefix != nullptr ? strnlen(prefix, MAX_SETTING_KEY_SIZE) : 0);
+    this->anchor   = {};
+    this->anchored = false;
+}
+
+const char* SettingsNamespace::getPrefix() const
+{
+    return prefix.c_str();
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::resolveSetting(const char*                               key,
+                                                                  const SettingsStorage::SettingValueType_t type,
+                                                                  SettingsStorage::SettingHandle_t& outputHandle)
+{
+    SettingsStorage::SettingValue_t* value;
+    if (SettingsStorage::SettingError_t result = getSettingValue(key, value); result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    if (value->settingValueType != type)
+    {
+        return SettingsStorage::TYPE_MISMATCH_ERROR;
+    }
+
+    outputHandle.settingValue     = value;
+    outputHandle.settingValueType = type;
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::getSettingAsInt(const char* key, int64_t& outputValue,
+                                                                   SettingPermissions_t* outputPermissions)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolveSetting(key, SettingsStorage::INTEGER, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+    return settingsStorage->getSettingAsInt(handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::getSettingAsReal(const char* key, double& outputValue,
+                                                                    SettingPermissions_t* outputPermissions)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolveSetting(key, SettingsStorage::REAL, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+    return settingsStorage->getSettingAsReal(handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::getSettingAsString(const char* key, char* outputValueBuffer,
+                                                                      const size_t          outputValueSize,
+                                                                      SettingPermissions_t* outputPermissions)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolveSetting(key, SettingsStorage::STRING, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+    return settingsStorage->getSettingAsString(handle, outputValueBuffer, outputValueSize, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::putSettingValueAsInt(const char* key, const int64_t value)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolveSetting(key, SettingsStorage::INTEGER, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+    return settingsStorage->putSettingValueAsInt(handle, value);
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::putSettingValueAsReal(const char* key, const double value)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolveSetting(key, SettingsStorage::REAL, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+    return settingsStorage->putSettingValueAsReal(handle, value);
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::putSettingValueAsString(const char* key, const char* value)
+{
+    if (value == nullptr)
+    {
+        return SettingsStorage::INVALID_INPUT_ERROR;
+    }
+
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolveSetting(key, SettingsStorage::STRING, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+    return settingsStorage->putSettingValueAsString(handle, value);
+}
+
+SettingsStorage::SettingError_t SettingsNamespace::getSettingValue(const char*                       key,
+                                                                   SettingsStorage::SettingValue_t*& outputValue)
+{
+    if (key == nullptr || key[0] == '\0')
+    {
+        return SettingsStorage::INVALID_INPUT_ERROR;
+    }
+
+    const size_t keyLength = strnlen(key, MAX_SETTING_KEY_SIZE);
+    if (settingsStorage->frozenIndex.load(std::memory_order_acquire) == nullptr)
+    {
+        SettingsStorage::Settings_t* settings = settingsStorage->settings;
+        bool searched = anchored && settings->searchFromAnchor(anchor, key, static_cast<int>(keyLength), outputValue);
+        if (!searched)
+        {
+            // The anchor is stale or was never taken. The full key is only built if the tree cannot take it.
+            anchored = settings->findAnchor(prefix.c_str(), static_cast<int>(prefix.size()), anchor);
+            searched = anchored && settings->searchFromAnchor(anchor, key, static_cast<int>(keyLength), outputValue);
+        }
+        if (searched)
+        {
+            return outputValue != nullptr ? SettingsStorage::NO_ERROR : SettingsStorage::KEY_NOT_FOUND_ERROR;
+        }
+    }
+
+    // The frozen index, and the trees that cannot take the anchor, look the full key up, which is built on the stack.
+    if (prefix.size() + keyLength >= MAX_SETTING_KEY_SIZE)
+    {
+        return SettingsStorage::KEY_NOT_FOUND_ERROR; // No setting has such a long key.
+    }
+    char fullKey[MAX_SETTING_KEY_SIZE];
+    memcpy(fullKey, prefix.c_str(), prefix.size());
+    memcpy(fullKey + prefix.size(), key, keyLength);
+    fullKey[prefix.size() + keyLength] = '\0';
+    return settingsStorage->getSettingValue(fullKey, outputValue);
+}
@@ -0,0 +1,121 @@
+#include "SettingsSnapshot.h"
+#include <algorithm>
+#include <cstring>
+
+size_t SettingsSnapshot::size() const
+{
+    return entries.size();
+}
+
+uint64_t SettingsSnapshot::getGeneration() const
+{
+    return generation;
+}
+
+SettingsStorage::SettingError_t SettingsSnapshot::getSettingAsInt(const char* key, int64_t& outputValue,
+                                                                  SettingPermissions_t* outputPermissions) const
+{
+    const Entry_t* entry;
+    if (SettingsStorage::SettingError_t result = find(key, SettingsStorage::INTEGER, entry, outputPermissions);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    outputValue = entry->value.integer;
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsSnapshot::getSettingAsReal(const char* key, double& outputValue,
+                                                                   SettingPermissions_t* outputPermissions) const
+{
+    const Entry_t* entry;
+    if (SettingsStorage::SettingError_t result = find(key, SettingsStorage::REAL, entry, outputPermissions);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    outputValue = entry->value.real;
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsSnapshot::getSettingAsString(const char* key, std::string_view& outputValue,
+                                                                     SettingPermissions_t* outputPermissions) const
+{
+    const Entry_t* entry;
+    if (SettingsStorage::SettingError_t result = find(key, SettingsStorage::STRING, entry, outputPermissions);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    outputValue = strings[entry->value.string].view();
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t
+SettingsSnapshot::listSettingsKeys(const char* keyPrefix, SettingsStorage::SettingsKeysList_t& outputKeys) const
+{
+    if (keyPrefix == nullptr)
+    {
+        return SettingsStorage::INVALID_INPUT_ERROR;
+    }
+
+    // The keys that start with the prefix follow each other, from the first key not lower than the prefix.
+    const std::string_view prefix(keyPrefix);
+    for (auto entry = lowerBound(prefix); entry != entries.end() && keyOf(*entry).starts_with(prefix); ++entry)
+    {
+        outputKeys.emplace_back(keyOf(*entry));
+    }
+    return SettingsStorage::NO_ERROR;
+}
+
+std::string_view SettingsSnapshot::keyOf(const Entry_t& entry) const
+{
+    return {&keys[entry.keyOffset], entry.keyLen};
+}
+
+std::vector<SettingsSnapshot::Entry_t>::const_iterator SettingsSnapshot::lowerBound(const std::string_view key) const
+{
+    return std::lower_bound(entries.begin(), entries.end(), key,
+                            [this](const Entry_t& entry, const std::string_view searched)
+                            { return keyOf(entry) < searched; });
+}
+
+SettingsStorage::SettingError_t SettingsSnapshot::find(const char* key, const SettingsStorage::SettingValueType_t type,
+                                                       const Entry_t*&       outputEntry,
+                                                       SettingPermissions_t* outputPermissions) const
+{
+    if (key == nullptr || key[0] == '\0')
+    {
+        return SettingsStorage::INVALID_INPUT_ERROR;
+    }
+
+    const std::string_view wanted(key, strnlen(key, MAX_SETTING_KEY_SIZE));
+    const auto             entry = lowerBound(wanted);
+    if (entry == entries.end() || keyOf(*entry) != wanted)
+    {
+        return SettingsStorage::KEY_NOT_FOUND_ERROR;
+    }
+
+    if (entry->settingValueType != type)
+    {
+        return SettingsStorage::TYPE_MISMATCH_ERROR;
+    }
+
+    outputEntry = &*entry;
+    if (outputPermissions != nullptr)
+    {
+        *outputPermissions = entry->settingPermissions;
+    }
+    return SettingsStorage::NO_ERROR;
+}
+
+void SettingsSnapshot::clear()
+{
+    keys.clear();
+    entries.clear();
+    strings.clear();
+    generation = 0;
+}
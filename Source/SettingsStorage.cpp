@@ -1,7 +1,9 @@
 #include "SettingsStorage.h"
+#include "SettingsSnapshot.h"
 #include <cstring>
 #include <format>
 #include <sstream>
+#include <vector>
 
 constexpr uint32_t SETTINGS_STORAGE_MUTEX_TIMEOUT_MS = 100;
 
@@ -66,9 +68,18 @@ SettingsStorage::SettingsStorage(OSInterface& osInterface, SettingsFile* setting
     this->osInterface       = &osInterface;
     this->moduleConfigMutex = osInterface.osCreateMutex();
     assert(this->moduleConfigMutex != nullptr && "Mutex creation failed");
+    this->valuesWriteMutex = osInterface.osCreateMutex();
+    assert(this->valuesWriteMutex != nullptr && "Mutex creation failed");
 
     this->persistentStorageEnabled = false;
     this->settings                 = new Settings_t(osInterface);
+    this->frozenIndex.store(nullptr, std::memory_order_relaxed);
+    this->registrations.store(0, std::memory_order_relaxed);
+    this->freezes.store(0, std::memory_order_relaxed);
+    this->valuesSequence.store(0, std::memory_order_relaxed);
+    this->unsavedChanges.store(false, std::memory_order_relaxed);
+    this->generation.store(0, std::memory_order_relaxed);
+    this->changeDispatcher = new SettingsChangeDispatcher(osInterface, collectKeys, this);
 
     this->settingsFile = settingsFile;
     if (settingsFile != nullptr)
@@ -84,10 +95,14 @@ SettingsStorage::~SettingsStorage()
         settingsFile->forceClose();
     }
 
+    // The dispatcher collects the keys from the settings tree, so it is destroyed first.
+    delete changeDispatcher;
     settings->iterateOverAll(freeSettingValuesCallback, nullptr);
 
+    delete frozenIndex.load(std::memory_order_relaxed);
     delete settings;
     delete moduleConfigMutex;
+    delete valuesWriteMutex;
 }
 
 bool SettingsStorage::isPersistentStorageEnabled() const
@@ -117,58 +132,109 @@ SettingsStorage::SettingError_t SettingsStorage::restoreDefaultSettings(const ch
                                                                         SettingPermissions_t           permissions,
                                                                         SettingPermissionsFilterMode_t filterMode) const
 {
-    if (keyPrefix == nullptr)
+    // The settings are collected under the tree lock, then restored in a single values write section, so readers of
+    // several settings never see a restore half done. Their keys are neither copied nor looked up again.
+    std::vector<SettingValue_t*> settingValues;
+    if (const SettingError_t result = forEachSetting(
+            keyPrefix,
+            [&settingValues](std::string_view, const SettingHandle_t& handle)
+            {
+                settingValues.push_back(handle.settingValue);
+                return true;
+            },
+            permissions, filterMode);
+        result != NO_ERROR)
     {
-        return INVALID_INPUT_ERROR;
+        return result;
     }
 
-    SettingsKeysList_t outputKeys;
-
-    SettingError_t result = listSettingsKeys(keyPrefix, permissions, filterMode, outputKeys);
-    if (result != NO_ERROR)
+    uint32_t sequence;
+    if (!beginValuesWrite(sequence))
     {
-        return result;
+        return LOCK_TIMEOUT_ERROR;
     }
 
-    for (const auto& key : outputKeys)
+    std::vector<SettingValueData_t> previousStrings;
+    for (SettingValue_t* settingValue : settingValues)
     {
-        SettingValue_t* outputValue;
-        result = getSettingValue(key.c_str(), outputValue);
-        if (result != NO_ERROR)
+        if (settingValue->settingValueType == STRING)
         {
-            return result;
+            // Readers may copy the string data meanwhile, so it is published with atomic stores. The previous string
+            // is released once out of the write section.
+            SettingValueData_t defaultValueData;
+            shareStringData(defaultValueData, settingValue->settingDefaultValueData);
+            previousStrings.push_back(settingValue->settingValueData);
+            storeValueData(settingValue->settingValueData, defaultValueData);
         }
-
-        if (outputValue->settingValueType == STRING)
+        else if (settingValue->settingValueType == INTEGER)
         {
-            free(outputValue->settingValueData.string);
-            outputValue->settingValueData.string = strdup(outputValue->settingDefaultValueData.string);
+            std::atomic_ref(settingValue->settingValueData.integer)
+                .store(settingValue->settingDefaultValueData.integer, std::memory_order_relaxed);
         }
         else
         {
-            outputValue->settingValueData = outputValue->settingDefaultValueData;
+            std::atomic_ref(settingValue->settingValueData.real)
+                .store(settingValue->settingDefaultValueData.real, std::memory_order_relaxed);
         }
     }
 
+    endValuesWrite(sequence);
+
+    for (const SettingValueData_t& previousString : previousStrings)
+    {
+        releaseStringData(previousString);
+    }
+    for (SettingValue_t* settingValue : settingValues)
+    {
+        noteSettingWritten(settingValue);
+    }
     return NO_ERROR;
 }
 
 SettingsStorage::SettingError_t SettingsStorage::storeSettingsInPersistentStorage() const
 {
+    // Cleared before the settings are read, so the changes made while they are being stored are not lost.
+    const bool hadUnsavedChanges = unsavedChanges.exchange(false, std::memory_order_acq_rel);
+
+    // The file is written from a snapshot, so the writers are not held back while it is being written. The snapshot is
+    // taken before the file is opened, as opening it for writing truncates it.
+    SettingsSnapshot settingsSnapshot;
+    if (const SettingError_t result = snapshot(settingsSnapshot, "", SettingPermissions_t::VOLATILE,
+                                               ExcludeSettingsWithAnyPermissionsListed);
+        result != NO_ERROR)
+    {
+        if (hadUnsavedChanges)
+        {
+            markUnsavedChanges();
+        }
+        return result;
+    }
+
     SettingsFile::SettingsFileResult res = settingsFile->openForWrite();
     if (res != SettingsFile::Success)
     {
+        if (hadUnsavedChanges)
+        {
+            markUnsavedChanges();
+        }
         return SETTINGS_FILESYSTEM_ERROR;
     }
 
-    uint32_t                    crc32;
-    bool                        firstSetting = true;
-    CRC::Table<unsigned, 32>    crcTable     = CRC::CRC_32().MakeTable();
-    SettingsStoreCallbackData_t callbackData = std::make_tuple(settingsFile, &crc32, &firstSetting, &crcTable);
-    res                                      = static_cast<SettingsFile::SettingsFileResult>(
-        settings->iterateOverAll(storeSettingsInPersistentStorageCallback, &callbackData));
+    uint32_t                 crc32;
+    bool                     firstSetting = true;
+    CRC::Table<unsigned, 32> crcTable     = CRC::CRC_32().MakeTable();
+    SettingsStoreData_t      storeData    = std::make_tuple(settingsFile, &crc32, &firstSetting, &crcTable);
+    for (size_t i = 0; i < settingsSnapshot.size() && res == SettingsFile::Success; i++)
+    {
+        res = storeSettingInPersistentStorage(storeData, settingsSnapshot, i);
+    }
     if (res != SettingsFile::Success)
     {
+        settingsFile->close();
+        if (hadUnsavedChanges)
+        {
+            markUnsavedChanges();
+        }
         return SETTINGS_FILESYSTEM_ERROR;
     }
 
@@ -176,12 +242,21 @@ SettingsStorage::SettingError_t SettingsStorage::storeSettingsInPersistentStorag
     res                         = settingsFile->write(formattedString);
     if (res != SettingsFile::Success)
     {
+        settingsFile->close();
+        if (hadUnsavedChanges)
+        {
+            markUnsavedChanges();
+        }
         return SETTINGS_FILESYSTEM_ERROR;
     }
 
     res = settingsFile->close();
     if (res != SettingsFile::Success)
     {
+        if (hadUnsavedChanges)
+        {
+            markUnsavedChanges();
+        }
         return SETTINGS_FILESYSTEM_ERROR;
     }
     return NO_ERROR;
@@ -329,8 +404,9 @@ SettingsStorage::SettingError_t SettingsStorage::loadSettingsFromPersistentStora
 
                 if (settingError == KEY_NOT_FOUND_ERROR)
                 {
+                    // Once the settings storage is frozen, the settings that are not registered are skipped.
                     settingError = registerSettingAsReal(key.c_str(), SettingPermissions_t::VOLATILE, realValue);
-                    if (settingError != NO_ERROR)
+                    if (settingError != NO_ERROR && settingError != SETTINGS_FROZEN_ERROR)
                     {
                         settingsFile->close();
                         return SETTINGS_FILESYSTEM_ERROR;
@@ -357,7 +433,7 @@ SettingsStorage::SettingError_t SettingsStorage::loadSettingsFromPersistentStora
                 if (settingError == KEY_NOT_FOUND_ERROR)
                 {
                     settingError = registerSettingAsInt(key.c_str(), SettingPermissions_t::VOLATILE, integerValue);
-                    if (settingError != NO_ERROR)
+                    if (settingError != NO_ERROR && settingError != SETTINGS_FROZEN_ERROR)
                     {
                         settingsFile->close();
                         return SETTINGS_FILESYSTEM_ERROR;
@@ -378,7 +454,7 @@ SettingsStorage::SettingError_t SettingsStorage::loadSettingsFromPersistentStora
                 {
                     settingError =
                         registerSettingAsString(key.c_str(), SettingPermissions_t::VOLATILE, valueStr.c_str());
-                    if (settingError != NO_ERROR)
+                    if (settingError != NO_ERROR && settingError != SETTINGS_FROZEN_ERROR)
                     {
                         settingsFile->close();
                         return SETTINGS_FILESYSTEM_ERROR;
@@ -408,58 +484,126 @@ SettingsStorage::SettingError_t SettingsStorage::loadSettingsFromPersistentStora
     {
         return SETTINGS_FILESYSTEM_ERROR;
     }
+
+    unsavedChanges.store(false, std::memory_order_release);
     return NO_ERROR;
 }
 
-int SettingsStorage::listSettingsKeysCallback(void* data, const unsigned char* key, uint32_t key_len, void* value)
+int SettingsStorage::iterateSettingsCallback(void* data, const unsigned char* key, uint32_t key_len, void* value)
 {
-    auto*                          callbackData = static_cast<SettingsListCallbackData_t*>(data);
+    auto*                          callbackData = static_cast<SettingsIterationCallbackData_t*>(data);
     SettingPermissions_t           permissions  = std::get<0>(*callbackData);
     SettingPermissionsFilterMode_t filterMode   = std::get<1>(*callbackData);
-    SettingsKeysList_t*            outputKeys   = std::get<2>(*callbackData);
+    SettingVisitor_t               visitor      = std::get<2>(*callbackData);
+    void*                          context      = std::get<3>(*callbackData);
     auto*                          settingValue = static_cast<SettingValue_t*>(value);
 
+    bool matches;
     switch (filterMode)
     {
         case MatchSettingsWithAnyPermissionsListed:
-        {
-            if (static_cast<uint32_t>(settingValue->settingPermissions & permissions) >
-                0) // If a bit is set in both, the result is greater than 0.
-            {
-                outputKeys->emplace_back(reinterpret_cast<const char*>(key), key_len);
-            }
-            return NO_ERROR;
-        }
-
+            // If a bit is set in both, the result is greater than 0.
+            matches = static_cast<uint32_t>(settingValue->settingPermissions & permissions) > 0;
+            break;
         case MatchSettingsWithAllPermissionsListed:
-        {
-            if (settingValue->settingPermissions == permissions)
-            {
-                outputKeys->emplace_back(reinterpret_cast<const char*>(key), key_len);
-            }
-            return NO_ERROR;
-        }
-
+            matches = settingValue->settingPermissions == permissions;
+            break;
         case ExcludeSettingsWithAllPermissionsListed:
-        {
-            if (settingValue->settingPermissions != permissions)
-            {
-                outputKeys->emplace_back(reinterpret_cast<const char*>(key), key_len);
-            }
-            return NO_ERROR;
-        }
-
+            matches = settingValue->settingPermissions != permissions;
+            break;
         case ExcludeSettingsWithAnyPermissionsListed:
-        {
-            if (static_cast<uint32_t>(settingValue->settingPermissions & permissions) == 0)
-            {
-                outputKeys->emplace_back(reinterpret_cast<const char*>(key), key_len);
-            }
-            return NO_ERROR;
-        }
+            matches = static_cast<uint32_t>(settingValue->settingPermissions & permissions) == 0;
+            break;
         default:
             return INVALID_INPUT_ERROR;
     }
+
+    if (matches && !visitor(context, std::string_view(reinterpret_cast<const char*>(key), key_len),
+                            {settingValue, settingValue->settingValueType}))
+    {
+        return ITERATION_STOPPED;
+    }
+    return NO_ERROR;
+}
+
+bool SettingsStorage::snapshotVisitor(void* context, const std::string_view key, const SettingHandle_t& handle)
+{
+    const auto& [outputSnapshot, outputValues] = *static_cast<SnapshotCallbackData_t*>(context);
+
+    SettingsSnapshot::Entry_t entry = {};
+    entry.keyOffset                 = static_cast<uint32_t>(outputSnapshot->keys.size());
+    entry.keyLen                    = static_cast<uint32_t>(key.size());
+    entry.settingValueType          = handle.settingValueType;
+    entry.settingPermissions        = handle.settingValue->settingPermissions;
+    if (entry.settingValueType == STRING)
+    {
+        entry.value.string = outputSnapshot->strings.size();
+        outputSnapshot->strings.emplace_back();
+    }
+
+    // The keys are null terminated, so they can be written to the settings file as they are.
+    outputSnapshot->keys.insert(outputSnapshot->keys.end(), key.begin(), key.end());
+    outputSnapshot->keys.push_back('\0');
+    outputSnapshot->entries.push_back(entry);
+    outputValues->push_back(handle.settingValue);
+    return true;
+}
+
+int SettingsStorage::listChildrenCallback(void* data, const unsigned char* key, const uint32_t key_len, void* value)
+{
+    auto*          callbackData   = static_cast<SettingsChildrenCallbackData_t*>(data);
+    auto*          outputChildren = std::get<0>(*callbackData);
+    const uint32_t prefixLen      = std::get<1>(*callbackData);
+
+    // The key of a directory ends with its separator, which is not part of the name.
+    const bool isDirectory = value == nullptr;
+    outputChildren->push_back({std::string(reinterpret_cast<const char*>(key) + prefixLen,
+                                           key_len - prefixLen - (isDirectory ? 1 : 0)),
+                               isDirectory});
+    return 0;
+}
+
+bool SettingsStorage::permissionsFilterCallback(void* data, const uint32_t anyBits, const uint32_t allBits)
+{
+    // anyBits holds every permission found below the node and allBits the permissions shared by all its settings.
+    auto*                                callbackData = static_cast<SettingsIterationCallbackData_t*>(data);
+    const auto                           permissions  = static_cast<uint32_t>(std::get<0>(*callbackData));
+    const SettingPermissionsFilterMode_t filterMode   = std::get<1>(*callbackData);
+
+    switch (filterMode)
+    {
+        case MatchSettingsWithAnyPermissionsListed:
+            return (anyBits & permissions) != 0;
+        case MatchSettingsWithAllPermissionsListed:
+            return (allBits & ~permissions) == 0 && (permissions & ~anyBits) == 0;
+        case ExcludeSettingsWithAllPermissionsListed:
+            return anyBits != permissions || allBits != permissions;
+        case ExcludeSettingsWithAnyPermissionsListed:
+            return (allBits & permissions) == 0;
+        default:
+            return true; // The settings report the invalid filter mode.
+    }
+}
+
+int SettingsStorage::freezeCallback(void* data, const unsigned char* key, const uint32_t key_len, void* value)
+{
+    static_cast<FrozenIndex_t*>(data)->add(reinterpret_cast<const char*>(key), key_len,
+                                           static_cast<SettingValue_t*>(value));
+    return 0;
+}
+
+int SettingsStorage::collectKeysCallback(void* data, const unsigned char* key, [[maybe_unused]] const uint32_t key_len,
+                                         void* value)
+{
+    // The keys of the leaves are null terminated, and settings are never deleted, so they are not copied.
+    auto* keys = static_cast<std::unordered_map<const void*, const char*>*>(data);
+    keys->try_emplace(value, reinterpret_cast<const char*>(key));
+    return 0;
+}
+
+bool SettingsStorage::collectKeys(void* context, std::unordered_map<const void*, const char*>& outputKeys)
+{
+    return static_cast<SettingsStorage*>(context)->settings->iterateOverAll(collectKeysCallback, &outputKeys) == 0;
 }
 
 int SettingsStorage::freeSettingValuesCallback([[maybe_unused]] void* data, [[maybe_unused]] const unsigned char* key,
@@ -471,41 +615,35 @@ int SettingsStorage::freeSettingValuesCallback([[maybe_unused]] void* data, [[ma
     return NO_ERROR;
 }
 
-int SettingsStorage::storeSettingsInPersistentStorageCallback(void* data, const unsigned char* key, uint32_t key_len,
-                                                              void* value)
+SettingsFile::SettingsFileResult
+SettingsStorage::storeSettingInPersistentStorage(SettingsStoreData_t& data, const SettingsSnapshot& snapshot,
+                                                 const size_t position)
 {
-    auto* callbackData = static_cast<SettingsStoreCallbackData_t*>(data);
-    auto* settingValue = static_cast<SettingValue_t*>(value);
-
-    // If the setting is volatile, it should not be stored in the persistent storage.
-    if (static_cast<bool>(settingValue->settingPermissions & SettingPermissions_t::VOLATILE))
-    {
-        return SettingsFile::Success;
-    }
-
-    SettingsFile*             settingsFile  = std::get<0>(*callbackData);
-    uint32_t*                 settingsCRC32 = std::get<1>(*callbackData);
-    bool*                     firstSetting  = std::get<2>(*callbackData);
-    CRC::Table<unsigned, 32>* crcTable      = std::get<3>(*callbackData);
+    SettingsFile*                    settingsFile  = std::get<0>(data);
+    uint32_t*                        settingsCRC32 = std::get<1>(data);
+    bool*                            firstSetting  = std::get<2>(data);
+    CRC::Table<unsigned, 32>*        crcTable      = std::get<3>(data);
+    const SettingsSnapshot::Entry_t& entry         = snapshot.entries[position];
+    const std::string_view           key           = snapshot.keyOf(entry);
 
     if (*firstSetting)
     {
         *firstSetting  = false;
-        *settingsCRC32 = CRC::Calculate(key, key_len, *crcTable);
+        *settingsCRC32 = CRC::Calculate(key.data(), key.size(), *crcTable);
     }
     else
     {
-        *settingsCRC32 = CRC::Calculate(key, key_len, *crcTable, *settingsCRC32);
+        *settingsCRC32 = CRC::Calculate(key.data(), key.size(), *crcTable, *settingsCRC32);
     }
 
-    SettingsFile::SettingsFileResult res = settingsFile->write(reinterpret_cast<const char*>(key));
+    SettingsFile::SettingsFileResult res = settingsFile->write(key.data());
     if (res != SettingsFile::Success)
     {
         return res;
     }
 
     {
-        const std::string formattedString = std::format("\t{}\t", static_cast<uint8_t>(settingValue->settingValueType));
+        const std::string formattedString = std::format("\t{}\t", static_cast<uint8_t>(entry.settingValueType));
 
         *settingsCRC32 = CRC::Calculate(formattedString.c_str(), formattedString.size(), *crcTable, *settingsCRC32);
         res            = settingsFile->write(formattedString);
@@ -515,43 +653,126 @@ int SettingsStorage::storeSettingsInPersistentStorageCallback(void* data, const
         }
     }
 
-    switch (settingValue->settingValueType)
+    std::string formattedString;
+    switch (entry.settingValueType)
     {
         case REAL:
-        {
-            std::string formattedString = std::format("{:.{}g}\n", settingValue->settingValueData.real,
-                                                      std::numeric_limits<double>::max_digits10);
-
-            *settingsCRC32 = CRC::Calculate(formattedString.c_str(), formattedString.size(), *crcTable, *settingsCRC32);
-            res            = settingsFile->write(formattedString);
+            formattedString = std::format("{:.{}g}\n", entry.value.real, std::numeric_limits<double>::max_digits10);
             break;
-        }
         case INTEGER:
-        {
-            std::string formattedString = std::format("{}\n", settingValue->settingValueData.integer);
-
-            *settingsCRC32 = CRC::Calculate(formattedString.c_str(), formattedString.size(), *crcTable, *settingsCRC32);
-            res            = settingsFile->write(formattedString);
+            formattedString = std::format("{}\n", entry.value.integer);
             break;
-        }
         case STRING:
-        {
-            std::string formattedString = std::format("{}\n", settingValue->settingValueData.string);
-
-            *settingsCRC32 = CRC::Calculate(formattedString.c_str(), formattedString.size(), *crcTable, *settingsCRC32);
-            res            = settingsFile->write(formattedString);
+            formattedString = std::format("{}\n", snapshot.strings[entry.value.string].view());
             break;
-        }
         default:
-            res = SettingsFile::InvalidState;
+            return SettingsFile::InvalidState;
     }
-    return res;
+
+    *settingsCRC32 = CRC::Calculate(formattedString.c_str(), formattedString.size(), *crcTable, *settingsCRC32);
+    return settingsFile->write(formattedString);
 }
 
 SettingsStorage::SettingError_t SettingsStorage::listSettingsKeys(const char*                    keyPrefix,
                                                                   SettingPermissions_t           permissions,
                                                                   SettingPermissionsFilterMode_t filterMode,
                                                                   SettingsKeysList_t&            outputKeys) const
+{
+    return forEachSetting(
+        keyPrefix,
+        [&outputKeys](const std::string_view key, const SettingHandle_t&)
+        {
+            outputKeys.emplace_back(key);
+            return true;
+        },
+        permissions, filterMode);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::listChildren(const char*            keyPrefix,
+                                                              SettingChildrenList_t& outputChildren) const
+{
+    if (keyPrefix == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    const auto                     prefixLen    = static_cast<uint32_t>(strnlen(keyPrefix, MAX_SETTING_KEY_SIZE));
+    SettingsChildrenCallbackData_t callbackData = std::make_tuple(&outputChildren, prefixLen);
+    const int res = settings->iterateOverChildren(keyPrefix, static_cast<int>(prefixLen), '/', listChildrenCallback,
+                                                  &callbackData);
+    if (res == 0)
+    {
+        return NO_ERROR;
+    }
+    return res == TREE_LOCK_TIMEOUT ? LOCK_TIMEOUT_ERROR : FATAL_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::snapshot(SettingsSnapshot& outputSnapshot, const char* keyPrefix,
+                                                          const SettingPermissions_t           permissions,
+                                                          const SettingPermissionsFilterMode_t filterMode) const
+{
+    outputSnapshot.clear();
+    if (keyPrefix == nullptr || !validatePermissions(permissions))
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    // Only the keys are copied under the tree lock.
+    std::vector<SettingValue_t*>    values;
+    SnapshotCallbackData_t          snapshotData = std::make_tuple(&outputSnapshot, &values);
+    SettingsIterationCallbackData_t callbackData =
+        std::make_tuple(permissions, filterMode, snapshotVisitor, &snapshotData);
+    const int res = settings->iterateOverPrefix(keyPrefix, static_cast<int>(strnlen(keyPrefix, MAX_SETTING_KEY_SIZE)),
+                                                iterateSettingsCallback, &callbackData, permissionsFilterCallback,
+                                                &callbackData);
+    if (res != NO_ERROR)
+    {
+        outputSnapshot.clear();
+        return res == TREE_LOCK_TIMEOUT ? LOCK_TIMEOUT_ERROR : static_cast<SettingError_t>(res);
+    }
+
+    // The values are read again if a setting was written meanwhile, so they are taken at a single point in time and
+    // all the updates of a transaction or none are taken.
+    outputSnapshot.generation = generation.load(std::memory_order_acquire);
+    uint32_t sequence;
+    uint32_t attempts = 0;
+    do
+    {
+        if (attempts++ == SNAPSHOT_READ_ATTEMPTS || !waitForValues(sequence))
+        {
+            outputSnapshot.clear();
+            return LOCK_TIMEOUT_ERROR;
+        }
+
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            SettingsSnapshot::Entry_t& entry = outputSnapshot.entries[i];
+            SettingValueData_t&        data  = values[i]->settingValueData;
+            if (entry.settingValueType == INTEGER)
+            {
+                entry.value.integer = std::atomic_ref(data.integer).load(std::memory_order_acquire);
+            }
+            else if (entry.settingValueType == REAL)
+            {
+                entry.value.real = std::atomic_ref(data.real).load(std::memory_order_acquire);
+            }
+            else if (!leaseStringData(data, outputSnapshot.strings[entry.value.string]))
+            {
+                outputSnapshot.clear();
+                return LOCK_TIMEOUT_ERROR;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (valuesSequence.load(std::memory_order_relaxed) != sequence);
+
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::iterateSettings(const char*                          keyPrefix,
+                                                                 const SettingPermissions_t           permissions,
+                                                                 const SettingPermissionsFilterMode_t filterMode,
+                                                                 const SettingVisitor_t visitor, void* context) const
 {
     if (keyPrefix == nullptr)
     {
@@ -563,10 +784,15 @@ SettingsStorage::SettingError_t SettingsStorage::listSettingsKeys(const char*
         return INVALID_INPUT_ERROR;
     }
 
-    SettingsListCallbackData_t callbackData = std::make_tuple(permissions, filterMode, &outputKeys);
-    int res = settings->iterateOverPrefix(keyPrefix, static_cast<int>(strnlen(keyPrefix, MAX_SETTING_KEY_SIZE)),
-                                          listSettingsKeysCallback, &callbackData);
-    return static_cast<SettingError_t>(res);
+    SettingsIterationCallbackData_t callbackData = std::make_tuple(permissions, filterMode, visitor, context);
+    const int res = settings->iterateOverPrefix(keyPrefix, static_cast<int>(strnlen(keyPrefix, MAX_SETTING_KEY_SIZE)),
+                                                iterateSettingsCallback, &callbackData, permissionsFilterCallback,
+                                                &callbackData);
+    if (res == ITERATION_STOPPED)
+    {
+        return NO_ERROR;
+    }
+    return res == TREE_LOCK_TIMEOUT ? LOCK_TIMEOUT_ERROR : static_cast<SettingError_t>(res);
 }
 
 SettingsStorage::SettingError_t SettingsStorage::getSettingAsInt(const char* key, int64_t& outputValue,
@@ -588,6 +814,59 @@ SettingsStorage::SettingError_t SettingsStorage::getSettingAsString(const char*
     return getSettingValueAsString(Value, key, outputValueBuffer, outputValueSize, outputPermissions);
 }
 
+SettingsStorage::SettingError_t SettingsStorage::leaseSettingAsString(const char*           key,
+                                                                      SettingStringLease&   outputLease,
+                                                                      SettingPermissions_t* outputPermissions) const
+{
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, STRING, handle); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return leaseSettingAsString(handle, outputLease, outputPermissions);
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::getSettingWithGenerationAsInt(const char* key, int64_t& outputValue, uint64_t& outputGeneration,
+                                               SettingPermissions_t* outputPermissions) const
+{
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, INTEGER, handle); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return getSettingWithGenerationAsInt(handle, outputValue, outputGeneration, outputPermissions);
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::getSettingWithGenerationAsReal(const char* key, double& outputValue, uint64_t& outputGeneration,
+                                                SettingPermissions_t* outputPermissions) const
+{
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, REAL, handle); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return getSettingWithGenerationAsReal(handle, outputValue, outputGeneration, outputPermissions);
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::leaseSettingWithGenerationAsString(const char* key, SettingStringLease& outputLease,
+                                                    uint64_t&             outputGeneration,
+                                                    SettingPermissions_t* outputPermissions) const
+{
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, STRING, handle); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return leaseSettingWithGenerationAsString(handle, outputLease, outputGeneration, outputPermissions);
+}
+
 SettingsStorage::SettingError_t SettingsStorage::registerSettingAsInt(const char*                key,
                                                                       const SettingPermissions_t permissions,
                                                                       const int64_t              defaultValue) const
@@ -597,18 +876,12 @@ SettingsStorage::SettingError_t SettingsStorage::registerSettingAsInt(const char
         return INVALID_INPUT_ERROR;
     }
 
-    auto* newValue                            = new SettingValue_t();
-    newValue->settingPermissions              = permissions;
-    newValue->settingValueType                = INTEGER;
-    newValue->settingValueData.integer        = defaultValue;
-    newValue->settingDefaultValueData.integer = defaultValue;
-    if (this->settings->insertIfNotExists(key, static_cast<int>(strnlen(key, MAX_SETTING_KEY_SIZE)), newValue) !=
-        nullptr)
-    {
-        delete newValue;
-        return KEY_EXISTS_ERROR;
-    }
-    return NO_ERROR;
+    SettingValue_t newValue                  = {};
+    newValue.settingPermissions              = permissions;
+    newValue.settingValueType                = INTEGER;
+    newValue.settingValueData.integer        = defaultValue;
+    newValue.settingDefaultValueData.integer = defaultValue;
+    return insertSetting(key, newValue);
 }
 
 SettingsStorage::SettingError_t SettingsStorage::registerSettingAsReal(const char*                key,
@@ -620,18 +893,12 @@ SettingsStorage::SettingError_t SettingsStorage::registerSettingAsReal(const cha
         return INVALID_INPUT_ERROR;
     }
 
-    auto* newValue                         = new SettingValue_t();
-    newValue->settingPermissions           = permissions;
-    newValue->settingValueType             = REAL;
-    newValue->settingValueData.real        = defaultValue;
-    newValue->settingDefaultValueData.real = defaultValue;
-    if (this->settings->insertIfNotExists(key, static_cast<int>(strnlen(key, MAX_SETTING_KEY_SIZE)), newValue) !=
-        nullptr)
-    {
-        delete newValue;
-        return KEY_EXISTS_ERROR;
-    }
-    return NO_ERROR;
+    SettingValue_t newValue               = {};
+    newValue.settingPermissions           = permissions;
+    newValue.settingValueType             = REAL;
+    newValue.settingValueData.real        = defaultValue;
+    newValue.settingDefaultValueData.real = defaultValue;
+    return insertSetting(key, newValue);
 }
 
 SettingsStorage::SettingError_t SettingsStorage::registerSettingAsString(const char*                key,
@@ -643,60 +910,153 @@ SettingsStorage::SettingError_t SettingsStorage::registerSettingAsString(const c
         return INVALID_INPUT_ERROR;
     }
 
-    auto* newValue                           = new SettingValue_t();
-    newValue->settingPermissions             = permissions;
-    newValue->settingValueType               = STRING;
-    newValue->settingValueData.string        = strdup(defaultValue);
-    newValue->settingDefaultValueData.string = strdup(defaultValue);
+    SettingValue_t newValue     = {};
+    newValue.settingPermissions = permissions;
+    newValue.settingValueType   = STRING;
+    setStringData(newValue.settingDefaultValueData, defaultValue);
+    shareStringData(newValue.settingValueData, newValue.settingDefaultValueData);
 
-    if (this->settings->insertIfNotExists(key, static_cast<int>(strnlen(key, MAX_SETTING_KEY_SIZE)), newValue) !=
-        nullptr)
+    const SettingError_t result = insertSetting(key, newValue);
+    if (result != NO_ERROR)
     {
-        free(newValue->settingValueData.string);
-        free(newValue->settingDefaultValueData.string);
-        delete newValue;
-
-        return KEY_EXISTS_ERROR;
+        freeStringData(newValue.settingValueData);
+        freeStringData(newValue.settingDefaultValueData);
     }
-    return NO_ERROR;
+    return result;
 }
 
-SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsInt(const char* key, const int64_t value) const
+SettingsStorage::SettingError_t
+SettingsStorage::registerSettings(const std::span<const SettingDescriptor_t> descriptors,
+                                  SettingError_t*                            outputResults) const
 {
-    SettingValue_t* outputValue;
+    std::vector<SettingError_t> results(descriptors.size(), NO_ERROR);
+    std::vector<const char*>    keys;
+    std::vector<int>            keyLengths;
+    std::vector<SettingValue_t> values;
+    std::vector<size_t>         positions; // Position in descriptors of each setting to create.
+    const SettingError_t        registration = beginRegistration();
+    keys.reserve(descriptors.size());
+    keyLengths.reserve(descriptors.size());
+    values.reserve(descriptors.size());
+    positions.reserve(descriptors.size());
+
+    for (size_t i = 0; i < descriptors.size(); i++)
+    {
+        const SettingDescriptor_t& descriptor = descriptors[i];
+        if (descriptor.key == nullptr || descriptor.key[0] == '\0' ||
+            !validatePermissions(descriptor.settingPermissions) ||
+            descriptor.settingValueType >= MAX_SETTING_VALUE_TYPE_ENUM ||
+            (descriptor.settingValueType == STRING && descriptor.defaultValue.string == nullptr))
+        {
+            results[i] = INVALID_INPUT_ERROR;
+            continue;
+        }
+        if (registration != NO_ERROR)
+        {
+            results[i] = registration;
+            continue;
+        }
 
-    if (SettingError_t result = getSettingValue(key, outputValue); result != NO_ERROR)
-    {
-        return result;
+        SettingValue_t newValue     = {};
+        newValue.settingPermissions = descriptor.settingPermissions;
+        newValue.settingValueType   = descriptor.settingValueType;
+        if (descriptor.settingValueType == STRING)
+        {
+            setStaticStringData(newValue.settingDefaultValueData, descriptor.defaultValue.string);
+            shareStringData(newValue.settingValueData, newValue.settingDefaultValueData);
+        }
+        else if (descriptor.settingValueType == INTEGER)
+        {
+            newValue.settingValueData.integer        = descriptor.defaultValue.integer;
+            newValue.settingDefaultValueData.integer = descriptor.defaultValue.integer;
+        }
+        else
+        {
+            newValue.settingValueData.real        = descriptor.defaultValue.real;
+            newValue.settingDefaultValueData.real = descriptor.defaultValue.real;
+        }
+
+        keys.push_back(descriptor.key);
+        keyLengths.push_back(static_cast<int>(strnlen(descriptor.key, MAX_SETTING_KEY_SIZE)));
+        values.push_back(newValue);
+        positions.push_back(i);
     }
 
-    if (outputValue->settingValueType != INTEGER)
+    // The new settings hold no heap buffer, so nothing has to be released for the keys that already exist.
+    std::vector<SettingValue_t*> existingValues(values.size());
+    std::vector<SettingValue_t*> insertedValues(values.size());
+    const bool                   inserted = this->settings->insertInlineBatchIfNotExists(
+        keys.data(), keyLengths.data(), values.size(), values.data(), existingValues.data(), insertedValues.data());
+    bool                         created  = false;
+    // A tree that is not locked as a whole may insert part of the batch, so each key is checked on its own.
+    for (size_t i = 0; i < values.size(); i++)
     {
-        return TYPE_MISMATCH_ERROR;
+        if (insertedValues[i] != nullptr)
+        {
+            created = true;
+        }
+        else if (existingValues[i] != nullptr)
+        {
+            results[positions[i]] = KEY_EXISTS_ERROR;
+        }
+        else if (!inserted)
+        {
+            results[positions[i]] = LOCK_TIMEOUT_ERROR;
+        }
+    }
+    if (created)
+    {
+        // The whole batch is a single change of the store.
+        const uint64_t newGeneration = nextGeneration();
+        for (SettingValue_t* insertedValue : insertedValues)
+        {
+            if (insertedValue != nullptr)
+            {
+                stampCreatedSetting(insertedValue, newGeneration);
+            }
+        }
+        readCache.invalidate();
+    }
+    if (registration == NO_ERROR)
+    {
+        endRegistration();
     }
 
-    outputValue->settingValueData.integer = value;
-
-    return NO_ERROR;
+    SettingError_t result = NO_ERROR;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (result == NO_ERROR)
+        {
+            result = results[i];
+        }
+        if (outputResults != nullptr)
+        {
+            outputResults[i] = results[i];
+        }
+    }
+    return result;
 }
 
-SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsReal(const char* key, const double value) const
+SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsInt(const char* key, const int64_t value) const
 {
-    SettingValue_t* outputValue;
-
-    if (SettingError_t result = getSettingValue(key, outputValue); result != NO_ERROR)
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, INTEGER, handle); result != NO_ERROR)
     {
         return result;
     }
 
-    if (outputValue->settingValueType != REAL)
+    return putSettingValueAsInt(handle, value);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsReal(const char* key, const double value) const
+{
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, REAL, handle); result != NO_ERROR)
     {
-        return TYPE_MISMATCH_ERROR;
+        return result;
     }
 
-    outputValue->settingValueData.real = value;
-
-    return NO_ERROR;
+    return putSettingValueAsReal(handle, value);
 }
 
 SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsString(const char* key, const char* value) const
@@ -706,23 +1066,14 @@ SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsString(const c
         return INVALID_INPUT_ERROR;
     }
 
-    SettingValue_t* outputValue;
-
-    if (SettingError_t result = getSettingValue(key, outputValue); result != NO_ERROR)
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, STRING, handle); result != NO_ERROR)
     {
         return result;
     }
 
-    if (outputValue->settingValueType != STRING)
-    {
-        return TYPE_MISMATCH_ERROR;
-    }
-
-    free(outputValue->settingValueData.string);
-    outputValue->settingValueData.string = strdup(value);
-
-    return NO_ERROR;
-}
+    return putSettingValueAsString(handle, value);
+}
 
 SettingsStorage::SettingError_t SettingsStorage::getDefaultSettingAsInt(const char* key, int64_t& outputValue,
                                                                         SettingPermissions_t* outputPermissions) const
@@ -743,6 +1094,392 @@ SettingsStorage::getDefaultSettingAsString(const char* key, char* outputValueBuf
     return getSettingValueAsString(DefaultValue, key, outputValueBuffer, outputValueSize, outputPermissions);
 }
 
+NodeAllocatorStats_t SettingsStorage::getSettingsTreeMemoryStats() const
+{
+    return settings->getNodeAllocatorStats();
+}
+
+LockStats_t SettingsStorage::getSettingsTreeLockStats() const
+{
+    return settings->getLockStats();
+}
+
+uint64_t SettingsStorage::getGeneration() const
+{
+    return generation.load(std::memory_order_acquire);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::freeze()
+{
+    if (isFrozen())
+    {
+        return NO_ERROR;
+    }
+
+    // The registrations that start from now on fail, see beginRegistration(). The ones already running would insert
+    // settings that the index may miss, so the storage is not frozen until they are done.
+    freezes.fetch_add(1, std::memory_order_seq_cst);
+    if (registrations.load(std::memory_order_seq_cst) != 0)
+    {
+        freezes.fetch_sub(1, std::memory_order_release);
+        return LOCK_TIMEOUT_ERROR;
+    }
+
+    auto*     index = new FrozenIndex_t();
+    const int res   = settings->iterateOverAll(freezeCallback, index);
+    if (res != 0 || !index->build())
+    {
+        delete index;
+        freezes.fetch_sub(1, std::memory_order_release);
+        return res == TREE_LOCK_TIMEOUT ? LOCK_TIMEOUT_ERROR : FATAL_ERROR;
+    }
+
+    // If another freeze() published its index meanwhile, that one is kept, as both hold the same settings.
+    FrozenIndex_t* expected = nullptr;
+    if (!frozenIndex.compare_exchange_strong(expected, index, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+        delete index;
+    }
+    freezes.fetch_sub(1, std::memory_order_release);
+    return NO_ERROR;
+}
+
+bool SettingsStorage::isFrozen() const
+{
+    return frozenIndex.load(std::memory_order_acquire) != nullptr;
+}
+
+bool SettingsStorage::hasUnsavedChanges() const
+{
+    return unsavedChanges.load(std::memory_order_acquire);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::subscribe(const char*                    keyPrefix,
+                                                           const SettingsChangeCallback_t callback, void* userData,
+                                                           uint32_t& outputSubscriptionId) const
+{
+    if (keyPrefix == nullptr || callback == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    const uint32_t subscriptionId = changeDispatcher->subscribe(keyPrefix, callback, userData);
+    if (subscriptionId == SettingsChangeDispatcher::INVALID_SUBSCRIPTION)
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+    outputSubscriptionId = subscriptionId;
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::unsubscribe(const uint32_t subscriptionId) const
+{
+    switch (changeDispatcher->unsubscribe(subscriptionId))
+    {
+        case SettingsChangeDispatcher::UNSUBSCRIBED:
+            return NO_ERROR;
+        case SettingsChangeDispatcher::SUBSCRIPTION_NOT_FOUND:
+            return KEY_NOT_FOUND_ERROR;
+        default:
+            return LOCK_TIMEOUT_ERROR;
+    }
+}
+
+bool SettingsStorage::dispatchChangeNotifications(const uint32_t timeoutMs) const
+{
+    return changeDispatcher->dispatch(timeoutMs);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::resolveSetting(const char* key, const SettingValueType_t type,
+                                                                SettingHandle_t& outputHandle) const
+{
+    SettingValue_t* value;
+    if (SettingError_t result = getSettingValue(key, value); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    if (value->settingValueType != type)
+    {
+        return TYPE_MISMATCH_ERROR;
+    }
+
+    outputHandle.settingValue     = value;
+    outputHandle.settingValueType = type;
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingAsInt(const SettingHandle_t& handle, int64_t& outputValue,
+                                                                 SettingPermissions_t* outputPermissions) const
+{
+    return getSettingValueAsInt(Value, handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingAsReal(const SettingHandle_t& handle, double& outputValue,
+                                                                  SettingPermissions_t* outputPermissions) const
+{
+    return getSettingValueAsReal(Value, handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingAsString(const SettingHandle_t& handle,
+                                                                    char*                  outputValueBuffer,
+                                                                    const size_t           outputValueSize,
+                                                                    SettingPermissions_t*  outputPermissions) const
+{
+    return getSettingValueAsString(Value, handle, outputValueBuffer, outputValueSize, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::leaseSettingAsString(const SettingHandle_t& handle,
+                                                                      SettingStringLease&    outputLease,
+                                                                      SettingPermissions_t*  outputPermissions) const
+{
+    if (handle.settingValue == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != STRING)
+    {
+        return TYPE_MISMATCH_ERROR;
+    }
+
+    if (!leaseStringData(handle.settingValue->settingValueData, outputLease))
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+    if (outputPermissions != nullptr)
+    {
+        *outputPermissions = handle.settingValue->settingPermissions;
+    }
+
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingGeneration(const SettingHandle_t& handle,
+                                                                      uint64_t&              outputGeneration) const
+{
+    if (handle.settingValue == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    outputGeneration = std::atomic_ref(handle.settingValue->settingGeneration).load(std::memory_order_acquire);
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::getSettingWithGenerationAsInt(const SettingHandle_t& handle, int64_t& outputValue,
+                                               uint64_t&             outputGeneration,
+                                               SettingPermissions_t* outputPermissions) const
+{
+    // The generation is read before the value, so the value is at least as recent as it.
+    if (SettingError_t result = getSettingGeneration(handle, outputGeneration); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return getSettingAsInt(handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::getSettingWithGenerationAsReal(const SettingHandle_t& handle, double& outputValue,
+                                                uint64_t&             outputGeneration,
+                                                SettingPermissions_t* outputPermissions) const
+{
+    if (SettingError_t result = getSettingGeneration(handle, outputGeneration); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return getSettingAsReal(handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::leaseSettingWithGenerationAsString(const SettingHandle_t& handle, SettingStringLease& outputLease,
+                                                    uint64_t&             outputGeneration,
+                                                    SettingPermissions_t* outputPermissions) const
+{
+    if (SettingError_t result = getSettingGeneration(handle, outputGeneration); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    return leaseSettingAsString(handle, outputLease, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsInt(const SettingHandle_t& handle,
+                                                                      const int64_t          value) const
+{
+    if (handle.settingValue == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != INTEGER)
+    {
+        return TYPE_MISMATCH_ERROR;
+    }
+
+    uint32_t sequence;
+    if (!beginValuesWrite(sequence))
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+    std::atomic_ref(handle.settingValue->settingValueData.integer).store(value, std::memory_order_release);
+    endValuesWrite(sequence);
+    noteSettingWritten(handle.settingValue);
+
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsReal(const SettingHandle_t& handle,
+                                                                       const double           value) const
+{
+    if (handle.settingValue == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != REAL)
+    {
+        return TYPE_MISMATCH_ERROR;
+    }
+
+    uint32_t sequence;
+    if (!beginValuesWrite(sequence))
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+    std::atomic_ref(handle.settingValue->settingValueData.real).store(value, std::memory_order_release);
+    endValuesWrite(sequence);
+    noteSettingWritten(handle.settingValue);
+
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::putSettingValueAsString(const SettingHandle_t& handle,
+                                                                         const char*            value) const
+{
+    if (handle.settingValue == nullptr || value == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != STRING)
+    {
+        return TYPE_MISMATCH_ERROR;
+    }
+
+    SettingValueData_t valueData;
+    setStringData(valueData, value);
+    if (!replaceStringData(handle.settingValue->settingValueData, valueData))
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+    noteSettingWritten(handle.settingValue);
+
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getDefaultSettingAsInt(const SettingHandle_t& handle,
+                                                                        int64_t&               outputValue,
+                                                                        SettingPermissions_t*  outputPermissions) const
+{
+    return getSettingValueAsInt(DefaultValue, handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getDefaultSettingAsReal(const SettingHandle_t& handle,
+                                                                         double&                  outputValue,
+                                                                         SettingPermissions_t*  outputPermissions) const
+{
+    return getSettingValueAsReal(DefaultValue, handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t
+SettingsStorage::getDefaultSettingAsString(const SettingHandle_t& handle, char* outputValueBuffer,
+                                           const size_t outputValueSize, SettingPermissions_t* outputPermissions) const
+{
+    return getSettingValueAsString(DefaultValue, handle, outputValueBuffer, outputValueSize, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingsBatch(SettingBatchGet_t* gets, const size_t count) const
+{
+    if (gets == nullptr)
+    {
+        return count == 0 ? NO_ERROR : INVALID_INPUT_ERROR;
+    }
+
+    std::vector<const char*>     keys(count);
+    std::vector<int>             keyLengths(count);
+    std::vector<SettingValue_t*> values(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        keys[i]       = gets[i].key != nullptr ? gets[i].key : "";
+        keyLengths[i] = static_cast<int>(strnlen(keys[i], MAX_SETTING_KEY_SIZE));
+    }
+
+    if (const FrozenIndex_t* index = frozenIndex.load(std::memory_order_acquire); index != nullptr)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            values[i] = index->search(keys[i], static_cast<uint32_t>(keyLengths[i]));
+        }
+    }
+    else if (!this->settings->searchBatch(keys.data(), keyLengths.data(), count, values.data()))
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+
+    // The values are read again if a transaction was committed meanwhile, so all its updates or none are returned.
+    uint32_t sequence;
+    do
+    {
+        if (!waitForValues(sequence))
+        {
+            return LOCK_TIMEOUT_ERROR;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            SettingBatchGet_t&    get    = gets[i];
+            const SettingHandle_t handle = {values[i], get.settingValueType};
+            if (keyLengths[i] == 0)
+            {
+                get.result = INVALID_INPUT_ERROR;
+            }
+            else if (handle.settingValue == nullptr)
+            {
+                get.result = KEY_NOT_FOUND_ERROR;
+            }
+            else if (handle.settingValue->settingValueType != get.settingValueType)
+            {
+                get.result = TYPE_MISMATCH_ERROR;
+            }
+            else if (get.settingValueType == INTEGER)
+            {
+                get.result = get.outputValue.integer == nullptr
+                                 ? INVALID_INPUT_ERROR
+                                 : getSettingValueAsInt(Value, handle, *get.outputValue.integer, get.outputPermissions);
+            }
+            else if (get.settingValueType == REAL)
+            {
+                get.result = get.outputValue.real == nullptr
+                                 ? INVALID_INPUT_ERROR
+                                 : getSettingValueAsReal(Value, handle, *get.outputValue.real, get.outputPermissions);
+            }
+            else
+            {
+                get.result = getSettingValueAsString(Value, handle, get.outputValue.string, get.outputValueSize,
+                                                     get.outputPermissions);
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (valuesSequence.load(std::memory_order_relaxed) != sequence);
+
+    return NO_ERROR;
+}
+
 bool validatePermissions(const SettingPermissions_t permissions)
 {
     return permissions <= ALL_PERMISSIONS_VOLATILE;
@@ -755,12 +1492,30 @@ SettingsStorage::SettingError_t SettingsStorage::getSettingValue(const char* key
         return INVALID_INPUT_ERROR;
     }
 
-    outputValue = this->settings->search(key, static_cast<int>(strnlen(key, MAX_SETTING_KEY_SIZE)));
+    const auto keyLength = static_cast<uint32_t>(strnlen(key, MAX_SETTING_KEY_SIZE));
+    uint64_t   cacheGeneration;
+
+    // A key this thread already read is found without taking the tree lock nor descending the tree.
+    outputValue = readCache.lookup(key, keyLength, cacheGeneration);
+    if (outputValue != nullptr)
+    {
+        return NO_ERROR;
+    }
+
+    if (const FrozenIndex_t* index = frozenIndex.load(std::memory_order_acquire); index != nullptr)
+    {
+        outputValue = index->search(key, keyLength);
+    }
+    else if (!this->settings->trySearch(key, static_cast<int>(keyLength), outputValue))
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
     if (outputValue == nullptr)
     {
         return KEY_NOT_FOUND_ERROR;
     }
 
+    readCache.store(key, keyLength, outputValue, cacheGeneration);
     return NO_ERROR;
 }
 
@@ -768,26 +1523,43 @@ SettingsStorage::SettingError_t SettingsStorage::getSettingValueAsInt(TypeofSett
                                                                       int64_t&              outputValue,
                                                                       SettingPermissions_t* outputPermissions) const
 {
-    SettingValue_t* value;
-    if (SettingError_t result = getSettingValue(key, value); result != NO_ERROR)
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, INTEGER, handle); result != NO_ERROR)
     {
         return result;
     }
 
-    if (value->settingValueType != INTEGER)
+    return getSettingValueAsInt(type, handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingValueAsInt(const TypeofSettingValue type,
+                                                                      const SettingHandle_t&   handle,
+                                                                      int64_t&                 outputValue,
+                                                                      SettingPermissions_t*    outputPermissions)
+{
+    if (handle.settingValue == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != INTEGER)
     {
         return TYPE_MISMATCH_ERROR;
     }
 
     if (outputPermissions != nullptr)
     {
-        *outputPermissions = value->settingPermissions;
+        *outputPermissions = handle.settingValue->settingPermissions;
     }
 
-    outputValue = value->settingValueData.integer;
+    // The default value never changes once registered, while the value may be updated concurrently.
     if (type == DefaultValue)
     {
-        outputValue = value->settingDefaultValueData.integer;
+        outputValue = handle.settingValue->settingDefaultValueData.integer;
+    }
+    else
+    {
+        outputValue = std::atomic_ref(handle.settingValue->settingValueData.integer).load(std::memory_order_acquire);
     }
 
     return NO_ERROR;
@@ -797,26 +1569,42 @@ SettingsStorage::SettingError_t SettingsStorage::getSettingValueAsReal(TypeofSet
                                                                        double&               outputValue,
                                                                        SettingPermissions_t* outputPermissions) const
 {
-    SettingValue_t* value;
-    if (SettingError_t result = getSettingValue(key, value); result != NO_ERROR)
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, REAL, handle); result != NO_ERROR)
     {
         return result;
     }
 
-    if (value->settingValueType != REAL)
+    return getSettingValueAsReal(type, handle, outputValue, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingValueAsReal(const TypeofSettingValue type,
+                                                                       const SettingHandle_t&   handle,
+                                                                       double&                  outputValue,
+                                                                       SettingPermissions_t*    outputPermissions)
+{
+    if (handle.settingValue == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != REAL)
     {
         return TYPE_MISMATCH_ERROR;
     }
 
     if (outputPermissions != nullptr)
     {
-        *outputPermissions = value->settingPermissions;
+        *outputPermissions = handle.settingValue->settingPermissions;
     }
 
-    outputValue = value->settingValueData.real;
     if (type == DefaultValue)
     {
-        outputValue = value->settingDefaultValueData.real;
+        outputValue = handle.settingValue->settingDefaultValueData.real;
+    }
+    else
+    {
+        outputValue = std::atomic_ref(handle.settingValue->settingValueData.real).load(std::memory_order_acquire);
     }
 
     return NO_ERROR;
@@ -832,35 +1620,52 @@ SettingsStorage::SettingError_t SettingsStorage::getSettingValueAsString(const T
         return INVALID_INPUT_ERROR;
     }
 
-    SettingValue_t* value;
-    if (SettingError_t result = getSettingValue(key, value); result != NO_ERROR)
+    SettingHandle_t handle = {};
+    if (SettingError_t result = resolveSetting(key, STRING, handle); result != NO_ERROR)
     {
         return result;
     }
 
-    if (value->settingValueType != STRING)
+    return getSettingValueAsString(type, handle, outputValueBuffer, outputValueSize, outputPermissions);
+}
+
+SettingsStorage::SettingError_t SettingsStorage::getSettingValueAsString(const TypeofSettingValue type,
+                                                                         const SettingHandle_t&   handle,
+                                                                         char*                    outputValueBuffer,
+                                                                         const size_t             outputValueSize,
+                                                                         SettingPermissions_t* outputPermissions) const
+{
+    if (handle.settingValue == nullptr || outputValueBuffer == nullptr)
+    {
+        return INVALID_INPUT_ERROR;
+    }
+
+    if (handle.settingValueType != STRING)
     {
         return TYPE_MISMATCH_ERROR;
     }
 
-    const char* outputValue = value->settingValueData.string;
-    if (type == DefaultValue)
+    // The default values never change, while the heap buffer of a value stays alive until the guard is released.
+    EpochGuard         guard(stringEpochManager);
+    SettingValueData_t valueData = handle.settingValue->settingDefaultValueData;
+    if (type == Value && !readStringData(handle.settingValue->settingValueData, valueData))
     {
-        outputValue = value->settingDefaultValueData.string;
+        return LOCK_TIMEOUT_ERROR;
     }
+    const char* outputValue = getStringData(valueData);
 
-    if (strlen(outputValue) >= outputValueSize) // Only allow the string to be copied if it fits in the buffer. (The ==
-                                                // is to account for the null terminator)
+    const size_t outputValueLength = strlen(outputValue);
+    if (outputValueLength >= outputValueSize) // Only allow the string to be copied if it fits in the buffer. (The ==
+                                              // is to account for the null terminator)
     {
         return INSUFFICIENT_BUFFER_SIZE_ERROR;
     }
 
     if (outputPermissions != nullptr)
     {
-        *outputPermissions = value->settingPermissions;
+        *outputPermissions = handle.settingValue->settingPermissions;
     }
-    strncpy(outputValueBuffer, outputValue, outputValueSize);
-    outputValueBuffer[outputValueSize] = '\0';
+    memcpy(outputValueBuffer, outputValue, outputValueLength + 1);
 
     return NO_ERROR;
 }
@@ -869,8 +1674,361 @@ void SettingsStorage::freeSettingValue(const SettingValue_t* settingValue)
 {
     if (settingValue->settingValueType == STRING)
     {
-        free(settingValue->settingValueData.string);
-        free(settingValue->settingDefaultValueData.string);
+        freeStringData(settingValue->settingValueData);
+        freeStringData(settingValue->settingDefaultValueData);
+    }
+}
+
+SettingsStorage::SettingError_t SettingsStorage::insertSetting(const char* key, SettingValue_t& newValue) const
+{
+    if (const SettingError_t result = beginRegistration(); result != NO_ERROR)
+    {
+        return result;
+    }
+
+    SettingValue_t* existingValue;
+    SettingValue_t* insertedValue;
+    const bool      inserted = this->settings->tryInsertInlineIfNotExists(
+        key, static_cast<int>(strnlen(key, MAX_SETTING_KEY_SIZE)), newValue, existingValue, &insertedValue);
+    endRegistration();
+    if (!inserted)
+    {
+        return LOCK_TIMEOUT_ERROR;
+    }
+    if (existingValue != nullptr)
+    {
+        return KEY_EXISTS_ERROR;
+    }
+    stampCreatedSetting(insertedValue, nextGeneration());
+    readCache.invalidate();
+    return NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsStorage::beginRegistration() const
+{
+    // Pairs with freeze(), which announces itself before checking the registrations: either the freeze sees this
+    // registration and gives up, or this registration sees the freeze. A freeze that ended is seen as published.
+    registrations.fetch_add(1, std::memory_order_seq_cst);
+    const bool freezing = freezes.load(std::memory_order_seq_cst) != 0;
+    if (isFrozen())
+    {
+        endRegistration();
+        return SETTINGS_FROZEN_ERROR;
+    }
+    if (freezing)
+    {
+        endRegistration();
+        return LOCK_TIMEOUT_ERROR;
+    }
+    return NO_ERROR;
+}
+
+void SettingsStorage::endRegistration() const
+{
+    registrations.fetch_sub(1, std::memory_order_release);
+}
+
+void SettingsStorage::markUnsavedChanges() const
+{
+    // Most puts find the mark already set, and only read it.
+    if (!unsavedChanges.load(std::memory_order_relaxed))
+    {
+        unsavedChanges.store(true, std::memory_order_release);
+    }
+}
+
+uint64_t SettingsStorage::nextGeneration() const
+{
+    return generation.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void SettingsStorage::stampCreatedSetting(SettingValue_t* settingValue, const uint64_t settingGeneration)
+{
+    // A setting is only stamped once it is created, so a failed registration leaves the store generation as it was.
+    // Until then it has generation 0, which no write has, and a put that won the race keeps its own generation.
+    uint64_t unstamped = 0;
+    std::atomic_ref(settingValue->settingGeneration)
+        .compare_exchange_strong(unstamped, settingGeneration, std::memory_order_release, std::memory_order_relaxed);
+}
+
+void SettingsStorage::markSettingChanged(SettingValue_t* settingValue) const
+{
+    // The generation is published after the value, so a reader that sees it also sees the value.
+    std::atomic_ref(settingValue->settingGeneration).store(nextGeneration(), std::memory_order_release);
+
+    // Without subscriptions, a put only pays for this check. The value is already written, so a change that cannot
+    // be queued in time is dropped rather than failing the put.
+    if (changeDispatcher->hasSubscribers())
+    {
+        changeDispatcher->notifyChange(settingValue);
+    }
+}
+
+void SettingsStorage::noteSettingWritten(SettingValue_t* settingValue) const
+{
+    if (!static_cast<bool>(settingValue->settingPermissions & SettingPermissions_t::VOLATILE))
+    {
+        markUnsavedChanges();
+    }
+    markSettingChanged(settingValue);
+}
+
+void SettingsStorage::setStringData(SettingValueData_t& data, const char* value)
+{
+    const size_t length = strlen(value);
+    memset(&data, 0, sizeof(data));
+    if (length <= SHORT_STRING_MAX_LENGTH)
+    {
+        memcpy(data.shortString, value, length + 1);
+        data.shortString[SHORT_STRING_MAX_LENGTH + 1] = SHORT_STRING_TAG;
+    }
+    else
+    {
+        void* buffer = malloc(sizeof(SharedString_t) + length + 1);
+        assert(buffer != nullptr && "Memory allocation failed");
+
+        auto* sharedString = new (buffer) SharedString_t();
+        sharedString->references.store(1, std::memory_order_relaxed);
+        sharedString->length = static_cast<uint32_t>(length);
+        data.string = reinterpret_cast<char*>(sharedString + 1);
+        memcpy(data.string, value, length + 1);
+    }
+}
+
+void SettingsStorage::setStaticStringData(SettingValueData_t& data, const char* value)
+{
+    if (strlen(value) <= SHORT_STRING_MAX_LENGTH)
+    {
+        setStringData(data, value);
+        return;
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.string                                   = const_cast<char*>(value);
+    data.shortString[SHORT_STRING_MAX_LENGTH + 1] = STATIC_STRING_TAG;
+}
+
+const char* SettingsStorage::getStringData(const SettingValueData_t& data)
+{
+    return data.shortString[SHORT_STRING_MAX_LENGTH + 1] == SHORT_STRING_TAG ? data.shortString : data.string;
+}
+
+void SettingsStorage::shareStringData(SettingValueData_t& destination, const SettingValueData_t& source)
+{
+    destination = source;
+    if (source.shortString[SHORT_STRING_MAX_LENGTH + 1] == SHARED_STRING_TAG)
+    {
+        reinterpret_cast<SharedString_t*>(source.string)[-1].references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SettingsStorage::freeStringData(const SettingValueData_t& data)
+{
+    if (data.shortString[SHORT_STRING_MAX_LENGTH + 1] == SHARED_STRING_TAG)
+    {
+        SharedString_t* sharedString = reinterpret_cast<SharedString_t*>(data.string) - 1;
+        if (sharedString->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            sharedString->~SharedString_t();
+            free(sharedString);
+        }
+    }
+}
+
+void SettingsStorage::releaseStringData(const SettingValueData_t& data) const
+{
+    if (data.shortString[SHORT_STRING_MAX_LENGTH + 1] == SHARED_STRING_TAG)
+    {
+        SharedString_t* sharedString = reinterpret_cast<SharedString_t*>(data.string) - 1;
+        if (sharedString->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Readers that copied the data before it was replaced may still be trying to reference the buffer.
+            stringEpochManager.retire(sharedString, reclaimSharedString, nullptr);
+        }
+    }
+}
+
+void SettingsStorage::reclaimSharedString(void* context, void* object)
+{
+    (void)context;
+    auto* sharedString = static_cast<SharedString_t*>(object);
+    sharedString->~SharedString_t();
+    free(sharedString);
+}
+
+bool SettingsStorage::beginValuesWrite(uint32_t& outputSequence) const
+{
+    if (!valuesWriteMutex->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
+    {
+        return false;
+    }
+    outputSequence = valuesSequence.load(std::memory_order_relaxed);
+    valuesSequence.store(outputSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+void SettingsStorage::endValuesWrite(const uint32_t sequence) const
+{
+    valuesSequence.store(sequence + 2, std::memory_order_release);
+    valuesWriteMutex->signal();
+}
+
+bool SettingsStorage::waitForValues(uint32_t& outputSequence) const
+{
+    while ((outputSequence = valuesSequence.load(std::memory_order_acquire)) % 2 != 0)
+    {
+        // The writer holds the mutex until its values are written.
+        if (!valuesWriteMutex->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
+        {
+            return false;
+        }
+        valuesWriteMutex->signal();
+    }
+    return true;
+}
+
+SettingsStorage::SettingValueData_t SettingsStorage::loadValueData(const SettingValueData_t& data)
+{
+    SettingValueData_t copy;
+    auto*              source      = reinterpret_cast<uintptr_t*>(const_cast<SettingValueData_t*>(&data));
+    auto*              destination = reinterpret_cast<uintptr_t*>(&copy);
+    for (size_t i = 0; i < sizeof(SettingValueData_t) / sizeof(uintptr_t); i++)
+    {
+        destination[i] = std::atomic_ref(source[i]).load(std::memory_order_relaxed);
+    }
+    return copy;
+}
+
+void SettingsStorage::storeValueData(SettingValueData_t& data, const SettingValueData_t& newData)
+{
+    auto*       destination = reinterpret_cast<uintptr_t*>(&data);
+    const auto* source      = reinterpret_cast<const uintptr_t*>(&newData);
+    for (size_t i = 0; i < sizeof(SettingValueData_t) / sizeof(uintptr_t); i++)
+    {
+        std::atomic_ref(destination[i]).store(source[i], std::memory_order_relaxed);
+    }
+}
+
+bool SettingsStorage::replaceStringData(SettingValueData_t& data, const SettingValueData_t& newData) const
+{
+    uint32_t sequence;
+    if (!beginValuesWrite(sequence))
+    {
+        // The new data was never reachable by readers.
+        freeStringData(newData);
+        return false;
+    }
+
+    // The writers are serialized by the values sequence, so the previous data can be read without atomic loads.
+    const SettingValueData_t oldData = data;
+    storeValueData(data, newData);
+    endValuesWrite(sequence);
+
+    releaseStringData(oldData);
+    return true;
+}
+
+bool SettingsStorage::readStringData(const SettingValueData_t& data, SettingValueData_t& outputData) const
+{
+    uint32_t sequence;
+    do
+    {
+        if (!waitForValues(sequence))
+        {
+            return false;
+        }
+        outputData = loadValueData(data);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (valuesSequence.load(std::memory_order_relaxed) != sequence);
+    return true;
+}
+
+bool SettingsStorage::leaseStringData(const SettingValueData_t& data, SettingStringLease& outputLease) const
+{
+    outputLease.release();
+
+    EpochGuard         guard(stringEpochManager);
+    SettingValueData_t snapshot;
+    bool               leased;
+    do
+    {
+        if (!readStringData(data, snapshot))
+        {
+            return false;
+        }
+        leased = true;
+        if (snapshot.shortString[SHORT_STRING_MAX_LENGTH + 1] == SHARED_STRING_TAG)
+        {
+            // A buffer whose last reference was released is retired, so it must not be referenced again. The data was
+            // replaced in that case, so it is read again.
+            std::atomic<uint32_t>& references = (reinterpret_cast<SharedString_t*>(snapshot.string) - 1)->references;
+            uint32_t               count      = references.load(std::memory_order_relaxed);
+            while (count != 0 &&
+                   !references.compare_exchange_weak(count, count + 1, std::memory_order_acquire,
+                                                     std::memory_order_relaxed))
+            {
+            }
+            leased = count != 0;
+        }
+    } while (!leased);
+
+    outputLease.settingsStorage = this;
+    outputLease.data            = snapshot;
+    switch (snapshot.shortString[SHORT_STRING_MAX_LENGTH + 1])
+    {
+        case SHARED_STRING_TAG:
+            outputLease.length = (reinterpret_cast<SharedString_t*>(snapshot.string) - 1)->length;
+            break;
+        case SHORT_STRING_TAG:
+            outputLease.length = strlen(snapshot.shortString);
+            break;
+        default:
+            outputLease.length = strlen(snapshot.string);
+    }
+    return true;
+}
+
+SettingsStorage::SettingStringLease::~SettingStringLease()
+{
+    release();
+}
+
+SettingsStorage::SettingStringLease::SettingStringLease(SettingStringLease&& other) noexcept
+{
+    settingsStorage       = other.settingsStorage;
+    data                  = other.data;
+    length                = other.length;
+    other.settingsStorage = nullptr;
+}
+
+SettingsStorage::SettingStringLease& SettingsStorage::SettingStringLease::operator=(SettingStringLease&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        settingsStorage       = other.settingsStorage;
+        data                  = other.data;
+        length                = other.length;
+        other.settingsStorage = nullptr;
+    }
+    return *this;
+}
+
+std::string_view SettingsStorage::SettingStringLease::view() const
+{
+    if (settingsStorage == nullptr)
+    {
+        return {};
+    }
+    return {getStringData(data), length};
+}
+
+void SettingsStorage::SettingStringLease::release()
+{
+    if (settingsStorage != nullptr)
+    {
+        settingsStorage->releaseStringData(data);
+        settingsStorage = nullptr;
     }
-    delete settingValue;
 }
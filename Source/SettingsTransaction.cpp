@@ -0,0 +1,145 @@
+#include "SettingsTransaction.h"
+
+SettingsTransaction::SettingsTransaction(const SettingsStorage& settingsStorage)
+{
+    this->settingsStorage = &settingsStorage;
+    this->firstError      = SettingsStorage::NO_ERROR;
+}
+
+SettingsTransaction::~SettingsTransaction()
+{
+    clear();
+}
+
+SettingsStorage::SettingError_t SettingsTransaction::putSettingValueAsInt(const char* key, const int64_t value)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolve(key, SettingsStorage::INTEGER, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    stagedPuts.push_back({handle, {.integer = value}});
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsTransaction::putSettingValueAsReal(const char* key, const double value)
+{
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolve(key, SettingsStorage::REAL, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    stagedPuts.push_back({handle, {.real = value}});
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsTransaction::putSettingValueAsString(const char* key, const char* value)
+{
+    if (value == nullptr)
+    {
+        if (firstError == SettingsStorage::NO_ERROR)
+        {
+            firstError = SettingsStorage::INVALID_INPUT_ERROR;
+        }
+        return SettingsStorage::INVALID_INPUT_ERROR;
+    }
+
+    SettingsStorage::SettingHandle_t handle = {};
+    if (SettingsStorage::SettingError_t result = resolve(key, SettingsStorage::STRING, handle);
+        result != SettingsStorage::NO_ERROR)
+    {
+        return result;
+    }
+
+    StagedPut_t stagedPut = {handle, {}};
+    SettingsStorage::setStringData(stagedPut.value, value);
+    stagedPuts.push_back(stagedPut);
+    return SettingsStorage::NO_ERROR;
+}
+
+SettingsStorage::SettingError_t SettingsTransaction::commit()
+{
+    if (firstError != SettingsStorage::NO_ERROR)
+    {
+        const SettingsStorage::SettingError_t result = firstError;
+        clear();
+        return result;
+    }
+
+    // Readers of several settings retry while the values are being written, see getSettingsBatch().
+    uint32_t sequence;
+    if (!settingsStorage->beginValuesWrite(sequence))
+    {
+        clear();
+        return SettingsStorage::LOCK_TIMEOUT_ERROR;
+    }
+
+    for (StagedPut_t& stagedPut : stagedPuts)
+    {
+        SettingsStorage::SettingValue_t* settingValue = stagedPut.handle.settingValue;
+        if (stagedPut.handle.settingValueType == SettingsStorage::INTEGER)
+        {
+            std::atomic_ref(settingValue->settingValueData.integer)
+                .store(stagedPut.value.integer, std::memory_order_relaxed);
+        }
+        else if (stagedPut.handle.settingValueType == SettingsStorage::REAL)
+        {
+            std::atomic_ref(settingValue->settingValueData.real).store(stagedPut.value.real, std::memory_order_relaxed);
+        }
+        else
+        {
+            // Readers may copy the string data meanwhile, so it is published with atomic stores. The previous string
+            // is released once out of the write section.
+            const SettingsStorage::SettingValueData_t previousData = settingValue->settingValueData;
+            SettingsStorage::storeValueData(settingValue->settingValueData, stagedPut.value);
+            stagedPut.value = previousData;
+        }
+    }
+
+    settingsStorage->endValuesWrite(sequence);
+
+    for (const StagedPut_t& stagedPut : stagedPuts)
+    {
+        if (stagedPut.handle.settingValueType == SettingsStorage::STRING)
+        {
+            settingsStorage->releaseStringData(stagedPut.value);
+        }
+        settingsStorage->noteSettingWritten(stagedPut.handle.settingValue);
+    }
+    stagedPuts.clear();
+    return SettingsStorage::NO_ERROR;
+}
+
+size_t SettingsTransaction::size() const
+{
+    return stagedPuts.size();
+}
+
+SettingsStorage::SettingError_t SettingsTransaction::resolve(const char*                               key,
+                                                             const SettingsStorage::SettingValueType_t type,
+                                                             SettingsStorage::SettingHandle_t&         outputHandle)
+{
+    const SettingsStorage::SettingError_t result = settingsStorage->resolveSetting(key, type, outputHandle);
+    if (result != SettingsStorage::NO_ERROR && firstError == SettingsStorage::NO_ERROR)
+    {
+        firstError = result;
+    }
+    return result;
+}
+
+void SettingsTransaction::clear()
+{
+    for (const StagedPut_t& stagedPut : stagedPuts)
+    {
+        if (stagedPut.handle.settingValueType == SettingsStorage::STRING)
+        {
+            SettingsStorage::freeStringData(stagedPut.value);
+        }
+    }
+    stagedPuts.clear();
+    firstError = SettingsStorage::NO_ERROR;
+}
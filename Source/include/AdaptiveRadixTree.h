@@ -0,0 +1,2049 @@
+#ifndef ADAPTIVERADIXTREE_H
+#define ADAPTIVERADIXTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "LockStatistics.h"
+#include "NodeAllocator.h"
+
+/**
+ * Callback invoked for each entry while iterating over an AdaptiveRadixTree.
+ * The key is null terminated. Returning a non-zero value stops the iteration.
+ */
+typedef int (*art_callback)(void* data, const unsigned char* key, uint32_t key_len, void* value);
+
+/**
+ * Filter invoked on the inner nodes while iterating over an AdaptiveRadixTree, with the OR (anyBits) and the AND
+ * (allBits) of the summary bits of the values below the node (see AdaptiveRadixTreeSummary). Returning false skips the
+ * whole node. The aggregates may still account for deleted values, so a node must only be skipped when its aggregates
+ * rule out every value the iteration is looking for.
+ */
+typedef bool (*art_summary_filter)(void* data, uint32_t anyBits, uint32_t allBits);
+
+/**
+ * Cached position of a key prefix in an AdaptiveRadixTree, taken by findAnchor() so that searchFromAnchor() can look
+ * the keys that start with the prefix up without walking the prefix again. It stays usable until a key is inserted into
+ * or deleted from the tree.
+ */
+typedef struct
+{
+    const void* tree;      ///< The tree that took the anchor, which is a shard of a sharded tree.
+    const void* node;      ///< Deepest node holding every key that starts with the prefix, or nullptr if there is none.
+    uint32_t    depth;     ///< Depth of the node.
+    uint32_t    prefixLen; ///< Length of the prefix.
+    uint64_t    version;   ///< Structure version of the tree when the anchor was taken.
+} art_anchor;
+
+/**
+ * Summary bits of the values stored in an AdaptiveRadixTree, aggregated by its inner nodes for art_summary_filter.
+ * Specialize it to give bits to a value type, which has none by default. The bits of a value must not change while it
+ * is stored in a tree.
+ */
+template <typename ValueType> struct AdaptiveRadixTreeSummary
+{
+    static uint32_t bits(const ValueType& value)
+    {
+        (void)value;
+        return 0;
+    }
+};
+
+/**
+ * @brief An Adaptive Radix Tree (ART) that maps byte string keys to pointers of type ValueType.
+ * The user is responsable for the memory management of the values stored in the tree.
+ *
+ * Keys must not contain the '\0' byte, which is used as the implicit terminator of every key so that a key may be a
+ * prefix of another one.
+ *
+ * Values are either referenced by the leaves (insert(), insertIfNotExists()), or copied into the leaf right after the key
+ * (insertInlineIfNotExists()), so that reaching the value of a key does not need another memory access. Inline values are
+ * owned by the tree, which destroys them when their leaf is released. Leaves are never moved nor copied, so the address
+ * of a value stays the same until its key is deleted.
+ *
+ * The writers never modify a node in a way that a concurrent reader could observe half-done: inner nodes are replaced
+ * by an updated copy (copy-on-write) that is published with a single atomic store, and only single child pointers are
+ * updated in place. The nodes unlinked by a writer are passed to reclaimNode(), which releases them immediately.
+ * Subclasses that let readers run concurrently with a writer override it to defer the release until those readers are
+ * done. Writers must be serialized by the caller, unless they lock the nodes they modify through Node::writeLock (see
+ * ConcurrentAdaptiveRadixTree).
+ */
+template <typename ValueType> class AdaptiveRadixTree
+{
+public:
+    /**
+     * @brief Construct a new Adaptive Radix Tree object
+     * @param nodeAllocator The allocator of the nodes and leaves, which must outlive the tree. If it is nullptr, the tree
+     * creates its own allocator: an ArenaNodeAllocator if CONFIG_SETTINGS_STORAGE_NODE_ARENA is enabled, or a
+     * MallocNodeAllocator otherwise.
+     */
+    explicit AdaptiveRadixTree(NodeAllocator* nodeAllocator = nullptr);
+
+    /**
+     * @brief Destroy the Adaptive Radix Tree object
+     */
+    virtual ~AdaptiveRadixTree();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    AdaptiveRadixTree& operator=(AdaptiveRadixTree&&) = delete;
+
+    /**
+     * @brief Get the size of the tree
+     *
+     * @return uint64_t size
+     */
+    virtual uint64_t size();
+
+    /**
+     * @brief Insert a new value into the art tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value opaque value.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    virtual ValueType* insert(const char* key, int key_len, ValueType* value);
+
+    /**
+     * @brief Insert a new value into the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value opaque value.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    virtual ValueType* insertIfNotExists(const char* key, int key_len, ValueType* value);
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    virtual ValueType* insertInlineIfNotExists(const char* key, int key_len, const ValueType& value);
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace), telling an existing key
+     * apart from a tree that could not be updated
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @param outputExisting Set to NULL if the item was newly inserted, otherwise to the value the key already had.
+     * @param outputInserted Optional output set to the value copied into the leaf if the item was newly inserted,
+     * otherwise to NULL.
+     * @return True if the insertion was done, false if the tree could not be updated in time.
+     */
+    virtual bool tryInsertInlineIfNotExists(const char* key, int key_len, const ValueType& value,
+                                            ValueType*& outputExisting, ValueType** outputInserted = nullptr);
+
+    /**
+     * @brief Insert copies of several values into the leaves of new keys of the art tree (no replace)
+     *
+     * If the tree is empty and the keys are sorted, the whole tree is built bottom-up, each node with its final size.
+     * Otherwise, the keys are inserted one by one.
+     *
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param values The values copied into the leaves
+     * @param outputExisting Output array of count pointers, set to null for each newly inserted key, otherwise to the
+     * value the key already had (which may be the value of the same key earlier in the batch).
+     * @param outputInserted Optional output array of count pointers, set to the value copied into the leaf of each
+     * newly inserted key, otherwise to null.
+     * @return True if the batch was inserted, false if the tree could not be updated in time for some keys, whose
+     * outputs are then set to null.
+     */
+    virtual bool insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens, size_t count,
+                                              const ValueType* values, ValueType** outputExisting,
+                                              ValueType** outputInserted = nullptr);
+
+    /**
+     * @brief Deletes a value from the ART tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @return NULL if the item was not found, otherwise
+     * the value pointer is returned. An inline value is destroyed with its leaf, so its pointer must not be dereferenced.
+     */
+    virtual ValueType* deleteValue(const char* key, int key_len);
+
+    /**
+     * @brief Deletes a value from the ART tree, telling a missing key apart from a tree that could not be updated
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the deletion was done, false if the tree could not be updated in time.
+     */
+    virtual bool tryDeleteValue(const char* key, int key_len, ValueType*& outputValue);
+
+    /**
+     * @brief Searches for a value in the ART tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @return NULL if the item was not found, otherwise
+     * the value pointer is returned.
+     */
+    virtual ValueType* search(const char* key, int key_len);
+
+    /**
+     * @brief Searches for a value in the ART tree, telling a missing key apart from a tree that could not be read
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the tree could not be read in time.
+     */
+    virtual bool trySearch(const char* key, int key_len, ValueType*& outputValue);
+
+    /**
+     * @brief Searches for several values in the ART tree
+     *
+     * Each key resumes the descent from the deepest node it shares with the previous key, so sorted keys with common
+     * prefixes walk those prefixes only once.
+     *
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param outputValues Output array of count pointers, set to the value of each key or NULL if it was not found
+     * @return True if the search was done, false if the tree could not be read in time.
+     */
+    virtual bool searchBatch(const char* const* keys, const int* key_lens, size_t count, ValueType** outputValues);
+
+    /**
+     * Iterates through the entries pairs in the map,
+     * invoking a callback for each.
+     * The callback gets a key value for each and returns an integer stop value.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
+     * @return Zero on success, or the return of the callback.
+     */
+    virtual int iterateOverAll(art_callback cb, void* data, art_summary_filter filter = nullptr,
+                               void* filterData = nullptr);
+
+    /**
+     * Iterates through the entry pairs in the map,
+     * invoking a callback for each that matches a given prefix.
+     * The callback gets a key value for each and returns an integer stop value.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of keys to read
+     * @param prefix_len The length of the prefix
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
+     * @return Zero on success, or the return of the callback.
+     */
+    virtual int iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb, void* data,
+                                  art_summary_filter filter = nullptr, void* filterData = nullptr);
+
+    /**
+     * Iterates through the immediate children of a prefix, like the entries of a directory, in order.
+     * A child is the part of a key that follows the prefix up to the next separator. The callback gets the key up to
+     * the end of each child: a key without a separator after the prefix is passed with its value, while the keys that
+     * continue past a separator are passed once per distinct child, as the key up to and including the separator with
+     * a NULL value. Such keys are not null terminated. The subtree of such a child is not visited, only the key of one
+     * of its leaves is read.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of the children
+     * @param prefix_len The length of the prefix
+     * @param separator The byte that ends a child.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @return Zero on success, or the return of the callback.
+     */
+    virtual int iterateOverChildren(const char* prefix, int prefix_len, char separator, art_callback cb, void* data);
+
+    /**
+     * Iterates through the keys that are a prefix of a key, including the key itself, from the shortest one.
+     * It walks the path of the key once, like a search. The derived trees do not synchronize it, so it is meant for
+     * trees protected by their owner.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param key The key
+     * @param key_len The length of the key
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverPrefixesOf(const char* key, int key_len, art_callback cb, void* data);
+
+    /**
+     * @brief Take an anchor on a key prefix, see art_anchor.
+     * @param prefix The prefix
+     * @param prefix_len The length of the prefix
+     * @param outputAnchor The anchor of the prefix.
+     * @return True if the anchor was taken, false if the tree could not take it.
+     */
+    virtual bool findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor);
+
+    /**
+     * @brief Searches for a value in the ART tree from an anchor, with the part of its key that follows the prefix of
+     * the anchor.
+     * @param anchor The anchor taken by findAnchor().
+     * @param key The key without the prefix of the anchor
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the anchor is stale and has to be taken again.
+     */
+    virtual bool searchFromAnchor(const art_anchor& anchor, const char* key, int key_len, ValueType*& outputValue);
+
+    /**
+     * @brief Returns the minimum valued leaf value in the tree
+     *
+     * @return The minimum leaf value or NULL
+     */
+    virtual ValueType* getMinimumValue();
+
+    /**
+     * @brief Returns the maximum valued leaf value in the tree
+     *
+     * @return The maximum leaf value or NULL
+     */
+    virtual ValueType* getMaximumValue();
+
+    /**
+     * @brief Get the memory usage figures of the allocator of the tree nodes and leaves
+     *
+     * @return The allocator statistics
+     */
+    virtual NodeAllocatorStats_t getNodeAllocatorStats();
+
+    /**
+     * @brief Get the contention figures of the lock protecting the tree
+     *
+     * @return The lock statistics, all zero if the tree has no lock
+     */
+    virtual LockStats_t getLockStats();
+
+protected:
+    /// Kinds of inner node, ordered by capacity.
+    typedef enum : uint8_t
+    {
+        NODE4,
+        NODE16,
+        NODE48,
+        NODE256
+    } NodeType_t;
+
+    /**
+     * Header shared by every inner node. The compressed path (prefix) of the node is stored right after the concrete
+     * node structure. Leaves are referenced through tagged pointers to Node (see isLeaf()).
+     *
+     * The summary aggregates are only ever widened: anyBits gains and allBits loses the bits of the values inserted
+     * below the node before they are linked, and they are kept when values are deleted.
+     */
+    struct Node
+    {
+        std::atomic<uint32_t> writeLock; ///< Lock bits of the node, only used by trees with concurrent writers.
+        NodeType_t            type;
+        uint16_t              numChildren;
+        uint32_t              prefixLen;
+        std::atomic<uint32_t> anyBits; ///< OR of the summary bits of the values below the node.
+        std::atomic<uint32_t> allBits; ///< AND of the summary bits of the values below the node.
+    };
+
+    /// Node with up to 4 children, sorted by key byte.
+    struct Node4 : Node
+    {
+        uint8_t             keys[4];
+        std::atomic<Node*>  children[4];
+    };
+
+    /// Node with up to 16 children, sorted by key byte.
+    struct Node16 : Node
+    {
+        uint8_t             keys[16];
+        std::atomic<Node*>  children[16];
+    };
+
+    /// Node with up to 48 children. childIndex maps a key byte to its position in children plus one (0 is empty).
+    struct Node48 : Node
+    {
+        uint8_t             childIndex[256];
+        std::atomic<Node*>  children[48];
+    };
+
+    /// Node with a child slot for every key byte. It is the only node type whose children are added in place.
+    struct Node256 : Node
+    {
+        std::atomic<Node*> children[256];
+    };
+
+    /// Leaf holding a value. The null terminated key is stored right after the structure, followed by the inline value.
+    struct Leaf
+    {
+        std::atomic<ValueType*> value;
+        uint32_t                keyLen;
+        bool                    inlineValue; ///< The leaf owns a copy of the value, see inlineValueSlot().
+    };
+
+    /// Maximum number of children copied by copy-on-write operations (a full Node48 plus the new child).
+    static constexpr uint16_t MAX_COPIED_CHILDREN = 49;
+
+    /// Node256 nodes are shrunk to a Node48 when removing a child leaves this number of children.
+    static constexpr uint16_t NODE256_SHRINK_THRESHOLD = 36;
+
+    std::atomic<Node*>    root;
+    std::atomic<uint64_t> numValues;
+    std::atomic<uint64_t> structureVersion; ///< Incremented before a key is linked into or unlinked from the tree.
+    NodeAllocator*        nodeAllocator;
+    bool                  ownsNodeAllocator;
+
+    /**
+     * @brief Release a node or leaf that a writer has just unlinked from the tree.
+     * The default implementation releases it immediately.
+     * @param node The unlinked node or the tagged pointer to the unlinked leaf.
+     */
+    virtual void reclaimNode(Node* node);
+
+    /// Release the memory of a node or leaf (tagged pointer) without releasing its children.
+    void freeNode(Node* node);
+
+    static bool                      isLeaf(const Node* node);
+    static Leaf*                     asLeaf(const Node* node);
+    static Node*                     leafRef(Leaf* leaf);
+    static const uint8_t*            leafKey(const Leaf* leaf);
+    static ValueType*                inlineValueSlot(const Leaf* leaf);
+    static size_t                    leafSize(uint32_t keyLen, bool inlineValue);
+    static uint8_t*                  nodePrefix(const Node* node);
+    static uint8_t                   keyByte(const uint8_t* key, uint32_t keyLen, uint32_t depth);
+    static bool                      leafMatches(const Leaf* leaf, const uint8_t* key, uint32_t keyLen);
+    static uint32_t                  prefixMismatch(const Node* node, const uint8_t* key, uint32_t keyLen, uint32_t depth);
+    static std::atomic<Node*>*       findChild(const Node* node, uint8_t keyByte);
+    static Leaf*                     minimumLeaf(const Node* node);
+    static Leaf*                     maximumLeaf(const Node* node);
+
+    static uint16_t collectChildren(const Node* node, uint8_t* keys, Node** children);
+
+    /**
+     * @brief Find the deepest node whose subtree holds every key that starts with a prefix.
+     * @param prefix The prefix
+     * @param prefixLen The length of the prefix
+     * @param outputDepth Set to the depth of the returned node.
+     * @return The node, the tagged pointer to a leaf, which may not start with the prefix, or nullptr if no key starts
+     * with the prefix.
+     */
+    const Node* findPrefixNode(const uint8_t* prefix, uint32_t prefixLen, uint32_t& outputDepth) const;
+
+    /**
+     * @brief Get the summary bits of a value, see AdaptiveRadixTreeSummary.
+     * @param value The value, or nullptr, which has no bits.
+     * @return The summary bits.
+     */
+    static uint32_t valueSummary(const ValueType* value);
+
+    /**
+     * @brief Widen the summary aggregates of a node with the summary bits of a value about to be inserted below it.
+     * @param node The inner node.
+     * @param bits The summary bits of the value.
+     * @return True if the aggregates already accounted for the bits, so nothing was changed.
+     */
+    static bool widenSummary(Node* node, uint32_t bits);
+
+    /**
+     * @brief Check if the summary aggregates of a node already account for the summary bits of a value.
+     * @param node The inner node.
+     * @param bits The summary bits of the value.
+     * @return True if widenSummary() would change nothing.
+     */
+    static bool coversSummary(const Node* node, uint32_t bits);
+
+    /**
+     * @brief Copy the summary aggregates of a replaced node into its copy, which may have lost children.
+     * @param copy The new node.
+     * @param node The replaced node.
+     */
+    static void inheritSummary(Node* copy, const Node* node);
+
+    /**
+     * @brief Allocate a new leaf.
+     * @param key The key
+     * @param keyLen The length of the key
+     * @param value The value referenced by the leaf, or the value copied into the leaf if inlineValue is true.
+     * @param inlineValue If the value is copied into the leaf.
+     * @param outputValue Optional output set to the value of the new leaf.
+     * @return The new leaf.
+     */
+    Leaf* allocateLeaf(const uint8_t* key, uint32_t keyLen, ValueType* value, bool inlineValue,
+                       ValueType** outputValue = nullptr);
+
+    /**
+     * @brief Check if keys are sorted in the order of the tree (shorter keys first when one is a prefix of another).
+     * Equal keys are sorted.
+     */
+    static bool keysAreSorted(const char* const* keys, const int* key_lens, size_t count);
+
+    /**
+     * @brief Build the subtree of a range of sorted keys, with copies of their values in the leaves.
+     * The number of values of the tree is updated.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param values The values copied into the leaves.
+     * @param outputExisting Set to null for the first of equal keys, and to the value of the first one for the others.
+     * @param outputInserted Optional output set to the value of the leaf for the first of equal keys, and to null for
+     * the others.
+     * @param begin The first key of the range.
+     * @param end The end of the range, which must not be empty.
+     * @param depth The number of bytes shared by all the keys of the range, which are not stored in the subtree.
+     * @return The root of the subtree.
+     */
+    Node* buildSubtree(const char* const* keys, const int* key_lens, const ValueType* values,
+                       ValueType** outputExisting, ValueType** outputInserted, size_t begin, size_t end,
+                       uint32_t depth);
+    Node* copyNodeWithChild(const Node* node, uint8_t keyByte, Node* child);
+
+    /**
+     * @brief Build the Node4 that replaces a leaf whose key differs from a new key after depth.
+     * @param leaf The tagged pointer to the leaf, which becomes a child of the new node.
+     * @param newLeaf The tagged pointer to the leaf of the new key.
+     * @param depth The depth of the slot holding the leaf.
+     * @return The new node, holding both leaves.
+     */
+    Node* splitLeaf(Node* leaf, Node* newLeaf, uint32_t depth);
+
+    /**
+     * @brief Build the Node4 that replaces a node whose prefix differs from a new key.
+     * @param node The node, which is copied without the matching part of its prefix. It is not reclaimed.
+     * @param mismatch The position of the first prefix byte that differs from the new key.
+     * @param newLeaf The tagged pointer to the leaf of the new key.
+     * @param depth The depth of the node.
+     * @return The new node, holding the copy of the node and the new leaf.
+     */
+    Node* splitPrefix(const Node* node, uint32_t mismatch, Node* newLeaf, uint32_t depth);
+
+    /**
+     * @brief Remove the child stored in childRef from node, which is stored in ref.
+     * The node is either updated in place or replaced by a copy (path compression included) and reclaimed.
+     * The removed child itself is not reclaimed.
+     */
+    void removeChild(std::atomic<Node*>* ref, Node* node, uint8_t keyByte, std::atomic<Node*>* childRef);
+
+private:
+    static size_t   nodeSize(NodeType_t type);
+    static NodeType_t smallestNodeType(uint16_t numChildren);
+
+    Node* allocateNode(NodeType_t type, uint32_t prefixLen);
+    Node* buildNode(NodeType_t type, const uint8_t* prefix, uint32_t prefixLen, const uint8_t* keys, Node* const* children,
+                    uint16_t numChildren);
+    Node* copyNode(const Node* node, const uint8_t* prefix, uint32_t prefixLen);
+    Node* copyNodeWithoutChild(const Node* node, uint8_t keyByte);
+    ValueType* insertValue(const uint8_t* key, uint32_t keyLen, ValueType* value, bool replace, bool inlineValue,
+                           ValueType** outputInserted = nullptr);
+    void       destroyNode(Node* node);
+    static int iterateNode(const Node* node, art_callback cb, void* data, art_summary_filter filter, void* filterData);
+    static ValueType* searchBelow(const Node* node, uint32_t depth, uint32_t prefixLen, const uint8_t* key,
+                                  uint32_t keyLen);
+    static int iterateChildren(const Node* node, uint32_t depth, uint32_t begin, uint8_t separator, art_callback cb,
+                               void* data);
+    static int visitChild(const Node* child, uint32_t depth, uint8_t keyByte, uint32_t begin, uint8_t separator,
+                          art_callback cb, void* data);
+};
+
+template <typename ValueType> AdaptiveRadixTree<ValueType>::AdaptiveRadixTree(NodeAllocator* nodeAllocator)
+{
+    root.store(nullptr, std::memory_order_relaxed);
+    numValues.store(0, std::memory_order_relaxed);
+    structureVersion.store(0, std::memory_order_relaxed);
+
+    this->ownsNodeAllocator = nodeAllocator == nullptr;
+    if (nodeAllocator == nullptr)
+    {
+        if (CONFIG_SETTINGS_STORAGE_NODE_ARENA)
+        {
+            nodeAllocator = new ArenaNodeAllocator();
+        }
+        else
+        {
+            nodeAllocator = new MallocNodeAllocator();
+        }
+    }
+    this->nodeAllocator = nodeAllocator;
+}
+
+template <typename ValueType> AdaptiveRadixTree<ValueType>::~AdaptiveRadixTree()
+{
+    if (ownsNodeAllocator)
+    {
+        // An allocator that releases its memory in bulk makes walking the tree unnecessary.
+        if (!nodeAllocator->releasesInBulk())
+        {
+            destroyNode(root.load(std::memory_order_relaxed));
+        }
+        delete nodeAllocator;
+    }
+    else
+    {
+        destroyNode(root.load(std::memory_order_relaxed));
+    }
+}
+
+template <typename ValueType> uint64_t AdaptiveRadixTree<ValueType>::size()
+{
+    return numValues.load(std::memory_order_relaxed);
+}
+
+template <typename ValueType>
+ValueType* AdaptiveRadixTree<ValueType>::insert(const char* key, int key_len, ValueType* value)
+{
+    return insertValue(reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len), value, true, false);
+}
+
+template <typename ValueType>
+ValueType* AdaptiveRadixTree<ValueType>::insertIfNotExists(const char* key, int key_len, ValueType* value)
+{
+    return insertValue(reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len), value, false, false);
+}
+
+template <typename ValueType> ValueType*
+AdaptiveRadixTree<ValueType>::insertInlineIfNotExists(const char* key, int key_len, const ValueType& value)
+{
+    return insertValue(reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len),
+                       const_cast<ValueType*>(&value), false, true);
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::tryInsertInlineIfNotExists(const char* key, const int key_len,
+                                                              const ValueType& value, ValueType*& outputExisting,
+                                                              ValueType** outputInserted)
+{
+    outputExisting = insertValue(reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len),
+                                 const_cast<ValueType*>(&value), false, true, outputInserted);
+    return true;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens,
+                                                                const size_t count, const ValueType* values,
+                                                                ValueType** outputExisting,
+                                                                ValueType** outputInserted)
+{
+    if (count > 0 && root.load(std::memory_order_relaxed) == nullptr && keysAreSorted(keys, key_lens, count))
+    {
+        root.store(buildSubtree(keys, key_lens, values, outputExisting, outputInserted, 0, count, 0),
+                   std::memory_order_release);
+        return true;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        outputExisting[i] = insertValue(reinterpret_cast<const uint8_t*>(keys[i]), static_cast<uint32_t>(key_lens[i]),
+                                        const_cast<ValueType*>(&values[i]), false, true,
+                                        outputInserted != nullptr ? &outputInserted[i] : nullptr);
+    }
+    return true;
+}
+
+template <typename ValueType> ValueType* AdaptiveRadixTree<ValueType>::deleteValue(const char* key, int key_len)
+{
+    const auto*         keyBytes = reinterpret_cast<const uint8_t*>(key);
+    const auto          keyLen   = static_cast<uint32_t>(key_len);
+    std::atomic<Node*>* ref      = &root;
+    uint32_t            depth    = 0;
+
+    while (true)
+    {
+        Node* node = ref->load(std::memory_order_relaxed);
+        if (node == nullptr)
+        {
+            return nullptr;
+        }
+
+        if (isLeaf(node))
+        {
+            // Only the root can be a leaf reached this way.
+            if (!leafMatches(asLeaf(node), keyBytes, keyLen))
+            {
+                return nullptr;
+            }
+            ValueType* value = asLeaf(node)->value.load(std::memory_order_relaxed);
+            structureVersion.fetch_add(1, std::memory_order_release);
+            ref->store(nullptr, std::memory_order_release);
+            reclaimNode(node);
+            numValues.fetch_sub(1, std::memory_order_relaxed);
+            return value;
+        }
+
+        if (prefixMismatch(node, keyBytes, keyLen, depth) != node->prefixLen)
+        {
+            return nullptr;
+        }
+        depth += node->prefixLen;
+
+        const uint8_t       byte     = keyByte(keyBytes, keyLen, depth);
+        std::atomic<Node*>* childRef = findChild(node, byte);
+        if (childRef == nullptr)
+        {
+            return nullptr;
+        }
+
+        Node* child = childRef->load(std::memory_order_relaxed);
+        if (!isLeaf(child))
+        {
+            ref = childRef;
+            depth++;
+            continue;
+        }
+
+        if (!leafMatches(asLeaf(child), keyBytes, keyLen))
+        {
+            return nullptr;
+        }
+        ValueType* value = asLeaf(child)->value.load(std::memory_order_relaxed);
+        structureVersion.fetch_add(1, std::memory_order_release);
+        removeChild(ref, node, byte, childRef);
+        reclaimNode(child);
+        numValues.fetch_sub(1, std::memory_order_relaxed);
+        return value;
+    }
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::tryDeleteValue(const char* key, const int key_len, ValueType*& outputValue)
+{
+    outputValue = deleteValue(key, key_len);
+    return true;
+}
+
+template <typename ValueType> ValueType* AdaptiveRadixTree<ValueType>::search(const char* key, int key_len)
+{
+    const auto* keyBytes = reinterpret_cast<const uint8_t*>(key);
+    const auto  keyLen   = static_cast<uint32_t>(key_len);
+    const Node* node     = root.load(std::memory_order_acquire);
+    uint32_t    depth    = 0;
+
+    while (node != nullptr)
+    {
+        if (isLeaf(node))
+        {
+            const Leaf* leaf = asLeaf(node);
+            return leafMatches(leaf, keyBytes, keyLen) ? leaf->value.load(std::memory_order_acquire) : nullptr;
+        }
+
+        if (prefixMismatch(node, keyBytes, keyLen, depth) != node->prefixLen)
+        {
+            return nullptr;
+        }
+        depth += node->prefixLen;
+
+        const std::atomic<Node*>* childRef = findChild(node, keyByte(keyBytes, keyLen, depth));
+        if (childRef == nullptr)
+        {
+            return nullptr;
+        }
+        node = childRef->load(std::memory_order_acquire);
+        depth++;
+    }
+    return nullptr;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::trySearch(const char* key, const int key_len, ValueType*& outputValue)
+{
+    outputValue = search(key, key_len);
+    return true;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::searchBatch(const char* const* keys, const int* key_lens, const size_t count,
+                                               ValueType** outputValues)
+{
+    // Inner nodes on the path of the previous key, with the depth each one was reached at.
+    std::vector<std::pair<const Node*, uint32_t>> path;
+    const uint8_t*                                previousKey    = nullptr;
+    uint32_t                                      previousKeyLen = 0;
+    const Node*                                   rootNode       = root.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto* keyBytes = reinterpret_cast<const uint8_t*>(keys[i]);
+        const auto  keyLen   = static_cast<uint32_t>(key_lens[i]);
+
+        // A node reached at depth d was chosen by the first d bytes of the previous key only, so it is on the path of
+        // this key too if both keys share those bytes.
+        uint32_t common = 0;
+        while (common < previousKeyLen && common < keyLen && previousKey[common] == keyBytes[common])
+        {
+            common++;
+        }
+        while (!path.empty() && path.back().second > common)
+        {
+            path.pop_back();
+        }
+
+        const Node* node  = rootNode;
+        uint32_t    depth = 0;
+        if (!path.empty())
+        {
+            node  = path.back().first;
+            depth = path.back().second;
+            path.pop_back();
+        }
+
+        outputValues[i] = nullptr;
+        while (node != nullptr)
+        {
+            if (isLeaf(node))
+            {
+                const Leaf* leaf = asLeaf(node);
+                if (leafMatches(leaf, keyBytes, keyLen))
+                {
+                    outputValues[i] = leaf->value.load(std::memory_order_acquire);
+                }
+                break;
+            }
+
+            path.emplace_back(node, depth);
+            if (prefixMismatch(node, keyBytes, keyLen, depth) != node->prefixLen)
+            {
+                break;
+            }
+            depth += node->prefixLen;
+
+            const std::atomic<Node*>* childRef = findChild(node, keyByte(keyBytes, keyLen, depth));
+            if (childRef == nullptr)
+            {
+                break;
+            }
+            node = childRef->load(std::memory_order_acquire);
+            depth++;
+        }
+
+        previousKey    = keyBytes;
+        previousKeyLen = keyLen;
+    }
+    return true;
+}
+
+template <typename ValueType> int AdaptiveRadixTree<ValueType>::iterateOverAll(art_callback cb, void* callbackData,
+                                                                               const art_summary_filter filter,
+                                                                               void*                    filterData)
+{
+    return iterateNode(root.load(std::memory_order_acquire), cb, callbackData, filter, filterData);
+}
+
+template <typename ValueType>
+int AdaptiveRadixTree<ValueType>::iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb,
+                                                    void* callbackData, const art_summary_filter filter,
+                                                    void* filterData)
+{
+    const auto* prefixBytes = reinterpret_cast<const uint8_t*>(prefix);
+    const auto  prefixLen   = static_cast<uint32_t>(prefix_len);
+    uint32_t    depth;
+    const Node* node = findPrefixNode(prefixBytes, prefixLen, depth);
+
+    if (node != nullptr && isLeaf(node))
+    {
+        const Leaf* leaf = asLeaf(node);
+        if (leaf->keyLen >= prefixLen && memcmp(leafKey(leaf), prefixBytes, prefixLen) == 0)
+        {
+            return cb(callbackData, leafKey(leaf), leaf->keyLen, leaf->value.load(std::memory_order_acquire));
+        }
+        return 0;
+    }
+    return iterateNode(node, cb, callbackData, filter, filterData);
+}
+
+template <typename ValueType>
+int AdaptiveRadixTree<ValueType>::iterateOverChildren(const char* prefix, int prefix_len, const char separator,
+                                                      art_callback cb, void* callbackData)
+{
+    const auto* prefixBytes = reinterpret_cast<const uint8_t*>(prefix);
+    const auto  prefixLen   = static_cast<uint32_t>(prefix_len);
+    uint32_t    depth;
+    const Node* node = findPrefixNode(prefixBytes, prefixLen, depth);
+
+    if (node != nullptr && isLeaf(node))
+    {
+        const Leaf* leaf = asLeaf(node);
+        if (leaf->keyLen < prefixLen || memcmp(leafKey(leaf), prefixBytes, prefixLen) != 0)
+        {
+            return 0;
+        }
+    }
+    return iterateChildren(node, depth, prefixLen, static_cast<uint8_t>(separator), cb, callbackData);
+}
+
+template <typename ValueType>
+int AdaptiveRadixTree<ValueType>::iterateOverPrefixesOf(const char* key, const int key_len, art_callback cb,
+                                                        void* data)
+{
+    const auto* keyBytes = reinterpret_cast<const uint8_t*>(key);
+    const auto  keyLen   = static_cast<uint32_t>(key_len);
+    const Node* node     = root.load(std::memory_order_acquire);
+    uint32_t    depth    = 0;
+
+    while (node != nullptr)
+    {
+        if (isLeaf(node))
+        {
+            const Leaf* leaf = asLeaf(node);
+            if (leaf->keyLen <= keyLen && memcmp(leafKey(leaf), keyBytes, leaf->keyLen) == 0)
+            {
+                return cb(data, leafKey(leaf), leaf->keyLen, leaf->value.load(std::memory_order_acquire));
+            }
+            return 0;
+        }
+
+        if (prefixMismatch(node, keyBytes, keyLen, depth) != node->prefixLen)
+        {
+            return 0;
+        }
+        depth += node->prefixLen;
+
+        // A key ending at this depth is the child of the terminating byte, followed by the rest of the path.
+        if (depth < keyLen)
+        {
+            const std::atomic<Node*>* endRef = findChild(node, 0);
+            const Node*               end    = endRef != nullptr ? endRef->load(std::memory_order_acquire) : nullptr;
+            if (end != nullptr && isLeaf(end) && asLeaf(end)->keyLen == depth)
+            {
+                const Leaf* leaf   = asLeaf(end);
+                const int   result = cb(data, leafKey(leaf), leaf->keyLen, leaf->value.load(std::memory_order_acquire));
+                if (result != 0)
+                {
+                    return result;
+                }
+            }
+        }
+
+        const std::atomic<Node*>* childRef = findChild(node, keyByte(keyBytes, keyLen, depth));
+        if (childRef == nullptr)
+        {
+            return 0;
+        }
+        node = childRef->load(std::memory_order_acquire);
+        depth++;
+    }
+    return 0;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor)
+{
+    const auto* prefixBytes = reinterpret_cast<const uint8_t*>(prefix);
+    const auto  prefixLen   = static_cast<uint32_t>(prefix_len);
+
+    // The version is read first, so a change made during the descent leaves the anchor stale rather than wrong.
+    outputAnchor.version = structureVersion.load(std::memory_order_acquire);
+
+    uint32_t    depth;
+    const Node* node = findPrefixNode(prefixBytes, prefixLen, depth);
+    if (node != nullptr && isLeaf(node))
+    {
+        const Leaf* leaf = asLeaf(node);
+        if (leaf->keyLen < prefixLen || memcmp(leafKey(leaf), prefixBytes, prefixLen) != 0)
+        {
+            node = nullptr;
+        }
+    }
+
+    outputAnchor.tree      = this;
+    outputAnchor.node      = node;
+    outputAnchor.depth     = depth;
+    outputAnchor.prefixLen = prefixLen;
+    return true;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::searchFromAnchor(const art_anchor& anchor, const char* key, int key_len,
+                                                    ValueType*& outputValue)
+{
+    if (anchor.tree != this || anchor.version != structureVersion.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    outputValue = searchBelow(static_cast<const Node*>(anchor.node), anchor.depth, anchor.prefixLen,
+                              reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len));
+    return true;
+}
+
+template <typename ValueType> ValueType* AdaptiveRadixTree<ValueType>::getMinimumValue()
+{
+    const Leaf* leaf = minimumLeaf(root.load(std::memory_order_acquire));
+    return leaf != nullptr ? leaf->value.load(std::memory_order_acquire) : nullptr;
+}
+
+template <typename ValueType> ValueType* AdaptiveRadixTree<ValueType>::getMaximumValue()
+{
+    const Leaf* leaf = maximumLeaf(root.load(std::memory_order_acquire));
+    return leaf != nullptr ? leaf->value.load(std::memory_order_acquire) : nullptr;
+}
+
+template <typename ValueType> NodeAllocatorStats_t AdaptiveRadixTree<ValueType>::getNodeAllocatorStats()
+{
+    return nodeAllocator->getStats();
+}
+
+template <typename ValueType> LockStats_t AdaptiveRadixTree<ValueType>::getLockStats()
+{
+    return {};
+}
+
+template <typename ValueType> void AdaptiveRadixTree<ValueType>::reclaimNode(Node* node)
+{
+    freeNode(node);
+}
+
+template <typename ValueType> void AdaptiveRadixTree<ValueType>::freeNode(Node* node)
+{
+    if (isLeaf(node))
+    {
+        Leaf* leaf = asLeaf(node);
+        if (leaf->inlineValue)
+        {
+            std::destroy_at(inlineValueSlot(leaf));
+        }
+        nodeAllocator->deallocate(leaf, leafSize(leaf->keyLen, leaf->inlineValue));
+    }
+    else
+    {
+        nodeAllocator->deallocate(node, nodeSize(node->type) + node->prefixLen);
+    }
+}
+
+template <typename ValueType> bool AdaptiveRadixTree<ValueType>::isLeaf(const Node* node)
+{
+    return (reinterpret_cast<uintptr_t>(node) & 1) != 0;
+}
+
+template <typename ValueType>
+typename AdaptiveRadixTree<ValueType>::Leaf* AdaptiveRadixTree<ValueType>::asLeaf(const Node* node)
+{
+    return reinterpret_cast<Leaf*>(reinterpret_cast<uintptr_t>(node) & ~static_cast<uintptr_t>(1));
+}
+
+template <typename ValueType>
+typename AdaptiveRadixTree<ValueType>::Node* AdaptiveRadixTree<ValueType>::leafRef(Leaf* leaf)
+{
+    return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(leaf) | 1);
+}
+
+template <typename ValueType> const uint8_t* AdaptiveRadixTree<ValueType>::leafKey(const Leaf* leaf)
+{
+    return reinterpret_cast<const uint8_t*>(leaf + 1);
+}
+
+template <typename ValueType> ValueType* AdaptiveRadixTree<ValueType>::inlineValueSlot(const Leaf* leaf)
+{
+    const size_t offset = (sizeof(Leaf) + leaf->keyLen + 1 + alignof(ValueType) - 1) / alignof(ValueType) *
+                          alignof(ValueType);
+    return reinterpret_cast<ValueType*>(reinterpret_cast<uint8_t*>(const_cast<Leaf*>(leaf)) + offset);
+}
+
+template <typename ValueType> size_t AdaptiveRadixTree<ValueType>::leafSize(const uint32_t keyLen, const bool inlineValue)
+{
+    if (!inlineValue)
+    {
+        return sizeof(Leaf) + keyLen + 1;
+    }
+    return (sizeof(Leaf) + keyLen + 1 + alignof(ValueType) - 1) / alignof(ValueType) * alignof(ValueType) +
+           sizeof(ValueType);
+}
+
+template <typename ValueType> uint8_t* AdaptiveRadixTree<ValueType>::nodePrefix(const Node* node)
+{
+    return reinterpret_cast<uint8_t*>(const_cast<Node*>(node)) + nodeSize(node->type);
+}
+
+template <typename ValueType>
+uint8_t AdaptiveRadixTree<ValueType>::keyByte(const uint8_t* key, const uint32_t keyLen, const uint32_t depth)
+{
+    return depth < keyLen ? key[depth] : 0;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::leafMatches(const Leaf* leaf, const uint8_t* key, const uint32_t keyLen)
+{
+    return leaf->keyLen == keyLen && memcmp(leafKey(leaf), key, keyLen) == 0;
+}
+
+template <typename ValueType> uint32_t AdaptiveRadixTree<ValueType>::prefixMismatch(const Node* node, const uint8_t* key,
+                                                                                   const uint32_t keyLen,
+                                                                                   const uint32_t depth)
+{
+    const uint8_t* prefix = nodePrefix(node);
+    for (uint32_t i = 0; i < node->prefixLen; i++)
+    {
+        if (prefix[i] != keyByte(key, keyLen, depth + i))
+        {
+            return i;
+        }
+    }
+    return node->prefixLen;
+}
+
+template <typename ValueType> std::atomic<typename AdaptiveRadixTree<ValueType>::Node*>*
+AdaptiveRadixTree<ValueType>::findChild(const Node* node, const uint8_t keyByte)
+{
+    switch (node->type)
+    {
+        case NODE4:
+        {
+            auto* node4 = static_cast<Node4*>(const_cast<Node*>(node));
+            for (uint16_t i = 0; i < node->numChildren; i++)
+            {
+                if (node4->keys[i] == keyByte)
+                {
+                    return &node4->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case NODE16:
+        {
+            auto* node16 = static_cast<Node16*>(const_cast<Node*>(node));
+            for (uint16_t i = 0; i < node->numChildren; i++)
+            {
+                if (node16->keys[i] == keyByte)
+                {
+                    return &node16->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case NODE48:
+        {
+            auto*         node48 = static_cast<Node48*>(const_cast<Node*>(node));
+            const uint8_t index  = node48->childIndex[keyByte];
+            return index != 0 ? &node48->children[index - 1] : nullptr;
+        }
+        case NODE256:
+        {
+            auto* node256 = static_cast<Node256*>(const_cast<Node*>(node));
+            return node256->children[keyByte].load(std::memory_order_acquire) != nullptr ? &node256->children[keyByte]
+                                                                                          : nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+template <typename ValueType>
+typename AdaptiveRadixTree<ValueType>::Leaf* AdaptiveRadixTree<ValueType>::minimumLeaf(const Node* node)
+{
+    while (node != nullptr && !isLeaf(node))
+    {
+        const Node* next = nullptr;
+        switch (node->type)
+        {
+            case NODE4:
+                next = static_cast<const Node4*>(node)->children[0].load(std::memory_order_acquire);
+                break;
+            case NODE16:
+                next = static_cast<const Node16*>(node)->children[0].load(std::memory_order_acquire);
+                break;
+            case NODE48:
+            {
+                const auto* node48 = static_cast<const Node48*>(node);
+                for (uint16_t i = 0; i < 256 && next == nullptr; i++)
+                {
+                    if (node48->childIndex[i] != 0)
+                    {
+                        next = node48->children[node48->childIndex[i] - 1].load(std::memory_order_acquire);
+                    }
+                }
+                break;
+            }
+            case NODE256:
+            {
+                const auto* node256 = static_cast<const Node256*>(node);
+                for (uint16_t i = 0; i < 256 && next == nullptr; i++)
+                {
+                    next = node256->children[i].load(std::memory_order_acquire);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        node = next;
+    }
+    return node != nullptr ? asLeaf(node) : nullptr;
+}
+
+template <typename ValueType>
+typename AdaptiveRadixTree<ValueType>::Leaf* AdaptiveRadixTree<ValueType>::maximumLeaf(const Node* node)
+{
+    while (node != nullptr && !isLeaf(node))
+    {
+        const Node* next = nullptr;
+        switch (node->type)
+        {
+            case NODE4:
+                next = static_cast<const Node4*>(node)->children[node->numChildren - 1].load(std::memory_order_acquire);
+                break;
+            case NODE16:
+                next =
+                    static_cast<const Node16*>(node)->children[node->numChildren - 1].load(std::memory_order_acquire);
+                break;
+            case NODE48:
+            {
+                const auto* node48 = static_cast<const Node48*>(node);
+                for (int i = 255; i >= 0 && next == nullptr; i--)
+                {
+                    if (node48->childIndex[i] != 0)
+                    {
+                        next = node48->children[node48->childIndex[i] - 1].load(std::memory_order_acquire);
+                    }
+                }
+                break;
+            }
+            case NODE256:
+            {
+                const auto* node256 = static_cast<const Node256*>(node);
+                for (int i = 255; i >= 0 && next == nullptr; i--)
+                {
+                    next = node256->children[i].load(std::memory_order_acquire);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        node = next;
+    }
+    return node != nullptr ? asLeaf(node) : nullptr;
+}
+
+template <typename ValueType> size_t AdaptiveRadixTree<ValueType>::nodeSize(const NodeType_t type)
+{
+    switch (type)
+    {
+        case NODE4:
+            return sizeof(Node4);
+        case NODE16:
+            return sizeof(Node16);
+        case NODE48:
+            return sizeof(Node48);
+        default:
+            return sizeof(Node256);
+    }
+}
+
+template <typename ValueType>
+uint16_t AdaptiveRadixTree<ValueType>::collectChildren(const Node* node, uint8_t* keys, Node** children)
+{
+    uint16_t count = 0;
+    switch (node->type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            const uint8_t*            nodeKeys     = node->type == NODE4 ? static_cast<const Node4*>(node)->keys
+                                                                         : static_cast<const Node16*>(node)->keys;
+            const std::atomic<Node*>* nodeChildren = node->type == NODE4 ? static_cast<const Node4*>(node)->children
+                                                                         : static_cast<const Node16*>(node)->children;
+            for (; count < node->numChildren; count++)
+            {
+                keys[count]     = nodeKeys[count];
+                children[count] = nodeChildren[count].load(std::memory_order_relaxed);
+            }
+            break;
+        }
+        case NODE48:
+        {
+            const auto* node48 = static_cast<const Node48*>(node);
+            for (uint16_t i = 0; i < 256; i++)
+            {
+                if (node48->childIndex[i] != 0)
+                {
+                    keys[count]     = static_cast<uint8_t>(i);
+                    children[count] = node48->children[node48->childIndex[i] - 1].load(std::memory_order_relaxed);
+                    count++;
+                }
+            }
+            break;
+        }
+        case NODE256:
+        {
+            assert(node->numChildren < MAX_COPIED_CHILDREN && "Node256 too big to be copied");
+            const auto* node256 = static_cast<const Node256*>(node);
+            for (uint16_t i = 0; i < 256; i++)
+            {
+                if (Node* child = node256->children[i].load(std::memory_order_relaxed); child != nullptr)
+                {
+                    keys[count]     = static_cast<uint8_t>(i);
+                    children[count] = child;
+                    count++;
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return count;
+}
+
+template <typename ValueType>
+const typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::findPrefixNode(const uint8_t* prefix, const uint32_t prefixLen,
+                                             uint32_t& outputDepth) const
+{
+    const Node* node = root.load(std::memory_order_acquire);
+    uint32_t    depth = 0;
+
+    while (node != nullptr && !isLeaf(node) && depth < prefixLen)
+    {
+        // Every key below this node starts with its prefix, so it only has to match the part of the prefix left.
+        const uint32_t compared = node->prefixLen < prefixLen - depth ? node->prefixLen : prefixLen - depth;
+        if (memcmp(nodePrefix(node), prefix + depth, compared) != 0)
+        {
+            return nullptr;
+        }
+        if (depth + node->prefixLen >= prefixLen)
+        {
+            break;
+        }
+        depth += node->prefixLen;
+
+        const std::atomic<Node*>* childRef = findChild(node, prefix[depth]);
+        if (childRef == nullptr)
+        {
+            return nullptr;
+        }
+        node = childRef->load(std::memory_order_acquire);
+        depth++;
+    }
+    outputDepth = depth;
+    return node;
+}
+
+template <typename ValueType> uint32_t AdaptiveRadixTree<ValueType>::valueSummary(const ValueType* value)
+{
+    return value != nullptr ? AdaptiveRadixTreeSummary<ValueType>::bits(*value) : 0;
+}
+
+template <typename ValueType> bool AdaptiveRadixTree<ValueType>::widenSummary(Node* node, const uint32_t bits)
+{
+    // Most values have the bits of their neighbours, so the aggregates are usually only read.
+    if (coversSummary(node, bits))
+    {
+        return true;
+    }
+    node->anyBits.fetch_or(bits, std::memory_order_relaxed);
+    node->allBits.fetch_and(bits, std::memory_order_relaxed);
+    return false;
+}
+
+template <typename ValueType> bool AdaptiveRadixTree<ValueType>::coversSummary(const Node* node, const uint32_t bits)
+{
+    return (node->anyBits.load(std::memory_order_relaxed) & bits) == bits &&
+           (node->allBits.load(std::memory_order_relaxed) & ~bits) == 0;
+}
+
+template <typename ValueType> void AdaptiveRadixTree<ValueType>::inheritSummary(Node* copy, const Node* node)
+{
+    copy->anyBits.fetch_or(node->anyBits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    copy->allBits.fetch_and(node->allBits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+template <typename ValueType>
+typename AdaptiveRadixTree<ValueType>::NodeType_t AdaptiveRadixTree<ValueType>::smallestNodeType(const uint16_t numChildren)
+{
+    if (numChildren <= 4)
+    {
+        return NODE4;
+    }
+    if (numChildren <= 16)
+    {
+        return NODE16;
+    }
+    if (numChildren <= 48)
+    {
+        return NODE48;
+    }
+    return NODE256;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::allocateNode(const NodeType_t type, const uint32_t prefixLen)
+{
+    void* memory = nodeAllocator->allocate(nodeSize(type) + prefixLen);
+    assert(memory != nullptr && "Memory allocation failed");
+
+    Node* node;
+    switch (type)
+    {
+        case NODE4:
+            node = new (memory) Node4();
+            break;
+        case NODE16:
+            node = new (memory) Node16();
+            break;
+        case NODE48:
+            node = new (memory) Node48();
+            break;
+        default:
+            node = new (memory) Node256();
+            break;
+    }
+    node->writeLock.store(0, std::memory_order_relaxed);
+    node->type        = type;
+    node->numChildren = 0;
+    node->prefixLen   = prefixLen;
+    node->anyBits.store(0, std::memory_order_relaxed);
+    node->allBits.store(UINT32_MAX, std::memory_order_relaxed);
+    return node;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Leaf*
+AdaptiveRadixTree<ValueType>::allocateLeaf(const uint8_t* key, const uint32_t keyLen, ValueType* value,
+                                           const bool inlineValue, ValueType** outputValue)
+{
+    // A leaf is only allocated right before it is linked, so the anchors are invalidated before the tree changes.
+    structureVersion.fetch_add(1, std::memory_order_release);
+
+    void* memory = nodeAllocator->allocate(leafSize(keyLen, inlineValue));
+    assert(memory != nullptr && "Memory allocation failed");
+
+    Leaf* leaf        = new (memory) Leaf();
+    leaf->keyLen      = keyLen;
+    leaf->inlineValue = inlineValue;
+
+    auto* storedKey = const_cast<uint8_t*>(leafKey(leaf));
+    memcpy(storedKey, key, keyLen);
+    storedKey[keyLen] = '\0';
+
+    if (inlineValue)
+    {
+        value = new (inlineValueSlot(leaf)) ValueType(*value);
+    }
+    leaf->value.store(value, std::memory_order_relaxed);
+    if (outputValue != nullptr)
+    {
+        *outputValue = value;
+    }
+    return leaf;
+}
+
+template <typename ValueType>
+bool AdaptiveRadixTree<ValueType>::keysAreSorted(const char* const* keys, const int* key_lens, const size_t count)
+{
+    for (size_t i = 1; i < count; i++)
+    {
+        const auto commonLen = static_cast<size_t>(std::min(key_lens[i - 1], key_lens[i]));
+        const int  order     = memcmp(keys[i - 1], keys[i], commonLen);
+        if (order > 0 || (order == 0 && key_lens[i - 1] > key_lens[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::buildSubtree(const char* const* keys, const int* key_lens, const ValueType* values,
+                                           ValueType** outputExisting, ValueType** outputInserted, const size_t begin,
+                                           const size_t end, const uint32_t depth)
+{
+    const auto* first    = reinterpret_cast<const uint8_t*>(keys[begin]);
+    const auto  firstLen = static_cast<uint32_t>(key_lens[begin]);
+    const auto* last     = reinterpret_cast<const uint8_t*>(keys[end - 1]);
+    const auto  lastLen  = static_cast<uint32_t>(key_lens[end - 1]);
+
+    // The keys are sorted, so all of them are equal if the first and the last ones are.
+    if (firstLen == lastLen && memcmp(first, last, firstLen) == 0)
+    {
+        Leaf* leaf = allocateLeaf(first, firstLen, const_cast<ValueType*>(&values[begin]), true,
+                                  outputInserted != nullptr ? &outputInserted[begin] : nullptr);
+        numValues.fetch_add(1, std::memory_order_relaxed);
+        outputExisting[begin] = nullptr;
+        for (size_t i = begin + 1; i < end; i++)
+        {
+            outputExisting[i] = leaf->value.load(std::memory_order_relaxed);
+            if (outputInserted != nullptr)
+            {
+                outputInserted[i] = nullptr;
+            }
+        }
+        return leafRef(leaf);
+    }
+
+    // The keys are sorted, so the prefix shared by the first and the last ones is shared by all of them.
+    uint32_t childDepth = depth;
+    while (keyByte(first, firstLen, childDepth) == keyByte(last, lastLen, childDepth))
+    {
+        childDepth++;
+    }
+
+    std::vector<uint8_t> childKeys;
+    std::vector<Node*>   children;
+    for (size_t childBegin = begin; childBegin < end;)
+    {
+        const uint8_t byte     = keyByte(reinterpret_cast<const uint8_t*>(keys[childBegin]),
+                                         static_cast<uint32_t>(key_lens[childBegin]), childDepth);
+        size_t        childEnd = childBegin + 1;
+        while (childEnd < end && keyByte(reinterpret_cast<const uint8_t*>(keys[childEnd]),
+                                         static_cast<uint32_t>(key_lens[childEnd]), childDepth) == byte)
+        {
+            childEnd++;
+        }
+        childKeys.push_back(byte);
+        children.push_back(
+            buildSubtree(keys, key_lens, values, outputExisting, outputInserted, childBegin, childEnd, childDepth + 1));
+        childBegin = childEnd;
+    }
+
+    const auto numChildren = static_cast<uint16_t>(children.size());
+    return buildNode(smallestNodeType(numChildren), first + depth, childDepth - depth, childKeys.data(),
+                     children.data(), numChildren);
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::buildNode(const NodeType_t type, const uint8_t* prefix, const uint32_t prefixLen,
+                                        const uint8_t* keys, Node* const* children, const uint16_t numChildren)
+{
+    Node* node = allocateNode(type, prefixLen);
+    memcpy(nodePrefix(node), prefix, prefixLen);
+    node->numChildren = numChildren;
+
+    uint32_t anyBits = 0;
+    uint32_t allBits = UINT32_MAX;
+    for (uint16_t i = 0; i < numChildren; i++)
+    {
+        if (isLeaf(children[i]))
+        {
+            const uint32_t bits = valueSummary(asLeaf(children[i])->value.load(std::memory_order_relaxed));
+            anyBits |= bits;
+            allBits &= bits;
+        }
+        else
+        {
+            anyBits |= children[i]->anyBits.load(std::memory_order_relaxed);
+            allBits &= children[i]->allBits.load(std::memory_order_relaxed);
+        }
+    }
+    node->anyBits.store(anyBits, std::memory_order_relaxed);
+    node->allBits.store(allBits, std::memory_order_relaxed);
+
+    switch (type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            uint8_t*            nodeKeys = type == NODE4 ? static_cast<Node4*>(node)->keys : static_cast<Node16*>(node)->keys;
+            std::atomic<Node*>* nodeChildren =
+                type == NODE4 ? static_cast<Node4*>(node)->children : static_cast<Node16*>(node)->children;
+            for (uint16_t i = 0; i < numChildren; i++)
+            {
+                nodeKeys[i] = keys[i];
+                nodeChildren[i].store(children[i], std::memory_order_relaxed);
+            }
+            break;
+        }
+        case NODE48:
+        {
+            auto* node48 = static_cast<Node48*>(node);
+            for (uint16_t i = 0; i < numChildren; i++)
+            {
+                node48->childIndex[keys[i]] = static_cast<uint8_t>(i + 1);
+                node48->children[i].store(children[i], std::memory_order_relaxed);
+            }
+            break;
+        }
+        default:
+        {
+            auto* node256 = static_cast<Node256*>(node);
+            for (uint16_t i = 0; i < numChildren; i++)
+            {
+                node256->children[keys[i]].store(children[i], std::memory_order_relaxed);
+            }
+            break;
+        }
+    }
+    return node;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::copyNode(const Node* node, const uint8_t* prefix, const uint32_t prefixLen)
+{
+    if (node->type == NODE256)
+    {
+        auto* copy = static_cast<Node256*>(allocateNode(NODE256, prefixLen));
+        memcpy(nodePrefix(copy), prefix, prefixLen);
+        copy->numChildren = node->numChildren;
+        for (uint16_t i = 0; i < 256; i++)
+        {
+            copy->children[i].store(static_cast<const Node256*>(node)->children[i].load(std::memory_order_relaxed),
+                                    std::memory_order_relaxed);
+        }
+        inheritSummary(copy, node);
+        return copy;
+    }
+
+    uint8_t        keys[MAX_COPIED_CHILDREN];
+    Node*          children[MAX_COPIED_CHILDREN];
+    const uint16_t numChildren = collectChildren(node, keys, children);
+    Node*          copy        = buildNode(node->type, prefix, prefixLen, keys, children, numChildren);
+    inheritSummary(copy, node);
+    return copy;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::copyNodeWithChild(const Node* node, const uint8_t keyByte, Node* child)
+{
+    uint8_t  keys[MAX_COPIED_CHILDREN];
+    Node*    children[MAX_COPIED_CHILDREN];
+    uint16_t numChildren = collectChildren(node, keys, children);
+
+    uint16_t position = numChildren;
+    while (position > 0 && keys[position - 1] > keyByte)
+    {
+        keys[position]     = keys[position - 1];
+        children[position] = children[position - 1];
+        position--;
+    }
+    keys[position]     = keyByte;
+    children[position] = child;
+    numChildren++;
+
+    const NodeType_t type = smallestNodeType(numChildren) > node->type ? smallestNodeType(numChildren) : node->type;
+    Node*            copy = buildNode(type, nodePrefix(node), node->prefixLen, keys, children, numChildren);
+    inheritSummary(copy, node);
+    return copy;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::copyNodeWithoutChild(const Node* node, const uint8_t keyByte)
+{
+    uint8_t  keys[MAX_COPIED_CHILDREN];
+    Node*    children[MAX_COPIED_CHILDREN];
+    uint16_t numChildren = collectChildren(node, keys, children);
+
+    uint16_t position = 0;
+    while (position < numChildren && keys[position] != keyByte)
+    {
+        position++;
+    }
+    for (numChildren--; position < numChildren; position++)
+    {
+        keys[position]     = keys[position + 1];
+        children[position] = children[position + 1];
+    }
+
+    Node* copy =
+        buildNode(smallestNodeType(numChildren), nodePrefix(node), node->prefixLen, keys, children, numChildren);
+    inheritSummary(copy, node);
+    return copy;
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::splitLeaf(Node* leaf, Node* newLeaf, const uint32_t depth)
+{
+    // The new node prefix is the part both keys have in common after depth.
+    const Leaf*    oldLeaf    = asLeaf(leaf);
+    const uint8_t* key        = leafKey(asLeaf(newLeaf));
+    const uint32_t keyLen     = asLeaf(newLeaf)->keyLen;
+    uint32_t       splitDepth = depth;
+    while (keyByte(leafKey(oldLeaf), oldLeaf->keyLen, splitDepth) == keyByte(key, keyLen, splitDepth))
+    {
+        assert(splitDepth <= keyLen && splitDepth <= oldLeaf->keyLen && "Keys must not contain the '\\0' byte");
+        splitDepth++;
+    }
+    uint8_t keys[2]     = {keyByte(leafKey(oldLeaf), oldLeaf->keyLen, splitDepth), keyByte(key, keyLen, splitDepth)};
+    Node*   children[2] = {leaf, newLeaf};
+    if (keys[0] > keys[1])
+    {
+        std::swap(keys[0], keys[1]);
+        std::swap(children[0], children[1]);
+    }
+    return buildNode(NODE4, key + depth, splitDepth - depth, keys, children, 2);
+}
+
+template <typename ValueType> typename AdaptiveRadixTree<ValueType>::Node*
+AdaptiveRadixTree<ValueType>::splitPrefix(const Node* node, const uint32_t mismatch, Node* newLeaf,
+                                          const uint32_t depth)
+{
+    // The new node takes the common part of the prefix, and a copy of the node keeps the rest of it.
+    const uint8_t* prefix      = nodePrefix(node);
+    uint8_t        keys[2]     = {prefix[mismatch], keyByte(leafKey(asLeaf(newLeaf)), asLeaf(newLeaf)->keyLen,
+                                                            depth + mismatch)};
+    Node*          children[2] = {copyNode(node, prefix + mismatch + 1, node->prefixLen - mismatch - 1), newLeaf};
+    if (keys[0] > keys[1])
+    {
+        std::swap(keys[0], keys[1]);
+        std::swap(children[0], children[1]);
+    }
+    return buildNode(NODE4, prefix, mismatch, keys, children, 2);
+}
+
+template <typename ValueType> void AdaptiveRadixTree<ValueType>::removeChild(std::atomic<Node*>* ref, Node* node,
+                                                                             const uint8_t        keyByte,
+                                                                             std::atomic<Node*>* childRef)
+{
+    if (node->type == NODE256 && node->numChildren > NODE256_SHRINK_THRESHOLD + 1)
+    {
+        childRef->store(nullptr, std::memory_order_release);
+        node->numChildren--;
+        return;
+    }
+
+    if (node->numChildren == 2)
+    {
+        // Path compression: the node is replaced by its remaining child.
+        uint8_t keys[MAX_COPIED_CHILDREN];
+        Node*   children[MAX_COPIED_CHILDREN];
+        collectChildren(node, keys, children);
+        const uint16_t remaining = keys[0] == keyByte ? 1 : 0;
+        Node*          child     = children[remaining];
+
+        if (isLeaf(child))
+        {
+            ref->store(child, std::memory_order_release);
+        }
+        else
+        {
+            // Prefix of the merged node: prefix of the node, the key byte of the child and the prefix of the child.
+            const uint32_t prefixLen = node->prefixLen + 1 + child->prefixLen;
+            auto*          prefix    = static_cast<uint8_t*>(malloc(prefixLen));
+            assert(prefix != nullptr && "Memory allocation failed");
+            memcpy(prefix, nodePrefix(node), node->prefixLen);
+            prefix[node->prefixLen] = keys[remaining];
+            memcpy(prefix + node->prefixLen + 1, nodePrefix(child), child->prefixLen);
+            Node* merged = copyNode(child, prefix, prefixLen);
+            free(prefix);
+
+            ref->store(merged, std::memory_order_release);
+            reclaimNode(child);
+        }
+        reclaimNode(node);
+        return;
+    }
+
+    ref->store(copyNodeWithoutChild(node, keyByte), std::memory_order_release);
+    reclaimNode(node);
+}
+
+template <typename ValueType>
+ValueType* AdaptiveRadixTree<ValueType>::insertValue(const uint8_t* key, const uint32_t keyLen, ValueType* value,
+                                                     const bool replace, const bool inlineValue,
+                                                     ValueType** outputInserted)
+{
+    std::atomic<Node*>* ref   = &root;
+    uint32_t            depth = 0;
+    if (outputInserted != nullptr)
+    {
+        *outputInserted = nullptr;
+    }
+
+    while (true)
+    {
+        Node* node = ref->load(std::memory_order_relaxed);
+        if (node == nullptr)
+        {
+            ref->store(leafRef(allocateLeaf(key, keyLen, value, inlineValue, outputInserted)),
+                       std::memory_order_release);
+            numValues.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        if (isLeaf(node))
+        {
+            Leaf* leaf = asLeaf(node);
+            if (leafMatches(leaf, key, keyLen))
+            {
+                ValueType* oldValue = leaf->value.load(std::memory_order_relaxed);
+                if (replace)
+                {
+                    assert(!leaf->inlineValue && "Inline values cannot be replaced");
+                    leaf->value.store(value, std::memory_order_release);
+                }
+                return oldValue;
+            }
+
+            ref->store(splitLeaf(node, leafRef(allocateLeaf(key, keyLen, value, inlineValue, outputInserted)), depth),
+                       std::memory_order_release);
+            numValues.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        // The node may end up above the new value. Widening it too when it does not is harmless.
+        widenSummary(node, valueSummary(value));
+        if (const uint32_t mismatch = prefixMismatch(node, key, keyLen, depth); mismatch != node->prefixLen)
+        {
+            Node* newLeaf = leafRef(allocateLeaf(key, keyLen, value, inlineValue, outputInserted));
+            ref->store(splitPrefix(node, mismatch, newLeaf, depth), std::memory_order_release);
+            reclaimNode(node);
+            numValues.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        depth += node->prefixLen;
+
+        const uint8_t byte = keyByte(key, keyLen, depth);
+        if (std::atomic<Node*>* childRef = findChild(node, byte); childRef != nullptr)
+        {
+            ref = childRef;
+            depth++;
+            continue;
+        }
+
+        Node* newLeaf = leafRef(allocateLeaf(key, keyLen, value, inlineValue, outputInserted));
+        if (node->type == NODE256)
+        {
+            static_cast<Node256*>(node)->children[byte].store(newLeaf, std::memory_order_release);
+            node->numChildren++;
+        }
+        else
+        {
+            ref->store(copyNodeWithChild(node, byte, newLeaf), std::memory_order_release);
+            reclaimNode(node);
+        }
+        numValues.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+}
+
+template <typename ValueType> void AdaptiveRadixTree<ValueType>::destroyNode(Node* node) // NOLINT(misc-no-recursion)
+{
+    if (node == nullptr)
+    {
+        return;
+    }
+
+    if (!isLeaf(node))
+    {
+        if (node->type == NODE256)
+        {
+            for (std::atomic<Node*>& child : static_cast<Node256*>(node)->children)
+            {
+                destroyNode(child.load(std::memory_order_relaxed));
+            }
+        }
+        else
+        {
+            uint8_t        keys[MAX_COPIED_CHILDREN];
+            Node*          children[MAX_COPIED_CHILDREN];
+            const uint16_t numChildren = collectChildren(node, keys, children);
+            for (uint16_t i = 0; i < numChildren; i++)
+            {
+                destroyNode(children[i]);
+            }
+        }
+    }
+    freeNode(node);
+}
+
+template <typename ValueType> // NOLINTNEXTLINE(misc-no-recursion) The depth is bounded by the key length.
+int AdaptiveRadixTree<ValueType>::iterateNode(const Node* node, art_callback cb, void* data,
+                                              const art_summary_filter filter, void* filterData)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+
+    if (isLeaf(node))
+    {
+        const Leaf* leaf = asLeaf(node);
+        return cb(data, leafKey(leaf), leaf->keyLen, leaf->value.load(std::memory_order_acquire));
+    }
+
+    if (filter != nullptr && !filter(filterData, node->anyBits.load(std::memory_order_relaxed),
+                                     node->allBits.load(std::memory_order_relaxed)))
+    {
+        return 0;
+    }
+
+    int result = 0;
+    switch (node->type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            const std::atomic<Node*>* children = node->type == NODE4 ? static_cast<const Node4*>(node)->children
+                                                                     : static_cast<const Node16*>(node)->children;
+            for (uint16_t i = 0; i < node->numChildren && result == 0; i++)
+            {
+                result = iterateNode(children[i].load(std::memory_order_acquire), cb, data, filter, filterData);
+            }
+            break;
+        }
+        case NODE48:
+        {
+            const auto* node48 = static_cast<const Node48*>(node);
+            for (uint16_t i = 0; i < 256 && result == 0; i++)
+            {
+                if (node48->childIndex[i] != 0)
+                {
+                    result = iterateNode(node48->children[node48->childIndex[i] - 1].load(std::memory_order_acquire),
+                                         cb, data, filter, filterData);
+                }
+            }
+            break;
+        }
+        case NODE256:
+        {
+            const auto* node256 = static_cast<const Node256*>(node);
+            for (uint16_t i = 0; i < 256 && result == 0; i++)
+            {
+                result =
+                    iterateNode(node256->children[i].load(std::memory_order_acquire), cb, data, filter, filterData);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return result;
+}
+
+template <typename ValueType>
+ValueType* AdaptiveRadixTree<ValueType>::searchBelow(const Node* node, uint32_t depth, const uint32_t prefixLen,
+                                                     const uint8_t* key, const uint32_t keyLen)
+{
+    // Every key below the anchor starts with the prefix, so only the bytes after it are compared, from key.
+    while (node != nullptr)
+    {
+        if (isLeaf(node))
+        {
+            const Leaf* leaf = asLeaf(node);
+            return leaf->keyLen == prefixLen + keyLen && memcmp(leafKey(leaf) + prefixLen, key, keyLen) == 0
+                       ? leaf->value.load(std::memory_order_acquire)
+                       : nullptr;
+        }
+
+        const uint8_t* prefix = nodePrefix(node);
+        for (uint32_t i = depth < prefixLen ? prefixLen - depth : 0; i < node->prefixLen; i++)
+        {
+            if (prefix[i] != keyByte(key, keyLen, depth + i - prefixLen))
+            {
+                return nullptr;
+            }
+        }
+        depth += node->prefixLen;
+
+        const std::atomic<Node*>* childRef = findChild(node, keyByte(key, keyLen, depth - prefixLen));
+        if (childRef == nullptr)
+        {
+            return nullptr;
+        }
+        node = childRef->load(std::memory_order_acquire);
+        depth++;
+    }
+    return nullptr;
+}
+
+template <typename ValueType> // NOLINTNEXTLINE(misc-no-recursion) The depth is bounded by the key length.
+int AdaptiveRadixTree<ValueType>::iterateChildren(const Node* node, const uint32_t depth, const uint32_t begin,
+                                                  const uint8_t separator, art_callback cb, void* data)
+{
+    if (node == nullptr)
+    {
+        return 0;
+    }
+
+    if (isLeaf(node))
+    {
+        const Leaf* leaf = asLeaf(node);
+        if (leaf->keyLen <= begin)
+        {
+            return 0; // The key is the prefix itself, which is not a child.
+        }
+        if (const auto* end =
+                static_cast<const uint8_t*>(memchr(leafKey(leaf) + begin, separator, leaf->keyLen - begin));
+            end != nullptr)
+        {
+            return cb(data, leafKey(leaf), static_cast<uint32_t>(end - leafKey(leaf)) + 1, nullptr);
+        }
+        return cb(data, leafKey(leaf), leaf->keyLen, leaf->value.load(std::memory_order_acquire));
+    }
+
+    // A separator in the prefix of the node ends the single child that holds the whole subtree.
+    const uint32_t skipped = begin > depth ? begin - depth : 0;
+    if (skipped < node->prefixLen)
+    {
+        if (const auto* end =
+                static_cast<const uint8_t*>(memchr(nodePrefix(node) + skipped, separator, node->prefixLen - skipped));
+            end != nullptr)
+        {
+            const Leaf* leaf = minimumLeaf(node);
+            return leaf != nullptr
+                       ? cb(data, leafKey(leaf), depth + static_cast<uint32_t>(end - nodePrefix(node)) + 1, nullptr)
+                       : 0;
+        }
+    }
+
+    const uint32_t childDepth = depth + node->prefixLen;
+    int            result     = 0;
+    switch (node->type)
+    {
+        case NODE4:
+        case NODE16:
+        {
+            const uint8_t*            keys     = node->type == NODE4 ? static_cast<const Node4*>(node)->keys
+                                                                     : static_cast<const Node16*>(node)->keys;
+            const std::atomic<Node*>* children = node->type == NODE4 ? static_cast<const Node4*>(node)->children
+                                                                     : static_cast<const Node16*>(node)->children;
+            for (uint16_t i = 0; i < node->numChildren && result == 0; i++)
+            {
+                result = visitChild(children[i].load(std::memory_order_acquire), childDepth, keys[i], begin, separator,
+                                    cb, data);
+            }
+            break;
+        }
+        case NODE48:
+        {
+            const auto* node48 = static_cast<const Node48*>(node);
+            for (uint16_t i = 0; i < 256 && result == 0; i++)
+            {
+                if (node48->childIndex[i] != 0)
+                {
+                    result = visitChild(node48->children[node48->childIndex[i] - 1].load(std::memory_order_acquire),
+                                        childDepth, static_cast<uint8_t>(i), begin, separator, cb, data);
+                }
+            }
+            break;
+        }
+        case NODE256:
+        {
+            const auto* node256 = static_cast<const Node256*>(node);
+            for (uint16_t i = 0; i < 256 && result == 0; i++)
+            {
+                result = visitChild(node256->children[i].load(std::memory_order_acquire), childDepth,
+                                    static_cast<uint8_t>(i), begin, separator, cb, data);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return result;
+}
+
+template <typename ValueType> // NOLINTNEXTLINE(misc-no-recursion) The depth is bounded by the key length.
+int AdaptiveRadixTree<ValueType>::visitChild(const Node* child, const uint32_t depth, const uint8_t keyByte,
+                                             const uint32_t begin, const uint8_t separator, art_callback cb, void* data)
+{
+    if (child == nullptr || keyByte != separator || isLeaf(child))
+    {
+        // A leaf finds the separator in its own key.
+        return iterateChildren(child, depth + 1, begin, separator, cb, data);
+    }
+
+    // The key byte of the child is the separator, which ends the child of every key below it.
+    const Leaf* leaf = minimumLeaf(child);
+    return leaf != nullptr ? cb(data, leafKey(leaf), depth + 1, nullptr) : 0;
+}
+
+#endif // ADAPTIVERADIXTREE_H
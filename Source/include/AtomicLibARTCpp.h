@@ -1,8 +1,19 @@
 #ifndef ATOMICLIBARTCPP_H
 #define ATOMICLIBARTCPP_H
 
+#include <algorithm>
+#include "AdaptiveRadixTree.h"
+#include "BigReaderLock.h"
+#include "EpochManager.h"
 #include "OSInterface.h"
-#include "libartcpp.h"
+
+#ifndef CONFIG_SETTINGS_STORAGE_LOCK_FREE_READS
+    #define CONFIG_SETTINGS_STORAGE_LOCK_FREE_READS false
+#endif
+
+#ifndef CONFIG_SETTINGS_STORAGE_BIG_READER_LOCK
+    #define CONFIG_SETTINGS_STORAGE_BIG_READER_LOCK false
+#endif
 
 extern const uint32_t SETTINGS_STORAGE_MUTEX_TIMEOUT_MS; // Defined in SettingsStorage.cpp
 
@@ -10,14 +21,45 @@ extern const uint32_t SETTINGS_STORAGE_MUTEX_TIMEOUT_MS; // Defined in SettingsS
  * @brief A C++ wrapper for the ART library with atomic operations
  * It can store pointers to types of template typename ValueType
  * The user is responsable for the memory management of the values stored in the tree.
+ *
+ * Writers are always serialized among themselves. Readers are synchronized with them depending on the read mode:
+ * — GateReads: readers and writers share a fair readers-writer gate, so writers wait for the readers to leave the tree.
+ * — EpochReads: readers do not use any OS primitive, they only announce themselves in an EpochManager. Writers run
+ * concurrently with them, and the nodes they replace are released once the readers that may be using them are done.
+ * — BigReaderReads: readers and writers share a BigReaderLock, so readers only update the counter of their CPU, while
+ * writers wait for the counters of every CPU to drop to zero.
+ * The lock acquisitions and timeouts are recorded in a LockStatistics, returned by getLockStats().
  */
+template <typename ValueType, uint32_t NumShards> class ShardedAdaptiveRadixTree;
+
 template <typename ValueType> class AtomicAdaptiveRadixTree : public AdaptiveRadixTree<ValueType>
 {
+    /// The sharded tree holds the read sections of all its shards at once, and checks their write sequences, see
+    /// ShardedAdaptiveRadixTree::collectEntries().
+    template <typename, uint32_t> friend class ShardedAdaptiveRadixTree;
+
 public:
+    /// Enum with the ways readers can be synchronized with writers.
+    typedef enum
+    {
+        GateReads,
+        EpochReads,
+        BigReaderReads
+    } ReadMode_t;
+
+    /// The read mode selected by the configuration.
+    static constexpr ReadMode_t DEFAULT_READ_MODE = CONFIG_SETTINGS_STORAGE_LOCK_FREE_READS   ? EpochReads
+                                                    : CONFIG_SETTINGS_STORAGE_BIG_READER_LOCK ? BigReaderReads
+                                                                                              : GateReads;
+
     /**
      * @brief Construct a new Adaptive Radix Tree object
+     * @param osInterface The OS shim object used to create the synchronization primitives.
+     * @param readMode The way readers are synchronized with writers.
+     * @param nodeAllocator The allocator of the nodes and leaves, or nullptr to let the tree create its own.
      */
-    explicit AtomicAdaptiveRadixTree(OSInterface& osInterface);
+    explicit AtomicAdaptiveRadixTree(OSInterface& osInterface, ReadMode_t readMode = DEFAULT_READ_MODE,
+                                     NodeAllocator* nodeAllocator = nullptr);
 
     /**
      * @brief Destroy the Adaptive Radix Tree object
@@ -58,6 +100,49 @@ public:
      */
     ValueType* insertIfNotExists(const char* key, int key_len, ValueType* value) override;
 
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insertInlineIfNotExists(const char* key, int key_len, const ValueType& value) override;
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace), telling an existing key
+     * apart from a lock timeout
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @param outputExisting Set to NULL if the item was newly inserted, otherwise to the value the key already had.
+     * @param outputInserted Optional output set to the value copied into the leaf if the item was newly inserted,
+     * otherwise to NULL.
+     * @return True if the insertion was done, false if the lock of the tree could not be taken in time.
+     */
+    bool tryInsertInlineIfNotExists(const char* key, int key_len, const ValueType& value, ValueType*& outputExisting,
+                                    ValueType** outputInserted = nullptr) override;
+
+    /**
+     * @brief Insert copies of several values into the leaves of new keys of the art tree (no replace), all of them in
+     * a single write section.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param values The values copied into the leaves
+     * @param outputExisting Output array of count pointers, set to null for each newly inserted key, otherwise to the
+     * value the key already had.
+     * @param outputInserted Optional output array of count pointers, set to the value copied into the leaf of each
+     * newly inserted key, otherwise to null.
+     * @return True if the batch was inserted, false if the tree could not be updated.
+     */
+    bool insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens, size_t count,
+                                      const ValueType* values, ValueType** outputExisting,
+                                      ValueType** outputInserted = nullptr) override;
+
     /**
      * @brief Searches for a value in the ART tree
      *
@@ -68,6 +153,16 @@ public:
      */
     ValueType* deleteValue(const char* key, int key_len) override;
 
+    /**
+     * @brief Deletes a value from the ART tree, telling a missing key apart from a lock timeout
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the deletion was done, false if the lock of the tree could not be taken in time.
+     */
+    bool tryDeleteValue(const char* key, int key_len, ValueType*& outputValue) override;
+
     /**
      * @brief Searches for a value in the ART tree
      *
@@ -78,6 +173,27 @@ public:
      */
     ValueType* search(const char* key, int key_len) override;
 
+    /**
+     * @brief Searches for a value in the ART tree, telling a missing key apart from a lock timeout
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the lock of the tree could not be taken in time.
+     */
+    bool trySearch(const char* key, int key_len, ValueType*& outputValue) override;
+
+    /**
+     * @brief Searches for several values in the ART tree, all of them in a single read section.
+     * If the read section fails, no value is found.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param outputValues Output array of count pointers, set to the value of each key or NULL if it was not found
+     * @return True if the search was done, false if the lock of the tree could not be taken in time.
+     */
+    bool searchBatch(const char* const* keys, const int* key_lens, size_t count, ValueType** outputValues) override;
+
     /**
      * Iterates through the entries pairs in the map,
      * invoking a callback for each.
@@ -85,9 +201,12 @@ public:
      * If the callback returns non-zero, then the iteration stops.
      * @param cb The callback function to invoke
      * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
      * @return Zero on success, or the return of the callback.
      */
-    int iterateOverAll(art_callback cb, void* data) override;
+    int iterateOverAll(art_callback cb, void* data, art_summary_filter filter = nullptr,
+                       void* filterData = nullptr) override;
 
     /**
      * Iterates through the entry pairs in the map,
@@ -98,9 +217,48 @@ public:
      * @param prefix_len The length of the prefix
      * @param cb The callback function to invoke
      * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
      * @return Zero on success, or the return of the callback.
      */
-    int iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb, void* data) override;
+    int iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb, void* data,
+                          art_summary_filter filter = nullptr, void* filterData = nullptr) override;
+
+    /**
+     * Iterates through the immediate children of a prefix, like the entries of a directory, in order.
+     * A child is the part of a key that follows the prefix up to the next separator. The callback gets the key up to
+     * the end of each child: a key without a separator after the prefix is passed with its value, while the keys that
+     * continue past a separator are passed once per distinct child, as the key up to and including the separator with
+     * a NULL value. Such keys are not null terminated.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of the children
+     * @param prefix_len The length of the prefix
+     * @param separator The byte that ends a child.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverChildren(const char* prefix, int prefix_len, char separator, art_callback cb, void* data) override;
+
+    /**
+     * @brief Take an anchor on a key prefix, see art_anchor.
+     * @param prefix The prefix
+     * @param prefix_len The length of the prefix
+     * @param outputAnchor The anchor of the prefix.
+     * @return True if the anchor was taken, false if the tree could not take it.
+     */
+    bool findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor) override;
+
+    /**
+     * @brief Searches for a value in the ART tree from an anchor, with the part of its key that follows the prefix of
+     * the anchor.
+     * @param anchor The anchor taken by findAnchor().
+     * @param key The key without the prefix of the anchor
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the anchor is stale and has to be taken again.
+     */
+    bool searchFromAnchor(const art_anchor& anchor, const char* key, int key_len, ValueType*& outputValue) override;
 
     /**
      * @brief Returns the minimum valued leaf value in the tree
@@ -116,24 +274,59 @@ public:
      */
     ValueType* getMaximumValue() override;
 
+    /**
+     * @brief Get the contention figures of the lock protecting the tree
+     *
+     * @return The lock statistics
+     */
+    LockStats_t getLockStats() override;
+
+protected:
+    using typename AdaptiveRadixTree<ValueType>::Node;
+
+    void reclaimNode(Node* node) override;
+
 private:
-    [[nodiscard]] bool           preWrite() const;
-    void                         postWrite() const;
-    [[nodiscard]] bool           preRead();
-    [[nodiscard]] bool           postRead();
+    /// State of a read section, from preRead() to postRead().
+    typedef struct
+    {
+        uint32_t readerEpoch; // Epoch of the reader, or counter of the big-reader lock it was added to.
+        uint64_t acquiredUs;  // Time the read section started, for the lock statistics.
+    } ReadSection_t;
+
+    [[nodiscard]] bool           preWrite();
+    void                         postWrite();
+    [[nodiscard]] bool           preRead(ReadSection_t& readSection);
+    void                         postRead(const ReadSection_t& readSection);
+    [[nodiscard]] bool           lockWrites();
+    void                         unlockWrites();
+    [[nodiscard]] bool           lockReads(uint32_t& readerEpoch);
+    void                         unlockReads(uint32_t readerEpoch);
+    static void                  reclaimNodeCallback(void* context, void* node);
     OSInterface*                 osInterface;
     OSInterface_BinarySemaphore* empty;
     OSInterface_BinarySemaphore* turn;
     OSInterface_Mutex*           readersMutex;
     uint32_t                     readers;
+    ReadMode_t                   readMode;
+    std::atomic<uint32_t>        writeSequence; // Odd while a writer modifies the tree. Only changed in EpochReads mode.
+    EpochManager                 epochManager;
+    BigReaderLock                bigReaderLock;
+    LockStatistics               lockStatistics;
+    uint64_t                     writeAcquiredUs; // Time the current write section started, for the lock statistics.
 };
 
-template <typename ValueType> AtomicAdaptiveRadixTree<ValueType>::AtomicAdaptiveRadixTree(OSInterface& osInterface) :
-    AdaptiveRadixTree<ValueType>()
+template <typename ValueType>
+AtomicAdaptiveRadixTree<ValueType>::AtomicAdaptiveRadixTree(OSInterface& osInterface, const ReadMode_t readMode,
+                                                            NodeAllocator* nodeAllocator) :
+    AdaptiveRadixTree<ValueType>(nodeAllocator), bigReaderLock(osInterface)
 {
-    this->readers     = 0;
-    this->osInterface = &osInterface;
-    this->empty       = osInterface.osCreateBinarySemaphore();
+    this->readMode        = readMode;
+    this->readers         = 0;
+    this->writeAcquiredUs = 0;
+    this->writeSequence.store(0, std::memory_order_relaxed);
+    this->osInterface     = &osInterface;
+    this->empty           = osInterface.osCreateBinarySemaphore();
     assert(this->empty != nullptr && "Semaphore creation failed");
     this->turn = osInterface.osCreateBinarySemaphore();
     assert(this->turn != nullptr && "Semaphore creation failed");
@@ -147,6 +340,7 @@ template <typename ValueType> AtomicAdaptiveRadixTree<ValueType>::AtomicAdaptive
 
 template <typename ValueType> AtomicAdaptiveRadixTree<ValueType>::~AtomicAdaptiveRadixTree()
 {
+    // The retired nodes are released by the epoch manager destructor, while the base tree is still alive.
     delete this->empty;
     delete this->turn;
     delete this->readersMutex;
@@ -154,13 +348,12 @@ template <typename ValueType> AtomicAdaptiveRadixTree<ValueType>::~AtomicAdaptiv
 
 template <typename ValueType> uint64_t AtomicAdaptiveRadixTree<ValueType>::size()
 {
-    if (preRead())
+    ReadSection_t readSection;
+    if (preRead(readSection))
     {
         const uint64_t size = AdaptiveRadixTree<ValueType>::size();
-        if (postRead())
-        {
-            return size;
-        }
+        postRead(readSection);
+        return size;
     }
     return 0;
 }
@@ -189,6 +382,62 @@ ValueType* AtomicAdaptiveRadixTree<ValueType>::insertIfNotExists(const char* key
     return nullptr;
 }
 
+template <typename ValueType> ValueType*
+AtomicAdaptiveRadixTree<ValueType>::insertInlineIfNotExists(const char* key, int key_len, const ValueType& value)
+{
+    if (preWrite())
+    {
+        ValueType* result = AdaptiveRadixTree<ValueType>::insertInlineIfNotExists(key, key_len, value);
+        postWrite();
+        return result;
+    }
+    return nullptr;
+}
+
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::tryInsertInlineIfNotExists(const char* key, int key_len,
+                                                                    const ValueType& value, ValueType*& outputExisting,
+                                                                    ValueType** outputInserted)
+{
+    if (preWrite())
+    {
+        const bool result = AdaptiveRadixTree<ValueType>::tryInsertInlineIfNotExists(key, key_len, value,
+                                                                                      outputExisting, outputInserted);
+        postWrite();
+        return result;
+    }
+    outputExisting = nullptr;
+    if (outputInserted != nullptr)
+    {
+        *outputInserted = nullptr;
+    }
+    return false;
+}
+
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens,
+                                                                      const size_t count, const ValueType* values,
+                                                                      ValueType** outputExisting,
+                                                                      ValueType** outputInserted)
+{
+    if (preWrite())
+    {
+        const bool result = AdaptiveRadixTree<ValueType>::insertInlineBatchIfNotExists(
+            keys, key_lens, count, values, outputExisting, outputInserted);
+        postWrite();
+        return result;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        outputExisting[i] = nullptr;
+        if (outputInserted != nullptr)
+        {
+            outputInserted[i] = nullptr;
+        }
+    }
+    return false;
+}
+
 template <typename ValueType> ValueType* AtomicAdaptiveRadixTree<ValueType>::deleteValue(const char* key, int key_len)
 {
     if (preWrite())
@@ -200,91 +449,276 @@ template <typename ValueType> ValueType* AtomicAdaptiveRadixTree<ValueType>::del
     return nullptr;
 }
 
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::tryDeleteValue(const char* key, int key_len, ValueType*& outputValue)
+{
+    if (preWrite())
+    {
+        outputValue = AdaptiveRadixTree<ValueType>::deleteValue(key, key_len);
+        postWrite();
+        return true;
+    }
+    outputValue = nullptr;
+    return false;
+}
+
 template <typename ValueType> ValueType* AtomicAdaptiveRadixTree<ValueType>::search(const char* key, int key_len)
 {
-    if (preRead())
+    ReadSection_t readSection;
+    if (preRead(readSection))
     {
         ValueType* result = AdaptiveRadixTree<ValueType>::search(key, key_len);
-        if (postRead())
-        {
-            return result;
-        }
+        postRead(readSection);
+        return result;
     }
     return nullptr;
 }
 
-template <typename ValueType> int AtomicAdaptiveRadixTree<ValueType>::iterateOverAll(art_callback cb, void* data)
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::trySearch(const char* key, int key_len, ValueType*& outputValue)
 {
-    if (preRead())
+    ReadSection_t readSection;
+    if (preRead(readSection))
     {
-        const int result = AdaptiveRadixTree<ValueType>::iterateOverAll(cb, data);
-        if (postRead())
-        {
-            return result;
-        }
+        outputValue = AdaptiveRadixTree<ValueType>::search(key, key_len);
+        postRead(readSection);
+        return true;
+    }
+    outputValue = nullptr;
+    return false;
+}
+
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::searchBatch(const char* const* keys, const int* key_lens, const size_t count,
+                                                     ValueType** outputValues)
+{
+    ReadSection_t readSection;
+    if (preRead(readSection))
+    {
+        AdaptiveRadixTree<ValueType>::searchBatch(keys, key_lens, count, outputValues);
+        postRead(readSection);
+        return true;
+    }
+    std::fill_n(outputValues, count, nullptr);
+    return false;
+}
+
+template <typename ValueType>
+int AtomicAdaptiveRadixTree<ValueType>::iterateOverAll(art_callback cb, void* data, const art_summary_filter filter,
+                                                       void* filterData)
+{
+    ReadSection_t readSection;
+    if (preRead(readSection))
+    {
+        const int result = AdaptiveRadixTree<ValueType>::iterateOverAll(cb, data, filter, filterData);
+        postRead(readSection);
+        return result;
     }
     return -1;
 }
 
-template <typename ValueType> int
-AtomicAdaptiveRadixTree<ValueType>::iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb, void* data)
+template <typename ValueType>
+int AtomicAdaptiveRadixTree<ValueType>::iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb,
+                                                          void* data, const art_summary_filter filter,
+                                                          void* filterData)
 {
-    if (preRead())
+    ReadSection_t readSection;
+    if (preRead(readSection))
     {
-        const int result = AdaptiveRadixTree<ValueType>::iterateOverPrefix(prefix, prefix_len, cb, data);
-        if (postRead())
-        {
-            return result;
-        }
+        const int result =
+            AdaptiveRadixTree<ValueType>::iterateOverPrefix(prefix, prefix_len, cb, data, filter, filterData);
+        postRead(readSection);
+        return result;
+    }
+    return -1;
+}
+
+template <typename ValueType>
+int AtomicAdaptiveRadixTree<ValueType>::iterateOverChildren(const char* prefix, int prefix_len, const char separator,
+                                                            art_callback cb, void* data)
+{
+    ReadSection_t readSection;
+    if (preRead(readSection))
+    {
+        const int result = AdaptiveRadixTree<ValueType>::iterateOverChildren(prefix, prefix_len, separator, cb, data);
+        postRead(readSection);
+        return result;
     }
     return -1;
 }
 
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor)
+{
+    ReadSection_t readSection;
+    if (preRead(readSection))
+    {
+        const bool result = AdaptiveRadixTree<ValueType>::findAnchor(prefix, prefix_len, outputAnchor);
+        postRead(readSection);
+        return result;
+    }
+    return false;
+}
+
+template <typename ValueType>
+bool AtomicAdaptiveRadixTree<ValueType>::searchFromAnchor(const art_anchor& anchor, const char* key, int key_len,
+                                                          ValueType*& outputValue)
+{
+    ReadSection_t readSection;
+    if (preRead(readSection))
+    {
+        const bool result = AdaptiveRadixTree<ValueType>::searchFromAnchor(anchor, key, key_len, outputValue);
+        postRead(readSection);
+        return result;
+    }
+    return false;
+}
+
 template <typename ValueType> ValueType* AtomicAdaptiveRadixTree<ValueType>::getMinimumValue()
 {
-    if (preRead())
+    ReadSection_t readSection;
+    if (preRead(readSection))
     {
         ValueType* result = AdaptiveRadixTree<ValueType>::getMinimumValue();
-        if (postRead())
-        {
-            return result;
-        }
+        postRead(readSection);
+        return result;
     }
     return nullptr;
 }
 
 template <typename ValueType> ValueType* AtomicAdaptiveRadixTree<ValueType>::getMaximumValue()
 {
-    if (preRead())
+    ReadSection_t readSection;
+    if (preRead(readSection))
     {
         ValueType* result = AdaptiveRadixTree<ValueType>::getMaximumValue();
-        if (postRead())
-        {
-            return result;
-        }
+        postRead(readSection);
+        return result;
     }
     return nullptr;
 }
 
-template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::preWrite() const
+template <typename ValueType> LockStats_t AtomicAdaptiveRadixTree<ValueType>::getLockStats()
+{
+    return lockStatistics.getStats();
+}
+
+template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::reclaimNode(Node* node)
+{
+    if (readMode == EpochReads)
+    {
+        epochManager.retire(node, reclaimNodeCallback, this);
+    }
+    else
+    {
+        AdaptiveRadixTree<ValueType>::reclaimNode(node);
+    }
+}
+
+template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::reclaimNodeCallback(void* context, void* node)
+{
+    static_cast<AtomicAdaptiveRadixTree*>(context)->freeNode(static_cast<Node*>(node));
+}
+
+template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::preWrite()
+{
+    const uint64_t waitStartUs = LockStatistics::now();
+    if (!lockWrites())
+    {
+        lockStatistics.recordTimeout(LockStatistics::WRITES);
+        return false;
+    }
+    writeAcquiredUs = LockStatistics::now();
+    lockStatistics.recordAcquisition(LockStatistics::WRITES, waitStartUs, writeAcquiredUs);
+    return true;
+}
+
+template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::postWrite()
+{
+    lockStatistics.recordRelease(LockStatistics::WRITES, writeAcquiredUs);
+    unlockWrites();
+}
+
+template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::preRead(ReadSection_t& readSection)
+{
+    const uint64_t waitStartUs = LockStatistics::now();
+    if (!lockReads(readSection.readerEpoch))
+    {
+        lockStatistics.recordTimeout(LockStatistics::READS);
+        return false;
+    }
+    readSection.acquiredUs = LockStatistics::now();
+    lockStatistics.recordAcquisition(LockStatistics::READS, waitStartUs, readSection.acquiredUs);
+    return true;
+}
+
+template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::postRead(const ReadSection_t& readSection)
+{
+    lockStatistics.recordRelease(LockStatistics::READS, readSection.acquiredUs);
+    unlockReads(readSection.readerEpoch);
+}
+
+template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::lockWrites()
 {
+    if (readMode == BigReaderReads)
+    {
+        return bigReaderLock.writeLock(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS);
+    }
+
     if (!turn->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
     {
         // ReSharper disable once CppDFAUnreachableCode False positive
         return false;
     }
+    // In epoch mode the readers do not use the gate, so the turn semaphore is enough to serialize the writers. The
+    // write sequence tells the readers that need a single point in time that a write overlapped them.
     // ReSharper disable once CppDFAUnreachableCode False positive
-    return empty->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS);
+    if (readMode == EpochReads)
+    {
+        writeSequence.store(writeSequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return true;
+    }
+    if (empty->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
+    {
+        return true;
+    }
+    // The readers did not leave in time. The turn is given back, so they are not locked out by this writer.
+    turn->signal();
+    return false;
 }
 
-template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::postWrite() const
+template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::unlockWrites()
 {
+    if (readMode == BigReaderReads)
+    {
+        bigReaderLock.writeUnlock();
+        return;
+    }
+
+    if (readMode == EpochReads)
+    {
+        writeSequence.store(writeSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        turn->signal();
+        return;
+    }
     turn->signal();
     empty->signal();
 }
 
-template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::preRead()
+template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::lockReads(uint32_t& readerEpoch)
 {
+    if (readMode == EpochReads)
+    {
+        readerEpoch = epochManager.enter();
+        return true;
+    }
+    if (readMode == BigReaderReads)
+    {
+        // The reader epoch holds the counter the reader was added to.
+        return bigReaderLock.readLock(readerEpoch, SETTINGS_STORAGE_MUTEX_TIMEOUT_MS);
+    }
+
     if (!turn->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
     {
         // ReSharper disable once CppDFAUnreachableCode False positive
@@ -301,6 +735,9 @@ template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::preRead()
     {
         if (!empty->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
         {
+            // The writer did not leave in time. The next reader tries to take the gate instead.
+            readers--;
+            readersMutex->signal();
             return false;
         }
     }
@@ -308,20 +745,30 @@ template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::preRead()
     return true;
 }
 
-template <typename ValueType> bool AtomicAdaptiveRadixTree<ValueType>::postRead()
+template <typename ValueType> void AtomicAdaptiveRadixTree<ValueType>::unlockReads(const uint32_t readerEpoch)
 {
-    if (!readersMutex->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
+    if (readMode == EpochReads)
+    {
+        epochManager.exit(readerEpoch);
+        return;
+    }
+    if (readMode == BigReaderReads)
+    {
+        bigReaderLock.readUnlock(readerEpoch);
+        return;
+    }
+
+    // A reader must always leave the gate, or the last one would never signal it empty and every writer would time
+    // out. The readers mutex is only held by the readers that enter or leave, so the wait is retried until it succeeds.
+    while (!readersMutex->wait(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS))
     {
-        return false;
     }
-    // ReSharper disable once CppDFAUnreachableCode False positive
     readers--;
     if (readers == 0)
     {
         empty->signal();
     }
     readersMutex->signal();
-    return true;
 }
 
 #endif // ATOMICLIBARTCPP_H
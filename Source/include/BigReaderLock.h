@@ -0,0 +1,100 @@
+#ifndef BIGREADERLOCK_H
+#define BIGREADERLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "OSInterface.h"
+
+/**
+ * @brief Readers-writer lock whose readers only touch the counter of their CPU (big-reader lock).
+ *
+ * Each reader increments a counter placed in its own cache line, picked by the CPU it runs on, and checks that no
+ * writer holds the lock. A writer raises its flag, then waits for the counter of every CPU to drop to zero, so the
+ * writers pay for the readers' scalability. Writers are preferred: new readers back off while a writer is waiting.
+ * The waits sleep until they are woken by the last reader of a counter or by the writer leaving: on futexes on Linux,
+ * on binary semaphores created through the OSInterface on other systems.
+ */
+class BigReaderLock
+{
+public:
+    /**
+     * @brief Build an unlocked lock.
+     * @param osInterface The OS interface used to create the semaphores the waits sleep on, when futexes are not
+     * available.
+     */
+    explicit BigReaderLock(OSInterface& osInterface);
+
+    /**
+     * @brief Destroy the lock, which must not be held.
+     */
+    ~BigReaderLock();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    BigReaderLock& operator=(BigReaderLock&&) = delete;
+
+    /**
+     * @brief Lock for reading, along with other readers.
+     * @param outputSlot Set to the counter the reader was added to, which must be passed to readUnlock().
+     * @param timeoutMs Maximum time to wait for the writer to leave.
+     * @return True if the lock was taken, false if it timed out.
+     */
+    [[nodiscard]] bool readLock(uint32_t& outputSlot, uint32_t timeoutMs);
+
+    /**
+     * @brief Unlock a read lock taken with readLock(), in any thread.
+     * @param slot The counter returned by readLock().
+     */
+    void readUnlock(uint32_t slot);
+
+    /**
+     * @brief Lock for writing, excluding the readers and the other writers.
+     * @param timeoutMs Maximum time to wait for the other writer and for the readers to leave.
+     * @return True if the lock was taken, false if it timed out.
+     */
+    [[nodiscard]] bool writeLock(uint32_t timeoutMs);
+
+    /**
+     * @brief Unlock a write lock taken with writeLock().
+     */
+    void writeUnlock();
+
+private:
+    /// Number of reader counters. CPUs beyond it share their counter with another one.
+    static constexpr uint32_t READER_SLOTS = 16;
+
+    struct alignas(64) ReaderSlot_t
+    {
+        std::atomic<uint32_t> readers;
+    };
+
+    /// Threads sleeping until a word changes, when futexes are not available.
+    typedef struct
+    {
+        OSInterface_BinarySemaphore* semaphore; // Signaled when the word changes while threads are waiting.
+        std::atomic<uint32_t>        waiters;   // Number of threads waiting, or about to wait, on the semaphore.
+    } WaitQueue_t;
+
+    ReaderSlot_t          readerSlots[READER_SLOTS];
+    std::atomic<uint32_t> writer;        // 1 while a writer holds or waits for the lock, 0 otherwise.
+    WaitQueue_t           writerWaiters; // Readers and writers waiting for the writer to leave.
+    WaitQueue_t           readersWaiter; // Writer waiting for the readers of a counter to leave.
+
+    static uint32_t readerSlotIndex();
+    void            leave(uint32_t slot);
+
+    /**
+     * @brief Wait until a word does not hold a value anymore, or a deadline is reached.
+     * @param queue The queue the waiting thread sleeps on, when futexes are not available.
+     * @return False if the deadline was reached.
+     */
+    static bool waitWhileEquals(const std::atomic<uint32_t>& word, uint32_t value,
+                                std::chrono::steady_clock::time_point deadline, WaitQueue_t& queue);
+
+    /// Wake the threads waiting on a word in waitWhileEquals(), after the word was changed.
+    static void wake(std::atomic<uint32_t>& word, WaitQueue_t& queue);
+};
+
+#endif // BIGREADERLOCK_H
@@ -0,0 +1,910 @@
+#ifndef CONCURRENTADAPTIVERADIXTREE_H
+#define CONCURRENTADAPTIVERADIXTREE_H
+
+#include <algorithm>
+#include <chrono>
+#include "AdaptiveRadixTree.h"
+#include "EpochManager.h"
+#include "OSInterface.h"
+
+extern const uint32_t SETTINGS_STORAGE_MUTEX_TIMEOUT_MS; // Defined in SettingsStorage.cpp
+
+/**
+ * @brief An Adaptive Radix Tree that can be used by several readers and writers at the same time.
+ * It can store pointers to types of template typename ValueType
+ * The user is responsable for the memory management of the values stored in the tree.
+ *
+ * The tree follows the ROWEX (Read-Optimized Write EXclusion) protocol instead of locking the whole tree:
+ * — Readers never lock. The nodes are never modified in a way a reader could observe half-done (see AdaptiveRadixTree),
+ * so readers only announce themselves in an EpochManager to keep the nodes they may be using alive.
+ * — Writers traverse the tree like readers, and then lock only the nodes they are going to modify: the node whose child
+ * slot changes and, when that node is replaced by a copy, its parent. Locks are always taken top-down. A replaced node
+ * is marked as obsolete before being unlocked, so a writer that locks an obsolete or changed node restarts from the
+ * root. Therefore, writers working on different subtrees never wait for each other.
+ * A writer waiting for a node lock sleeps on a semaphore created through the OSInterface, and gives up once
+ * SETTINGS_STORAGE_MUTEX_TIMEOUT_MS have elapsed since the write started. The writes and their timeouts are recorded in
+ * a LockStatistics, returned by getLockStats(); the readers are not, as they never wait.
+ */
+template <typename ValueType> class ConcurrentAdaptiveRadixTree : public AdaptiveRadixTree<ValueType>
+{
+public:
+    /**
+     * @brief Construct a new Adaptive Radix Tree object
+     * @param osInterface The OS shim object, used to create the semaphore the writers waiting for a node sleep on.
+     * @param nodeAllocator The allocator of the nodes and leaves, or nullptr to let the tree create its own.
+     */
+    explicit ConcurrentAdaptiveRadixTree(OSInterface& osInterface, NodeAllocator* nodeAllocator = nullptr);
+
+    /**
+     * @brief Destroy the Adaptive Radix Tree object
+     */
+    ~ConcurrentAdaptiveRadixTree() override;
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    ConcurrentAdaptiveRadixTree& operator=(ConcurrentAdaptiveRadixTree&&) = delete;
+
+    /**
+     * @brief Get the size of the tree
+     *
+     * @return uint64_t size
+     */
+    uint64_t size() override;
+
+    /**
+     * @brief Insert a new value into the art tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value opaque value.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insert(const char* key, int key_len, ValueType* value) override;
+
+    /**
+     * @brief Insert a new value into the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value opaque value.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insertIfNotExists(const char* key, int key_len, ValueType* value) override;
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insertInlineIfNotExists(const char* key, int key_len, const ValueType& value) override;
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @param outputExisting Set to NULL if the item was newly inserted, otherwise to the value the key already had.
+     * @param outputInserted Optional output set to the value copied into the leaf if the item was newly inserted,
+     * otherwise to NULL.
+     * @return True if the insertion was done, false if the nodes to modify could not be locked in time.
+     */
+    bool tryInsertInlineIfNotExists(const char* key, int key_len, const ValueType& value, ValueType*& outputExisting,
+                                    ValueType** outputInserted = nullptr) override;
+
+    /**
+     * @brief Insert copies of several values into the leaves of new keys of the art tree (no replace).
+     * If the tree is empty and the keys are sorted, the whole tree is built while the root slot is locked.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param values The values copied into the leaves
+     * @param outputExisting Output array of count pointers, set to null for each newly inserted key, otherwise to the
+     * value the key already had.
+     * @param outputInserted Optional output array of count pointers, set to the value copied into the leaf of each
+     * newly inserted key, otherwise to null.
+     * @return True if the batch was inserted, false if the nodes to modify could not be locked in time for some keys,
+     * whose outputs are then set to null. The other keys of the batch are inserted anyway.
+     */
+    bool insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens, size_t count,
+                                      const ValueType* values, ValueType** outputExisting,
+                                      ValueType** outputInserted = nullptr) override;
+
+    /**
+     * @brief Deletes a value from the ART tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @return NULL if the item was not found, otherwise
+     * the value pointer is returned.
+     */
+    ValueType* deleteValue(const char* key, int key_len) override;
+
+    /**
+     * @brief Deletes a value from the ART tree, telling a missing key apart from a tree that could not be updated
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the deletion was done, false if the nodes to modify could not be locked in time.
+     */
+    bool tryDeleteValue(const char* key, int key_len, ValueType*& outputValue) override;
+
+    /**
+     * @brief Searches for a value in the ART tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @return NULL if the item was not found, otherwise
+     * the value pointer is returned.
+     */
+    ValueType* search(const char* key, int key_len) override;
+
+    /**
+     * @brief Searches for several values in the ART tree, all of them in a single epoch.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param outputValues Output array of count pointers, set to the value of each key or NULL if it was not found
+     * @return True, as readers never wait.
+     */
+    bool searchBatch(const char* const* keys, const int* key_lens, size_t count, ValueType** outputValues) override;
+
+    /**
+     * Iterates through the entries pairs in the map,
+     * invoking a callback for each.
+     * The callback gets a key value for each and returns an integer stop value.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverAll(art_callback cb, void* data, art_summary_filter filter = nullptr,
+                       void* filterData = nullptr) override;
+
+    /**
+     * Iterates through the entry pairs in the map,
+     * invoking a callback for each that matches a given prefix.
+     * The callback gets a key value for each and returns an integer stop value.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of keys to read
+     * @param prefix_len The length of the prefix
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb, void* data,
+                          art_summary_filter filter = nullptr, void* filterData = nullptr) override;
+
+    /**
+     * Iterates through the immediate children of a prefix, like the entries of a directory, in order.
+     * A child is the part of a key that follows the prefix up to the next separator. The callback gets the key up to
+     * the end of each child: a key without a separator after the prefix is passed with its value, while the keys that
+     * continue past a separator are passed once per distinct child, as the key up to and including the separator with
+     * a NULL value. Such keys are not null terminated.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of the children
+     * @param prefix_len The length of the prefix
+     * @param separator The byte that ends a child.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverChildren(const char* prefix, int prefix_len, char separator, art_callback cb, void* data) override;
+
+    /**
+     * @brief Take an anchor on a key prefix, see art_anchor.
+     * @param prefix The prefix
+     * @param prefix_len The length of the prefix
+     * @param outputAnchor The anchor of the prefix.
+     * @return True if the anchor was taken, false if the tree could not take it.
+     */
+    bool findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor) override;
+
+    /**
+     * @brief Searches for a value in the ART tree from an anchor, with the part of its key that follows the prefix of
+     * the anchor.
+     * @param anchor The anchor taken by findAnchor().
+     * @param key The key without the prefix of the anchor
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the anchor is stale and has to be taken again.
+     */
+    bool searchFromAnchor(const art_anchor& anchor, const char* key, int key_len, ValueType*& outputValue) override;
+
+    /**
+     * @brief Returns the minimum valued leaf value in the tree
+     *
+     * @return The minimum leaf value or NULL
+     */
+    ValueType* getMinimumValue() override;
+
+    /**
+     * @brief Returns the maximum valued leaf value in the tree
+     *
+     * @return The maximum leaf value or NULL
+     */
+    ValueType* getMaximumValue() override;
+
+    /**
+     * @brief Get the contention figures of the node locks, the writes being recorded as a whole.
+     * @return The figures of the writers. Those of the readers are zero, as they never wait.
+     */
+    LockStats_t getLockStats() override;
+
+protected:
+    using typename AdaptiveRadixTree<ValueType>::Node;
+    using typename AdaptiveRadixTree<ValueType>::Node256;
+    using typename AdaptiveRadixTree<ValueType>::Leaf;
+
+    void reclaimNode(Node* node) override;
+
+private:
+    /// Lock bit of Node::writeLock, set while a writer is modifying the node.
+    static constexpr uint32_t LOCKED = 1;
+    /// Obsolete bit of Node::writeLock, set once the node has been replaced. An obsolete node is never unlocked.
+    static constexpr uint32_t OBSOLETE = 2;
+
+    /// Longest sleep of a writer waiting for a node lock. The semaphore is shared by every node, so a writer may take
+    /// a signal meant for the waiter of another node, which then only notices its node was unlocked after this delay.
+    static constexpr uint32_t LOCK_WAIT_SLICE_MS = 1;
+
+    typedef std::chrono::steady_clock::time_point Deadline_t;
+
+    std::atomic<uint32_t>        rootLock;      // Lock of the root slot, which has no owner node.
+    OSInterface_BinarySemaphore* lockSemaphore; // Signaled when a node is unlocked while writers are waiting.
+    std::atomic<uint32_t>        lockWaiters;   // Number of writers waiting, or about to wait, on the semaphore.
+    LockStatistics               lockStatistics;
+    EpochManager                 epochManager;
+
+    std::atomic<uint32_t>& lockOf(Node* owner);
+    [[nodiscard]] bool     lockNode(std::atomic<uint32_t>& writeLock, Deadline_t deadline);
+    void                   unlockNode(std::atomic<uint32_t>& writeLock);
+    void                   unlockObsoleteNode(std::atomic<uint32_t>& writeLock);
+    void                   wakeLockWaiters();
+    static Deadline_t      writeDeadline();
+    static void            reclaimNodeCallback(void* context, void* node);
+
+    [[nodiscard]] bool insertValue(const char* key, int key_len, ValueType* value, bool replace, bool inlineValue,
+                                   ValueType*& oldValue, ValueType** outputInserted = nullptr);
+    [[nodiscard]] bool tryInsert(const uint8_t* key, uint32_t keyLen, ValueType* value, bool replace, bool inlineValue,
+                                 Deadline_t deadline, ValueType*& oldValue, ValueType** outputInserted);
+    [[nodiscard]] bool tryDelete(const uint8_t* key, uint32_t keyLen, Deadline_t deadline, ValueType*& oldValue);
+};
+
+template <typename ValueType>
+ConcurrentAdaptiveRadixTree<ValueType>::ConcurrentAdaptiveRadixTree(OSInterface&   osInterface,
+                                                                    NodeAllocator* nodeAllocator) :
+    AdaptiveRadixTree<ValueType>(nodeAllocator)
+{
+    this->rootLock.store(0, std::memory_order_relaxed);
+    this->lockWaiters.store(0, std::memory_order_relaxed);
+    this->lockSemaphore = osInterface.osCreateBinarySemaphore();
+    assert(this->lockSemaphore != nullptr && "Semaphore creation failed");
+}
+
+template <typename ValueType> ConcurrentAdaptiveRadixTree<ValueType>::~ConcurrentAdaptiveRadixTree()
+{
+    delete lockSemaphore;
+}
+
+template <typename ValueType> uint64_t ConcurrentAdaptiveRadixTree<ValueType>::size()
+{
+    return AdaptiveRadixTree<ValueType>::size();
+}
+
+template <typename ValueType>
+ValueType* ConcurrentAdaptiveRadixTree<ValueType>::insert(const char* key, int key_len, ValueType* value)
+{
+    ValueType* oldValue;
+    return insertValue(key, key_len, value, true, false, oldValue) ? oldValue : nullptr;
+}
+
+template <typename ValueType>
+ValueType* ConcurrentAdaptiveRadixTree<ValueType>::insertIfNotExists(const char* key, int key_len, ValueType* value)
+{
+    ValueType* oldValue;
+    return insertValue(key, key_len, value, false, false, oldValue) ? oldValue : nullptr;
+}
+
+template <typename ValueType> ValueType*
+ConcurrentAdaptiveRadixTree<ValueType>::insertInlineIfNotExists(const char* key, int key_len, const ValueType& value)
+{
+    ValueType* oldValue;
+    return insertValue(key, key_len, const_cast<ValueType*>(&value), false, true, oldValue) ? oldValue : nullptr;
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::tryInsertInlineIfNotExists(const char* key, int key_len,
+                                                                        const ValueType& value,
+                                                                        ValueType*&      outputExisting,
+                                                                        ValueType**      outputInserted)
+{
+    return insertValue(key, key_len, const_cast<ValueType*>(&value), false, true, outputExisting, outputInserted);
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens,
+                                                                          const size_t count, const ValueType* values,
+                                                                          ValueType** outputExisting,
+                                                                          ValueType** outputInserted)
+{
+    if (count > 0 && this->root.load(std::memory_order_acquire) == nullptr &&
+        this->keysAreSorted(keys, key_lens, count))
+    {
+        const uint64_t waitStartUs = LockStatistics::now();
+        if (!lockNode(rootLock, writeDeadline()))
+        {
+            lockStatistics.recordTimeout(LockStatistics::WRITES);
+            for (size_t i = 0; i < count; i++)
+            {
+                outputExisting[i] = nullptr;
+                if (outputInserted != nullptr)
+                {
+                    outputInserted[i] = nullptr;
+                }
+            }
+            return false;
+        }
+        const bool empty = this->root.load(std::memory_order_relaxed) == nullptr;
+        if (empty)
+        {
+            this->root.store(this->buildSubtree(keys, key_lens, values, outputExisting, outputInserted, 0, count, 0),
+                             std::memory_order_release);
+        }
+        unlockNode(rootLock);
+        if (empty)
+        {
+            lockStatistics.recordAcquisition(LockStatistics::WRITES, waitStartUs, LockStatistics::now());
+            return true;
+        }
+    }
+
+    bool result = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        result &= insertValue(keys[i], key_lens[i], const_cast<ValueType*>(&values[i]), false, true, outputExisting[i],
+                              outputInserted != nullptr ? &outputInserted[i] : nullptr);
+    }
+    return result;
+}
+
+template <typename ValueType> ValueType* ConcurrentAdaptiveRadixTree<ValueType>::deleteValue(const char* key, int key_len)
+{
+    ValueType* result;
+    return tryDeleteValue(key, key_len, result) ? result : nullptr;
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::tryDeleteValue(const char* key, int key_len, ValueType*& outputValue)
+{
+    const uint64_t   waitStartUs = LockStatistics::now();
+    const Deadline_t deadline    = writeDeadline();
+    bool             deleted;
+    {
+        EpochGuard guard(epochManager);
+        do
+        {
+            deleted = tryDelete(reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len), deadline,
+                                outputValue);
+        } while (!deleted && std::chrono::steady_clock::now() < deadline);
+    }
+    if (!deleted)
+    {
+        lockStatistics.recordTimeout(LockStatistics::WRITES);
+        outputValue = nullptr;
+        return false;
+    }
+    lockStatistics.recordAcquisition(LockStatistics::WRITES, waitStartUs, LockStatistics::now());
+    return true;
+}
+
+template <typename ValueType> ValueType* ConcurrentAdaptiveRadixTree<ValueType>::search(const char* key, int key_len)
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::search(key, key_len);
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::searchBatch(const char* const* keys, const int* key_lens,
+                                                         const size_t count, ValueType** outputValues)
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::searchBatch(keys, key_lens, count, outputValues);
+}
+
+template <typename ValueType>
+int ConcurrentAdaptiveRadixTree<ValueType>::iterateOverAll(art_callback cb, void* data, const art_summary_filter filter,
+                                                           void* filterData)
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::iterateOverAll(cb, data, filter, filterData);
+}
+
+template <typename ValueType>
+int ConcurrentAdaptiveRadixTree<ValueType>::iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb,
+                                                              void* data, const art_summary_filter filter,
+                                                              void* filterData)
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::iterateOverPrefix(prefix, prefix_len, cb, data, filter, filterData);
+}
+
+template <typename ValueType>
+int ConcurrentAdaptiveRadixTree<ValueType>::iterateOverChildren(const char* prefix, int prefix_len,
+                                                                const char separator, art_callback cb, void* data)
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::iterateOverChildren(prefix, prefix_len, separator, cb, data);
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor)
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::findAnchor(prefix, prefix_len, outputAnchor);
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::searchFromAnchor(const art_anchor& anchor, const char* key, int key_len,
+                                                              ValueType*& outputValue)
+{
+    // A node unlinked after the version check is only reclaimed once the guard is released.
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::searchFromAnchor(anchor, key, key_len, outputValue);
+}
+
+template <typename ValueType> ValueType* ConcurrentAdaptiveRadixTree<ValueType>::getMinimumValue()
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::getMinimumValue();
+}
+
+template <typename ValueType> ValueType* ConcurrentAdaptiveRadixTree<ValueType>::getMaximumValue()
+{
+    EpochGuard guard(epochManager);
+    return AdaptiveRadixTree<ValueType>::getMaximumValue();
+}
+
+template <typename ValueType> LockStats_t ConcurrentAdaptiveRadixTree<ValueType>::getLockStats()
+{
+    return lockStatistics.getStats();
+}
+
+template <typename ValueType> void ConcurrentAdaptiveRadixTree<ValueType>::reclaimNode(Node* node)
+{
+    epochManager.retire(node, reclaimNodeCallback, this);
+}
+
+template <typename ValueType> std::atomic<uint32_t>& ConcurrentAdaptiveRadixTree<ValueType>::lockOf(Node* owner)
+{
+    return owner == nullptr ? rootLock : owner->writeLock;
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::lockNode(std::atomic<uint32_t>& writeLock, const Deadline_t deadline)
+{
+    uint32_t state   = writeLock.load(std::memory_order_relaxed);
+    bool     waiting = false;
+    bool     locked  = false;
+    while ((state & OBSOLETE) == 0)
+    {
+        if ((state & LOCKED) == 0)
+        {
+            if (writeLock.compare_exchange_weak(state, state | LOCKED, std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+            {
+                locked = true;
+                break;
+            }
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            break;
+        }
+        if (!waiting)
+        {
+            // Pairs with wakeLockWaiters(): either the unlocker sees this waiter, or this waiter sees the unlock.
+            lockWaiters.fetch_add(1, std::memory_order_seq_cst);
+            waiting = true;
+        }
+        else
+        {
+            const auto remainingMs = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+            lockSemaphore->wait(static_cast<uint32_t>(std::min<int64_t>(remainingMs, LOCK_WAIT_SLICE_MS)));
+        }
+        state = writeLock.load(std::memory_order_seq_cst);
+    }
+
+    // A binary semaphore wakes a single thread, so the other waiters are woken in turn.
+    if (waiting && lockWaiters.fetch_sub(1, std::memory_order_seq_cst) > 1)
+    {
+        lockSemaphore->signal();
+    }
+    return locked;
+}
+
+template <typename ValueType> void ConcurrentAdaptiveRadixTree<ValueType>::unlockNode(std::atomic<uint32_t>& writeLock)
+{
+    writeLock.store(0, std::memory_order_seq_cst);
+    wakeLockWaiters();
+}
+
+template <typename ValueType>
+void ConcurrentAdaptiveRadixTree<ValueType>::unlockObsoleteNode(std::atomic<uint32_t>& writeLock)
+{
+    // The writers waiting for the node are woken too, to restart from the root.
+    writeLock.store(OBSOLETE, std::memory_order_seq_cst);
+    wakeLockWaiters();
+}
+
+template <typename ValueType> void ConcurrentAdaptiveRadixTree<ValueType>::wakeLockWaiters()
+{
+    if (lockWaiters.load(std::memory_order_seq_cst) != 0)
+    {
+        lockSemaphore->signal();
+    }
+}
+
+template <typename ValueType>
+typename ConcurrentAdaptiveRadixTree<ValueType>::Deadline_t ConcurrentAdaptiveRadixTree<ValueType>::writeDeadline()
+{
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(SETTINGS_STORAGE_MUTEX_TIMEOUT_MS);
+}
+
+template <typename ValueType> void ConcurrentAdaptiveRadixTree<ValueType>::reclaimNodeCallback(void* context, void* node)
+{
+    static_cast<ConcurrentAdaptiveRadixTree*>(context)->freeNode(static_cast<Node*>(node));
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::insertValue(const char* key, int key_len, ValueType* value,
+                                                         const bool replace, const bool inlineValue,
+                                                         ValueType*& oldValue, ValueType** outputInserted)
+{
+    const uint64_t   waitStartUs = LockStatistics::now();
+    const Deadline_t deadline    = writeDeadline();
+    bool             inserted;
+    oldValue = nullptr;
+    if (outputInserted != nullptr)
+    {
+        *outputInserted = nullptr;
+    }
+    {
+        // Writers also traverse nodes that other writers may be replacing, so they are protected like readers.
+        // A writer restarts when a node it locks was replaced meanwhile, that is when another writer made progress.
+        EpochGuard guard(epochManager);
+        do
+        {
+            inserted = tryInsert(reinterpret_cast<const uint8_t*>(key), static_cast<uint32_t>(key_len), value, replace,
+                                 inlineValue, deadline, oldValue, outputInserted);
+        } while (!inserted && std::chrono::steady_clock::now() < deadline);
+    }
+    if (!inserted)
+    {
+        lockStatistics.recordTimeout(LockStatistics::WRITES);
+        return false;
+    }
+    lockStatistics.recordAcquisition(LockStatistics::WRITES, waitStartUs, LockStatistics::now());
+    return true;
+}
+
+template <typename ValueType> bool ConcurrentAdaptiveRadixTree<ValueType>::tryInsert(const uint8_t*   key,
+                                                                                    const uint32_t   keyLen,
+                                                                                    ValueType*       value,
+                                                                                    const bool       replace,
+                                                                                    const bool       inlineValue,
+                                                                                    const Deadline_t deadline,
+                                                                                    ValueType*&      oldValue,
+                                                                                    ValueType**      outputInserted)
+{
+    std::atomic<Node*>* ref    = &this->root;
+    Node*               parent = nullptr; // Owner of ref, nullptr for the root slot.
+    uint32_t            depth  = 0;
+
+    while (true)
+    {
+        Node* node = ref->load(std::memory_order_acquire);
+        if (node == nullptr)
+        {
+            // Only the root slot can be found empty. A Node256 slot emptied meanwhile is retried from the root.
+            if (parent != nullptr || !lockNode(rootLock, deadline))
+            {
+                return false;
+            }
+            const bool unchanged = ref->load(std::memory_order_relaxed) == nullptr;
+            if (unchanged)
+            {
+                ref->store(this->leafRef(this->allocateLeaf(key, keyLen, value, inlineValue, outputInserted)),
+                           std::memory_order_release);
+                this->numValues.fetch_add(1, std::memory_order_relaxed);
+                oldValue = nullptr;
+            }
+            unlockNode(rootLock);
+            return unchanged;
+        }
+
+        if (this->isLeaf(node))
+        {
+            // The slot holding the leaf belongs to the parent, so the parent lock protects both the slot and the value.
+            std::atomic<uint32_t>& parentLock = lockOf(parent);
+            if (!lockNode(parentLock, deadline))
+            {
+                return false;
+            }
+            if (ref->load(std::memory_order_relaxed) != node)
+            {
+                unlockNode(parentLock);
+                return false;
+            }
+
+            Leaf* leaf = this->asLeaf(node);
+            if (this->leafMatches(leaf, key, keyLen))
+            {
+                oldValue = leaf->value.load(std::memory_order_relaxed);
+                if (replace)
+                {
+                    assert(!leaf->inlineValue && "Inline values cannot be replaced");
+                    leaf->value.store(value, std::memory_order_release);
+                }
+            }
+            else
+            {
+                Node* newLeaf = this->leafRef(this->allocateLeaf(key, keyLen, value, inlineValue, outputInserted));
+                ref->store(this->splitLeaf(node, newLeaf, depth), std::memory_order_release);
+                this->numValues.fetch_add(1, std::memory_order_relaxed);
+                oldValue = nullptr;
+            }
+            unlockNode(parentLock);
+            return true;
+        }
+
+        // The summary aggregates are widened under the node lock, which the writers copying the node hold too, so no
+        // copy can miss them. The node may end up above the new value. Widening it too when it does not is harmless.
+        if (const uint32_t bits = this->valueSummary(value); !this->coversSummary(node, bits))
+        {
+            if (!lockNode(node->writeLock, deadline))
+            {
+                return false;
+            }
+            this->widenSummary(node, bits);
+            unlockNode(node->writeLock);
+        }
+
+        if (const uint32_t mismatch = this->prefixMismatch(node, key, keyLen, depth); mismatch != node->prefixLen)
+        {
+            std::atomic<uint32_t>& parentLock = lockOf(parent);
+            if (!lockNode(parentLock, deadline))
+            {
+                return false;
+            }
+            if (!lockNode(node->writeLock, deadline))
+            {
+                unlockNode(parentLock);
+                return false;
+            }
+            if (ref->load(std::memory_order_relaxed) != node)
+            {
+                unlockNode(node->writeLock);
+                unlockNode(parentLock);
+                return false;
+            }
+
+            Node* newLeaf = this->leafRef(this->allocateLeaf(key, keyLen, value, inlineValue, outputInserted));
+            ref->store(this->splitPrefix(node, mismatch, newLeaf, depth), std::memory_order_release);
+            this->numValues.fetch_add(1, std::memory_order_relaxed);
+            unlockObsoleteNode(node->writeLock);
+            unlockNode(parentLock);
+            reclaimNode(node);
+            oldValue = nullptr;
+            return true;
+        }
+        depth += node->prefixLen;
+
+        const uint8_t byte = this->keyByte(key, keyLen, depth);
+        if (std::atomic<Node*>* childRef = this->findChild(node, byte); childRef != nullptr)
+        {
+            parent = node;
+            ref    = childRef;
+            depth++;
+            continue;
+        }
+
+        if (node->type == AdaptiveRadixTree<ValueType>::NODE256)
+        {
+            // Node256 children are added in place, so its parent is not involved.
+            if (!lockNode(node->writeLock, deadline))
+            {
+                return false;
+            }
+            std::atomic<Node*>& slot      = static_cast<Node256*>(node)->children[byte];
+            const bool          unchanged = slot.load(std::memory_order_relaxed) == nullptr;
+            if (unchanged)
+            {
+                slot.store(this->leafRef(this->allocateLeaf(key, keyLen, value, inlineValue, outputInserted)),
+                           std::memory_order_release);
+                node->numChildren++;
+                this->numValues.fetch_add(1, std::memory_order_relaxed);
+                oldValue = nullptr;
+            }
+            unlockNode(node->writeLock);
+            return unchanged;
+        }
+
+        std::atomic<uint32_t>& parentLock = lockOf(parent);
+        if (!lockNode(parentLock, deadline))
+        {
+            return false;
+        }
+        if (!lockNode(node->writeLock, deadline))
+        {
+            unlockNode(parentLock);
+            return false;
+        }
+        if (ref->load(std::memory_order_relaxed) != node)
+        {
+            unlockNode(node->writeLock);
+            unlockNode(parentLock);
+            return false;
+        }
+
+        Node* newLeaf = this->leafRef(this->allocateLeaf(key, keyLen, value, inlineValue, outputInserted));
+        ref->store(this->copyNodeWithChild(node, byte, newLeaf), std::memory_order_release);
+        this->numValues.fetch_add(1, std::memory_order_relaxed);
+        unlockObsoleteNode(node->writeLock);
+        unlockNode(parentLock);
+        reclaimNode(node);
+        oldValue = nullptr;
+        return true;
+    }
+}
+
+template <typename ValueType>
+bool ConcurrentAdaptiveRadixTree<ValueType>::tryDelete(const uint8_t* key, const uint32_t keyLen,
+                                                       const Deadline_t deadline, ValueType*& oldValue)
+{
+    std::atomic<Node*>* ref    = &this->root;
+    Node*               parent = nullptr; // Owner of ref, nullptr for the root slot.
+    uint32_t            depth  = 0;
+    oldValue                   = nullptr;
+
+    while (true)
+    {
+        Node* node = ref->load(std::memory_order_acquire);
+        if (node == nullptr)
+        {
+            return true;
+        }
+
+        if (this->isLeaf(node))
+        {
+            // Only the root can be a leaf reached this way.
+            if (!this->leafMatches(this->asLeaf(node), key, keyLen))
+            {
+                return true;
+            }
+            if (!lockNode(rootLock, deadline))
+            {
+                return false;
+            }
+            const bool unchanged = ref->load(std::memory_order_relaxed) == node;
+            if (unchanged)
+            {
+                oldValue = this->asLeaf(node)->value.load(std::memory_order_relaxed);
+                this->structureVersion.fetch_add(1, std::memory_order_release);
+                ref->store(nullptr, std::memory_order_release);
+                this->numValues.fetch_sub(1, std::memory_order_relaxed);
+            }
+            unlockNode(rootLock);
+            if (unchanged)
+            {
+                reclaimNode(node);
+            }
+            return unchanged;
+        }
+
+        if (this->prefixMismatch(node, key, keyLen, depth) != node->prefixLen)
+        {
+            return true;
+        }
+        depth += node->prefixLen;
+
+        const uint8_t       byte     = this->keyByte(key, keyLen, depth);
+        std::atomic<Node*>* childRef = this->findChild(node, byte);
+        if (childRef == nullptr)
+        {
+            return true;
+        }
+
+        Node* child = childRef->load(std::memory_order_acquire);
+        if (child == nullptr)
+        {
+            return true;
+        }
+        if (!this->isLeaf(child))
+        {
+            parent = node;
+            ref    = childRef;
+            depth++;
+            continue;
+        }
+        if (!this->leafMatches(this->asLeaf(child), key, keyLen))
+        {
+            return true;
+        }
+
+        // The node may be replaced by a copy, so both the node and its parent are locked.
+        std::atomic<uint32_t>& parentLock = lockOf(parent);
+        if (!lockNode(parentLock, deadline))
+        {
+            return false;
+        }
+        if (!lockNode(node->writeLock, deadline))
+        {
+            unlockNode(parentLock);
+            return false;
+        }
+        if (ref->load(std::memory_order_relaxed) != node || childRef->load(std::memory_order_relaxed) != child)
+        {
+            unlockNode(node->writeLock);
+            unlockNode(parentLock);
+            return false;
+        }
+
+        // With two children the node is merged with the remaining one, which is copied and must be locked too.
+        Node* merged = nullptr;
+        if (node->numChildren == 2)
+        {
+            uint8_t keys[AdaptiveRadixTree<ValueType>::MAX_COPIED_CHILDREN];
+            Node*   children[AdaptiveRadixTree<ValueType>::MAX_COPIED_CHILDREN];
+            this->collectChildren(node, keys, children);
+            merged = children[keys[0] == byte ? 1 : 0];
+            if (this->isLeaf(merged))
+            {
+                merged = nullptr;
+            }
+            else if (!lockNode(merged->writeLock, deadline))
+            {
+                unlockNode(node->writeLock);
+                unlockNode(parentLock);
+                return false;
+            }
+        }
+
+        oldValue = this->asLeaf(child)->value.load(std::memory_order_relaxed);
+        this->structureVersion.fetch_add(1, std::memory_order_release);
+        this->removeChild(ref, node, byte, childRef);
+        this->numValues.fetch_sub(1, std::memory_order_relaxed);
+        if (merged != nullptr)
+        {
+            unlockObsoleteNode(merged->writeLock);
+        }
+        if (ref->load(std::memory_order_relaxed) != node)
+        {
+            unlockObsoleteNode(node->writeLock);
+        }
+        else
+        {
+            unlockNode(node->writeLock);
+        }
+        unlockNode(parentLock);
+        reclaimNode(child);
+        return true;
+    }
+}
+
+#endif // CONCURRENTADAPTIVERADIXTREE_H
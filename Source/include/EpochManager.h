@@ -0,0 +1,125 @@
+#ifndef EPOCHMANAGER_H
+#define EPOCHMANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Epoch based (RCU-style) memory reclamation for data structures with lock-free readers.
+ *
+ * Readers wrap every traversal between enter() and exit(). Both only touch an atomic counter placed in a cache line
+ * shared by a few threads, so no OS primitive is involved in the read path.
+ * Writers unlink objects from the data structure and hand them to retire(). A retired object is released once a grace
+ * period has elapsed, that is, once every reader that was running when the object was retired has called exit().
+ * Writers never wait for the readers: once enough objects are retired, retire() releases those whose grace period is
+ * already over and leaves the others to a later call.
+ */
+class EpochManager
+{
+public:
+    /// Function used to release a retired object. It receives the context given to retire() and the object itself.
+    typedef void (*ReclaimFunction_t)(void* context, void* object);
+
+    /// Number of retired objects below which collect() does nothing.
+    static constexpr size_t RECLAIM_THRESHOLD = 32;
+
+    /**
+     * @brief Build a new epoch manager with no readers and no retired objects.
+     */
+    EpochManager();
+
+    /**
+     * @brief Destroy the epoch manager, releasing every object still retired.
+     * No reader may be inside a read section when the manager is destroyed.
+     */
+    ~EpochManager();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    EpochManager& operator=(EpochManager&&) = delete;
+
+    /**
+     * @brief Start a read section. Objects reachable when this function returns are not released before exit().
+     * @return The epoch of the read section, that must be passed to exit().
+     */
+    [[nodiscard]] uint32_t enter();
+
+    /**
+     * @brief Finish a read section started with enter() in the same thread.
+     * @param epoch The value returned by the matching enter() call.
+     */
+    void exit(uint32_t epoch);
+
+    /**
+     * @brief Defer the release of an object that is no longer reachable by new readers. Once RECLAIM_THRESHOLD objects
+     * are retired, it also calls collect().
+     * @param object The unlinked object.
+     * @param reclaimFunction The function that releases the object once no reader can reference it.
+     * @param context Opaque value passed to reclaimFunction.
+     */
+    void retire(void* object, ReclaimFunction_t reclaimFunction, void* context);
+
+    /**
+     * @brief Release the retired objects whose grace period has elapsed, if there are enough retired objects.
+     * Never waits: objects still reachable by a reader are kept for a later call, as are all of them if another thread
+     * is collecting.
+     */
+    void collect();
+
+private:
+    /// Number of reader counters. Threads are spread among them so that readers rarely share a cache line.
+    static constexpr uint32_t READER_SLOTS = 16;
+
+    typedef struct RetiredObject
+    {
+        void*                 object;
+        ReclaimFunction_t     reclaimFunction;
+        void*                 context;
+        struct RetiredObject* next;
+    } RetiredObject_t;
+
+    struct alignas(64) ReaderSlot_t
+    {
+        std::atomic<uint32_t> readers[2];
+    };
+
+    ReaderSlot_t                  readerSlots[READER_SLOTS];
+    std::atomic<uint32_t>         currentEpoch;
+    std::atomic<RetiredObject_t*> incoming;          // Objects retired since the last collect() call.
+    std::atomic<size_t>           retiredCount;      // Objects retired and not released yet.
+    std::atomic_flag              collecting;        // Set while a thread runs collect().
+    RetiredObject_t*              retiredInEpoch[2]; // Objects collected while each epoch was the current one.
+
+    static uint32_t               readerSlotIndex();
+    [[nodiscard]] bool            hasReaders(uint32_t epoch) const;
+    static size_t                 reclaim(RetiredObject_t* objects);
+};
+
+/**
+ * @brief RAII helper that keeps a read section of an EpochManager open during its lifetime.
+ */
+class EpochGuard
+{
+public:
+    explicit EpochGuard(EpochManager& epochManager) : epochManager(epochManager), epoch(epochManager.enter())
+    {
+    }
+
+    ~EpochGuard()
+    {
+        epochManager.exit(epoch);
+    }
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    EpochGuard& operator=(EpochGuard&&) = delete;
+
+private:
+    EpochManager&  epochManager;
+    const uint32_t epoch;
+};
+
+#endif // EPOCHMANAGER_H
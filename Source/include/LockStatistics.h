@@ -0,0 +1,124 @@
+#ifndef LOCKSTATISTICS_H
+#define LOCKSTATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef CONFIG_SETTINGS_STORAGE_LOCK_STATS
+    #define CONFIG_SETTINGS_STORAGE_LOCK_STATS false
+#endif
+
+/// Number of buckets of the wait and hold time histograms of a lock.
+#define LOCK_STATS_HISTOGRAM_BUCKETS 8
+
+/// Figures of the readers, or of the writers, of a lock.
+typedef struct
+{
+    uint64_t acquisitions; ///< Number of times the lock was taken.
+    uint64_t timeouts;     ///< Number of times the lock could not be taken, or left, in time.
+    uint64_t maxWaitUs;    ///< Longest time waited to take the lock, in microseconds.
+    /// Number of acquisitions per time waited to take the lock. See LockStatistics::bucketOf() for the bucket bounds.
+    uint64_t waitHistogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+    /// Number of acquisitions per time the lock was held. See LockStatistics::bucketOf() for the bucket bounds.
+    uint64_t holdHistogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+} LockSideStats_t;
+
+/// Contention figures of a readers-writer lock.
+typedef struct
+{
+    LockSideStats_t readers; ///< Figures of the read locks.
+    LockSideStats_t writers; ///< Figures of the write locks.
+} LockStats_t;
+
+/**
+ * @brief Recorder of the contention figures of a readers-writer lock.
+ *
+ * The timeouts are always counted. The acquisitions and the wait and hold times are only recorded if
+ * CONFIG_SETTINGS_STORAGE_LOCK_STATS is set, as every acquisition then updates counters shared by all the threads.
+ * Every figure is updated and read with relaxed atomics, so a snapshot is cheap but its figures may be slightly apart.
+ */
+class LockStatistics
+{
+public:
+    /// Enum with the sides of a readers-writer lock.
+    typedef enum
+    {
+        READS,
+        WRITES
+    } LockSide_t;
+
+    /// True if the acquisitions and the wait and hold times are recorded.
+    static constexpr bool ENABLED = CONFIG_SETTINGS_STORAGE_LOCK_STATS;
+
+    /**
+     * @brief Build a recorder with every figure at zero.
+     */
+    LockStatistics();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    LockStatistics& operator=(LockStatistics&&) = delete;
+
+    /**
+     * @brief Get the current time to pass to the recording functions.
+     * @return The time in microseconds, or 0 if the times are not recorded.
+     */
+    [[nodiscard]] static uint64_t now();
+
+    /**
+     * @brief Record that the lock was taken.
+     * @param side The side of the lock that was taken.
+     * @param waitStartUs The time given by now() before waiting for the lock.
+     * @param acquiredUs The time given by now() once the lock was taken.
+     */
+    void recordAcquisition(LockSide_t side, uint64_t waitStartUs, uint64_t acquiredUs);
+
+    /**
+     * @brief Record that the lock was left.
+     * @param side The side of the lock that was left.
+     * @param acquiredUs The time given by now() once the lock was taken.
+     */
+    void recordRelease(LockSide_t side, uint64_t acquiredUs);
+
+    /**
+     * @brief Record that the lock could not be taken, or left, in time.
+     * @param side The side of the lock that timed out.
+     */
+    void recordTimeout(LockSide_t side);
+
+    /**
+     * @brief Get a snapshot of the figures.
+     * @return The figures.
+     */
+    [[nodiscard]] LockStats_t getStats() const;
+
+    /**
+     * @brief Get the histogram bucket of a duration. Bucket 0 counts the durations under 1 us, bucket i the ones from
+     * 4^(i-1) us to under 4^i us, and the last bucket every longer one.
+     * @param durationUs The duration in microseconds.
+     * @return The bucket index.
+     */
+    [[nodiscard]] static uint32_t bucketOf(uint64_t durationUs);
+
+    /**
+     * @brief Add the figures of a lock to those of another one, to report several locks as one.
+     * @param total The figures to add to.
+     * @param stats The figures to add.
+     */
+    static void accumulate(LockStats_t& total, const LockStats_t& stats);
+
+private:
+    typedef struct
+    {
+        std::atomic<uint64_t> acquisitions;
+        std::atomic<uint64_t> timeouts;
+        std::atomic<uint64_t> maxWaitUs;
+        std::atomic<uint64_t> waitHistogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+        std::atomic<uint64_t> holdHistogram[LOCK_STATS_HISTOGRAM_BUCKETS];
+    } AtomicSideStats_t;
+
+    AtomicSideStats_t sides[2];
+};
+
+#endif // LOCKSTATISTICS_H
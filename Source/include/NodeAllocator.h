@@ -0,0 +1,149 @@
+#ifndef NODEALLOCATOR_H
+#define NODEALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#ifndef CONFIG_SETTINGS_STORAGE_NODE_ARENA
+    #define CONFIG_SETTINGS_STORAGE_NODE_ARENA false
+#endif
+
+#ifndef CONFIG_SETTINGS_STORAGE_NODE_ARENA_SIZE
+    #define CONFIG_SETTINGS_STORAGE_NODE_ARENA_SIZE 4096
+#endif
+
+/// Memory usage figures of a NodeAllocator.
+typedef struct
+{
+    size_t arenas;           ///< Number of arenas reserved.
+    size_t reservedBytes;    ///< Memory obtained from the system, including the unused part of the arenas.
+    size_t usedBytes;        ///< Memory of the blocks currently handed out, rounded up to their size class.
+    size_t freeBytes;        ///< Memory of released blocks kept in the free lists for reuse.
+    size_t allocations;      ///< Number of blocks currently handed out.
+    size_t largeAllocations; ///< Number of blocks currently handed out that were too big for the size classes.
+} NodeAllocatorStats_t;
+
+/**
+ * @brief Interface of the memory allocators used by AdaptiveRadixTree for its nodes and leaves.
+ * Every block is released with the same size it was requested with, so implementations do not need block headers.
+ * Implementations must be thread safe.
+ */
+class NodeAllocator
+{
+public:
+    virtual ~NodeAllocator() = default;
+
+    /**
+     * @brief Get a block of memory, aligned to 16 bytes.
+     * @param size The size of the block.
+     * @return The block, or nullptr if there is no memory left.
+     */
+    virtual void* allocate(size_t size) = 0;
+
+    /**
+     * @brief Release a block obtained from allocate().
+     * @param block The block.
+     * @param size The size given to allocate() for this block.
+     */
+    virtual void deallocate(void* block, size_t size) = 0;
+
+    /**
+     * @brief Check if the allocator releases every block when it is destroyed.
+     * In that case, the owner of the allocator does not need to deallocate the blocks one by one before destroying it.
+     * @return true if the blocks are released in bulk, false otherwise.
+     */
+    [[nodiscard]] virtual bool releasesInBulk() const = 0;
+
+    /**
+     * @brief Get the memory usage figures of the allocator.
+     * @return The statistics.
+     */
+    [[nodiscard]] virtual NodeAllocatorStats_t getStats() const = 0;
+};
+
+/**
+ * @brief NodeAllocator that forwards every request to malloc and free.
+ */
+class MallocNodeAllocator : public NodeAllocator
+{
+public:
+    MallocNodeAllocator();
+    void*                              allocate(size_t size) override;
+    void                               deallocate(void* block, size_t size) override;
+    [[nodiscard]] bool                 releasesInBulk() const override;
+    [[nodiscard]] NodeAllocatorStats_t getStats() const override;
+
+private:
+    std::atomic<size_t> usedBytes;
+    std::atomic<size_t> allocations;
+};
+
+/**
+ * @brief NodeAllocator that carves the blocks from large arenas, with one free list per size class.
+ *
+ * Block sizes are rounded up to a size class. Released blocks are kept in the free list of their class to serve later
+ * requests of the same class, and the arenas are only returned to the system when the allocator is destroyed. Blocks
+ * bigger than the largest size class are forwarded to malloc and free.
+ */
+class ArenaNodeAllocator : public NodeAllocator
+{
+public:
+    /**
+     * @brief Build an allocator without any arena. Arenas are reserved when they are first needed.
+     * @param arenaSize Size of each arena. It is raised to the largest size class if it is smaller.
+     */
+    explicit ArenaNodeAllocator(size_t arenaSize = CONFIG_SETTINGS_STORAGE_NODE_ARENA_SIZE);
+
+    /**
+     * @brief Destroy the allocator, releasing every arena and every large block still in use.
+     */
+    ~ArenaNodeAllocator() override;
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    ArenaNodeAllocator& operator=(ArenaNodeAllocator&&) = delete;
+
+    void*                              allocate(size_t size) override;
+    void                               deallocate(void* block, size_t size) override;
+    [[nodiscard]] bool                 releasesInBulk() const override;
+    [[nodiscard]] NodeAllocatorStats_t getStats() const override;
+
+    /**
+     * @brief Get the size class a block size is rounded up to.
+     * @param size The block size.
+     * @return The size of the class, or 0 if the block is bigger than the largest class.
+     */
+    static size_t sizeClassOf(size_t size);
+
+private:
+    /// Sizes of the classes. They are multiples of 16, so every block is 16 bytes aligned.
+    static constexpr size_t SIZE_CLASSES[] = {16,   32,   48,   64,   80,   96,   112,  128,  144,  160,  176,
+                                              192,  208,  224,  240,  256,  320,  384,  448,  512,  640,  768,
+                                              896,  1024, 1280, 1536, 1792, 2048, 2560, 3072};
+    static constexpr size_t NUM_SIZE_CLASSES = sizeof(SIZE_CLASSES) / sizeof(SIZE_CLASSES[0]);
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    mutable std::mutex mutex;
+    size_t             arenaSize;
+    std::vector<void*> arenas;
+    std::vector<void*> largeBlocks;
+    uint8_t*           arenaCursor; // Next free byte of the last arena.
+    size_t             arenaLeft;   // Free bytes after arenaCursor.
+    FreeBlock*         freeLists[NUM_SIZE_CLASSES];
+    size_t             usedBytes;
+    size_t             freeBytes;
+    size_t             largeBytes;
+    size_t             allocations;
+
+    static size_t sizeClassIndex(size_t size);
+};
+
+#endif // NODEALLOCATOR_H
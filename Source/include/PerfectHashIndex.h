@@ -0,0 +1,198 @@
+#ifndef PERFECTHASHINDEX_H
+#define PERFECTHASHINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Read-only map from a fixed set of keys to value pointers, built as a minimal perfect hash (hash and
+ * displace).
+ *
+ * Keys are first hashed into buckets of a few keys each. While building, the buckets are placed from the biggest to
+ * the smallest, and each one gets the first displacement that sends all its keys to free slots. A lookup therefore
+ * hashes the key twice, reads one displacement and compares the key stored in the slot, whatever the number of keys.
+ * The table has exactly one slot per key.
+ *
+ * Keys are added with add() and the index is built once with build(). After that, the index is never modified, so it
+ * can be searched from any number of threads without synchronization.
+ */
+template <typename ValueType> class PerfectHashIndex
+{
+public:
+    /**
+     * @brief Build an empty index.
+     */
+    PerfectHashIndex() = default;
+
+    /**
+     * @brief Add a key to the index before it is built. The key is copied.
+     * @param key The key. It must not have been added before.
+     * @param keyLen The length of the key.
+     * @param value The value of the key.
+     */
+    void add(const char* key, uint32_t keyLen, ValueType* value);
+
+    /**
+     * @brief Build the hash function over the added keys. No key can be added afterwards.
+     * @return true if the index was built, false if no perfect hash function was found.
+     */
+    [[nodiscard]] bool build();
+
+    /**
+     * @brief Search a key in a built index.
+     * @param key The key.
+     * @param keyLen The length of the key.
+     * @return The value of the key, or nullptr if the key is not in the index.
+     */
+    [[nodiscard]] ValueType* search(const char* key, uint32_t keyLen) const;
+
+    /**
+     * @brief Get the number of keys of the index.
+     * @return The number of keys.
+     */
+    [[nodiscard]] size_t size() const;
+
+private:
+    /// Number of keys per bucket on average. Bigger buckets take less memory but are harder to place.
+    static constexpr uint32_t KEYS_PER_BUCKET = 2;
+
+    /// Number of displacements tried for a bucket before the whole build is retried with another seed.
+    static constexpr uint32_t MAX_DISPLACEMENT = 1u << 16;
+
+    /// Number of bucket seeds tried before the build fails.
+    static constexpr uint32_t MAX_SEEDS = 16;
+
+    typedef struct
+    {
+        ValueType* value;
+        uint32_t   keyOffset; // Position of the key in keys.
+        uint32_t   keyLen;
+    } Slot_t;
+
+    std::vector<char>     keys;
+    std::vector<Slot_t>   slots;         // Before build(), the added keys in insertion order.
+    std::vector<uint32_t> displacements; // Displacement of each bucket.
+    uint32_t              bucketSeed = 0;
+
+    static uint64_t hash(const char* key, uint32_t keyLen, uint64_t seed);
+    [[nodiscard]] bool tryBuild(uint32_t seed, std::vector<Slot_t>& table);
+};
+
+template <typename ValueType>
+void PerfectHashIndex<ValueType>::add(const char* key, const uint32_t keyLen, ValueType* value)
+{
+    slots.push_back({value, static_cast<uint32_t>(keys.size()), keyLen});
+    keys.insert(keys.end(), key, key + keyLen);
+}
+
+template <typename ValueType> bool PerfectHashIndex<ValueType>::build()
+{
+    std::vector<Slot_t> table;
+    for (uint32_t seed = 1; seed <= MAX_SEEDS; seed++)
+    {
+        if (tryBuild(seed, table))
+        {
+            slots      = std::move(table);
+            bucketSeed = seed;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename ValueType>
+ValueType* PerfectHashIndex<ValueType>::search(const char* key, const uint32_t keyLen) const
+{
+    if (slots.empty())
+    {
+        return nullptr;
+    }
+
+    const uint32_t bucket       = hash(key, keyLen, bucketSeed) % displacements.size();
+    const Slot_t&  slot         = slots[hash(key, keyLen, displacements[bucket]) % slots.size()];
+    const bool     keyIsInIndex = slot.keyLen == keyLen && memcmp(&keys[slot.keyOffset], key, keyLen) == 0;
+    return keyIsInIndex ? slot.value : nullptr;
+}
+
+template <typename ValueType> size_t PerfectHashIndex<ValueType>::size() const
+{
+    return slots.size();
+}
+
+template <typename ValueType>
+uint64_t PerfectHashIndex<ValueType>::hash(const char* key, const uint32_t keyLen, const uint64_t seed)
+{
+    // 64-bit FNV-1a, with the seed mixed into the offset basis.
+    uint64_t hash = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+    for (uint32_t i = 0; i < keyLen; i++)
+    {
+        hash ^= static_cast<uint8_t>(key[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+template <typename ValueType> bool PerfectHashIndex<ValueType>::tryBuild(const uint32_t seed, std::vector<Slot_t>& table)
+{
+    const size_t                       numBuckets = slots.size() / KEYS_PER_BUCKET + 1;
+    std::vector<std::vector<uint32_t>> buckets(numBuckets);
+    for (uint32_t i = 0; i < slots.size(); i++)
+    {
+        buckets[hash(&keys[slots[i].keyOffset], slots[i].keyLen, seed) % numBuckets].push_back(i);
+    }
+
+    std::vector<uint32_t> order(numBuckets);
+    for (uint32_t i = 0; i < numBuckets; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](const uint32_t a, const uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    table.assign(slots.size(), {nullptr, 0, 0});
+    std::vector<bool>     used(slots.size(), false);
+    std::vector<uint32_t> bucketSlots;
+    displacements.assign(numBuckets, 0);
+    for (const uint32_t bucket : order)
+    {
+        if (buckets[bucket].empty())
+        {
+            break;
+        }
+
+        uint32_t displacement = 0;
+        for (; displacement < MAX_DISPLACEMENT; displacement++)
+        {
+            bucketSlots.clear();
+            for (const uint32_t key : buckets[bucket])
+            {
+                const uint32_t slot = hash(&keys[slots[key].keyOffset], slots[key].keyLen, displacement) % slots.size();
+                if (used[slot] || std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+                {
+                    break;
+                }
+                bucketSlots.push_back(slot);
+            }
+            if (bucketSlots.size() == buckets[bucket].size())
+            {
+                break;
+            }
+        }
+        if (displacement == MAX_DISPLACEMENT)
+        {
+            return false;
+        }
+
+        displacements[bucket] = displacement;
+        for (size_t i = 0; i < bucketSlots.size(); i++)
+        {
+            used[bucketSlots[i]]  = true;
+            table[bucketSlots[i]] = slots[buckets[bucket][i]];
+        }
+    }
+    return true;
+}
+
+#endif // PERFECTHASHINDEX_H
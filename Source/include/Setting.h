@@ -0,0 +1,296 @@
+#ifndef SETTING_H
+#define SETTING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include "SettingsStorage.h"
+
+/**
+ * @brief Key of a setting known at compile time, used as the template argument of Setting.
+ * @tparam N The size of the key literal, including its null terminator.
+ */
+template <size_t N> struct SettingKey
+{
+    /// The key, null terminated.
+    char chars[N] = {};
+
+    /// The length of the key, without the null terminator.
+    static constexpr size_t LENGTH = N - 1;
+
+    consteval SettingKey(const char (&key)[N]) // NOLINT(google-explicit-constructor): built from string literals.
+    {
+        std::copy_n(key, N, chars);
+    }
+
+    /**
+     * @brief Check that the key is a valid settings storage key.
+     * @return true if the key is not empty, fits in MAX_SETTING_KEY_SIZE and has no tab (\t) nor inner null character.
+     */
+    [[nodiscard]] constexpr bool isValid() const
+    {
+        return LENGTH > 0 && LENGTH < MAX_SETTING_KEY_SIZE && chars[LENGTH] == '\0' &&
+               std::find(chars, chars + LENGTH, '\t') == chars + LENGTH &&
+               std::find(chars, chars + LENGTH, '\0') == chars + LENGTH;
+    }
+};
+
+/**
+ * @brief Typed access to a setting whose key and type are known at compile time.
+ *
+ * The key is validated and its length computed when the program is compiled. The setting is resolved in the settings
+ * storage the first time it is used, and its address is cached, so later accesses neither look the key up nor check its
+ * type. Reading an integer or real setting is then a single load from the setting.
+ *
+ * @code
+ * Setting<"menu1/setting2", int64_t> setting2(settingsStorage);
+ * int64_t value;
+ * setting2.get(value);
+ * @endcode
+ *
+ * @tparam Key The key of the setting.
+ * @tparam ValueType The type of the setting: int64_t, double or const char*.
+ */
+template <SettingKey Key, typename ValueType> class Setting
+{
+public:
+    static_assert(Key.LENGTH > 0, "Setting keys must not be empty");
+    static_assert(Key.LENGTH < MAX_SETTING_KEY_SIZE, "Setting keys must be shorter than MAX_SETTING_KEY_SIZE");
+    static_assert(Key.isValid(), "Setting keys must not contain the tab (\\t) nor the null character");
+    static_assert(std::is_same_v<ValueType, int64_t> || std::is_same_v<ValueType, double> ||
+                      std::is_same_v<ValueType, const char*>,
+                  "Settings can only be of type int64_t, double or const char*");
+
+    /// The type of the setting in the settings storage.
+    static constexpr SettingsStorage::SettingValueType_t TYPE =
+        std::is_same_v<ValueType, int64_t>  ? SettingsStorage::INTEGER
+        : std::is_same_v<ValueType, double> ? SettingsStorage::REAL
+                                            : SettingsStorage::STRING;
+
+    /**
+     * @brief Build an accessor to the setting. The setting does not need to be registered yet.
+     * @param settingsStorage The settings storage holding the setting. It must outlive the accessor.
+     */
+    explicit Setting(const SettingsStorage& settingsStorage);
+
+    /**
+     * @brief Get the key of the setting.
+     * @return The key, null terminated.
+     */
+    static constexpr const char* key();
+
+    /**
+     * @brief Get the length of the key of the setting, without the null terminator.
+     * @return The length of the key.
+     */
+    static constexpr size_t keyLength();
+
+    /**
+     * @brief Register the setting in the settings storage.
+     * @param permissions The set of permissions associated with the setting.
+     * @param defaultValue The default value of the setting.
+     * @return SettingError_t The result of SettingsStorage::registerSettingAsInt(), registerSettingAsReal() or
+     * registerSettingAsString().
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t registerSetting(SettingPermissions_t permissions,
+                                                                  ValueType            defaultValue) const;
+
+    /**
+     * @brief Get the value of an integer or real setting.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval KEY_NOT_FOUND_ERROR The setting is not registered.
+     * @retval TYPE_MISMATCH_ERROR The setting was registered with another type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t get(ValueType&            outputValue,
+                                                      SettingPermissions_t* outputPermissions = nullptr)
+        requires(TYPE != SettingsStorage::STRING);
+
+    /**
+     * @brief Get the value of a string setting.
+     * @param outputValueBuffer The value of the setting. Must be a buffer with enough space to store the value.
+     * @param outputValueSize The size of the outputValueBuffer.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The outputValueBuffer is nullptr.
+     * @retval KEY_NOT_FOUND_ERROR The setting is not registered.
+     * @retval TYPE_MISMATCH_ERROR The setting was registered with another type.
+     * @retval INSUFFICIENT_BUFFER_SIZE_ERROR The outputValueBuffer is not big enough to store the value.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t get(char* outputValueBuffer, size_t outputValueSize,
+                                                      SettingPermissions_t* outputPermissions = nullptr)
+        requires(TYPE == SettingsStorage::STRING);
+
+    /**
+     * @brief Get the value of a string setting without copying it, see SettingsStorage::leaseSettingAsString().
+     * @param outputLease The lease that receives the value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval KEY_NOT_FOUND_ERROR The setting is not registered.
+     * @retval TYPE_MISMATCH_ERROR The setting was registered with another type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t lease(SettingsStorage::SettingStringLease& outputLease,
+                                                        SettingPermissions_t* outputPermissions = nullptr)
+        requires(TYPE == SettingsStorage::STRING);
+
+    /**
+     * @brief Update the value of the setting.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The value is a null string.
+     * @retval KEY_NOT_FOUND_ERROR The setting is not registered.
+     * @retval TYPE_MISMATCH_ERROR The setting was registered with another type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t put(ValueType value);
+
+private:
+    const SettingsStorage*                        settingsStorage;
+    std::atomic<SettingsStorage::SettingValue_t*> settingValue; // Cached once the setting is resolved.
+
+    [[nodiscard]] SettingsStorage::SettingError_t resolve(SettingsStorage::SettingHandle_t& outputHandle);
+};
+
+template <SettingKey Key, typename ValueType>
+Setting<Key, ValueType>::Setting(const SettingsStorage& settingsStorage)
+{
+    this->settingsStorage = &settingsStorage;
+    this->settingValue.store(nullptr, std::memory_order_relaxed);
+}
+
+template <SettingKey Key, typename ValueType> constexpr const char* Setting<Key, ValueType>::key()
+{
+    return Key.chars;
+}
+
+template <SettingKey Key, typename ValueType> constexpr size_t Setting<Key, ValueType>::keyLength()
+{
+    return Key.LENGTH;
+}
+
+template <SettingKey Key, typename ValueType> SettingsStorage::SettingError_t
+Setting<Key, ValueType>::registerSetting(const SettingPermissions_t permissions, const ValueType defaultValue) const
+{
+    if constexpr (TYPE == SettingsStorage::INTEGER)
+    {
+        return settingsStorage->registerSettingAsInt(key(), permissions, defaultValue);
+    }
+    else if constexpr (TYPE == SettingsStorage::REAL)
+    {
+        return settingsStorage->registerSettingAsReal(key(), permissions, defaultValue);
+    }
+    else
+    {
+        return settingsStorage->registerSettingAsString(key(), permissions, defaultValue);
+    }
+}
+
+template <SettingKey Key, typename ValueType> SettingsStorage::SettingError_t
+Setting<Key, ValueType>::get(ValueType& outputValue, SettingPermissions_t* outputPermissions)
+    requires(TYPE != SettingsStorage::STRING)
+{
+    SettingsStorage::SettingValue_t* value = settingValue.load(std::memory_order_acquire);
+    if (value == nullptr)
+    {
+        SettingsStorage::SettingHandle_t handle = {};
+        if (SettingsStorage::SettingError_t result = resolve(handle); result != SettingsStorage::NO_ERROR)
+        {
+            return result;
+        }
+        value = handle.settingValue;
+    }
+
+    if (outputPermissions != nullptr)
+    {
+        *outputPermissions = value->settingPermissions;
+    }
+    if constexpr (TYPE == SettingsStorage::INTEGER)
+    {
+        outputValue = std::atomic_ref(value->settingValueData.integer).load(std::memory_order_acquire);
+    }
+    else
+    {
+        outputValue = std::atomic_ref(value->settingValueData.real).load(std::memory_order_acquire);
+    }
+    return SettingsStorage::NO_ERROR;
+}
+
+template <SettingKey Key, typename ValueType> SettingsStorage::SettingError_t
+Setting<Key, ValueType>::get(char* outputValueBuffer, const size_t outputValueSize,
+                             SettingPermissions_t* outputPermissions)
+    requires(TYPE == SettingsStorage::STRING)
+{
+    SettingsStorage::SettingHandle_t handle = {settingValue.load(std::memory_order_acquire), TYPE};
+    if (handle.settingValue == nullptr)
+    {
+        if (SettingsStorage::SettingError_t result = resolve(handle); result != SettingsStorage::NO_ERROR)
+        {
+            return result;
+        }
+    }
+    return settingsStorage->getSettingAsString(handle, outputValueBuffer, outputValueSize, outputPermissions);
+}
+
+template <SettingKey Key, typename ValueType> SettingsStorage::SettingError_t
+Setting<Key, ValueType>::lease(SettingsStorage::SettingStringLease& outputLease,
+                               SettingPermissions_t*                outputPermissions)
+    requires(TYPE == SettingsStorage::STRING)
+{
+    SettingsStorage::SettingHandle_t handle = {settingValue.load(std::memory_order_acquire), TYPE};
+    if (handle.settingValue == nullptr)
+    {
+        if (SettingsStorage::SettingError_t result = resolve(handle); result != SettingsStorage::NO_ERROR)
+        {
+            return result;
+        }
+    }
+    return settingsStorage->leaseSettingAsString(handle, outputLease, outputPermissions);
+}
+
+template <SettingKey Key, typename ValueType>
+SettingsStorage::SettingError_t Setting<Key, ValueType>::put(const ValueType value)
+{
+    SettingsStorage::SettingHandle_t handle = {settingValue.load(std::memory_order_acquire), TYPE};
+    if (handle.settingValue == nullptr)
+    {
+        if (SettingsStorage::SettingError_t result = resolve(handle); result != SettingsStorage::NO_ERROR)
+        {
+            return result;
+        }
+    }
+
+    if constexpr (TYPE == SettingsStorage::INTEGER)
+    {
+        return settingsStorage->putSettingValueAsInt(handle, value);
+    }
+    else if constexpr (TYPE == SettingsStorage::REAL)
+    {
+        return settingsStorage->putSettingValueAsReal(handle, value);
+    }
+    else
+    {
+        return settingsStorage->putSettingValueAsString(handle, value);
+    }
+}
+
+template <SettingKey Key, typename ValueType>
+SettingsStorage::SettingError_t Setting<Key, ValueType>::resolve(SettingsStorage::SettingHandle_t& outputHandle)
+{
+    // Several threads may resolve the setting at the same time. They all find the same address, so any store wins.
+    SettingsStorage::SettingError_t result = settingsStorage->resolveSetting(key(), TYPE, outputHandle);
+    if (result == SettingsStorage::NO_ERROR)
+    {
+        settingValue.store(outputHandle.settingValue, std::memory_order_release);
+    }
+    return result;
+}
+
+#endif // SETTING_H
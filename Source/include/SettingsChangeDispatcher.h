@@ -0,0 +1,173 @@
+#ifndef SETTINGSCHANGEDISPATCHER_H
+#define SETTINGSCHANGEDISPATCHER_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "AdaptiveRadixTree.h"
+#include "OSInterface.h"
+
+#ifndef CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS
+    #define CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS 10
+#endif
+
+/**
+ * @brief Delivers the changes of the settings to the subscribers of their key prefixes, from dispatch().
+ *
+ * Writers only add the changed setting to a set of pending changes, so a setting changed several times before the
+ * changes are dispatched is reported once. Once woken by a change, dispatch() lets the changes gather for
+ * CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS, then matches the key of each changed setting against the subscribed
+ * prefixes, which are kept in an AdaptiveRadixTree, and calls every matching subscriber once with all its keys.
+ * The settings are identified by an opaque pointer, whose key is given by a KeyCollector_t.
+ *
+ * The dispatcher does not start any task: the callbacks run on the task that calls dispatch(), usually in a loop, so
+ * the application chooses its stack size and priority. Every synchronization primitive is created through the
+ * OSInterface, and no function waits for one of them for longer than SETTINGS_STORAGE_MUTEX_TIMEOUT_MS. A change that
+ * cannot be queued in time is dropped, while the changes that cannot be delivered in time are queued again, unless
+ * the pending changes cannot be locked in time either.
+ */
+class SettingsChangeDispatcher
+{
+public:
+    /**
+     * Function called with the keys of the settings that changed under a subscribed prefix, sorted. The keys are
+     * only valid during the call. It runs on the task that calls dispatch(), so it must not block for long.
+     */
+    typedef void (*ChangeCallback_t)(void* userData, const char* const* keys, size_t count);
+
+    /**
+     * Function that adds the null terminated key of every setting to a map, indexed by the pointer that identifies the
+     * setting. The keys are not copied, so they must stay valid as long as the dispatcher. It returns false if the keys
+     * could not be collected in time.
+     */
+    typedef bool (*KeyCollector_t)(void* context, std::unordered_map<const void*, const char*>& outputKeys);
+
+    /// Result of unsubscribe().
+    typedef enum
+    {
+        UNSUBSCRIBED,
+        SUBSCRIPTION_NOT_FOUND,
+        UNSUBSCRIBE_TIMEOUT
+    } UnsubscribeResult_t;
+
+    /// Subscription identifier never returned by subscribe().
+    static constexpr uint32_t INVALID_SUBSCRIPTION = 0;
+
+    /**
+     * @brief Build a dispatcher without subscriptions.
+     * @param osInterface The OS interface used to create the synchronization primitives.
+     * @param keyCollector The function that gives the keys of the settings. It is called from dispatch().
+     * @param keyCollectorContext Opaque value passed to keyCollector.
+     */
+    SettingsChangeDispatcher(OSInterface& osInterface, KeyCollector_t keyCollector, void* keyCollectorContext);
+
+    /**
+     * @brief Destroy the dispatcher. The changes not delivered yet are dropped. No task may be in dispatch().
+     */
+    ~SettingsChangeDispatcher();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    SettingsChangeDispatcher& operator=(SettingsChangeDispatcher&&) = delete;
+
+    /**
+     * @brief Subscribe to the changes of the settings whose key starts with a prefix.
+     * @param keyPrefix The prefix, "" to get every change. It is copied.
+     * @param callback The function called with the changed keys.
+     * @param userData Opaque value passed to callback.
+     * @return The identifier of the subscription, or INVALID_SUBSCRIPTION if the subscriptions could not be locked in
+     * time.
+     */
+    [[nodiscard]] uint32_t subscribe(const char* keyPrefix, ChangeCallback_t callback, void* userData);
+
+    /**
+     * @brief Cancel a subscription. Once it returns, the callback is not called anymore, unless it is called from
+     * a callback. It waits for the delivery in progress, if any.
+     * @param subscriptionId The identifier returned by subscribe().
+     * @return UnsubscribeResult_t The result of the operation.
+     * @retval UNSUBSCRIBED The subscription was cancelled.
+     * @retval SUBSCRIPTION_NOT_FOUND There is no subscription with this identifier.
+     * @retval UNSUBSCRIBE_TIMEOUT The delivery or the subscriptions could not be locked in time. The subscription is
+     * left as it was.
+     */
+    [[nodiscard]] UnsubscribeResult_t unsubscribe(uint32_t subscriptionId);
+
+    /**
+     * @brief Check if there is any subscription, so writers can skip notifyChange() otherwise.
+     * @return True if there is at least one subscription.
+     */
+    [[nodiscard]] bool hasSubscribers() const;
+
+    /**
+     * @brief Report that a setting changed.
+     * @param setting The pointer that identifies the setting.
+     * @return True if the change was queued, false if the pending changes could not be locked in time, in which case
+     * the change is dropped.
+     */
+    bool notifyChange(const void* setting);
+
+    /**
+     * @brief Wait for a change to be reported, then deliver it, along with the changes reported during the coalescing
+     * delay, on the calling task. It must only be called by one task at a time.
+     * @param timeoutMs Maximum time to wait for a change, which also caps the coalescing delay. 0 delivers the pending
+     * changes, if any, without waiting.
+     * @return True if the changes were delivered, false if no change was reported in time, or if some changes could
+     * not be delivered in time, because of contention. Those are queued again, to be delivered by the next call.
+     */
+    bool dispatch(uint32_t timeoutMs);
+
+private:
+    typedef struct
+    {
+        uint32_t         id;
+        ChangeCallback_t callback;
+        void*            userData;
+    } Subscriber_t;
+
+    typedef std::vector<Subscriber_t> SubscriberList_t;
+
+    /// Keys to deliver to one subscriber.
+    typedef struct
+    {
+        ChangeCallback_t         callback;
+        void*                    userData;
+        std::vector<const char*> keys;
+    } Delivery_t;
+
+    /// Deliveries being built for the changed key being matched, see matchSubscribersCallback().
+    typedef std::tuple<std::map<uint32_t, Delivery_t>*, const char*> MatchCallbackData_t;
+
+    KeyCollector_t                               keyCollector;
+    void*                                        keyCollectorContext;
+    std::unordered_map<const void*, const char*> keys; // Keys of the settings, only used by dispatch().
+
+    OSInterface_Mutex*                        subscriptionsMutex;
+    AdaptiveRadixTree<SubscriberList_t>       subscriptions;        // Subscribers of each non-empty prefix.
+    SubscriberList_t                          allKeysSubscribers;   // Subscribers of the "" prefix.
+    std::unordered_map<uint32_t, std::string> subscriptionPrefixes; // Prefix of each subscription.
+    uint32_t                                  nextSubscriptionId;
+    std::atomic<uint32_t>                     subscriptionsCount;
+
+    OSInterface_Mutex*              pendingMutex;
+    OSInterface_BinarySemaphore*    pendingSemaphore; // Signaled when a change is reported while none was pending.
+    std::unordered_set<const void*> pending;          // Settings changed since the last delivery.
+    OSInterface_Mutex*              deliveryMutex;    // Held while the callbacks are being called.
+
+    /// Dispatcher whose callbacks the current task is calling, nullptr outside of the callbacks.
+    inline static thread_local const SettingsChangeDispatcher* deliveringDispatcher = nullptr;
+
+    static bool lock(OSInterface_Mutex* mutex);
+    bool        deliver(const std::vector<const void*>& changed);
+    void        requeue(const std::vector<const void*>& changes);
+    static void addDelivery(std::map<uint32_t, Delivery_t>& deliveries, const SubscriberList_t& subscribers,
+                            const char* key);
+    static int  matchSubscribersCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+    static int  freeSubscriberListCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+};
+
+#endif // SETTINGSCHANGEDISPATCHER_H
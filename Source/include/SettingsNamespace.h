@@ -0,0 +1,159 @@
+#ifndef SETTINGSNAMESPACE_H
+#define SETTINGSNAMESPACE_H
+
+#include <string>
+#include "SettingsStorage.h"
+
+/**
+ * @brief View of the settings whose keys start with a prefix, which are accessed with the rest of their key.
+ *
+ * The namespace keeps an anchor on the node of the settings tree reached by the prefix, so a lookup only walks the
+ * part of the key that follows it, and the full key is never built. The anchor is taken again on the first lookup after
+ * a setting is registered or removed. Once the settings are frozen, the lookups use the frozen index instead.
+ *
+ * @code
+ * SettingsNamespace eth0(settingsStorage, "network/eth0/");
+ * int64_t           mtu;
+ * SettingsStorage::SettingError_t result = eth0.getSettingAsInt("mtu", mtu); // Gets "network/eth0/mtu".
+ * @endcode
+ *
+ * A namespace must only be used by one thread at a time.
+ */
+class SettingsNamespace
+{
+public:
+    /**
+     * @brief Build a namespace.
+     * @param settingsStorage The settings storage the namespace views. It must outlive the namespace.
+     * @param prefix The prefix of the keys of the namespace, which usually ends with '/'. It is copied.
+     */
+    SettingsNamespace(const SettingsStorage& settingsStorage, const char* prefix);
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    SettingsNamespace& operator=(SettingsNamespace&&) = delete;
+
+    /**
+     * @brief Get the prefix of the keys of the namespace.
+     * @return The prefix.
+     */
+    [[nodiscard]] const char* getPrefix() const;
+
+    /**
+     * @brief This function looks the setting with the provided key up once, so it can then be accessed through the
+     * handle with the SettingsStorage handle based functions.
+     * @param key The key of the setting to resolve, without the prefix of the namespace.
+     * @param type The type the setting must be of.
+     * @param outputHandle The handle of the setting. It is not modified if an error is returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully resolved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t resolveSetting(const char*                         key,
+                                                                 SettingsStorage::SettingValueType_t type,
+                                                                 SettingsStorage::SettingHandle_t&   outputHandle);
+
+    /**
+     * @brief This function returns the value of the setting with the provided key.
+     * @param key The key of the setting to get, without the prefix of the namespace.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t getSettingAsInt(const char* key, int64_t& outputValue,
+                                                                  SettingPermissions_t* outputPermissions = nullptr);
+
+    /**
+     * @brief This function returns the value of the setting with the provided key.
+     * @param key The key of the setting to get, without the prefix of the namespace.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t getSettingAsReal(const char* key, double& outputValue,
+                                                                   SettingPermissions_t* outputPermissions = nullptr);
+
+    /**
+     * @brief This function returns the value of the setting with the provided key.
+     * @param key The key of the setting to get, without the prefix of the namespace.
+     * @param outputValueBuffer The buffer to store the value of the setting.
+     * @param outputValueSize The size of the buffer.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     * @retval INSUFFICIENT_BUFFER_SIZE_ERROR The outputValueBuffer is null or not big enough to store the value.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t getSettingAsString(const char* key, char* outputValueBuffer,
+                                                                     size_t                outputValueSize,
+                                                                     SettingPermissions_t* outputPermissions = nullptr);
+
+    /**
+     * @brief This function updates the value of the setting with the provided key.
+     * @param key The key of the setting to update, without the prefix of the namespace.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of type INTEGER.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t putSettingValueAsInt(const char* key, int64_t value);
+
+    /**
+     * @brief This function updates the value of the setting with the provided key.
+     * @param key The key of the setting to update, without the prefix of the namespace.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of type REAL.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t putSettingValueAsReal(const char* key, double value);
+
+    /**
+     * @brief This function updates the value of the setting with the provided key. The string is copied.
+     * @param key The key of the setting to update, without the prefix of the namespace.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "", or the value is nullptr.
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of type STRING.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t putSettingValueAsString(const char* key, const char* value);
+
+private:
+    const SettingsStorage* settingsStorage;
+    std::string            prefix;
+    art_anchor             anchor;
+    bool                   anchored; // If anchor was taken, though it may be stale.
+
+    SettingsStorage::SettingError_t getSettingValue(const char* key, SettingsStorage::SettingValue_t*& outputValue);
+};
+
+#endif // SETTINGSNAMESPACE_H
@@ -0,0 +1,143 @@
+#ifndef SETTINGSSNAPSHOT_H
+#define SETTINGSSNAPSHOT_H
+
+#include <string_view>
+#include <vector>
+#include "SettingsStorage.h"
+
+/**
+ * @brief Immutable copy of a set of settings as they were at one point in time, taken by SettingsStorage::snapshot().
+ *
+ * The snapshot holds the keys, the permissions and the values of the settings, so it can be read, iterated and
+ * written to the persistent storage while the settings keep being updated. The values are read together, so a
+ * SettingsTransaction commit is either fully in the snapshot or not at all. The long strings are not copied: the
+ * snapshot holds a reference to the buffer of each one, which keeps that version of the string alive after the setting
+ * is updated. A snapshot must therefore be destroyed before the settings storage it was taken from.
+ *
+ * @code
+ * SettingsSnapshot snapshot;
+ * if (settingsStorage.snapshot(snapshot, "pid/") == SettingsStorage::NO_ERROR)
+ * {
+ *     double kp;
+ *     double ki;
+ *     snapshot.getSettingAsReal("pid/kp", kp);
+ *     snapshot.getSettingAsReal("pid/ki", ki);
+ * }
+ * @endcode
+ *
+ * A snapshot is not modified once taken, so it can be read from any number of threads.
+ */
+class SettingsSnapshot
+{
+public:
+    /**
+     * @brief Build an empty snapshot.
+     */
+    SettingsSnapshot() = default;
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    SettingsSnapshot& operator=(SettingsSnapshot&&) = delete;
+
+    /**
+     * @brief Get the number of settings of the snapshot.
+     * @return The number of settings.
+     */
+    [[nodiscard]] size_t size() const;
+
+    /**
+     * @brief Get the store generation the snapshot was taken at, see SettingsStorage::getGeneration(). The settings
+     * have not changed since the snapshot while the store generation is the same.
+     * @return The store generation of the snapshot.
+     */
+    [[nodiscard]] uint64_t getGeneration() const;
+
+    /**
+     * @brief This function returns the value of a setting of the snapshot.
+     * @param key The key of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key is not in the snapshot.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t
+    getSettingAsInt(const char* key, int64_t& outputValue, SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a setting of the snapshot.
+     * @param key The key of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key is not in the snapshot.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t
+    getSettingAsReal(const char* key, double& outputValue, SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a setting of the snapshot without copying it.
+     * @param key The key of the setting to get.
+     * @param outputValue The value of the setting. It is valid until the snapshot is destroyed.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key is not in the snapshot.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t
+    getSettingAsString(const char* key, std::string_view& outputValue,
+                       SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This lists the keys of the settings of the snapshot that match the provided key prefix.
+     * @param keyPrefix The prefix of the keys to list. An empty string will list all keys.
+     * @param outputKeys The list of keys that match the provided key prefix, appended in lexical order.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The settings were successfully listed.
+     * @retval INVALID_INPUT_ERROR The keyPrefix is nullptr.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t
+    listSettingsKeys(const char* keyPrefix, SettingsStorage::SettingsKeysList_t& outputKeys) const;
+
+private:
+    friend class SettingsStorage;
+
+    typedef struct
+    {
+        uint32_t                            keyOffset; // Position of the null terminated key in keys.
+        uint32_t                            keyLen;
+        SettingsStorage::SettingValueType_t settingValueType;
+        SettingPermissions_t                settingPermissions;
+        union
+        {
+            int64_t integer;
+            double  real;
+            size_t  string; // Position of the lease of the string in strings.
+        } value;
+    } Entry_t;
+
+    std::vector<char>                                keys;
+    std::vector<Entry_t>                             entries; // In the lexical order of their keys.
+    std::vector<SettingsStorage::SettingStringLease> strings;
+    uint64_t                                         generation = 0;
+
+    [[nodiscard]] std::string_view                     keyOf(const Entry_t& entry) const;
+    [[nodiscard]] std::vector<Entry_t>::const_iterator lowerBound(std::string_view key) const;
+    [[nodiscard]] SettingsStorage::SettingError_t
+    find(const char* key, SettingsStorage::SettingValueType_t type, const Entry_t*& outputEntry,
+         SettingPermissions_t* outputPermissions) const;
+    void clear();
+};
+
+#endif // SETTINGSSNAPSHOT_H
@@ -3,20 +3,45 @@
 
 #define CRCPP_USE_CPP11
 
+#include <atomic>
+#include <span>
 #include <string>
+#include <string_view>
 #include "AtomicLibARTCpp.h"
 #include "CRC.h"
+#include "ConcurrentAdaptiveRadixTree.h"
+#include "EpochManager.h"
 #include "OSInterface.h"
+#include "PerfectHashIndex.h"
+#include "SettingsChangeDispatcher.h"
 #include "SettingsFile.h"
+#include "ShardedAdaptiveRadixTree.h"
+#include "ThreadLocalLookupCache.h"
 #include "list"
 
 #ifndef CONFIG_SETTINGS_STORAGE_FORCE_DISABLE_PERSISTENT_STORAGE
     #define CONFIG_SETTINGS_STORAGE_FORCE_DISABLE_PERSISTENT_STORAGE false
 #endif
 
+#ifndef CONFIG_SETTINGS_STORAGE_CONCURRENT_WRITES
+    #define CONFIG_SETTINGS_STORAGE_CONCURRENT_WRITES false
+#endif
+
+#ifndef CONFIG_SETTINGS_STORAGE_SHARDED_TREE
+    #define CONFIG_SETTINGS_STORAGE_SHARDED_TREE false
+#endif
+
+#ifndef CONFIG_SETTINGS_STORAGE_SHORT_STRING_LENGTH
+    #define CONFIG_SETTINGS_STORAGE_SHORT_STRING_LENGTH 22
+#endif
+
 constexpr size_t PERMISSION_STRING_SIZE = 34;
 constexpr size_t MAX_SETTING_KEY_SIZE   = 128;
 
+/// Maximum length of the string setting values stored inside the setting itself. Longer strings use the heap.
+constexpr size_t SHORT_STRING_MAX_LENGTH = CONFIG_SETTINGS_STORAGE_SHORT_STRING_LENGTH;
+static_assert(SHORT_STRING_MAX_LENGTH + 1 >= sizeof(char*), "The short strings must not overlap their tag byte");
+
 /**
  * @brief The permissions that can be granted to a setting.
  *
@@ -68,12 +93,26 @@ const char* settingPermissionToString(SettingPermissions_t permission, char* per
 /// This function validates the permissions.
 bool validatePermissions(SettingPermissions_t permissions);
 
+class SettingsTransaction;
+class SettingsNamespace;
+class SettingsSnapshot;
+
 class SettingsStorage
 {
 public:
     /// List of keys that match the provided key prefix.
     using SettingsKeysList_t = std::list<std::string>;
 
+    /// An immediate child of a key prefix, see listChildren().
+    typedef struct
+    {
+        std::string name;        ///< The part of the keys after the prefix, up to the next '/'.
+        bool        isDirectory; ///< True if the keys continue with '/' after the name, false if it is a setting.
+    } SettingChild_t;
+
+    /// List of the immediate children of a key prefix.
+    using SettingChildrenList_t = std::list<SettingChild_t>;
+
     /// Enum that stores the possible errors returned by the SettingsStorage API.
     typedef enum
     {
@@ -84,7 +123,9 @@ public:
         KEY_EXISTS_ERROR,
         SETTINGS_FILESYSTEM_ERROR,
         INVALID_INPUT_ERROR,
-        INSUFFICIENT_BUFFER_SIZE_ERROR
+        INSUFFICIENT_BUFFER_SIZE_ERROR,
+        SETTINGS_FROZEN_ERROR,
+        LOCK_TIMEOUT_ERROR
     } SettingError_t;
 
     /// Enum with the types of data that can be saved.
@@ -96,13 +137,31 @@ public:
         MAX_SETTING_VALUE_TYPE_ENUM
     } SettingValueType_t;
 
-    /// Union with the types of data that can be saved.
+    /**
+     * @brief The data of a setting value.
+     *
+     * Strings of up to SHORT_STRING_MAX_LENGTH characters are stored in shortString, followed by SHORT_STRING_TAG.
+     * Longer strings are stored in immutable reference counted heap buffers (see SharedString_t) and referenced by
+     * string, with SHARED_STRING_TAG, so a value and its default can share one buffer. The long defaults registered
+     * with registerSettings() are referenced in place, with STATIC_STRING_TAG. Use getStringData() to read a string
+     * regardless of its representation.
+     *
+     * The integer and real values of a setting may be read and updated at the same time by several tasks, so they are
+     * only accessed through std::atomic_ref, which makes their gets and puts tear-free without any lock.
+     */
     typedef union
     {
         double  real;
         int64_t integer;
         char*   string;
+        char    shortString[SHORT_STRING_MAX_LENGTH + 2]; // The last byte is the tag.
     } SettingValueData_t;
+    static_assert(alignof(SettingValueData_t) >= std::atomic_ref<int64_t>::required_alignment &&
+                      alignof(SettingValueData_t) >= std::atomic_ref<double>::required_alignment,
+                  "The scalar setting values must be suitably aligned for atomic access");
+    static_assert(sizeof(SettingValueData_t) % sizeof(uintptr_t) == 0 &&
+                      alignof(SettingValueData_t) >= std::atomic_ref<uintptr_t>::required_alignment,
+                  "The setting value data must be made of words suitable for atomic access");
 
     /// The value of each setting element.
     typedef struct SettingValue_t
@@ -111,13 +170,125 @@ public:
         SettingValueData_t   settingValueData;
         SettingValueData_t   settingDefaultValueData;
         SettingPermissions_t settingPermissions;
+        uint64_t             settingGeneration; // Store generation of the last write, accessed through atomic_ref.
     } SettingValue_t;
 
+    static_assert(alignof(SettingValue_t) >= std::atomic_ref<uint64_t>::required_alignment,
+                  "The setting generations must be suitably aligned for atomic access");
+
+    /**
+     * @brief A setting resolved by resolveSetting(), which gives access to it without looking its key up again.
+     *
+     * Settings are never removed nor moved once registered, so a handle stays valid, even while other settings are
+     * being registered, until the settings storage is destroyed. Handles must be initialized with {} before they are
+     * resolved.
+     */
+    typedef struct
+    {
+        SettingValue_t*    settingValue;     ///< The resolved setting, nullptr if the handle was never resolved.
+        SettingValueType_t settingValueType; ///< The type the setting was resolved for.
+    } SettingHandle_t;
+
+    /**
+     * Function called from dispatchChangeNotifications() with the sorted keys of the settings that changed under a
+     * subscribed prefix, see subscribe(). The keys are only valid during the call.
+     */
+    typedef SettingsChangeDispatcher::ChangeCallback_t SettingsChangeCallback_t;
+
+    /// Description of a setting to create with registerSettings(), usually part of a constant table.
+    typedef struct
+    {
+        const char*          key;                ///< The key of the setting. It must not contain the tab character.
+        SettingValueType_t   settingValueType;   ///< The type of the setting.
+        SettingPermissions_t settingPermissions; ///< The set of permissions associated with the setting.
+        union
+        {
+            double      real;
+            int64_t     integer;
+            const char* string; ///< Referenced, not copied, so it must outlive the settings storage.
+        } defaultValue;         ///< The default value of the setting, the member matching settingValueType.
+    } SettingDescriptor_t;
+
+    /// One setting of a batch get, see getSettingsBatch().
+    typedef struct
+    {
+        const char*        key;              ///< The key of the setting to get.
+        SettingValueType_t settingValueType; ///< The type the setting must be of.
+        union
+        {
+            int64_t* integer;
+            double*  real;
+            char*    string;
+        } outputValue;                           ///< Where the value is written, the member matching settingValueType.
+        size_t                outputValueSize;   ///< The size of outputValue.string. Unused for the other types.
+        SettingPermissions_t* outputPermissions; ///< Where the permissions are written, or nullptr.
+        SettingError_t        result;            ///< Output: the result of the get of this setting.
+    } SettingBatchGet_t;
+
+    /**
+     * @brief The value of a string setting, read by leaseSettingAsString() without copying it.
+     *
+     * The string is kept alive and unchanged until the lease is released, even if the setting is updated meanwhile:
+     * the lease holds a reference to its heap buffer, or a copy of it if it is short. A lease must be released before
+     * the settings storage it was taken from is destroyed.
+     */
+    class SettingStringLease
+    {
+    public:
+        /**
+         * @brief Build an empty lease.
+         */
+        SettingStringLease() = default;
+
+        /**
+         * @brief Release the leased string, if any.
+         */
+        ~SettingStringLease();
+
+        /**
+         * @brief Take over the string leased by another lease, which is left empty.
+         * @param other The lease to move from.
+         */
+        SettingStringLease(SettingStringLease&& other) noexcept;
+
+        /**
+         * @brief Release the leased string, if any, and take over the string leased by another lease, which is left
+         * empty.
+         * @param other The lease to move from.
+         * @return This lease.
+         */
+        SettingStringLease& operator=(SettingStringLease&& other) noexcept;
+
+        /**
+         * @brief Get the leased string. It is valid until the lease is released or moved.
+         * @return The leased string, or an empty view if the lease is empty.
+         */
+        [[nodiscard]] std::string_view view() const;
+
+        /**
+         * @brief Release the leased string, if any, leaving the lease empty.
+         */
+        void release();
+
+    private:
+        friend class SettingsStorage;
+
+        const SettingsStorage* settingsStorage = nullptr; // nullptr while the lease is empty.
+        SettingValueData_t     data            = {};
+        size_t                 length          = 0;
+    };
+
     /// String with the name of the component.
     constexpr static const char* const COMPONENT_TAG = "PurifyMyWater - SettingsStorage";
 
     /// The data structure used internally to store the settings.
+#if CONFIG_SETTINGS_STORAGE_CONCURRENT_WRITES
+    typedef ConcurrentAdaptiveRadixTree<SettingValue_t> Settings_t;
+#elif CONFIG_SETTINGS_STORAGE_SHARDED_TREE
+    typedef ShardedAdaptiveRadixTree<SettingValue_t> Settings_t;
+#else
     typedef AtomicAdaptiveRadixTree<SettingValue_t> Settings_t;
+#endif
 
     /**
      * @brief Build a new empty Settings Storage object.
@@ -161,6 +332,8 @@ public:
      * @retval INVALID_INPUT_ERROR If keyPrefix is nullptr.
      * @retval INVALID_INPUT_ERROR The permissions are invalid.
      * @retval INVALID_INPUT_ERROR The filterMode is invalid.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read or written in time, because of contention. No setting
+     * is restored.
      */
     [[nodiscard]] SettingError_t
     restoreDefaultSettings(const char* keyPrefix, SettingPermissions_t permissions = ALL_PERMISSIONS,
@@ -176,6 +349,7 @@ public:
      * @retval NO_ERROR The settings were successfully saved.
      * @retval SETTINGS_FILESYSTEM_ERROR The settings filesystem is corrupted, and the settings were not saved.
      * @retval SETTINGS_FILESYSTEM_ERROR The persisten storage is disabled, and the settings were not saved.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention. The old copy is kept.
      */
     [[nodiscard]] SettingError_t storeSettingsInPersistentStorage() const;
 
@@ -185,6 +359,7 @@ public:
      * @note If there are settings in the settingsFile that are not registered by the components,
      * they will be loaded but marked as volatile,
      * which means they will not be saved in the persistent storage.
+     * Once the settings storage is frozen, no setting can be created, so these settings are skipped instead.
      *
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The settings were successfully loaded.
@@ -203,11 +378,71 @@ public:
      * @retval INVALID_INPUT_ERROR The keyPrefix is nullptr.
      * @retval INVALID_INPUT_ERROR The permissions are invalid.
      * @retval INVALID_INPUT_ERROR The filterMode is invalid.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      */
     [[nodiscard]] SettingError_t listSettingsKeys(const char* keyPrefix, SettingPermissions_t permissions,
                                                   SettingPermissionsFilterMode_t filterMode,
                                                   SettingsKeysList_t&            outputKeys) const;
 
+    /**
+     * @brief This lists the immediate children of the provided key prefix, like the entries of a directory, with '/'
+     * separating the levels. Each child is listed once, in lexical order, without visiting the settings deeper than
+     * it. A name that is both a setting and the start of deeper keys is listed twice, first as a setting.
+     * @param keyPrefix The prefix of the children, which is usually "" or ends with '/'.
+     * @param outputChildren The children of the prefix, appended in lexical order.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The children were successfully listed.
+     * @retval INVALID_INPUT_ERROR The keyPrefix is nullptr.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval FATAL_ERROR The settings could not be read.
+     */
+    [[nodiscard]] SettingError_t listChildren(const char* keyPrefix, SettingChildrenList_t& outputChildren) const;
+
+    /**
+     * @brief This function takes a snapshot of the settings that match the provided key prefix and permissions filter,
+     * which can be read and iterated while the settings keep being updated, see SettingsSnapshot. The settings tree is
+     * only locked while the keys of the matching settings are copied, and their values are then read without holding
+     * back the writers. They are read again if a setting is written meanwhile, a bounded number of times.
+     * @param outputSnapshot The snapshot to fill. The settings it held before are released.
+     * @param keyPrefix The prefix of the keys of the settings to take. An empty string will take all settings.
+     * @param permissions The permissions filter to apply to the settings.
+     * @param filterMode The filter mode to apply to the permissions.
+     * @return SettingError_t The result of the operation. The snapshot is empty if it is an error.
+     * @retval NO_ERROR The snapshot was taken.
+     * @retval INVALID_INPUT_ERROR The keyPrefix is nullptr.
+     * @retval INVALID_INPUT_ERROR The permissions are invalid.
+     * @retval INVALID_INPUT_ERROR The filterMode is invalid.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t
+    snapshot(SettingsSnapshot& outputSnapshot, const char* keyPrefix = "",
+             SettingPermissions_t           permissions = ALL_PERMISSIONS,
+             SettingPermissionsFilterMode_t filterMode  = MatchSettingsWithAnyPermissionsListed) const;
+
+    /**
+     * @brief This function visits the settings that match the provided key prefix in lexical order, applying the
+     * permissions filter on the way. No key is copied: each setting is handed to the visitor as a view of its key and
+     * a handle, which the visitor may use with the handle based functions. The visitor must not register settings.
+     * Nothing is allocated, except with the sharded tree, where a prefix without a '/' spans several shards, whose
+     * settings are collected in a vector to be merged in order.
+     * @tparam Visitor A callable like bool(std::string_view key, const SettingHandle_t& handle), returning true to
+     * visit the next setting or false to stop. The key view is valid until the settings storage is destroyed.
+     * @param keyPrefix The prefix of the keys to visit. An empty string will visit all settings.
+     * @param visitor The callable invoked for each setting. It is copied.
+     * @param permissions The permissions filter to apply to the settings.
+     * @param filterMode The filter mode to apply to the permissions.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The settings were visited, or the visitor stopped the visit.
+     * @retval INVALID_INPUT_ERROR The keyPrefix is nullptr.
+     * @retval INVALID_INPUT_ERROR The permissions are invalid.
+     * @retval INVALID_INPUT_ERROR The filterMode is invalid.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     */
+    template <typename Visitor>
+    [[nodiscard]] SettingError_t
+    forEachSetting(const char* keyPrefix, Visitor visitor, SettingPermissions_t permissions = ALL_PERMISSIONS,
+                   SettingPermissionsFilterMode_t filterMode = MatchSettingsWithAnyPermissionsListed) const;
+
     /**
      * @brief This function returns the value of the setting with the provided key.
      * @param key The key of the setting to get.
@@ -218,6 +453,7 @@ public:
      * @retval NO_ERROR The setting was successfully retrieved.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
      */
     [[nodiscard]] SettingError_t getSettingAsInt(const char* key, int64_t& outputValue,
@@ -233,6 +469,7 @@ public:
      * @retval NO_ERROR The setting was successfully retrieved.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
      */
     [[nodiscard]] SettingError_t getSettingAsReal(const char* key, double& outputValue,
@@ -250,12 +487,88 @@ public:
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval INVALID_INPUT_ERROR The outputValueBuffer is nullptr.
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
      * @retval INSUFFICIENT_BUFFER_SIZE_ERROR The outputValueBuffer is null or not big enough to store the value.
      */
     [[nodiscard]] SettingError_t getSettingAsString(const char* key, char* outputValueBuffer, size_t outputValueSize,
                                                     SettingPermissions_t* outputPermissions = nullptr) const;
 
+    /**
+     * @brief This function returns the value of the setting with the provided key without copying it. The value stays
+     * valid while the lease holds it, regardless of the puts of the setting.
+     * @param key The key of the setting to get.
+     * @param outputLease The lease that receives the value of the setting. The string it held before is released.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingError_t leaseSettingAsString(const char* key, SettingStringLease& outputLease,
+                                                      SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of the setting with the provided key with its generation, see
+     * getSettingWithGenerationAsInt(const SettingHandle_t&, int64_t&, uint64_t&, SettingPermissions_t*) const.
+     * @param key The key of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputGeneration The generation of the setting, see getSettingGeneration().
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingError_t
+    getSettingWithGenerationAsInt(const char* key, int64_t& outputValue, uint64_t& outputGeneration,
+                                  SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of the setting with the provided key with its generation, see
+     * getSettingWithGenerationAsReal(const SettingHandle_t&, double&, uint64_t&, SettingPermissions_t*) const.
+     * @param key The key of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputGeneration The generation of the setting, see getSettingGeneration().
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingError_t
+    getSettingWithGenerationAsReal(const char* key, double& outputValue, uint64_t& outputGeneration,
+                                   SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of the setting with the provided key with its generation, without
+     * copying it, see leaseSettingWithGenerationAsString(const SettingHandle_t&, SettingStringLease&, uint64_t&,
+     * SettingPermissions_t*) const.
+     * @param key The key of the setting to get.
+     * @param outputLease The lease that receives the value of the setting. The string it held before is released.
+     * @param outputGeneration The generation of the setting, see getSettingGeneration().
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingError_t
+    leaseSettingWithGenerationAsString(const char* key, SettingStringLease& outputLease, uint64_t& outputGeneration,
+                                       SettingPermissions_t* outputPermissions = nullptr) const;
+
     /**
      * @brief This function creates an empty setting located at the specified path, with the provided permissions.
      * @param key The key of the setting to create. It must not contain the tab (\t) character.
@@ -264,6 +577,9 @@ public:
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The setting was successfully created.
      * @retval KEY_EXISTS_ERROR The setting with the provided key already exists.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be updated in time, because of contention, or the settings
+     * storage is being frozen.
+     * @retval SETTINGS_FROZEN_ERROR The settings storage is frozen, so no setting can be created.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval INVALID_INPUT_ERROR The permissions are invalid.
      */
@@ -278,6 +594,9 @@ public:
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The setting was successfully created.
      * @retval KEY_EXISTS_ERROR The setting with the provided key already exists.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be updated in time, because of contention, or the settings
+     * storage is being frozen.
+     * @retval SETTINGS_FROZEN_ERROR The settings storage is frozen, so no setting can be created.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval INVALID_INPUT_ERROR The permissions are invalid.
      */
@@ -292,6 +611,9 @@ public:
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The setting was successfully created.
      * @retval KEY_EXISTS_ERROR The setting with the provided key already exists.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be updated in time, because of contention, or the settings
+     * storage is being frozen.
+     * @retval SETTINGS_FROZEN_ERROR The settings storage is frozen, so no setting can be created.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval INVALID_INPUT_ERROR The permissions are invalid.
      * @retval INVALID_INPUT_ERROR The defaultValue is nullptr.
@@ -299,6 +621,23 @@ public:
     [[nodiscard]] SettingError_t registerSettingAsString(const char* key, SettingPermissions_t permissions,
                                                          const char* defaultValue) const;
 
+    /**
+     * @brief This function creates several settings, all of them in a single write section of the settings tree.
+     * If no setting was created yet and the descriptors are sorted by key, the settings tree is built at once. The long
+     * string defaults are not copied, but referenced from the descriptors.
+     * @param descriptors The settings to create.
+     * @param outputResults Optional output array with the result of each descriptor, as returned by
+     * registerSettingAsInt(), registerSettingAsReal() or registerSettingAsString(). If it is nullptr, the results are
+     * not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR All the settings were successfully created.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be updated in time, because of contention. With a sharded
+     * tree, the settings of the other shards may have been created.
+     * @retval Others The first error of outputResults. The other settings were created.
+     */
+    [[nodiscard]] SettingError_t registerSettings(std::span<const SettingDescriptor_t> descriptors,
+                                                  SettingError_t*                      outputResults = nullptr) const;
+
     /**
      * @brief This function updates the value of the setting with the provided key.
      * @param key The key of the setting to update.
@@ -306,6 +645,7 @@ public:
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The setting was successfully updated.
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type or void.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      */
@@ -318,6 +658,7 @@ public:
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The setting was successfully updated.
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type or void.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      */
@@ -330,6 +671,7 @@ public:
      * @return SettingError_t The result of the operation.
      * @retval NO_ERROR The setting was successfully updated.
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type or void.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval INVALID_INPUT_ERROR The value is nullptr.
@@ -346,6 +688,7 @@ public:
      * @retval NO_ERROR The setting was successfully retrieved.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
      */
     [[nodiscard]] SettingError_t getDefaultSettingAsInt(const char* key, int64_t& outputValue,
@@ -361,6 +704,7 @@ public:
      * @retval NO_ERROR The setting was successfully retrieved.
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
      */
     [[nodiscard]] SettingError_t getDefaultSettingAsReal(const char* key, double& outputValue,
@@ -378,6 +722,7 @@ public:
      * @retval INVALID_INPUT_ERROR The key is nullptr or "".
      * @retval INVALID_INPUT_ERROR The outputValueBuffer is nullptr.
      * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
      * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
      * @retval INSUFFICIENT_BUFFER_SIZE_ERROR The outputValueBuffer is null or not big enough to store the value.
      */
@@ -385,29 +730,425 @@ public:
                                                            size_t                outputValueSize,
                                                            SettingPermissions_t* outputPermissions = nullptr) const;
 
+    /**
+     * @brief This function looks the setting with the provided key up once, so it can then be accessed through the
+     * handle without any key lookup or type check.
+     * @param key The key of the setting to resolve.
+     * @param type The type the setting must be of.
+     * @param outputHandle The handle of the setting. It is not modified if an error is returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully resolved.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of the expected type.
+     */
+    [[nodiscard]] SettingError_t resolveSetting(const char* key, SettingValueType_t type,
+                                                SettingHandle_t& outputHandle) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting.
+     * @param handle The handle of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     */
+    [[nodiscard]] SettingError_t getSettingAsInt(const SettingHandle_t& handle, int64_t& outputValue,
+                                                 SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting.
+     * @param handle The handle of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     */
+    [[nodiscard]] SettingError_t getSettingAsReal(const SettingHandle_t& handle, double& outputValue,
+                                                  SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting.
+     * @param handle The handle of the setting to get.
+     * @param outputValueBuffer The value of the setting. Must be a buffer with enough space to store the value.
+     * @param outputValueSize The size of the outputValueBuffer.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval INVALID_INPUT_ERROR The outputValueBuffer is nullptr.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval LOCK_TIMEOUT_ERROR The setting could not be read in time, because of contention.
+     * @retval INSUFFICIENT_BUFFER_SIZE_ERROR The outputValueBuffer is not big enough to store the value.
+     */
+    [[nodiscard]] SettingError_t getSettingAsString(const SettingHandle_t& handle, char* outputValueBuffer,
+                                                    size_t                outputValueSize,
+                                                    SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting without copying it. The value stays valid while the
+     * lease holds it, regardless of the puts of the setting.
+     * @param handle The handle of the setting to get.
+     * @param outputLease The lease that receives the value of the setting. The string it held before is released.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval LOCK_TIMEOUT_ERROR The setting could not be read in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t leaseSettingAsString(const SettingHandle_t& handle, SettingStringLease& outputLease,
+                                                      SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the generation of a resolved setting, which is the store generation at its last
+     * write or at its registration. A copy of the value taken at a generation is still current while the setting keeps
+     * that generation. It is 0 while the setting is being registered.
+     * @param handle The handle of the setting.
+     * @param outputGeneration The generation of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The generation was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     */
+    [[nodiscard]] SettingError_t getSettingGeneration(const SettingHandle_t& handle, uint64_t& outputGeneration) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting with its generation. The value is at least as recent
+     * as the generation, so a racing put can make the caller fetch the value again, but never keep a stale one.
+     * @param handle The handle of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputGeneration The generation of the setting, see getSettingGeneration().
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     */
+    [[nodiscard]] SettingError_t
+    getSettingWithGenerationAsInt(const SettingHandle_t& handle, int64_t& outputValue, uint64_t& outputGeneration,
+                                  SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting with its generation. The value is at least as recent
+     * as the generation, so a racing put can make the caller fetch the value again, but never keep a stale one.
+     * @param handle The handle of the setting to get.
+     * @param outputValue The value of the setting.
+     * @param outputGeneration The generation of the setting, see getSettingGeneration().
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     */
+    [[nodiscard]] SettingError_t
+    getSettingWithGenerationAsReal(const SettingHandle_t& handle, double& outputValue, uint64_t& outputGeneration,
+                                   SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the value of a resolved setting with its generation, without copying it. The value
+     * is at least as recent as the generation, so a racing put can make the caller fetch the value again, but never
+     * keep a stale one.
+     * @param handle The handle of the setting to get.
+     * @param outputLease The lease that receives the value of the setting. The string it held before is released.
+     * @param outputGeneration The generation of the setting, see getSettingGeneration().
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval LOCK_TIMEOUT_ERROR The setting could not be read in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t
+    leaseSettingWithGenerationAsString(const SettingHandle_t& handle, SettingStringLease& outputLease,
+                                       uint64_t&             outputGeneration,
+                                       SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function updates the value of a resolved setting.
+     * @param handle The handle of the setting to update.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval LOCK_TIMEOUT_ERROR The setting could not be written in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t putSettingValueAsInt(const SettingHandle_t& handle, int64_t value) const;
+
+    /**
+     * @brief This function updates the value of a resolved setting.
+     * @param handle The handle of the setting to update.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval LOCK_TIMEOUT_ERROR The setting could not be written in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t putSettingValueAsReal(const SettingHandle_t& handle, double value) const;
+
+    /**
+     * @brief This function updates the value of a resolved setting.
+     * @param handle The handle of the setting to update.
+     * @param value The new value of the setting. It must not contain the tab (\t) character.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully updated.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval INVALID_INPUT_ERROR The value is nullptr.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval LOCK_TIMEOUT_ERROR The setting could not be written in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t putSettingValueAsString(const SettingHandle_t& handle, const char* value) const;
+
+    /**
+     * @brief This function returns the default value of a resolved setting.
+     * @param handle The handle of the setting to get.
+     * @param outputValue The default value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     */
+    [[nodiscard]] SettingError_t getDefaultSettingAsInt(const SettingHandle_t& handle, int64_t& outputValue,
+                                                        SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the default value of a resolved setting.
+     * @param handle The handle of the setting to get.
+     * @param outputValue The default value of the setting.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     */
+    [[nodiscard]] SettingError_t getDefaultSettingAsReal(const SettingHandle_t& handle, double& outputValue,
+                                                         SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function returns the default value of a resolved setting.
+     * @param handle The handle of the setting to get.
+     * @param outputValueBuffer The default value of the setting. Must be a buffer with enough space to store the value.
+     * @param outputValueSize The size of the outputValueBuffer.
+     * @param outputPermissions Optional output parameter to store the permissions of the setting. If it is nullptr, the
+     * permissions are not returned.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was successfully retrieved.
+     * @retval INVALID_INPUT_ERROR The handle was not resolved.
+     * @retval INVALID_INPUT_ERROR The outputValueBuffer is nullptr.
+     * @retval TYPE_MISMATCH_ERROR The handle was not resolved for this type.
+     * @retval INSUFFICIENT_BUFFER_SIZE_ERROR The outputValueBuffer is not big enough to store the value.
+     */
+    [[nodiscard]] SettingError_t getDefaultSettingAsString(const SettingHandle_t& handle, char* outputValueBuffer,
+                                                           size_t                outputValueSize,
+                                                           SettingPermissions_t* outputPermissions = nullptr) const;
+
+    /**
+     * @brief This function gets the values of several settings, looking all their keys up in a single read section of
+     * the settings tree. Keys sorted in lexicographic order share the traversal of their common prefixes.
+     * The values include all the updates of a SettingsTransaction or none of them.
+     * @param gets The settings to get. The result of each one is stored in its result member:
+     * - NO_ERROR if the setting was successfully retrieved.
+     * - INVALID_INPUT_ERROR if the key or the output is nullptr, or the key is "".
+     * - KEY_NOT_FOUND_ERROR if the setting with the provided key was not found.
+     * - TYPE_MISMATCH_ERROR if the setting with the provided key is not of the expected type.
+     * - INSUFFICIENT_BUFFER_SIZE_ERROR if the output string buffer is not big enough to store the value.
+     * - LOCK_TIMEOUT_ERROR if the string could not be read in time, because of contention.
+     * @param count The number of settings to get.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The settings were looked up. The result of each one must be checked.
+     * @retval INVALID_INPUT_ERROR gets is nullptr.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, or a SettingsTransaction commit did not
+     * finish in time. The results are not set.
+     */
+    [[nodiscard]] SettingError_t getSettingsBatch(SettingBatchGet_t* gets, size_t count) const;
+
+    /**
+     * @brief This function returns the memory usage figures of the tree nodes that index the settings.
+     * @return The statistics of the node allocator of the settings tree.
+     */
+    [[nodiscard]] NodeAllocatorStats_t getSettingsTreeMemoryStats() const;
+
+    /**
+     * @brief This function returns the contention figures of the lock protecting the tree that indexes the settings.
+     * The timeouts are always counted, the other figures only if CONFIG_SETTINGS_STORAGE_LOCK_STATS is set.
+     * The lookups served by the frozen index are not counted, as they do not take the lock.
+     * @return The statistics of the lock of the settings tree, all zero if the tree has no lock.
+     */
+    [[nodiscard]] LockStats_t getSettingsTreeLockStats() const;
+
+    /**
+     * @brief This function returns the store generation, which is increased by every registration and every write of
+     * a setting. A copy of any setting is still current while the store generation is the same.
+     * @return The store generation.
+     */
+    [[nodiscard]] uint64_t getGeneration() const;
+
+    /**
+     * @brief This function fixes the set of registered settings, and builds a perfect hash index over their keys.
+     * Afterwards, every access to a setting by its key is served by the index in constant time, while the functions
+     * working on key prefixes keep using the settings tree. No setting can be registered once the storage is frozen.
+     * It can be called from several threads at once. It fails if settings are being registered, and registrations
+     * fail while it runs, so the index always holds every registered setting.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The settings storage was frozen, or it already was.
+     * @retval LOCK_TIMEOUT_ERROR The settings tree could not be read, or settings were being registered. The settings
+     * storage is left unfrozen.
+     * @retval FATAL_ERROR The index could not be built. The settings storage is left unfrozen.
+     */
+    [[nodiscard]] SettingError_t freeze();
+
+    /**
+     * @brief Check if the settings storage is frozen.
+     * @return True if freeze() was successfully called, false otherwise.
+     */
+    [[nodiscard]] bool isFrozen() const;
+
+    /**
+     * @brief Check if a non volatile setting was updated since the settings were last stored in or loaded from the
+     * persistent storage.
+     * @return True if there are changes to store, false otherwise.
+     */
+    [[nodiscard]] bool hasUnsavedChanges() const;
+
+    /**
+     * @brief This function subscribes to the changes of the settings whose key starts with the provided prefix.
+     * Every put, restoreDefaultSettings(), loadSettingsFromPersistentStorage() and SettingsTransaction commit that
+     * writes a matching setting queues a change, which is delivered by dispatchChangeNotifications(). The changes are
+     * coalesced per key, and each burst of changes calls the callback of a subscriber once, with every changed key it
+     * matches. A change that cannot be queued in time, because of contention, is dropped, as the write itself has
+     * succeeded.
+     * @param keyPrefix The prefix of the keys to watch, "" to watch every setting. It is copied.
+     * @param callback The function called with the changed keys. It must not block for long.
+     * @param userData Opaque value passed to the callback.
+     * @param outputSubscriptionId The identifier to pass to unsubscribe().
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The subscription was created.
+     * @retval INVALID_INPUT_ERROR The keyPrefix or the callback is nullptr.
+     * @retval LOCK_TIMEOUT_ERROR The subscriptions could not be locked in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t subscribe(const char* keyPrefix, SettingsChangeCallback_t callback, void* userData,
+                                           uint32_t& outputSubscriptionId) const;
+
+    /**
+     * @brief This function cancels a subscription. Once it returns, the callback of the subscription is not called
+     * anymore, unless it is called from a callback.
+     * @param subscriptionId The identifier returned by subscribe().
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The subscription was cancelled.
+     * @retval KEY_NOT_FOUND_ERROR There is no subscription with this identifier.
+     * @retval LOCK_TIMEOUT_ERROR The delivery in progress or the subscriptions could not be locked in time, because of
+     * contention. The subscription is not cancelled.
+     */
+    [[nodiscard]] SettingError_t unsubscribe(uint32_t subscriptionId) const;
+
+    /**
+     * @brief Wait for a change to be queued, then deliver it to the subscribers, along with the changes queued during
+     * CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS. The callbacks run on the calling task, so the application chooses
+     * its stack size and priority, usually by calling this function in a loop from a dedicated task. It must only be
+     * called by one task at a time, and return before the SettingsStorage is destroyed.
+     * @param timeoutMs Maximum time to wait for a change, which also caps the coalescing delay. 0 delivers the queued
+     * changes, if any, without waiting.
+     * @return True if changes were delivered, false if no change was queued in time, or if some changes could not be
+     * delivered in time, because of contention. Those stay queued for the next call.
+     */
+    [[nodiscard]] bool dispatchChangeNotifications(uint32_t timeoutMs) const;
+
     /**
      * Disallow copying or moving the object.
      */
     SettingsStorage& operator=(SettingsStorage&&) = delete;
 
 private:
-    typedef std::tuple<SettingPermissions_t, SettingPermissionsFilterMode_t, SettingsKeysList_t*>
-                                                                                   SettingsListCallbackData_t;
-    typedef std::tuple<SettingsFile*, uint32_t*, bool*, CRC::Table<unsigned, 32>*> SettingsStoreCallbackData_t;
+    friend class SettingsTransaction;
+    friend class SettingsNamespace;
+    friend class SettingsSnapshot;
+
+    /// Function invoked by iterateSettings() for each setting that passes the permissions filter. It returns true to
+    /// visit the next setting, or false to stop.
+    typedef bool (*SettingVisitor_t)(void* context, std::string_view key, const SettingHandle_t& handle);
+    typedef std::tuple<SettingPermissions_t, SettingPermissionsFilterMode_t, SettingVisitor_t, void*>
+                                                                                   SettingsIterationCallbackData_t;
+    typedef std::tuple<SettingsFile*, uint32_t*, bool*, CRC::Table<unsigned, 32>*> SettingsStoreData_t;
+    typedef std::tuple<SettingsSnapshot*, std::vector<SettingValue_t*>*>           SnapshotCallbackData_t;
+    typedef std::tuple<SettingChildrenList_t*, uint32_t>                           SettingsChildrenCallbackData_t;
     using TypeofSettingValue = enum { Value, DefaultValue };
+    typedef PerfectHashIndex<SettingValue_t>                             FrozenIndex_t;
+    typedef ThreadLocalLookupCache<SettingValue_t, MAX_SETTING_KEY_SIZE> ReadCache_t;
+
+    OSInterface_Mutex*            moduleConfigMutex;
+    SettingsFile*                 settingsFile;
+    bool                          persistentStorageEnabled;
+    Settings_t*                   settings;
+    std::atomic<FrozenIndex_t*>   frozenIndex;        // Index of every setting once frozen, nullptr before.
+    mutable std::atomic<uint32_t> registrations;      // Registrations running, see beginRegistration().
+    std::atomic<uint32_t>         freezes;            // freeze() calls building an index, see beginRegistration().
+    mutable std::atomic<uint32_t> valuesSequence;     // Odd while a value or a transaction is being written.
+    OSInterface_Mutex*            valuesWriteMutex;   // Held by the writer of valuesSequence, see beginValuesWrite().
+    mutable EpochManager          stringEpochManager; // Defers the release of the replaced long strings.
+    mutable std::atomic<bool>     unsavedChanges;
+    mutable std::atomic<uint64_t> generation;         // Increased by every registration and write of a setting.
+    mutable ReadCache_t           readCache;          // Settings found by getSettingValue(), per thread.
+    SettingsChangeDispatcher*     changeDispatcher;
+    OSInterface*                  osInterface;
 
-    OSInterface_Mutex* moduleConfigMutex;
-    SettingsFile*      settingsFile;
-    bool               persistentStorageEnabled;
-    Settings_t*        settings;
-    OSInterface*       osInterface;
+    /// Value returned by the settings tree iterations when the tree lock could not be taken in time.
+    static constexpr int TREE_LOCK_TIMEOUT = -1;
+    /// Number of times snapshot() reads the values before giving up, when settings keep being written meanwhile.
+    static constexpr uint32_t SNAPSHOT_READ_ATTEMPTS = 16;
+    /// Value returned by iterateSettingsCallback() when the visitor stops the iteration, distinct from any other
+    /// result of the settings tree iterations.
+    static constexpr int ITERATION_STOPPED = -2;
 
-    static int listSettingsKeysCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+    static int  iterateSettingsCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+    static int  listChildrenCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+    static bool permissionsFilterCallback(void* data, uint32_t anyBits, uint32_t allBits);
     static int freeSettingValuesCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
-    static int storeSettingsInPersistentStorageCallback(void* data, const unsigned char* key, uint32_t key_len,
-                                                        void* value);
+    static int freezeCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+    static int collectKeysCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+    static bool collectKeys(void* context, std::unordered_map<const void*, const char*>& outputKeys);
+    static bool snapshotVisitor(void* context, std::string_view key, const SettingHandle_t& handle);
+
+    /**
+     * @brief Write a setting of a snapshot to the settings file, adding it to the checksum of the file.
+     * @param data The settings file, the checksum, whether the setting is the first one and the CRC table.
+     * @param snapshot The snapshot of the setting.
+     * @param position The position of the setting in the snapshot.
+     * @return The result of the writes.
+     */
+    static SettingsFile::SettingsFileResult storeSettingInPersistentStorage(SettingsStoreData_t&    data,
+                                                                            const SettingsSnapshot& snapshot,
+                                                                            size_t                  position);
     [[nodiscard]] SettingError_t validateChecksum() const;
 
+    /**
+     * @brief Visit the settings that match a key prefix and a permissions filter, see forEachSetting().
+     * @param keyPrefix The prefix of the keys to visit.
+     * @param permissions The permissions filter to apply to the settings.
+     * @param filterMode The filter mode to apply to the permissions.
+     * @param visitor The function invoked for each setting.
+     * @param context Opaque value passed to the visitor.
+     * @return SettingError_t The result of the operation, as returned by forEachSetting().
+     */
+    [[nodiscard]] SettingError_t iterateSettings(const char* keyPrefix, SettingPermissions_t permissions,
+                                                 SettingPermissionsFilterMode_t filterMode, SettingVisitor_t visitor,
+                                                 void* context) const;
+
     SettingError_t               getSettingValue(const char* key, SettingValue_t*& outputValue) const;
     [[nodiscard]] SettingError_t getSettingValueAsInt(TypeofSettingValue type, const char* key, int64_t& outputValue,
                                                       SettingPermissions_t* outputPermissions = nullptr) const;
@@ -416,8 +1157,226 @@ private:
     [[nodiscard]] SettingError_t getSettingValueAsString(TypeofSettingValue type, const char* key,
                                                          char* outputValueBuffer, size_t outputValueSize,
                                                          SettingPermissions_t* outputPermissions = nullptr) const;
+    [[nodiscard]] static SettingError_t getSettingValueAsInt(TypeofSettingValue type, const SettingHandle_t& handle,
+                                                             int64_t&              outputValue,
+                                                             SettingPermissions_t* outputPermissions);
+    [[nodiscard]] static SettingError_t getSettingValueAsReal(TypeofSettingValue type, const SettingHandle_t& handle,
+                                                              double&               outputValue,
+                                                              SettingPermissions_t* outputPermissions);
+    [[nodiscard]] SettingError_t getSettingValueAsString(TypeofSettingValue type, const SettingHandle_t& handle,
+                                                         char* outputValueBuffer, size_t outputValueSize,
+                                                         SettingPermissions_t* outputPermissions) const;
 
     static void freeSettingValue(const SettingValue_t* settingValue);
+
+    /**
+     * @brief Create a setting in the settings tree, and advance the store generation if it was created.
+     * @param key The key of the setting.
+     * @param newValue The value copied into the tree, stamped with its generation first. Its heap buffers are owned by
+     * the tree only if it is created.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The setting was created.
+     * @retval KEY_EXISTS_ERROR A setting with this key already exists.
+     * @retval LOCK_TIMEOUT_ERROR The settings tree could not be updated in time, because of contention.
+     */
+    [[nodiscard]] SettingError_t insertSetting(const char* key, SettingValue_t& newValue) const;
+
+    /**
+     * @brief Start registering settings, unless the settings storage is frozen or being frozen. A registration that
+     * started keeps freeze() from building an index until endRegistration() is called.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR The settings can be inserted. endRegistration() must be called afterwards.
+     * @retval LOCK_TIMEOUT_ERROR The settings storage is being frozen.
+     * @retval SETTINGS_FROZEN_ERROR The settings storage is frozen.
+     */
+    [[nodiscard]] SettingError_t beginRegistration() const;
+
+    /**
+     * @brief Finish a registration started by a successful beginRegistration() call.
+     */
+    void endRegistration() const;
+
+    /**
+     * @brief Mark the settings as changed since they were last stored in the persistent storage.
+     */
+    void markUnsavedChanges() const;
+
+    /**
+     * @brief Increase the store generation.
+     * @return The new store generation.
+     */
+    uint64_t nextGeneration() const;
+
+    /**
+     * @brief Stamp a setting that was just created with its generation, unless a put already stamped it.
+     * @param settingValue The setting that was created.
+     * @param settingGeneration The store generation returned by nextGeneration() for its creation.
+     */
+    static void stampCreatedSetting(SettingValue_t* settingValue, uint64_t settingGeneration);
+
+    /**
+     * @brief Record the write of a setting: stamp it with a new store generation, then queue its change for its
+     * subscribers, if there is any subscription. It must be called once the new value is visible.
+     * @param settingValue The setting that was written.
+     */
+    void markSettingChanged(SettingValue_t* settingValue) const;
+
+    /**
+     * @brief Record the write of a setting with markSettingChanged(), and mark the settings as unsaved if the setting
+     * is not volatile. It must be called once the new value is visible.
+     * @param settingValue The setting that was written.
+     */
+    void noteSettingWritten(SettingValue_t* settingValue) const;
+
+    /// Header of the heap buffers of the long strings. The characters follow it, and SettingValueData_t::string points
+    /// to them. The buffer is never modified once built, and it is freed when its last reference is released.
+    typedef struct
+    {
+        std::atomic<uint32_t> references;
+        uint32_t              length;
+    } SharedString_t;
+
+    /// Tags stored in the last byte of SettingValueData_t, telling how its string is stored.
+    static constexpr char SHARED_STRING_TAG = 0; // In a SharedString_t buffer.
+    static constexpr char SHORT_STRING_TAG  = 1; // In shortString.
+    static constexpr char STATIC_STRING_TAG = 2; // In storage that outlives the settings storage.
+
+    /**
+     * @brief Store a string into a setting value data, inline if it is short enough or in a new heap buffer otherwise.
+     * The previous string of the data is not released.
+     * @param data The setting value data.
+     * @param value The string.
+     */
+    static void setStringData(SettingValueData_t& data, const char* value);
+
+    /**
+     * @brief Store a string that outlives the settings storage into a setting value data, inline if it is short enough
+     * or by reference otherwise. The previous string of the data is not released.
+     * @param data The setting value data.
+     * @param value The string.
+     */
+    static void setStaticStringData(SettingValueData_t& data, const char* value);
+
+    /**
+     * @brief Get the string stored in a setting value data.
+     * @param data The setting value data.
+     * @return The string.
+     */
+    static const char* getStringData(const SettingValueData_t& data);
+
+    /**
+     * @brief Store the string of a setting value data into another one, sharing its heap buffer if it has one.
+     * The previous string of the destination is not released.
+     * @param destination The setting value data that receives the string.
+     * @param source The setting value data holding the string.
+     */
+    static void shareStringData(SettingValueData_t& destination, const SettingValueData_t& source);
+
+    /**
+     * @brief Release the reference of a setting value data to its heap buffer, if any. The buffer is freed right away,
+     * so it must never have been reachable by readers. Use releaseStringData() otherwise.
+     * @param data The setting value data.
+     */
+    static void freeStringData(const SettingValueData_t& data);
+
+    /**
+     * @brief Release the reference of a setting value data to its heap buffer, if any. The buffer is retired to
+     * stringEpochManager, which frees it along with the next retired buffers once no reader can reference it any more.
+     * @param data The setting value data.
+     */
+    void releaseStringData(const SettingValueData_t& data) const;
+
+    /**
+     * @brief Free a heap buffer retired by releaseStringData().
+     * @param context Unused.
+     * @param object The SharedString_t header of the buffer.
+     */
+    static void reclaimSharedString(void* context, void* object);
+
+    /**
+     * @brief Start writing string values, waiting for the other writers to finish. The readers of string values retry
+     * until endValuesWrite() is called.
+     * @param outputSequence The sequence to pass to endValuesWrite().
+     * @return True if the write was started, false if the other writers did not finish in time.
+     */
+    [[nodiscard]] bool beginValuesWrite(uint32_t& outputSequence) const;
+
+    /**
+     * @brief Finish writing string values.
+     * @param sequence The sequence given by beginValuesWrite().
+     */
+    void endValuesWrite(uint32_t sequence) const;
+
+    /**
+     * @brief Wait until no string values are being written, to start reading them. The reader blocks on the mutex of
+     * the writer, so on FreeRTOS a higher priority reader lends its priority to the writer instead of spinning.
+     * @param outputSequence The sequence the values must still have once read, for them to be consistent.
+     * @return True if the values can be read, false if the writers did not finish in time.
+     */
+    [[nodiscard]] bool waitForValues(uint32_t& outputSequence) const;
+
+    /**
+     * @brief Copy a setting value data that may be written concurrently, word by word with atomic loads, so it does
+     * not race with storeValueData(). The copy is only consistent if the values sequence did not change meanwhile.
+     * @param data The setting value data.
+     * @return The copy of the data.
+     */
+    static SettingValueData_t loadValueData(const SettingValueData_t& data);
+
+    /**
+     * @brief Overwrite a setting value data that may be read concurrently, word by word with atomic stores. It must be
+     * called between beginValuesWrite() and endValuesWrite().
+     * @param data The setting value data.
+     * @param newData The new content of the data.
+     */
+    static void storeValueData(SettingValueData_t& data, const SettingValueData_t& newData);
+
+    /**
+     * @brief Replace the string of a setting value data that may be read concurrently, and release the previous one.
+     * @param data The setting value data.
+     * @param newData The setting value data holding the new string. Its reference, if any, is moved to data, or
+     * released if the string could not be replaced.
+     * @return True if the string was replaced, false if the other writers did not finish in time.
+     */
+    [[nodiscard]] bool replaceStringData(SettingValueData_t& data, const SettingValueData_t& newData) const;
+
+    /**
+     * @brief Take a consistent copy of a setting value data that may be written concurrently. It must be called inside
+     * a read section of stringEpochManager, which keeps the heap buffer of the copy alive until it ends.
+     * @param data The setting value data.
+     * @param outputData The copy of the data. It holds no reference to the heap buffer.
+     * @return True if the data was copied, false if the writers did not finish in time.
+     */
+    [[nodiscard]] bool readStringData(const SettingValueData_t& data, SettingValueData_t& outputData) const;
+
+    /**
+     * @brief Lease the string of a setting value data that may be written concurrently.
+     * @param data The setting value data.
+     * @param outputLease The lease that receives the string. The string it held before is released.
+     * @return True if the string was leased, false if the writers did not finish in time. The lease is then empty.
+     */
+    [[nodiscard]] bool leaseStringData(const SettingValueData_t& data, SettingStringLease& outputLease) const;
 };
 
+/// The permissions of the settings summarize them in the settings tree, so the permissions filters skip whole subtrees.
+template <> struct AdaptiveRadixTreeSummary<SettingsStorage::SettingValue_t>
+{
+    static uint32_t bits(const SettingsStorage::SettingValue_t& value)
+    {
+        return static_cast<uint32_t>(value.settingPermissions);
+    }
+};
+
+template <typename Visitor>
+SettingsStorage::SettingError_t SettingsStorage::forEachSetting(const char* keyPrefix, Visitor visitor,
+                                                                const SettingPermissions_t           permissions,
+                                                                const SettingPermissionsFilterMode_t filterMode) const
+{
+    return iterateSettings(
+        keyPrefix, permissions, filterMode,
+        [](void* context, const std::string_view key, const SettingHandle_t& handle) -> bool
+        { return (*static_cast<Visitor*>(context))(key, handle); },
+        &visitor);
+}
+
 #endif // SETTINGSSTORAGE_SETTINGS_H
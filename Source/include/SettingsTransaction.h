@@ -0,0 +1,115 @@
+#ifndef SETTINGSTRANSACTION_H
+#define SETTINGSTRANSACTION_H
+
+#include <vector>
+#include "SettingsStorage.h"
+
+/**
+ * @brief Set of setting updates applied together.
+ *
+ * The updates are staged with the put functions, which look each setting up and check its type right away, and they
+ * are applied by commit(), all or none of them. The commit holds the settings storage write section only while it
+ * stores the staged values, and getSettingsBatch() never returns a mix of values from before and after it. The
+ * settings are marked as unsaved once per commit.
+ *
+ * @code
+ * SettingsTransaction transaction(settingsStorage);
+ * transaction.putSettingValueAsReal("pid/kp", 1.2);
+ * transaction.putSettingValueAsReal("pid/ki", 0.1);
+ * transaction.putSettingValueAsReal("pid/kd", 0.05);
+ * SettingsStorage::SettingError_t result = transaction.commit();
+ * @endcode
+ *
+ * A transaction must only be used by one thread at a time.
+ */
+class SettingsTransaction
+{
+public:
+    /**
+     * @brief Build an empty transaction.
+     * @param settingsStorage The settings storage the transaction updates. It must outlive the transaction.
+     */
+    explicit SettingsTransaction(const SettingsStorage& settingsStorage);
+
+    /**
+     * @brief Discard the updates that were not committed.
+     */
+    ~SettingsTransaction();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    SettingsTransaction& operator=(SettingsTransaction&&) = delete;
+
+    /**
+     * @brief This function stages an update of an integer setting.
+     * @param key The key of the setting to update.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation. If it is an error, the whole transaction fails.
+     * @retval NO_ERROR The update was staged.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of type INTEGER.
+     */
+    SettingsStorage::SettingError_t putSettingValueAsInt(const char* key, int64_t value);
+
+    /**
+     * @brief This function stages an update of a real setting.
+     * @param key The key of the setting to update.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation. If it is an error, the whole transaction fails.
+     * @retval NO_ERROR The update was staged.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "".
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of type REAL.
+     */
+    SettingsStorage::SettingError_t putSettingValueAsReal(const char* key, double value);
+
+    /**
+     * @brief This function stages an update of a string setting. The string is copied.
+     * @param key The key of the setting to update.
+     * @param value The new value of the setting.
+     * @return SettingError_t The result of the operation. If it is an error, the whole transaction fails.
+     * @retval NO_ERROR The update was staged.
+     * @retval INVALID_INPUT_ERROR The key is nullptr or "", or the value is nullptr.
+     * @retval KEY_NOT_FOUND_ERROR The setting with the provided key was not found.
+     * @retval LOCK_TIMEOUT_ERROR The settings could not be read in time, because of contention.
+     * @retval TYPE_MISMATCH_ERROR The setting with the provided key is not of type STRING.
+     */
+    SettingsStorage::SettingError_t putSettingValueAsString(const char* key, const char* value);
+
+    /**
+     * @brief This function applies all the staged updates, or none of them if any put failed. The transaction is
+     * empty afterwards, whatever the result, and it can be reused.
+     * @return SettingError_t The result of the operation.
+     * @retval NO_ERROR All the updates were applied.
+     * @retval LOCK_TIMEOUT_ERROR The other writers of the settings did not finish in time. No update was applied.
+     * @retval Others The error of the first put that failed. No update was applied.
+     */
+    [[nodiscard]] SettingsStorage::SettingError_t commit();
+
+    /**
+     * @brief Get the number of staged updates.
+     * @return The number of updates.
+     */
+    [[nodiscard]] size_t size() const;
+
+private:
+    typedef struct
+    {
+        SettingsStorage::SettingHandle_t    handle;
+        SettingsStorage::SettingValueData_t value; // Strings are built when staged, so commit only swaps them.
+    } StagedPut_t;
+
+    const SettingsStorage*          settingsStorage;
+    std::vector<StagedPut_t>        stagedPuts;
+    SettingsStorage::SettingError_t firstError; // Error of the first put that failed, NO_ERROR otherwise.
+
+    SettingsStorage::SettingError_t resolve(const char* key, SettingsStorage::SettingValueType_t type,
+                                            SettingsStorage::SettingHandle_t& outputHandle);
+    void                            clear();
+};
+
+#endif // SETTINGSTRANSACTION_H
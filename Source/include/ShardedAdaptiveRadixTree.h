@@ -0,0 +1,818 @@
+#ifndef SHARDEDADAPTIVERADIXTREE_H
+#define SHARDEDADAPTIVERADIXTREE_H
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "AtomicLibARTCpp.h"
+
+#ifndef CONFIG_SETTINGS_STORAGE_SHARDS
+    #define CONFIG_SETTINGS_STORAGE_SHARDS 8
+#endif
+
+/**
+ * @brief A set of independent AtomicAdaptiveRadixTree shards, each one with its own lock.
+ * It can store pointers to types of template typename ValueType
+ * The user is responsable for the memory management of the values stored in the tree.
+ *
+ * Keys are routed to a shard by the hash of their first path segment (the part before the first '/'), so all the keys
+ * of a top-level namespace live in the same shard, and readers and writers of different namespaces rarely contend.
+ * Operations on a single key and prefix iterations whose prefix contains a '/' only use one shard. The other
+ * iterations fan out to every shard and merge the results, so the entries are still visited in lexical order. The
+ * merged entries are collected in a vector before the callback is invoked: they are not copied, but point at the keys
+ * and values of the leaves, which must stay alive until the iteration ends. The entries of every shard are collected
+ * while all the shards are read locked, so a fan-out sees a single point in time of the whole tree. In EpochReads mode
+ * the read sections do not keep the writers out, so the entries are collected again with the writers of every shard
+ * locked out if a shard was written during the first collection.
+ *
+ * @tparam NumShards The number of shards.
+ */
+template <typename ValueType, uint32_t NumShards = CONFIG_SETTINGS_STORAGE_SHARDS>
+class ShardedAdaptiveRadixTree : public AdaptiveRadixTree<ValueType>
+{
+    static_assert(NumShards > 0, "At least one shard is needed");
+
+public:
+    /// The type of each shard.
+    using Shard_t = AtomicAdaptiveRadixTree<ValueType>;
+
+    /**
+     * @brief Construct a new Adaptive Radix Tree object
+     * @param osInterface The OS shim object used to create the synchronization primitives of the shards.
+     * @param readMode The way readers are synchronized with writers in every shard.
+     * @param nodeAllocator The allocator shared by the nodes and leaves of every shard, or nullptr to let each shard
+     * create its own.
+     */
+    explicit ShardedAdaptiveRadixTree(OSInterface&                 osInterface,
+                                      typename Shard_t::ReadMode_t readMode      = Shard_t::DEFAULT_READ_MODE,
+                                      NodeAllocator*               nodeAllocator = nullptr);
+
+    /**
+     * @brief Destroy the Adaptive Radix Tree object
+     */
+    ~ShardedAdaptiveRadixTree() override;
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    ShardedAdaptiveRadixTree& operator=(ShardedAdaptiveRadixTree&&) = delete;
+
+    /**
+     * @brief Get the size of the tree
+     *
+     * @return uint64_t size
+     */
+    uint64_t size() override;
+
+    /**
+     * @brief Insert a new value into the art tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value opaque value.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insert(const char* key, int key_len, ValueType* value) override;
+
+    /**
+     * @brief Insert a new value into the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value opaque value.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insertIfNotExists(const char* key, int key_len, ValueType* value) override;
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the art tree (no replace)
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @return Null if the item was newly inserted, otherwise
+     * the old value pointer is returned.
+     */
+    ValueType* insertInlineIfNotExists(const char* key, int key_len, const ValueType& value) override;
+
+    /**
+     * @brief Insert a copy of a value into the leaf of a new key of the shard of the key (no replace), telling an
+     * existing key apart from a lock timeout
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param value The value copied into the leaf.
+     * @param outputExisting Set to NULL if the item was newly inserted, otherwise to the value the key already had.
+     * @param outputInserted Optional output set to the value copied into the leaf if the item was newly inserted,
+     * otherwise to NULL.
+     * @return True if the insertion was done, false if the lock of the shard could not be taken in time.
+     */
+    bool tryInsertInlineIfNotExists(const char* key, int key_len, const ValueType& value, ValueType*& outputExisting,
+                                    ValueType** outputInserted = nullptr) override;
+
+    /**
+     * @brief Insert copies of several values into the leaves of new keys of the art tree (no replace).
+     * The keys are grouped by shard, and each shard inserts its keys in a single batch, in their original order.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param values The values copied into the leaves
+     * @param outputExisting Output array of count pointers, set to null for each newly inserted key, otherwise to the
+     * value the key already had.
+     * @param outputInserted Optional output array of count pointers, set to the value copied into the leaf of each
+     * newly inserted key, otherwise to null.
+     * @return True if the batch was inserted, false if some shards could not be updated in time. The outputs of their
+     * keys are then set to null, while the other shards keep their part of the batch.
+     */
+    bool insertInlineBatchIfNotExists(const char* const* keys, const int* key_lens, size_t count,
+                                      const ValueType* values, ValueType** outputExisting,
+                                      ValueType** outputInserted = nullptr) override;
+
+    /**
+     * @brief Deletes a value from the ART tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @return NULL if the item was not found, otherwise
+     * the value pointer is returned.
+     */
+    ValueType* deleteValue(const char* key, int key_len) override;
+
+    /**
+     * @brief Deletes a value from the shard of its key, telling a missing key apart from a lock timeout
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the deletion was done, false if the lock of the shard could not be taken in time.
+     */
+    bool tryDeleteValue(const char* key, int key_len, ValueType*& outputValue) override;
+
+    /**
+     * @brief Searches for a value in the ART tree
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @return NULL if the item was not found, otherwise
+     * the value pointer is returned.
+     */
+    ValueType* search(const char* key, int key_len) override;
+
+    /**
+     * @brief Searches for a value in the shard of its key, telling a missing key apart from a lock timeout
+     *
+     * @param key The key
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the lock of the shard could not be taken in time.
+     */
+    bool trySearch(const char* key, int key_len, ValueType*& outputValue) override;
+
+    /**
+     * @brief Searches for several values in the ART tree.
+     * The keys are grouped by shard, and each shard serves its keys in a single batch, in their original order.
+     * @param keys The keys
+     * @param key_lens The length of each key
+     * @param count The number of keys
+     * @param outputValues Output array of count pointers, set to the value of each key or NULL if it was not found
+     * @return True if the search was done, false if the lock of a shard could not be taken in time.
+     */
+    bool searchBatch(const char* const* keys, const int* key_lens, size_t count, ValueType** outputValues) override;
+
+    /**
+     * Iterates through the entries pairs in the map,
+     * invoking a callback for each.
+     * The callback gets a key value for each and returns an integer stop value.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverAll(art_callback cb, void* data, art_summary_filter filter = nullptr,
+                       void* filterData = nullptr) override;
+
+    /**
+     * Iterates through the entry pairs in the map,
+     * invoking a callback for each that matches a given prefix.
+     * The callback gets a key value for each and returns an integer stop value.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of keys to read
+     * @param prefix_len The length of the prefix
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @param filter Optional filter of the inner nodes, whose skipped subtrees are not visited.
+     * @param filterData Opaque handle passed to the filter
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb, void* data,
+                          art_summary_filter filter = nullptr, void* filterData = nullptr) override;
+
+    /**
+     * Iterates through the immediate children of a prefix, like the entries of a directory, in order.
+     * A child is the part of a key that follows the prefix up to the next separator. The callback gets the key up to
+     * the end of each child: a key without a separator after the prefix is passed with its value, while the keys that
+     * continue past a separator are passed once per distinct child, as the key up to and including the separator with
+     * a NULL value. Such keys are not null terminated.
+     * If the callback returns non-zero, then the iteration stops.
+     * @param prefix The prefix of the children
+     * @param prefix_len The length of the prefix
+     * @param separator The byte that ends a child.
+     * @param cb The callback function to invoke
+     * @param data Opaque handle passed to the callback
+     * @return Zero on success, or the return of the callback.
+     */
+    int iterateOverChildren(const char* prefix, int prefix_len, char separator, art_callback cb, void* data) override;
+
+    /**
+     * @brief Take an anchor on a key prefix, see art_anchor.
+     * @param prefix The prefix
+     * @param prefix_len The length of the prefix
+     * @param outputAnchor The anchor of the prefix.
+     * @return True if the anchor was taken, false if the tree could not take it, which is the case of the prefixes that
+     * do not contain their whole first segment.
+     */
+    bool findAnchor(const char* prefix, int prefix_len, art_anchor& outputAnchor) override;
+
+    /**
+     * @brief Searches for a value in the ART tree from an anchor, with the part of its key that follows the prefix of
+     * the anchor.
+     * @param anchor The anchor taken by findAnchor().
+     * @param key The key without the prefix of the anchor
+     * @param key_len The length of the key
+     * @param outputValue Set to NULL if the item was not found, otherwise to the value pointer.
+     * @return True if the search was done, false if the anchor is stale and has to be taken again.
+     */
+    bool searchFromAnchor(const art_anchor& anchor, const char* key, int key_len, ValueType*& outputValue) override;
+
+    /**
+     * @brief Returns the minimum valued leaf value in the tree
+     *
+     * @return The minimum leaf value or NULL
+     */
+    ValueType* getMinimumValue() override;
+
+    /**
+     * @brief Returns the maximum valued leaf value in the tree
+     *
+     * @return The maximum leaf value or NULL
+     */
+    ValueType* getMaximumValue() override;
+
+    /**
+     * @brief Get the memory usage figures of the allocators of the tree nodes and leaves
+     *
+     * @return The allocator statistics, added up for every shard
+     */
+    NodeAllocatorStats_t getNodeAllocatorStats() override;
+
+    /**
+     * @brief Get the contention figures of the locks protecting the shards
+     *
+     * @return The lock statistics, added up for every shard
+     */
+    LockStats_t getLockStats() override;
+
+    /**
+     * @brief Get the shard that stores a key.
+     * @param key The key
+     * @param key_len The length of the key
+     * @return The index of the shard, lower than NumShards.
+     */
+    static uint32_t shardIndex(const char* key, int key_len);
+
+private:
+    /// An entry collected from a shard during a fan-out iteration. Its key is not copied: it points into the leaf of
+    /// the shard, so it is valid as long as that key is not deleted.
+    struct Entry_t
+    {
+        const unsigned char* key;
+        uint32_t             keyLen;
+        ValueType*           value;
+
+        bool operator<(const Entry_t& other) const;
+        bool operator==(const Entry_t& other) const;
+    };
+
+    /// The sections of every shard, held together during a fan-out iteration.
+    typedef struct
+    {
+        typename Shard_t::ReadSection_t readSections[NumShards];
+        uint32_t                        writeSequences[NumShards]; // Write sequence of each shard once read locked.
+        bool                            writersExcluded;           // True if the write lock of every shard is held.
+    } ShardSections_t;
+
+    Shard_t* shards[NumShards];
+    bool     sharedNodeAllocator;
+
+    Shard_t&   shardOf(const char* key, int key_len);
+    int        fanOut(const char* prefix, int prefix_len, art_callback cb, void* data, art_summary_filter filter,
+                      void* filterData);
+    template <typename CollectShard> bool collectEntries(std::vector<Entry_t>& entries, CollectShard collectShard);
+    bool       lockShards(ShardSections_t& sections, bool excludeWriters);
+    void       unlockShards(const ShardSections_t& sections, uint32_t count);
+    bool       shardsUnchanged(const ShardSections_t& sections) const;
+    static int visitEntries(const std::vector<Entry_t>& entries, art_callback cb, void* data);
+    static int collectEntryCallback(void* data, const unsigned char* key, uint32_t key_len, void* value);
+};
+
+template <typename ValueType, uint32_t NumShards>
+ShardedAdaptiveRadixTree<ValueType, NumShards>::ShardedAdaptiveRadixTree(OSInterface&                       osInterface,
+                                                                        const typename Shard_t::ReadMode_t readMode,
+                                                                        NodeAllocator* nodeAllocator) :
+    AdaptiveRadixTree<ValueType>(nodeAllocator)
+{
+    this->sharedNodeAllocator = nodeAllocator != nullptr;
+    for (Shard_t*& shard : shards)
+    {
+        shard = new Shard_t(osInterface, readMode, nodeAllocator);
+    }
+}
+
+template <typename ValueType, uint32_t NumShards> ShardedAdaptiveRadixTree<ValueType, NumShards>::~ShardedAdaptiveRadixTree()
+{
+    for (const Shard_t* shard : shards)
+    {
+        delete shard;
+    }
+}
+
+template <typename ValueType, uint32_t NumShards> uint64_t ShardedAdaptiveRadixTree<ValueType, NumShards>::size()
+{
+    uint64_t size = 0;
+    for (Shard_t* shard : shards)
+    {
+        size += shard->size();
+    }
+    return size;
+}
+
+template <typename ValueType, uint32_t NumShards>
+ValueType* ShardedAdaptiveRadixTree<ValueType, NumShards>::insert(const char* key, int key_len, ValueType* value)
+{
+    return shardOf(key, key_len).insert(key, key_len, value);
+}
+
+template <typename ValueType, uint32_t NumShards> ValueType*
+ShardedAdaptiveRadixTree<ValueType, NumShards>::insertIfNotExists(const char* key, int key_len, ValueType* value)
+{
+    return shardOf(key, key_len).insertIfNotExists(key, key_len, value);
+}
+
+template <typename ValueType, uint32_t NumShards> ValueType*
+ShardedAdaptiveRadixTree<ValueType, NumShards>::insertInlineIfNotExists(const char* key, int key_len,
+                                                                        const ValueType& value)
+{
+    return shardOf(key, key_len).insertInlineIfNotExists(key, key_len, value);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::tryInsertInlineIfNotExists(const char* key, int key_len,
+                                                                                const ValueType& value,
+                                                                                ValueType*&      outputExisting,
+                                                                                ValueType**      outputInserted)
+{
+    return shardOf(key, key_len).tryInsertInlineIfNotExists(key, key_len, value, outputExisting, outputInserted);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::insertInlineBatchIfNotExists(const char* const* keys,
+                                                                                  const int*         key_lens,
+                                                                                  const size_t       count,
+                                                                                  const ValueType*   values,
+                                                                                  ValueType**        outputExisting,
+                                                                                  ValueType**        outputInserted)
+{
+    std::vector<uint32_t>    shardIndexes(count);
+    std::vector<const char*> shardKeys;
+    std::vector<int>         shardKeyLens;
+    std::vector<ValueType>   shardValues;
+    std::vector<ValueType*>  shardExisting;
+    std::vector<ValueType*>  shardInserted;
+    bool                     result = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        shardIndexes[i] = shardIndex(keys[i], key_lens[i]);
+    }
+
+    for (uint32_t shard = 0; shard < NumShards; shard++)
+    {
+        shardKeys.clear();
+        shardKeyLens.clear();
+        shardValues.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (shardIndexes[i] == shard)
+            {
+                shardKeys.push_back(keys[i]);
+                shardKeyLens.push_back(key_lens[i]);
+                shardValues.push_back(values[i]);
+            }
+        }
+        if (shardKeys.empty())
+        {
+            continue;
+        }
+
+        shardExisting.resize(shardKeys.size());
+        shardInserted.resize(shardKeys.size());
+        result &= shards[shard]->insertInlineBatchIfNotExists(shardKeys.data(), shardKeyLens.data(), shardKeys.size(),
+                                                              shardValues.data(), shardExisting.data(),
+                                                              shardInserted.data());
+        for (size_t i = 0, j = 0; i < count; i++)
+        {
+            if (shardIndexes[i] == shard)
+            {
+                outputExisting[i] = shardExisting[j];
+                if (outputInserted != nullptr)
+                {
+                    outputInserted[i] = shardInserted[j];
+                }
+                j++;
+            }
+        }
+    }
+    return result;
+}
+
+template <typename ValueType, uint32_t NumShards>
+ValueType* ShardedAdaptiveRadixTree<ValueType, NumShards>::deleteValue(const char* key, int key_len)
+{
+    return shardOf(key, key_len).deleteValue(key, key_len);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::tryDeleteValue(const char* key, int key_len,
+                                                                    ValueType*& outputValue)
+{
+    return shardOf(key, key_len).tryDeleteValue(key, key_len, outputValue);
+}
+
+template <typename ValueType, uint32_t NumShards>
+ValueType* ShardedAdaptiveRadixTree<ValueType, NumShards>::search(const char* key, int key_len)
+{
+    return shardOf(key, key_len).search(key, key_len);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::trySearch(const char* key, int key_len, ValueType*& outputValue)
+{
+    return shardOf(key, key_len).trySearch(key, key_len, outputValue);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::searchBatch(const char* const* keys, const int* key_lens,
+                                                                 const size_t count, ValueType** outputValues)
+{
+    std::vector<uint32_t>    shardIndexes(count);
+    std::vector<const char*> shardKeys;
+    std::vector<int>         shardKeyLens;
+    std::vector<ValueType*>  shardValues;
+    bool                     result = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        shardIndexes[i] = shardIndex(keys[i], key_lens[i]);
+    }
+
+    for (uint32_t shard = 0; shard < NumShards; shard++)
+    {
+        shardKeys.clear();
+        shardKeyLens.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (shardIndexes[i] == shard)
+            {
+                shardKeys.push_back(keys[i]);
+                shardKeyLens.push_back(key_lens[i]);
+            }
+        }
+        if (shardKeys.empty())
+        {
+            continue;
+        }
+
+        shardValues.resize(shardKeys.size());
+        result &= shards[shard]->searchBatch(shardKeys.data(), shardKeyLens.data(), shardKeys.size(),
+                                             shardValues.data());
+        for (size_t i = 0, j = 0; i < count; i++)
+        {
+            if (shardIndexes[i] == shard)
+            {
+                outputValues[i] = shardValues[j++];
+            }
+        }
+    }
+    return result;
+}
+
+template <typename ValueType, uint32_t NumShards>
+int ShardedAdaptiveRadixTree<ValueType, NumShards>::iterateOverAll(art_callback cb, void* data,
+                                                                   const art_summary_filter filter, void* filterData)
+{
+    return fanOut("", 0, cb, data, filter, filterData);
+}
+
+template <typename ValueType, uint32_t NumShards> int
+ShardedAdaptiveRadixTree<ValueType, NumShards>::iterateOverPrefix(const char* prefix, int prefix_len, art_callback cb,
+                                                                  void* data, const art_summary_filter filter,
+                                                                  void* filterData)
+{
+    // A prefix that contains the whole first segment can only match keys of its own shard.
+    if (memchr(prefix, '/', static_cast<size_t>(prefix_len)) != nullptr)
+    {
+        return shardOf(prefix, prefix_len).iterateOverPrefix(prefix, prefix_len, cb, data, filter, filterData);
+    }
+    return fanOut(prefix, prefix_len, cb, data, filter, filterData);
+}
+
+template <typename ValueType, uint32_t NumShards>
+int ShardedAdaptiveRadixTree<ValueType, NumShards>::iterateOverChildren(const char* prefix, int prefix_len,
+                                                                        const char separator, art_callback cb,
+                                                                        void* data)
+{
+    // A prefix that contains the whole first segment can only match keys of its own shard.
+    if (memchr(prefix, '/', static_cast<size_t>(prefix_len)) != nullptr)
+    {
+        return shardOf(prefix, prefix_len).iterateOverChildren(prefix, prefix_len, separator, cb, data);
+    }
+
+    std::vector<Entry_t> entries;
+    if (!collectEntries(entries,
+                        [&](Shard_t& shard)
+                        {
+                            shard.AdaptiveRadixTree<ValueType>::iterateOverChildren(prefix, prefix_len, separator,
+                                                                                    collectEntryCallback, &entries);
+                        }))
+    {
+        return -1;
+    }
+    // A child that ends before the first '/' may hold keys of several shards.
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    return visitEntries(entries, cb, data);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::findAnchor(const char* prefix, int prefix_len,
+                                                               art_anchor& outputAnchor)
+{
+    // The anchor is taken by the shard of the prefix, which must then contain its whole first segment.
+    if (memchr(prefix, '/', static_cast<size_t>(prefix_len)) == nullptr)
+    {
+        return false;
+    }
+    return shardOf(prefix, prefix_len).findAnchor(prefix, prefix_len, outputAnchor);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::searchFromAnchor(const art_anchor& anchor, const char* key,
+                                                                     int key_len, ValueType*& outputValue)
+{
+    for (Shard_t* shard : shards)
+    {
+        if (anchor.tree == static_cast<AdaptiveRadixTree<ValueType>*>(shard))
+        {
+            return shard->searchFromAnchor(anchor, key, key_len, outputValue);
+        }
+    }
+    return false;
+}
+
+template <typename ValueType, uint32_t NumShards> ValueType* ShardedAdaptiveRadixTree<ValueType, NumShards>::getMinimumValue()
+{
+    Entry_t minimum = {};
+    for (Shard_t* shard : shards)
+    {
+        // The first entry visited in a shard is its minimum.
+        Entry_t shardMinimum = {};
+        shard->iterateOverAll(
+            [](void* data, const unsigned char* key, uint32_t key_len, void* value)
+            {
+                *static_cast<Entry_t*>(data) = {key, key_len, static_cast<ValueType*>(value)};
+                return 1;
+            },
+            &shardMinimum);
+        if (shardMinimum.key != nullptr && (minimum.key == nullptr || shardMinimum < minimum))
+        {
+            minimum = shardMinimum;
+        }
+    }
+    return minimum.value;
+}
+
+template <typename ValueType, uint32_t NumShards> ValueType* ShardedAdaptiveRadixTree<ValueType, NumShards>::getMaximumValue()
+{
+    // Shards do not expose their maximum key, so every entry has to be visited, keeping only the greatest one.
+    Entry_t maximum = {};
+    for (Shard_t* shard : shards)
+    {
+        shard->iterateOverAll(
+            [](void* data, const unsigned char* key, uint32_t key_len, void* value)
+            {
+                Entry_t&      greatest = *static_cast<Entry_t*>(data);
+                const Entry_t entry    = {key, key_len, static_cast<ValueType*>(value)};
+                if (greatest.key == nullptr || greatest < entry)
+                {
+                    greatest = entry;
+                }
+                return 0;
+            },
+            &maximum);
+    }
+    return maximum.value;
+}
+
+template <typename ValueType, uint32_t NumShards>
+NodeAllocatorStats_t ShardedAdaptiveRadixTree<ValueType, NumShards>::getNodeAllocatorStats()
+{
+    if (sharedNodeAllocator)
+    {
+        return AdaptiveRadixTree<ValueType>::getNodeAllocatorStats();
+    }
+
+    NodeAllocatorStats_t stats = {};
+    for (Shard_t* shard : shards)
+    {
+        const NodeAllocatorStats_t shardStats = shard->getNodeAllocatorStats();
+        stats.arenas += shardStats.arenas;
+        stats.reservedBytes += shardStats.reservedBytes;
+        stats.usedBytes += shardStats.usedBytes;
+        stats.freeBytes += shardStats.freeBytes;
+        stats.allocations += shardStats.allocations;
+        stats.largeAllocations += shardStats.largeAllocations;
+    }
+    return stats;
+}
+
+template <typename ValueType, uint32_t NumShards>
+LockStats_t ShardedAdaptiveRadixTree<ValueType, NumShards>::getLockStats()
+{
+    LockStats_t stats = {};
+    for (Shard_t* shard : shards)
+    {
+        LockStatistics::accumulate(stats, shard->getLockStats());
+    }
+    return stats;
+}
+
+template <typename ValueType, uint32_t NumShards>
+uint32_t ShardedAdaptiveRadixTree<ValueType, NumShards>::shardIndex(const char* key, const int key_len)
+{
+    // FNV-1a hash of the first path segment.
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < key_len && key[i] != '/'; i++)
+    {
+        hash ^= static_cast<uint8_t>(key[i]);
+        hash *= 16777619u;
+    }
+    return hash % NumShards;
+}
+
+template <typename ValueType, uint32_t NumShards> typename ShardedAdaptiveRadixTree<ValueType, NumShards>::Shard_t&
+ShardedAdaptiveRadixTree<ValueType, NumShards>::shardOf(const char* key, const int key_len)
+{
+    return *shards[shardIndex(key, key_len)];
+}
+
+template <typename ValueType, uint32_t NumShards>
+int ShardedAdaptiveRadixTree<ValueType, NumShards>::fanOut(const char* prefix, const int prefix_len, art_callback cb,
+                                                           void* data, const art_summary_filter filter,
+                                                           void* filterData)
+{
+    std::vector<Entry_t> entries;
+    if (!collectEntries(entries,
+                        [&](Shard_t& shard)
+                        {
+                            shard.AdaptiveRadixTree<ValueType>::iterateOverPrefix(prefix, prefix_len,
+                                                                                  collectEntryCallback, &entries,
+                                                                                  filter, filterData);
+                        }))
+    {
+        return -1;
+    }
+    return visitEntries(entries, cb, data);
+}
+
+template <typename ValueType, uint32_t NumShards>
+template <typename CollectShard>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::collectEntries(std::vector<Entry_t>& entries,
+                                                                   CollectShard          collectShard)
+{
+    // The shards are read through the base tree, as their sections are already held. A write that overlapped the
+    // collection can only be seen in EpochReads mode, and the second collection keeps the writers out.
+    bool unchanged      = false;
+    bool excludeWriters = false;
+    while (!unchanged)
+    {
+        ShardSections_t sections;
+        if (!lockShards(sections, excludeWriters))
+        {
+            return false;
+        }
+        entries.clear();
+        for (Shard_t* shard : shards)
+        {
+            const auto shardBegin = static_cast<std::ptrdiff_t>(entries.size());
+            collectShard(*shard);
+            // Every shard visits its entries in order, so they only have to be merged with the previous ones.
+            std::inplace_merge(entries.begin(), entries.begin() + shardBegin, entries.end());
+        }
+        unchanged = sections.writersExcluded || shardsUnchanged(sections);
+        unlockShards(sections, NumShards);
+        excludeWriters = true;
+    }
+    return true;
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::lockShards(ShardSections_t& sections, const bool excludeWriters)
+{
+    // Writers only lock one shard, and the shards are always locked in the same order, so this cannot deadlock. The
+    // write locks are only taken in EpochReads mode, where the read sections do not keep the writers out.
+    sections.writersExcluded = excludeWriters && shards[0]->readMode == Shard_t::EpochReads;
+    for (uint32_t i = 0; i < NumShards; i++)
+    {
+        if (!shards[i]->preRead(sections.readSections[i]))
+        {
+            unlockShards(sections, i);
+            return false;
+        }
+        if (sections.writersExcluded && !shards[i]->preWrite())
+        {
+            shards[i]->postRead(sections.readSections[i]);
+            unlockShards(sections, i);
+            return false;
+        }
+        sections.writeSequences[i] = shards[i]->writeSequence.load(std::memory_order_acquire);
+    }
+    return true;
+}
+
+template <typename ValueType, uint32_t NumShards>
+void ShardedAdaptiveRadixTree<ValueType, NumShards>::unlockShards(const ShardSections_t& sections,
+                                                                 const uint32_t         count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        shards[i]->postRead(sections.readSections[i]);
+        if (sections.writersExcluded)
+        {
+            shards[i]->postWrite();
+        }
+    }
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::shardsUnchanged(const ShardSections_t& sections) const
+{
+    // Pairs with the fences of the writers: a write that overlapped the collection has changed the sequence.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    for (uint32_t i = 0; i < NumShards; i++)
+    {
+        const uint32_t sequence = sections.writeSequences[i];
+        if (sequence % 2 != 0 || shards[i]->writeSequence.load(std::memory_order_relaxed) != sequence)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename ValueType, uint32_t NumShards>
+int ShardedAdaptiveRadixTree<ValueType, NumShards>::visitEntries(const std::vector<Entry_t>& entries, art_callback cb,
+                                                                 void* data)
+{
+    for (const Entry_t& entry : entries)
+    {
+        if (const int result = cb(data, entry.key, entry.keyLen, entry.value); result != 0)
+        {
+            return result;
+        }
+    }
+    return 0;
+}
+
+template <typename ValueType, uint32_t NumShards>
+int ShardedAdaptiveRadixTree<ValueType, NumShards>::collectEntryCallback(void* data, const unsigned char* key,
+                                                                         const uint32_t key_len, void* value)
+{
+    static_cast<std::vector<Entry_t>*>(data)->push_back({key, key_len, static_cast<ValueType*>(value)});
+    return 0;
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::Entry_t::operator<(const Entry_t& other) const
+{
+    const int result = memcmp(key, other.key, std::min(keyLen, other.keyLen));
+    return result < 0 || (result == 0 && keyLen < other.keyLen);
+}
+
+template <typename ValueType, uint32_t NumShards>
+bool ShardedAdaptiveRadixTree<ValueType, NumShards>::Entry_t::operator==(const Entry_t& other) const
+{
+    return keyLen == other.keyLen && memcmp(key, other.key, keyLen) == 0;
+}
+
+#endif // SHARDEDADAPTIVERADIXTREE_H
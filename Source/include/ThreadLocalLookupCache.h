@@ -0,0 +1,154 @@
+#ifndef THREADLOCALLOOKUPCACHE_H
+#define THREADLOCALLOOKUPCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#ifndef CONFIG_SETTINGS_STORAGE_READ_CACHE_SLOTS
+    #define CONFIG_SETTINGS_STORAGE_READ_CACHE_SLOTS 0
+#endif
+
+/**
+ * @brief Direct-mapped cache, private to each thread, of the values a map gave for the keys looked up in it.
+ *
+ * The slot of a key is chosen from the address and the length of the key, so a hit costs a multiplication, a load of
+ * the cache generation and the comparison of the key with the copy kept in the slot, without any lock nor shared
+ * write. As the key is compared, a key buffer reused for another key is not mistaken for the previous key.
+ *
+ * Every cache of the same type shares the table of the thread, and each entry records the cache and the generation of
+ * that cache it was stored under. invalidate() advances the generation, so the entries stored before, in every thread,
+ * miss. It must be called whenever a key of the map may stop giving the same value.
+ *
+ * With Slots set to 0, the cache never hits and does not use any thread-local memory.
+ */
+template <typename ValueType, uint32_t MaxKeySize, uint32_t Slots = CONFIG_SETTINGS_STORAGE_READ_CACHE_SLOTS>
+class ThreadLocalLookupCache
+{
+public:
+    /// True if the cache can hit.
+    static constexpr bool ENABLED = Slots > 0;
+
+    static_assert((Slots & (Slots - 1)) == 0, "The number of slots of the lookup cache must be a power of two");
+
+    /**
+     * @brief Build an empty cache.
+     */
+    ThreadLocalLookupCache();
+
+    /**
+     * Disallow copying or moving the object.
+     */
+    ThreadLocalLookupCache& operator=(ThreadLocalLookupCache&&) = delete;
+
+    /**
+     * @brief Search a key in the cache of the calling thread.
+     * @param key The key.
+     * @param keyLen The length of the key.
+     * @param outputGeneration On a miss, the generation to pass to store() once the key is looked up in the map. As
+     * it is read before that lookup, a value stored with it misses if the cache was invalidated meanwhile.
+     * @return The cached value, or nullptr on a miss.
+     */
+    [[nodiscard]] ValueType* lookup(const char* key, uint32_t keyLen, uint64_t& outputGeneration) const;
+
+    /**
+     * @brief Store the value of a key in the cache of the calling thread, replacing the key that used its slot.
+     * @param key The key. It is copied, unless it is longer than MaxKeySize and then not cached.
+     * @param keyLen The length of the key.
+     * @param value The value the map gave for the key.
+     * @param lookupGeneration The generation given by the lookup() that missed the key.
+     */
+    void store(const char* key, uint32_t keyLen, ValueType* value, uint64_t lookupGeneration) const;
+
+    /**
+     * @brief Make every value cached so far miss, in every thread.
+     */
+    void invalidate();
+
+private:
+    typedef struct
+    {
+        uint64_t   cacheId;    // Cache that stored the entry, 0 if the entry is free.
+        uint64_t   generation; // Generation of that cache when the key was looked up in the map.
+        ValueType* value;
+        uint32_t   keyLen;
+        char       key[MaxKeySize];
+    } Entry_t;
+
+    uint64_t              cacheId;
+    std::atomic<uint64_t> generation;
+
+    inline static std::atomic<uint64_t> nextCacheId{1};
+
+    static Entry_t& entryOf(const char* key, uint32_t keyLen);
+};
+
+template <typename ValueType, uint32_t MaxKeySize, uint32_t Slots>
+ThreadLocalLookupCache<ValueType, MaxKeySize, Slots>::ThreadLocalLookupCache()
+{
+    // The identifiers are never reused, so the entries of a destroyed cache cannot hit in a new one at its address.
+    cacheId = nextCacheId.fetch_add(1, std::memory_order_relaxed);
+    generation.store(0, std::memory_order_relaxed);
+}
+
+template <typename ValueType, uint32_t MaxKeySize, uint32_t Slots>
+ValueType* ThreadLocalLookupCache<ValueType, MaxKeySize, Slots>::lookup(const char* key, const uint32_t keyLen,
+                                                                        uint64_t& outputGeneration) const
+{
+    if constexpr (!ENABLED)
+    {
+        outputGeneration = 0;
+        return nullptr;
+    }
+
+    outputGeneration     = generation.load(std::memory_order_acquire);
+    const Entry_t& entry = entryOf(key, keyLen);
+    const bool     hit   = entry.cacheId == cacheId && entry.generation == outputGeneration &&
+                     entry.keyLen == keyLen && memcmp(entry.key, key, keyLen) == 0;
+    return hit ? entry.value : nullptr;
+}
+
+template <typename ValueType, uint32_t MaxKeySize, uint32_t Slots>
+void ThreadLocalLookupCache<ValueType, MaxKeySize, Slots>::store(const char* key, const uint32_t keyLen,
+                                                                 ValueType* value, const uint64_t lookupGeneration) const
+{
+    if constexpr (!ENABLED)
+    {
+        return;
+    }
+
+    if (keyLen > MaxKeySize)
+    {
+        return;
+    }
+
+    Entry_t& entry   = entryOf(key, keyLen);
+    entry.cacheId    = cacheId;
+    entry.generation = lookupGeneration;
+    entry.value      = value;
+    entry.keyLen     = keyLen;
+    memcpy(entry.key, key, keyLen);
+}
+
+template <typename ValueType, uint32_t MaxKeySize, uint32_t Slots>
+void ThreadLocalLookupCache<ValueType, MaxKeySize, Slots>::invalidate()
+{
+    if constexpr (ENABLED)
+    {
+        generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+template <typename ValueType, uint32_t MaxKeySize, uint32_t Slots>
+typename ThreadLocalLookupCache<ValueType, MaxKeySize, Slots>::Entry_t&
+ThreadLocalLookupCache<ValueType, MaxKeySize, Slots>::entryOf(const char* key, const uint32_t keyLen)
+{
+    // Zero initialized, so every entry starts free.
+    thread_local Entry_t entries[ENABLED ? Slots : 1];
+
+    // Fibonacci hashing: the multiplication mixes the address into the high bits, which select the slot.
+    const uint64_t mixed = (reinterpret_cast<uintptr_t>(key) ^ keyLen) * 0x9E3779B97F4A7C15ull;
+    return entries[static_cast<uint32_t>(mixed >> 32) & (ENABLED ? Slots - 1 : 0)];
+}
+
+#endif // THREADLOCALLOOKUPCACHE_H
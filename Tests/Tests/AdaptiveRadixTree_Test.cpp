@@ -0,0 +1,1282 @@
+#include "AtomicLibARTCpp.h"
+#include "ConcurrentAdaptiveRadixTree.h"
+#include "LinuxOSInterface.h"
+#include "ShardedAdaptiveRadixTree.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr uint32_t SETTINGS_STORAGE_TEST_KEYS = 2000;
+
+static LinuxOSInterface artOSInterface;
+
+using KeyValueMap = std::map<std::string, int*>;
+
+/// Value type with summary bits, used to check the summary aggregates of the inner nodes.
+struct TaggedValue
+{
+    uint32_t tags;
+};
+
+template <> struct AdaptiveRadixTreeSummary<TaggedValue>
+{
+    static uint32_t bits(const TaggedValue& value)
+    {
+        return value.tags;
+    }
+};
+
+int collectEntriesCallback(void* data, const unsigned char* key, uint32_t key_len, void* value)
+{
+    auto* entries = static_cast<std::vector<std::pair<std::string, int*>>*>(data);
+    EXPECT_EQ('\0', key[key_len]);
+    entries->emplace_back(std::string(reinterpret_cast<const char*>(key), key_len), static_cast<int*>(value));
+    return 0;
+}
+
+int stopIterationCallback(void* data, [[maybe_unused]] const unsigned char* key, [[maybe_unused]] uint32_t key_len,
+                          [[maybe_unused]] void* value)
+{
+    auto* visited = static_cast<int*>(data);
+    (*visited)++;
+    return *visited == 2 ? 7 : 0;
+}
+
+static std::string randomKey(std::mt19937& random)
+{
+    static constexpr char segments[][8] = {"menu1", "menu2", "net", "eth0", "a", "ab", "abc", "setting"};
+    std::string           key;
+    const uint32_t        depth = 1 + random() % 4;
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        if (i != 0)
+        {
+            key += '/';
+        }
+        key += segments[random() % 8];
+        if (random() % 3 == 0)
+        {
+            key += std::to_string(random() % 300);
+        }
+    }
+    return key;
+}
+
+static void expectSameEntries(AdaptiveRadixTree<int>& tree, const KeyValueMap& expected, const std::string& prefix)
+{
+    std::vector<std::pair<std::string, int*>> entries;
+    EXPECT_EQ(0, tree.iterateOverPrefix(prefix.c_str(), static_cast<int>(prefix.size()), collectEntriesCallback,
+                                        &entries));
+
+    std::vector<std::pair<std::string, int*>> expectedEntries;
+    for (const auto& [key, value] : expected)
+    {
+        if (key.starts_with(prefix))
+        {
+            expectedEntries.emplace_back(key, value);
+        }
+    }
+    EXPECT_EQ(expectedEntries, entries);
+}
+
+static void expectSearchBatchMatchesMap(AdaptiveRadixTree<int>& tree, const uint32_t seed)
+{
+    KeyValueMap      expected;
+    std::vector<int> values(SETTINGS_STORAGE_TEST_KEYS);
+    std::mt19937     random(seed);
+
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        const std::string key = randomKey(random);
+        tree.insert(key.c_str(), static_cast<int>(key.size()), &values[i]);
+        expected[key] = &values[i];
+    }
+
+    // Half of the keys are most likely not in the tree, and some keys are repeated
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        keys.push_back(randomKey(random));
+        keys.push_back(std::next(expected.begin(), random() % expected.size())->first);
+    }
+
+    for (const bool sorted : {false, true})
+    {
+        if (sorted)
+        {
+            std::sort(keys.begin(), keys.end());
+        }
+        std::vector<const char*> keyPointers;
+        std::vector<int>         keyLengths;
+        for (const std::string& key : keys)
+        {
+            keyPointers.push_back(key.c_str());
+            keyLengths.push_back(static_cast<int>(key.size()));
+        }
+
+        std::vector<int*> outputValues(keys.size());
+        tree.searchBatch(keyPointers.data(), keyLengths.data(), keys.size(), outputValues.data());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            const auto found = expected.find(keys[i]);
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr, outputValues[i]) << keys[i];
+        }
+    }
+}
+
+static void expectInlineBatchMatchesMap(AdaptiveRadixTree<int>& tree, const uint32_t seed)
+{
+    std::map<std::string, int> expected;
+    std::mt19937               random(seed);
+
+    // Sorted keys build the empty tree at once, unsorted ones are inserted one by one
+    for (const bool sorted : {true, false})
+    {
+        std::vector<std::string> keys;
+        std::vector<int>         values;
+        for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+        {
+            keys.push_back(randomKey(random));
+            values.push_back(static_cast<int>(random()));
+        }
+        if (sorted)
+        {
+            std::sort(keys.begin(), keys.end());
+        }
+
+        std::vector<const char*> keyPointers;
+        std::vector<int>         keyLengths;
+        for (const std::string& key : keys)
+        {
+            keyPointers.push_back(key.c_str());
+            keyLengths.push_back(static_cast<int>(key.size()));
+        }
+        std::vector<int*> existing(keys.size());
+        std::vector<int*> inserted(keys.size());
+        EXPECT_TRUE(tree.insertInlineBatchIfNotExists(keyPointers.data(), keyLengths.data(), keys.size(),
+                                                      values.data(), existing.data(), inserted.data()));
+
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            const bool isNew = expected.try_emplace(keys[i], values[i]).second;
+            EXPECT_EQ(isNew, existing[i] == nullptr) << keys[i];
+            if (isNew)
+            {
+                EXPECT_EQ(tree.search(keys[i].c_str(), static_cast<int>(keys[i].size())), inserted[i]) << keys[i];
+            }
+            else
+            {
+                EXPECT_EQ(expected[keys[i]], *existing[i]) << keys[i];
+                EXPECT_EQ(nullptr, inserted[i]) << keys[i];
+            }
+        }
+    }
+
+    EXPECT_EQ(expected.size(), tree.size());
+    std::vector<std::pair<std::string, int*>> entries;
+    EXPECT_EQ(0, tree.iterateOverAll(collectEntriesCallback, &entries));
+    ASSERT_EQ(expected.size(), entries.size());
+    auto entry = entries.begin();
+    for (const auto& [key, value] : expected)
+    {
+        EXPECT_EQ(key, entry->first);
+        EXPECT_EQ(value, *entry->second);
+        EXPECT_EQ(entry->second, tree.search(key.c_str(), static_cast<int>(key.size())));
+        ++entry;
+    }
+}
+
+static void expectChildrenMatchMap(AdaptiveRadixTree<int>& tree, const uint32_t seed)
+{
+    std::set<std::string> keys;
+    std::mt19937          random(seed);
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        std::string key = randomKey(random);
+        if (tree.insertInlineIfNotExists(key.c_str(), static_cast<int>(key.size()), static_cast<int>(i)) == nullptr)
+        {
+            keys.insert(key);
+        }
+    }
+
+    for (const std::string prefix : {"", "menu1/", "menu1", "a", "a/", "net/eth0/", "setting/ab/", "none/"})
+    {
+        std::vector<std::pair<std::string, int*>> expected;
+        for (const std::string& key : keys)
+        {
+            if (key.size() <= prefix.size() || !key.starts_with(prefix))
+            {
+                continue;
+            }
+            if (const size_t end = key.find('/', prefix.size()); end != std::string::npos)
+            {
+                expected.emplace_back(key.substr(0, end + 1), nullptr);
+            }
+            else
+            {
+                expected.emplace_back(key, tree.search(key.c_str(), static_cast<int>(key.size())));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+
+        std::vector<std::pair<std::string, int*>> children;
+        const art_callback                        collectChildrenCallback =
+            [](void* data, const unsigned char* key, uint32_t key_len, void* value)
+        {
+            static_cast<std::vector<std::pair<std::string, int*>>*>(data)->emplace_back(
+                std::string(reinterpret_cast<const char*>(key), key_len), static_cast<int*>(value));
+            return 0;
+        };
+        EXPECT_EQ(0, tree.iterateOverChildren(prefix.c_str(), static_cast<int>(prefix.size()), '/',
+                                              collectChildrenCallback, &children));
+        EXPECT_EQ(expected, children) << "prefix: " << prefix;
+    }
+}
+
+static void expectAnchorSearchMatchesSearch(AdaptiveRadixTree<int>& tree, const uint32_t seed)
+{
+    std::set<std::string> keys;
+    std::mt19937          random(seed);
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        std::string key = randomKey(random);
+        if (tree.insertInlineIfNotExists(key.c_str(), static_cast<int>(key.size()), static_cast<int>(i)) == nullptr)
+        {
+            keys.insert(key);
+        }
+    }
+
+    for (const std::string prefix : {"menu1/", "a/ab/", "net/eth0/setting/", "abc/abc", "none/"})
+    {
+        art_anchor anchor;
+        ASSERT_TRUE(tree.findAnchor(prefix.c_str(), static_cast<int>(prefix.size()), anchor));
+        for (const std::string& key : keys)
+        {
+            if (key.size() <= prefix.size() || !key.starts_with(prefix))
+            {
+                continue;
+            }
+            // Both the key and a key that is missing right after it are looked up.
+            for (const std::string& fullKey : {key, key + "x"})
+            {
+                int* value = nullptr;
+                EXPECT_TRUE(tree.searchFromAnchor(anchor, fullKey.c_str() + prefix.size(),
+                                                  static_cast<int>(fullKey.size() - prefix.size()), value));
+                EXPECT_EQ(tree.search(fullKey.c_str(), static_cast<int>(fullKey.size())), value) << fullKey;
+            }
+        }
+        int* value = nullptr;
+        EXPECT_TRUE(tree.searchFromAnchor(anchor, "missing", 7, value));
+        EXPECT_EQ(nullptr, value);
+
+        // When: a key is inserted, then deleted
+        const std::string newKey = prefix + "new";
+        EXPECT_EQ(nullptr, tree.insertInlineIfNotExists(newKey.c_str(), static_cast<int>(newKey.size()), 1));
+
+        // Then: the anchor is stale until taken again
+        EXPECT_FALSE(tree.searchFromAnchor(anchor, "new", 3, value));
+        ASSERT_TRUE(tree.findAnchor(prefix.c_str(), static_cast<int>(prefix.size()), anchor));
+        EXPECT_TRUE(tree.searchFromAnchor(anchor, "new", 3, value));
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ(1, *value);
+        tree.deleteValue(newKey.c_str(), static_cast<int>(newKey.size()));
+        EXPECT_FALSE(tree.searchFromAnchor(anchor, "new", 3, value));
+    }
+}
+
+static void expectSummaryFilterMatchesMap(AdaptiveRadixTree<TaggedValue>& tree, const uint32_t seed)
+{
+    static constexpr uint32_t RARE_TAG = 0x4;
+    std::map<std::string, uint32_t> expected;
+    std::mt19937                    random(seed);
+
+    // Rare tags are clustered in a few subtrees, and some of their values are deleted afterwards.
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        std::string       key  = randomKey(random);
+        const TaggedValue value = {random() % 50 == 0 && key.starts_with("menu1/") ? RARE_TAG | 0x1 : 0x1u};
+        if (tree.insertInlineIfNotExists(key.c_str(), static_cast<int>(key.size()), value) == nullptr)
+        {
+            expected[key] = value.tags;
+        }
+    }
+    for (auto entry = expected.begin(); entry != expected.end();)
+    {
+        if (random() % 4 == 0)
+        {
+            tree.deleteValue(entry->first.c_str(), static_cast<int>(entry->first.size()));
+            entry = expected.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+
+    std::pair<std::vector<std::string>, uint32_t> visit; // Keys with the rare tag, and number of values visited.
+    const art_callback                            collectRareCallback =
+        [](void* data, const unsigned char* key, uint32_t key_len, void* value)
+    {
+        auto* visited = static_cast<std::pair<std::vector<std::string>, uint32_t>*>(data);
+        visited->second++;
+        if ((static_cast<TaggedValue*>(value)->tags & RARE_TAG) != 0)
+        {
+            visited->first.emplace_back(reinterpret_cast<const char*>(key), key_len);
+        }
+        return 0;
+    };
+    const art_summary_filter rareFilter = [](void*, const uint32_t anyBits, uint32_t)
+    {
+        return (anyBits & RARE_TAG) != 0;
+    };
+
+    EXPECT_EQ(0, tree.iterateOverAll(collectRareCallback, &visit, rareFilter));
+
+    std::vector<std::string> expectedRare;
+    for (const auto& [key, tags] : expected)
+    {
+        if ((tags & RARE_TAG) != 0)
+        {
+            expectedRare.push_back(key);
+        }
+    }
+    EXPECT_EQ(expectedRare, visit.first);
+    EXPECT_LT(visit.second, expected.size() / 2);
+
+    // A filter on bits every value has never skips anything.
+    visit = {};
+    const art_summary_filter commonFilter = [](void*, uint32_t, const uint32_t allBits)
+    {
+        return (allBits & 0x1) != 0;
+    };
+    EXPECT_EQ(0, tree.iterateOverPrefix("", 0, collectRareCallback, &visit, commonFilter));
+    EXPECT_EQ(expected.size(), visit.second);
+}
+
+TEST(AdaptiveRadixTree, EmptyTree)
+{
+    AdaptiveRadixTree<int> tree;
+
+    EXPECT_EQ(0u, tree.size());
+    EXPECT_EQ(nullptr, tree.search("key", 3));
+    EXPECT_EQ(nullptr, tree.deleteValue("key", 3));
+    EXPECT_EQ(nullptr, tree.getMinimumValue());
+    EXPECT_EQ(nullptr, tree.getMaximumValue());
+    EXPECT_EQ(0, tree.iterateOverAll(collectEntriesCallback, nullptr));
+}
+
+TEST(AdaptiveRadixTree, KeysThatArePrefixesOfOtherKeys)
+{
+    AdaptiveRadixTree<int> tree;
+    int                    values[4] = {0, 1, 2, 3};
+
+    // When
+    EXPECT_EQ(nullptr, tree.insert("menu1/setting", 13, &values[0]));
+    EXPECT_EQ(nullptr, tree.insert("menu1", 5, &values[1]));
+    EXPECT_EQ(nullptr, tree.insert("menu1/setting1", 14, &values[2]));
+    EXPECT_EQ(nullptr, tree.insert("menu", 4, &values[3]));
+
+    // Then
+    EXPECT_EQ(4u, tree.size());
+    EXPECT_EQ(&values[0], tree.search("menu1/setting", 13));
+    EXPECT_EQ(&values[1], tree.search("menu1", 5));
+    EXPECT_EQ(&values[2], tree.search("menu1/setting1", 14));
+    EXPECT_EQ(&values[3], tree.search("menu", 4));
+    EXPECT_EQ(nullptr, tree.search("menu1/", 6));
+    EXPECT_EQ(&values[3], tree.getMinimumValue());
+    EXPECT_EQ(&values[2], tree.getMaximumValue());
+
+    EXPECT_EQ(&values[1], tree.deleteValue("menu1", 5));
+    EXPECT_EQ(nullptr, tree.search("menu1", 5));
+    EXPECT_EQ(&values[0], tree.search("menu1/setting", 13));
+}
+
+TEST(AdaptiveRadixTree, InsertReplaceAndNoReplace)
+{
+    AdaptiveRadixTree<int> tree;
+    int                    oldValue = 1, newValue = 2;
+
+    EXPECT_EQ(nullptr, tree.insertIfNotExists("key", 3, &oldValue));
+    EXPECT_EQ(&oldValue, tree.insertIfNotExists("key", 3, &newValue));
+    EXPECT_EQ(&oldValue, tree.search("key", 3));
+
+    EXPECT_EQ(&oldValue, tree.insert("key", 3, &newValue));
+    EXPECT_EQ(&newValue, tree.search("key", 3));
+    EXPECT_EQ(1u, tree.size());
+}
+
+TEST(AdaptiveRadixTree, IterationStopsWhenCallbackReturnsNonZero)
+{
+    AdaptiveRadixTree<int> tree;
+    int                    value   = 0;
+    int                    visited = 0;
+    tree.insert("a", 1, &value);
+    tree.insert("b", 1, &value);
+    tree.insert("c", 1, &value);
+
+    EXPECT_EQ(7, tree.iterateOverAll(stopIterationCallback, &visited));
+    EXPECT_EQ(2, visited);
+}
+
+TEST(AdaptiveRadixTree, RandomOperationsMatchOrderedMap)
+{
+    AdaptiveRadixTree<int> tree;
+    KeyValueMap            expected;
+    std::vector<int>       values(SETTINGS_STORAGE_TEST_KEYS);
+    std::mt19937           random(1234);
+
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS * 4; i++)
+    {
+        const std::string key   = randomKey(random);
+        int*              value = &values[random() % SETTINGS_STORAGE_TEST_KEYS];
+        const auto        found = expected.find(key);
+
+        if (random() % 3 == 0)
+        {
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr,
+                      tree.deleteValue(key.c_str(), static_cast<int>(key.size())));
+            expected.erase(key);
+        }
+        else
+        {
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr,
+                      tree.insert(key.c_str(), static_cast<int>(key.size()), value));
+            expected[key] = value;
+        }
+    }
+
+    EXPECT_EQ(expected.size(), tree.size());
+    for (const auto& [key, value] : expected)
+    {
+        EXPECT_EQ(value, tree.search(key.c_str(), static_cast<int>(key.size())));
+    }
+    expectSameEntries(tree, expected, "");
+    expectSameEntries(tree, expected, "menu1/");
+    expectSameEntries(tree, expected, "a");
+    expectSameEntries(tree, expected, "ab/net");
+    expectSameEntries(tree, expected, "zzz");
+
+    // Remove everything to exercise every node shrink path.
+    for (const auto& [key, value] : expected)
+    {
+        EXPECT_EQ(value, tree.deleteValue(key.c_str(), static_cast<int>(key.size())));
+    }
+    EXPECT_EQ(0u, tree.size());
+    EXPECT_EQ(nullptr, tree.getMinimumValue());
+}
+
+TEST(AdaptiveRadixTree, WideNodes)
+{
+    AdaptiveRadixTree<int> tree;
+    KeyValueMap            expected;
+    std::vector<int>       values(256);
+
+    for (int i = 255; i > 0; i--)
+    {
+        const std::string key = "node/" + std::string(1, static_cast<char>(i));
+        tree.insert(key.c_str(), static_cast<int>(key.size()), &values[i]);
+        expected[key] = &values[i];
+    }
+    expectSameEntries(tree, expected, "node/");
+
+    for (int i = 1; i < 250; i++)
+    {
+        const std::string key = "node/" + std::string(1, static_cast<char>(i));
+        EXPECT_EQ(&values[i], tree.deleteValue(key.c_str(), static_cast<int>(key.size())));
+        expected.erase(key);
+    }
+    expectSameEntries(tree, expected, "");
+}
+
+TEST(AdaptiveRadixTree, InlineValues)
+{
+    MallocNodeAllocator                 allocator;
+    AdaptiveRadixTree<std::string>      tree(&allocator);
+    const std::string                   value = "an inline value longer than the small string buffer";
+    std::map<std::string, std::string*> inlineValues;
+
+    // When: the values are copied into the leaves
+    for (const char* key : {"menu1/setting1", "menu1/setting2", "menu1", "menu2/setting1"})
+    {
+        std::string* existing;
+        std::string* inserted;
+        EXPECT_TRUE(
+            tree.tryInsertInlineIfNotExists(key, static_cast<int>(strlen(key)), value + key, existing, &inserted));
+        EXPECT_EQ(nullptr, existing);
+        inlineValues[key] = tree.search(key, static_cast<int>(strlen(key)));
+        EXPECT_EQ(inlineValues[key], inserted);
+    }
+
+    // Then: each leaf holds its own aligned copy, which is not replaced by a second registration
+    for (const auto& [key, inlineValue] : inlineValues)
+    {
+        ASSERT_NE(nullptr, inlineValue);
+        EXPECT_EQ(value + key, *inlineValue);
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(inlineValue) % alignof(std::string));
+        EXPECT_EQ(inlineValue, tree.insertInlineIfNotExists(key.c_str(), static_cast<int>(key.size()), value));
+        EXPECT_EQ(value + key, *inlineValue);
+    }
+    EXPECT_EQ(7u, allocator.getStats().allocations); // 4 leaves with their values and 3 inner nodes
+
+    // When: a key is deleted, its inline value is destroyed with its leaf
+    EXPECT_EQ(inlineValues["menu1"], tree.deleteValue("menu1", 5));
+    EXPECT_EQ(nullptr, tree.search("menu1", 5));
+    EXPECT_EQ(value + "menu1/setting2", *tree.search("menu1/setting2", 14));
+    EXPECT_EQ(3u, tree.size());
+}
+
+TEST(AdaptiveRadixTree, SearchBatchMatchesOrderedMap)
+{
+    AdaptiveRadixTree<int> tree;
+    expectSearchBatchMatchesMap(tree, 11);
+
+    // A batch on an empty tree
+    AdaptiveRadixTree<int> emptyTree;
+    const char*            key         = "key";
+    const int              keyLength   = 3;
+    int                    value       = 0;
+    int*                   outputValue = &value;
+    emptyTree.searchBatch(&key, &keyLength, 1, &outputValue);
+    EXPECT_EQ(nullptr, outputValue);
+}
+
+TEST(AtomicAdaptiveRadixTree, SearchBatchMatchesOrderedMap)
+{
+    for (const auto readMode : {AtomicAdaptiveRadixTree<int>::GateReads, AtomicAdaptiveRadixTree<int>::EpochReads,
+                                AtomicAdaptiveRadixTree<int>::BigReaderReads})
+    {
+        AtomicAdaptiveRadixTree<int> tree(artOSInterface, readMode);
+        expectSearchBatchMatchesMap(tree, 12);
+    }
+}
+
+TEST(AdaptiveRadixTree, InlineBatchMatchesOrderedMap)
+{
+    AdaptiveRadixTree<int> tree;
+    expectInlineBatchMatchesMap(tree, 21);
+}
+
+TEST(AtomicAdaptiveRadixTree, EpochReadsMatchGateReads)
+{
+    for (const auto readMode : {AtomicAdaptiveRadixTree<int>::GateReads, AtomicAdaptiveRadixTree<int>::EpochReads,
+                                AtomicAdaptiveRadixTree<int>::BigReaderReads})
+    {
+        AtomicAdaptiveRadixTree<int> tree(artOSInterface, readMode);
+        KeyValueMap                  expected;
+        std::vector<int>             values(SETTINGS_STORAGE_TEST_KEYS);
+        std::mt19937                 random(42);
+
+        for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+        {
+            const std::string key = randomKey(random);
+            tree.insert(key.c_str(), static_cast<int>(key.size()), &values[i]);
+            expected[key] = &values[i];
+        }
+
+        EXPECT_EQ(expected.size(), tree.size());
+        for (const auto& [key, value] : expected)
+        {
+            EXPECT_EQ(value, tree.search(key.c_str(), static_cast<int>(key.size())));
+        }
+        expectSameEntries(tree, expected, "menu2/");
+    }
+}
+
+TEST(AtomicAdaptiveRadixTree, InlineBatchMatchesOrderedMap)
+{
+    AtomicAdaptiveRadixTree<int> tree(artOSInterface);
+    expectInlineBatchMatchesMap(tree, 22);
+}
+
+TEST(AtomicAdaptiveRadixTree, EpochReadersRunConcurrentlyWithWriters)
+{
+    AtomicAdaptiveRadixTree<int> tree(artOSInterface, AtomicAdaptiveRadixTree<int>::EpochReads);
+    std::vector<int>             values(SETTINGS_STORAGE_TEST_KEYS);
+    std::atomic<bool>            stop{false};
+    std::atomic<uint32_t>        errors{0};
+
+    // Given: keys that are never removed, so readers must always find them
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        const std::string key = "stable/" + std::to_string(i);
+        tree.insert(key.c_str(), static_cast<int>(key.size()), &values[i]);
+    }
+
+    // When: readers poll the stable keys while a writer keeps inserting and deleting keys around them
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; r++)
+    {
+        readers.emplace_back(
+            [&]
+            {
+                while (!stop.load())
+                {
+                    for (uint32_t i = 0; i < 64; i++)
+                    {
+                        const std::string key = "stable/" + std::to_string(i);
+                        if (tree.search(key.c_str(), static_cast<int>(key.size())) != &values[i])
+                        {
+                            errors++;
+                        }
+                    }
+                }
+            });
+    }
+
+    std::mt19937 random(7);
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS * 10; i++)
+    {
+        const std::string key = "stable/" + std::to_string(random() % 200) + "/" + std::to_string(random() % 5);
+        if (random() % 2 == 0)
+        {
+            tree.insert(key.c_str(), static_cast<int>(key.size()), &values[64 + i % 100]);
+        }
+        else
+        {
+            tree.deleteValue(key.c_str(), static_cast<int>(key.size()));
+        }
+    }
+    stop.store(true);
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    // Then
+    EXPECT_EQ(0u, errors.load());
+}
+
+TEST(AtomicAdaptiveRadixTree, WriterTimeoutIsCountedAndReleasesTheLock)
+{
+    /// Reader blocked inside an iteration until it is released.
+    struct BlockedReader
+    {
+        std::atomic<bool> entered{false};
+        std::atomic<bool> released{false};
+    };
+
+    for (const auto readMode : {AtomicAdaptiveRadixTree<int>::GateReads, AtomicAdaptiveRadixTree<int>::BigReaderReads})
+    {
+        AtomicAdaptiveRadixTree<int> tree(artOSInterface, readMode);
+        int                          value = 1;
+        int*                         outputValue;
+        BlockedReader                blockedReader;
+        tree.insert("key", 3, &value);
+
+        // Given: a reader that stays in the tree
+        std::thread reader([&tree, &blockedReader] {
+            tree.iterateOverAll(
+                [](void* data, const unsigned char*, uint32_t, void*) {
+                    auto* blocked = static_cast<BlockedReader*>(data);
+                    blocked->entered.store(true);
+                    while (!blocked->released.load())
+                    {
+                        std::this_thread::yield();
+                    }
+                    return 0;
+                },
+                &blockedReader);
+        });
+        while (!blockedReader.entered.load())
+        {
+            std::this_thread::yield();
+        }
+
+        // When
+        EXPECT_EQ(nullptr, tree.insert("other", 5, &value));
+
+        // Then: the writer gave up without locking the readers out
+        EXPECT_EQ(1u, tree.getLockStats().writers.timeouts);
+        EXPECT_TRUE(tree.trySearch("key", 3, outputValue));
+        EXPECT_EQ(&value, outputValue);
+        EXPECT_EQ(0u, tree.getLockStats().readers.timeouts);
+
+        // When
+        blockedReader.released.store(true);
+        reader.join();
+
+        // Then
+        EXPECT_EQ(nullptr, tree.insert("other", 5, &value));
+        EXPECT_EQ(&value, tree.search("other", 5));
+        const LockStats_t stats = tree.getLockStats();
+        EXPECT_EQ(1u, stats.writers.timeouts);
+        if (LockStatistics::ENABLED)
+        {
+            EXPECT_EQ(2u, stats.writers.acquisitions);
+            EXPECT_EQ(3u, stats.readers.acquisitions);
+            uint64_t readerHolds = 0;
+            for (const uint64_t count : stats.readers.holdHistogram)
+            {
+                readerHolds += count;
+            }
+            EXPECT_EQ(3u, readerHolds);
+        }
+        else
+        {
+            EXPECT_EQ(0u, stats.writers.acquisitions);
+        }
+    }
+}
+
+TEST(AtomicAdaptiveRadixTree, GateReaderLeavesWhileTheReadersMutexIsHeld)
+{
+    /// OS interface that keeps the mutex of the tree, which is the mutex of the readers in gate mode.
+    class ReadersMutexOSInterface : public LinuxOSInterface
+    {
+    public:
+        OSInterface_Mutex* osCreateMutex() override
+        {
+            readersMutex = LinuxOSInterface::osCreateMutex();
+            return readersMutex;
+        }
+
+        OSInterface_Mutex* readersMutex = nullptr;
+    };
+
+    /// Task holding the readers mutex for longer than the lock timeout.
+    struct ReadersMutexHolder
+    {
+        OSInterface_Mutex* readersMutex;
+        std::thread        thread;
+        std::atomic<bool>  held{false};
+    };
+
+    ReadersMutexOSInterface      osInterface;
+    AtomicAdaptiveRadixTree<int> tree(osInterface, AtomicAdaptiveRadixTree<int>::GateReads);
+    ReadersMutexHolder           holder = {osInterface.readersMutex, {}, false};
+    int                          value  = 1;
+    tree.insert("key", 3, &value);
+
+    // When: the readers mutex is held while the reader leaves the tree
+    EXPECT_EQ(0, tree.iterateOverAll(
+                     [](void* data, const unsigned char*, uint32_t, void*)
+                     {
+                         auto* mutexHolder   = static_cast<ReadersMutexHolder*>(data);
+                         mutexHolder->thread = std::thread(
+                             [mutexHolder]
+                             {
+                                 EXPECT_TRUE(mutexHolder->readersMutex->wait(1000));
+                                 mutexHolder->held.store(true);
+                                 std::this_thread::sleep_for(
+                                     std::chrono::milliseconds(2 * SETTINGS_STORAGE_MUTEX_TIMEOUT_MS));
+                                 mutexHolder->readersMutex->signal();
+                             });
+                         while (!mutexHolder->held.load())
+                         {
+                             std::this_thread::yield();
+                         }
+                         return 0;
+                     },
+                     &holder));
+    holder.thread.join();
+
+    // Then: the reader left the gate, so the writers are not locked out
+    EXPECT_EQ(nullptr, tree.insert("other", 5, &value));
+    EXPECT_EQ(&value, tree.search("other", 5));
+    EXPECT_EQ(0u, tree.getLockStats().writers.timeouts);
+}
+
+TEST(ConcurrentAdaptiveRadixTree, RandomOperationsMatchOrderedMap)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    KeyValueMap                      expected;
+    std::vector<int>                 values(SETTINGS_STORAGE_TEST_KEYS);
+    std::mt19937                     random(99);
+
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS * 4; i++)
+    {
+        const std::string key   = randomKey(random);
+        int*              value = &values[random() % SETTINGS_STORAGE_TEST_KEYS];
+        const auto        found = expected.find(key);
+
+        if (random() % 3 == 0)
+        {
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr,
+                      tree.deleteValue(key.c_str(), static_cast<int>(key.size())));
+            expected.erase(key);
+        }
+        else
+        {
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr,
+                      tree.insert(key.c_str(), static_cast<int>(key.size()), value));
+            expected[key] = value;
+        }
+    }
+
+    EXPECT_EQ(expected.size(), tree.size());
+    expectSameEntries(tree, expected, "");
+    expectSameEntries(tree, expected, "menu2/net");
+}
+
+TEST(ConcurrentAdaptiveRadixTree, SearchBatchMatchesOrderedMap)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    expectSearchBatchMatchesMap(tree, 13);
+}
+
+TEST(ConcurrentAdaptiveRadixTree, InlineBatchMatchesOrderedMap)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    expectInlineBatchMatchesMap(tree, 23);
+}
+
+TEST(ConcurrentAdaptiveRadixTree, WritersOnDifferentSubtreesRunConcurrently)
+{
+    constexpr int                    WRITERS = 4;
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    std::vector<int>                 values(SETTINGS_STORAGE_TEST_KEYS);
+    KeyValueMap                      expected[WRITERS];
+
+    // When: every writer inserts and deletes keys in its own namespace, and they all share the upper tree nodes
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; w++)
+    {
+        writers.emplace_back(
+            [&, w]
+            {
+                std::mt19937 random(w);
+                for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS * 5; i++)
+                {
+                    const std::string key = "menu" + std::to_string(w) + "/" + randomKey(random);
+                    if (random() % 3 == 0)
+                    {
+                        tree.deleteValue(key.c_str(), static_cast<int>(key.size()));
+                        expected[w].erase(key);
+                    }
+                    else
+                    {
+                        int* value = &values[random() % SETTINGS_STORAGE_TEST_KEYS];
+                        tree.insert(key.c_str(), static_cast<int>(key.size()), value);
+                        expected[w][key] = value;
+                    }
+                }
+            });
+    }
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+
+    // Then: no update was lost
+    KeyValueMap allExpected;
+    for (const KeyValueMap& writerExpected : expected)
+    {
+        allExpected.insert(writerExpected.begin(), writerExpected.end());
+    }
+    EXPECT_EQ(allExpected.size(), tree.size());
+    expectSameEntries(tree, allExpected, "");
+}
+
+TEST(ConcurrentAdaptiveRadixTree, WritersRaceOnTheSameKeys)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    std::vector<int>                 values(8);
+    std::atomic<uint32_t>            inserted{0};
+
+    // When: several writers try to register the same keys
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 8; w++)
+    {
+        writers.emplace_back(
+            [&, w]
+            {
+                for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+                {
+                    const std::string key = "shared/" + std::to_string(i);
+                    if (tree.insertIfNotExists(key.c_str(), static_cast<int>(key.size()), &values[w]) == nullptr)
+                    {
+                        inserted++;
+                    }
+                }
+            });
+    }
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+
+    // Then: each key was registered exactly once
+    EXPECT_EQ(SETTINGS_STORAGE_TEST_KEYS, inserted.load());
+    EXPECT_EQ(SETTINGS_STORAGE_TEST_KEYS, tree.size());
+}
+
+TEST(ConcurrentAdaptiveRadixTree, WritersRaceOnTheSameInlineKeys)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    std::atomic<uint32_t>            inserted{0};
+
+    // When: several writers try to register the same keys with inline values
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 8; w++)
+    {
+        writers.emplace_back(
+            [&, w]
+            {
+                for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+                {
+                    const std::string key = "shared/" + std::to_string(i);
+                    if (tree.insertInlineIfNotExists(key.c_str(), static_cast<int>(key.size()), w) == nullptr)
+                    {
+                        inserted++;
+                    }
+                }
+            });
+    }
+    for (std::thread& writer : writers)
+    {
+        writer.join();
+    }
+
+    // Then: each key was registered exactly once, holding the value of the writer that won
+    EXPECT_EQ(SETTINGS_STORAGE_TEST_KEYS, inserted.load());
+    EXPECT_EQ(SETTINGS_STORAGE_TEST_KEYS, tree.size());
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        const std::string key   = "shared/" + std::to_string(i);
+        const int*        value = tree.search(key.c_str(), static_cast<int>(key.size()));
+        ASSERT_NE(nullptr, value);
+        EXPECT_TRUE(*value >= 0 && *value < 8);
+    }
+}
+
+/// Value type whose summary bits are only computed once it is released, to keep a writer inside the tree.
+struct BlockingValue
+{
+    std::atomic<bool>* entered;
+    std::atomic<bool>* released;
+};
+
+template <> struct AdaptiveRadixTreeSummary<BlockingValue>
+{
+    static uint32_t bits(const BlockingValue& value)
+    {
+        if (value.released != nullptr)
+        {
+            value.entered->store(true);
+            while (!value.released->load())
+            {
+                std::this_thread::yield();
+            }
+        }
+        return 0;
+    }
+};
+
+TEST(ConcurrentAdaptiveRadixTree, WriterGivesUpWhenANodeStaysLocked)
+{
+    ConcurrentAdaptiveRadixTree<BlockingValue> tree(artOSInterface);
+    std::atomic<bool>                          entered{false};
+    std::atomic<bool>                          released{false};
+    const BlockingValue                        plain    = {nullptr, nullptr};
+    const BlockingValue                        blocking = {&entered, &released};
+    BlockingValue*                             outputExisting;
+    BlockingValue*                             outputInserted;
+    tree.insertInlineIfNotExists("a", 1, plain);
+
+    // Given: a writer that holds the root slot while it splits the root leaf
+    std::thread writer([&tree, &blocking] { tree.insertInlineIfNotExists("b", 1, blocking); });
+    while (!entered.load())
+    {
+        std::this_thread::yield();
+    }
+
+    // When
+    const bool inserted = tree.tryInsertInlineIfNotExists("c", 1, plain, outputExisting, &outputInserted);
+
+    // Then: the other writer gave up in time
+    EXPECT_FALSE(inserted);
+    EXPECT_EQ(nullptr, outputExisting);
+    EXPECT_EQ(nullptr, outputInserted);
+    EXPECT_EQ(1u, tree.getLockStats().writers.timeouts);
+
+    // When
+    released.store(true);
+    writer.join();
+
+    // Then
+    EXPECT_TRUE(tree.tryInsertInlineIfNotExists("c", 1, plain, outputExisting, &outputInserted));
+    EXPECT_EQ(nullptr, outputExisting);
+    EXPECT_NE(nullptr, outputInserted);
+    EXPECT_EQ(3u, tree.size());
+    const LockStats_t stats = tree.getLockStats();
+    EXPECT_EQ(1u, stats.writers.timeouts);
+    EXPECT_EQ(LockStatistics::ENABLED ? 3u : 0u, stats.writers.acquisitions);
+    EXPECT_EQ(0u, stats.readers.acquisitions);
+}
+
+TEST(ShardedAdaptiveRadixTree, KeysOfANamespaceShareTheirShard)
+{
+    using Tree = ShardedAdaptiveRadixTree<int, 8>;
+
+    EXPECT_EQ(Tree::shardIndex("menu1", 5), Tree::shardIndex("menu1/setting1", 14));
+    EXPECT_EQ(Tree::shardIndex("menu1/", 6), Tree::shardIndex("menu1/submenu/setting2", 22));
+    EXPECT_LT(Tree::shardIndex("menu2/setting1", 14), 8u);
+}
+
+TEST(ShardedAdaptiveRadixTree, RandomOperationsMatchOrderedMap)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    KeyValueMap                      expected;
+    std::vector<int>                 values(SETTINGS_STORAGE_TEST_KEYS);
+    std::mt19937                     random(5);
+
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS * 4; i++)
+    {
+        const std::string key   = randomKey(random);
+        int*              value = &values[random() % SETTINGS_STORAGE_TEST_KEYS];
+        const auto        found = expected.find(key);
+
+        if (random() % 3 == 0)
+        {
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr,
+                      tree.deleteValue(key.c_str(), static_cast<int>(key.size())));
+            expected.erase(key);
+        }
+        else
+        {
+            EXPECT_EQ(found != expected.end() ? found->second : nullptr,
+                      tree.insert(key.c_str(), static_cast<int>(key.size()), value));
+            expected[key] = value;
+        }
+    }
+
+    EXPECT_EQ(expected.size(), tree.size());
+    for (const auto& [key, value] : expected)
+    {
+        EXPECT_EQ(value, tree.search(key.c_str(), static_cast<int>(key.size())));
+    }
+
+    // Fan-out iterations must keep the lexical order across shards
+    expectSameEntries(tree, expected, "");
+    expectSameEntries(tree, expected, "a");
+    expectSameEntries(tree, expected, "menu");
+    // Single shard iterations
+    expectSameEntries(tree, expected, "menu1/");
+    expectSameEntries(tree, expected, "ab/net");
+
+    EXPECT_EQ(expected.begin()->second, tree.getMinimumValue());
+    EXPECT_EQ(expected.rbegin()->second, tree.getMaximumValue());
+}
+
+TEST(ShardedAdaptiveRadixTree, SearchBatchMatchesOrderedMap)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    expectSearchBatchMatchesMap(tree, 14);
+}
+
+TEST(ShardedAdaptiveRadixTree, InlineBatchMatchesOrderedMap)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    expectInlineBatchMatchesMap(tree, 24);
+}
+
+TEST(ShardedAdaptiveRadixTree, FanOutStopsWhenCallbackReturnsNonZero)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    int                              value   = 0;
+    int                              visited = 0;
+    tree.insert("a/1", 3, &value);
+    tree.insert("b/1", 3, &value);
+    tree.insert("c/1", 3, &value);
+
+    EXPECT_EQ(7, tree.iterateOverAll(stopIterationCallback, &visited));
+    EXPECT_EQ(2, visited);
+}
+
+TEST(ShardedAdaptiveRadixTree, FanOutPassesTheKeysOfTheLeaves)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    int                              value = 0;
+    tree.insert("a/1", 3, &value);
+    tree.insert("b/1", 3, &value);
+    tree.insert("c/1", 3, &value);
+
+    // When
+    std::vector<const unsigned char*> fanOutKeys;
+    std::vector<const unsigned char*> shardKeys;
+    const art_callback                collectKeyCallback = [](void* data, const unsigned char* key, uint32_t, void*)
+    {
+        static_cast<std::vector<const unsigned char*>*>(data)->push_back(key);
+        return 0;
+    };
+    EXPECT_EQ(0, tree.iterateOverAll(collectKeyCallback, &fanOutKeys));
+    for (const char* key : {"a/1", "b/1", "c/1"})
+    {
+        EXPECT_EQ(0, tree.iterateOverPrefix(key, 3, collectKeyCallback, &shardKeys));
+    }
+
+    // Then the fan-out does not copy the keys
+    EXPECT_EQ(shardKeys, fanOutKeys);
+}
+
+TEST(ShardedAdaptiveRadixTree, FanOutSeesASinglePointInTime)
+{
+    using Tree = ShardedAdaptiveRadixTree<int, 4>;
+
+    // The keys of the first namespace are written first, in a shard that is read before the other one
+    std::string first  = "a";
+    std::string second = "b";
+    while (Tree::shardIndex(first.c_str(), 1) >= Tree::shardIndex(second.c_str(), 1))
+    {
+        second[0]++;
+    }
+
+    for (const auto readMode : {Tree::Shard_t::GateReads, Tree::Shard_t::EpochReads, Tree::Shard_t::BigReaderReads})
+    {
+        Tree tree(artOSInterface, readMode);
+        int  value = 0;
+
+        // When
+        std::atomic<bool> writing{true};
+        std::thread       writer(
+            [&]
+            {
+                for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+                {
+                    const std::string suffix = "/" + std::to_string(i);
+                    tree.insert((first + suffix).c_str(), static_cast<int>(first.size() + suffix.size()), &value);
+                    tree.insert((second + suffix).c_str(), static_cast<int>(second.size() + suffix.size()), &value);
+                }
+                writing.store(false);
+            });
+
+        // Then: a key of the second namespace is never seen without the key of the first one written before it
+        const art_callback countCallback = [](void* data, const unsigned char* key, uint32_t, void*)
+        {
+            auto* counts = static_cast<std::map<char, uint32_t>*>(data);
+            (*counts)[static_cast<char>(key[0])]++;
+            return 0;
+        };
+        while (writing.load())
+        {
+            std::map<char, uint32_t> counts;
+            EXPECT_EQ(0, tree.iterateOverAll(countCallback, &counts));
+            EXPECT_LE(counts[second[0]], counts[first[0]]);
+        }
+        writer.join();
+    }
+}
+
+TEST(AdaptiveRadixTree, SummaryFilterSkipsSubtrees)
+{
+    AdaptiveRadixTree<TaggedValue> tree;
+    expectSummaryFilterMatchesMap(tree, 31);
+}
+
+TEST(ConcurrentAdaptiveRadixTree, SummaryFilterSkipsSubtrees)
+{
+    ConcurrentAdaptiveRadixTree<TaggedValue> tree(artOSInterface);
+    expectSummaryFilterMatchesMap(tree, 32);
+}
+
+TEST(ShardedAdaptiveRadixTree, SummaryFilterSkipsSubtrees)
+{
+    ShardedAdaptiveRadixTree<TaggedValue, 4> tree(artOSInterface);
+    expectSummaryFilterMatchesMap(tree, 33);
+}
+
+TEST(AdaptiveRadixTree, IterateOverChildrenMatchesOrderedMap)
+{
+    AdaptiveRadixTree<int> tree;
+    expectChildrenMatchMap(tree, 41);
+
+    // When / Then: the callback stops the iteration
+    int visited = 0;
+    EXPECT_EQ(7, tree.iterateOverChildren("", 0, '/', stopIterationCallback, &visited));
+    EXPECT_EQ(2, visited);
+}
+
+TEST(ConcurrentAdaptiveRadixTree, IterateOverChildrenMatchesOrderedMap)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    expectChildrenMatchMap(tree, 42);
+}
+
+TEST(ShardedAdaptiveRadixTree, IterateOverChildrenMatchesOrderedMap)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    expectChildrenMatchMap(tree, 43);
+}
+
+TEST(AdaptiveRadixTree, IterateOverPrefixesOfMatchesOrderedMap)
+{
+    AdaptiveRadixTree<int> tree;
+    KeyValueMap            expected;
+    std::vector<int>       values(SETTINGS_STORAGE_TEST_KEYS);
+    std::mt19937           random(44);
+
+    // Given: keys that are often prefixes of one another
+    for (uint32_t i = 0; i < SETTINGS_STORAGE_TEST_KEYS; i++)
+    {
+        const std::string key = randomKey(random).substr(0, 1 + random() % 12);
+        tree.insert(key.c_str(), static_cast<int>(key.size()), &values[i]);
+        expected[key] = &values[i];
+    }
+
+    for (uint32_t i = 0; i < 500; i++)
+    {
+        const std::string                         key = randomKey(random);
+        std::vector<std::pair<std::string, int*>> expectedPrefixes;
+        std::vector<std::pair<std::string, int*>> prefixes;
+        for (size_t length = 1; length <= key.size(); length++)
+        {
+            if (const auto entry = expected.find(key.substr(0, length)); entry != expected.end())
+            {
+                expectedPrefixes.emplace_back(*entry);
+            }
+        }
+
+        // When
+        EXPECT_EQ(0, tree.iterateOverPrefixesOf(key.c_str(), static_cast<int>(key.size()), collectEntriesCallback,
+                                                &prefixes));
+
+        // Then
+        EXPECT_EQ(expectedPrefixes, prefixes) << key;
+    }
+
+    // When / Then: the callback stops the iteration
+    int visited = 0;
+    tree.insert("n", 1, &values[0]);
+    tree.insert("ne", 2, &values[0]);
+    tree.insert("net", 3, &values[0]);
+    EXPECT_EQ(7, tree.iterateOverPrefixesOf("net/eth0", 8, stopIterationCallback, &visited));
+    EXPECT_EQ(2, visited);
+}
+
+TEST(AdaptiveRadixTree, SearchFromAnchorMatchesSearch)
+{
+    AdaptiveRadixTree<int> tree;
+    expectAnchorSearchMatchesSearch(tree, 51);
+}
+
+TEST(AtomicAdaptiveRadixTree, SearchFromAnchorMatchesSearch)
+{
+    AtomicAdaptiveRadixTree<int> tree(artOSInterface);
+    expectAnchorSearchMatchesSearch(tree, 52);
+}
+
+TEST(ConcurrentAdaptiveRadixTree, SearchFromAnchorMatchesSearch)
+{
+    ConcurrentAdaptiveRadixTree<int> tree(artOSInterface);
+    expectAnchorSearchMatchesSearch(tree, 53);
+}
+
+TEST(ShardedAdaptiveRadixTree, SearchFromAnchorMatchesSearch)
+{
+    ShardedAdaptiveRadixTree<int, 4> tree(artOSInterface);
+    expectAnchorSearchMatchesSearch(tree, 54);
+
+    // A prefix without its whole first segment spans several shards.
+    art_anchor anchor;
+    EXPECT_FALSE(tree.findAnchor("menu", 4, anchor));
+}
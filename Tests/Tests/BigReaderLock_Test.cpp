@@ -0,0 +1,76 @@
+#include "BigReaderLock.h"
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+static LinuxOSInterface linuxOSInterface;
+
+TEST(BigReaderLock, ReadersShareTheLockAndExcludeWriters)
+{
+    BigReaderLock lock(linuxOSInterface);
+    uint32_t      firstSlot;
+    uint32_t      secondSlot;
+
+    // When
+    ASSERT_TRUE(lock.readLock(firstSlot, 100));
+    ASSERT_TRUE(lock.readLock(secondSlot, 100));
+
+    // Then
+    EXPECT_FALSE(lock.writeLock(10));
+
+    // When
+    lock.readUnlock(firstSlot);
+    lock.readUnlock(secondSlot);
+
+    // Then
+    ASSERT_TRUE(lock.writeLock(100));
+    EXPECT_FALSE(lock.readLock(firstSlot, 10));
+    EXPECT_FALSE(lock.writeLock(10));
+    lock.writeUnlock();
+    ASSERT_TRUE(lock.readLock(firstSlot, 100));
+    lock.readUnlock(firstSlot);
+}
+
+TEST(BigReaderLock, WritersAreExclusiveUnderContention)
+{
+    BigReaderLock            lock(linuxOSInterface);
+    uint64_t                 counter = 0;
+    uint64_t                 mirror  = 0;
+    std::atomic<uint32_t>    errors{0};
+    std::vector<std::thread> threads;
+
+    for (uint32_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&lock, &counter, &mirror] {
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                ASSERT_TRUE(lock.writeLock(5000));
+                counter++;
+                mirror++;
+                lock.writeUnlock();
+            }
+        });
+        threads.emplace_back([&lock, &counter, &mirror, &errors] {
+            for (uint32_t i = 0; i < 2000; i++)
+            {
+                uint32_t slot;
+                ASSERT_TRUE(lock.readLock(slot, 5000));
+                if (counter != mirror)
+                {
+                    errors++;
+                }
+                lock.readUnlock(slot);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Then
+    EXPECT_EQ(0u, errors.load());
+    EXPECT_EQ(4u * 2000u, counter);
+}
@@ -0,0 +1,82 @@
+#include "EpochManager.h"
+#include "gtest/gtest.h"
+
+static void countReclaim(void* context, void*)
+{
+    (*static_cast<size_t*>(context))++;
+}
+
+TEST(EpochManager, CollectKeepsTheObjectsUntilTheReadersLeave)
+{
+    size_t         reclaimed = 0;
+    EpochManager   epochManager;
+    const uint32_t epoch = epochManager.enter();
+    for (size_t i = 0; i < EpochManager::RECLAIM_THRESHOLD; i++)
+    {
+        epochManager.retire(nullptr, countReclaim, &reclaimed);
+    }
+
+    // When: a reader that may still reference the objects is running
+    epochManager.collect();
+    epochManager.collect();
+
+    // Then: collect() returned without releasing them
+    EXPECT_EQ(0u, reclaimed);
+
+    // When
+    epochManager.exit(epoch);
+    epochManager.collect();
+    epochManager.collect();
+
+    // Then
+    EXPECT_EQ(EpochManager::RECLAIM_THRESHOLD, reclaimed);
+}
+
+TEST(EpochManager, RetireCollectsOnceEnoughObjectsAreRetired)
+{
+    size_t       reclaimed = 0;
+    EpochManager epochManager;
+
+    // When: no reader is running
+    for (size_t i = 0; i <= EpochManager::RECLAIM_THRESHOLD; i++)
+    {
+        epochManager.retire(nullptr, countReclaim, &reclaimed);
+    }
+
+    // Then: the objects retired before the last epoch change are released
+    EXPECT_EQ(EpochManager::RECLAIM_THRESHOLD, reclaimed);
+}
+
+TEST(EpochManager, CollectWaitsForEnoughRetiredObjects)
+{
+    size_t       reclaimed = 0;
+    EpochManager epochManager;
+    for (size_t i = 0; i < EpochManager::RECLAIM_THRESHOLD - 1; i++)
+    {
+        epochManager.retire(nullptr, countReclaim, &reclaimed);
+    }
+
+    // When
+    epochManager.collect();
+    epochManager.collect();
+
+    // Then
+    EXPECT_EQ(0u, reclaimed);
+}
+
+TEST(EpochManager, DestructorReleasesEveryObject)
+{
+    size_t reclaimed = 0;
+    {
+        EpochManager epochManager;
+        for (size_t i = 0; i < EpochManager::RECLAIM_THRESHOLD; i++)
+        {
+            epochManager.retire(nullptr, countReclaim, &reclaimed);
+        }
+        epochManager.collect();
+        epochManager.retire(nullptr, countReclaim, &reclaimed);
+    }
+
+    // Then
+    EXPECT_EQ(EpochManager::RECLAIM_THRESHOLD + 1, reclaimed);
+}
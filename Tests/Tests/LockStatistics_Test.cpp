@@ -0,0 +1,43 @@
+#include "LockStatistics.h"
+#include "gtest/gtest.h"
+
+TEST(LockStatistics, HistogramBuckets)
+{
+    EXPECT_EQ(0u, LockStatistics::bucketOf(0));
+    EXPECT_EQ(1u, LockStatistics::bucketOf(1));
+    EXPECT_EQ(1u, LockStatistics::bucketOf(3));
+    EXPECT_EQ(2u, LockStatistics::bucketOf(4));
+    EXPECT_EQ(5u, LockStatistics::bucketOf(1000));
+    EXPECT_EQ(6u, LockStatistics::bucketOf(4095));
+    EXPECT_EQ(LOCK_STATS_HISTOGRAM_BUCKETS - 1, LockStatistics::bucketOf(4096));
+    EXPECT_EQ(LOCK_STATS_HISTOGRAM_BUCKETS - 1, LockStatistics::bucketOf(UINT64_MAX));
+}
+
+TEST(LockStatistics, RecordsAndAccumulates)
+{
+    LockStatistics statistics;
+
+    // When
+    statistics.recordTimeout(LockStatistics::WRITES);
+    statistics.recordAcquisition(LockStatistics::READS, 100, 105);
+    statistics.recordAcquisition(LockStatistics::READS, 200, 200);
+    LockStats_t total = statistics.getStats();
+    LockStatistics::accumulate(total, statistics.getStats());
+
+    // Then
+    EXPECT_EQ(0u, total.readers.timeouts);
+    EXPECT_EQ(2u, total.writers.timeouts);
+    if (LockStatistics::ENABLED)
+    {
+        EXPECT_EQ(4u, total.readers.acquisitions);
+        EXPECT_EQ(5u, total.readers.maxWaitUs);
+        EXPECT_EQ(2u, total.readers.waitHistogram[0]);
+        EXPECT_EQ(2u, total.readers.waitHistogram[2]);
+    }
+    else
+    {
+        EXPECT_EQ(0u, total.readers.acquisitions);
+        EXPECT_EQ(0u, LockStatistics::now());
+    }
+    EXPECT_EQ(0u, total.writers.acquisitions);
+}
@@ -0,0 +1,128 @@
+#include "AdaptiveRadixTree.h"
+#include "NodeAllocator.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+TEST(ArenaNodeAllocator, SizeClasses)
+{
+    EXPECT_EQ(16u, ArenaNodeAllocator::sizeClassOf(1));
+    EXPECT_EQ(16u, ArenaNodeAllocator::sizeClassOf(16));
+    EXPECT_EQ(32u, ArenaNodeAllocator::sizeClassOf(17));
+    EXPECT_EQ(320u, ArenaNodeAllocator::sizeClassOf(257));
+    EXPECT_EQ(3072u, ArenaNodeAllocator::sizeClassOf(3072));
+    EXPECT_EQ(0u, ArenaNodeAllocator::sizeClassOf(3073));
+}
+
+TEST(ArenaNodeAllocator, BlocksAreCarvedFromArenasAndReused)
+{
+    ArenaNodeAllocator allocator(4096);
+
+    // When
+    void* first  = allocator.allocate(40);
+    void* second = allocator.allocate(48);
+
+    // Then
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(first) % 16);
+    EXPECT_EQ(static_cast<uint8_t*>(first) + 48, static_cast<uint8_t*>(second));
+
+    NodeAllocatorStats_t stats = allocator.getStats();
+    EXPECT_EQ(1u, stats.arenas);
+    EXPECT_EQ(4096u, stats.reservedBytes);
+    EXPECT_EQ(96u, stats.usedBytes);
+    EXPECT_EQ(2u, stats.allocations);
+
+    // When: a released block is requested again with a size of the same class
+    allocator.deallocate(first, 40);
+    stats = allocator.getStats();
+    EXPECT_EQ(48u, stats.freeBytes);
+    EXPECT_EQ(1u, stats.allocations);
+
+    // Then
+    EXPECT_EQ(first, allocator.allocate(33));
+    EXPECT_EQ(0u, allocator.getStats().freeBytes);
+}
+
+TEST(ArenaNodeAllocator, NewArenaWhenFull)
+{
+    ArenaNodeAllocator allocator(4096);
+
+    for (int i = 0; i < 3; i++)
+    {
+        ASSERT_NE(nullptr, allocator.allocate(2048));
+    }
+
+    const NodeAllocatorStats_t stats = allocator.getStats();
+    EXPECT_EQ(2u, stats.arenas);
+    EXPECT_EQ(3u * 2048u, stats.usedBytes);
+}
+
+TEST(ArenaNodeAllocator, LargeBlocks)
+{
+    ArenaNodeAllocator allocator(4096);
+
+    // When
+    void* block = allocator.allocate(5000);
+
+    // Then
+    ASSERT_NE(nullptr, block);
+    NodeAllocatorStats_t stats = allocator.getStats();
+    EXPECT_EQ(0u, stats.arenas);
+    EXPECT_EQ(1u, stats.largeAllocations);
+    EXPECT_EQ(5000u, stats.reservedBytes);
+
+    allocator.deallocate(block, 5000);
+    stats = allocator.getStats();
+    EXPECT_EQ(0u, stats.largeAllocations);
+    EXPECT_EQ(0u, stats.reservedBytes);
+}
+
+TEST(ArenaNodeAllocator, TreeNodesComeFromTheArenas)
+{
+    ArenaNodeAllocator     allocator(4096);
+    std::vector<int>       values(300);
+    AdaptiveRadixTree<int> tree(&allocator);
+
+    // When
+    for (int i = 0; i < 300; i++)
+    {
+        const std::string key = "menu" + std::to_string(i % 7) + "/setting" + std::to_string(i);
+        tree.insert(key.c_str(), static_cast<int>(key.size()), &values[i]);
+    }
+
+    // Then
+    const NodeAllocatorStats_t stats = tree.getNodeAllocatorStats();
+    EXPECT_GT(stats.arenas, 0u);
+    EXPECT_GT(stats.allocations, 300u);
+    EXPECT_EQ(0u, stats.largeAllocations);
+    EXPECT_LE(stats.usedBytes, stats.reservedBytes);
+    EXPECT_EQ(&values[42], tree.search("menu0/setting42", 15));
+
+    // When: removing keys gives their blocks back to the free lists, while the arenas are kept (the shrunk copies of
+    // the nodes may still claim a new one)
+    for (int i = 0; i < 300; i++)
+    {
+        const std::string key = "menu" + std::to_string(i % 7) + "/setting" + std::to_string(i);
+        tree.deleteValue(key.c_str(), static_cast<int>(key.size()));
+    }
+    EXPECT_EQ(0u, tree.getNodeAllocatorStats().allocations);
+    EXPECT_LE(stats.arenas, tree.getNodeAllocatorStats().arenas);
+}
+
+TEST(MallocNodeAllocator, Stats)
+{
+    MallocNodeAllocator allocator;
+
+    void* block = allocator.allocate(100);
+    ASSERT_NE(nullptr, block);
+    EXPECT_EQ(100u, allocator.getStats().usedBytes);
+    EXPECT_EQ(1u, allocator.getStats().allocations);
+    EXPECT_FALSE(allocator.releasesInBulk());
+
+    allocator.deallocate(block, 100);
+    EXPECT_EQ(0u, allocator.getStats().usedBytes);
+    EXPECT_EQ(0u, allocator.getStats().allocations);
+}
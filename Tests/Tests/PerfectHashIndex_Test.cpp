@@ -0,0 +1,51 @@
+#include "PerfectHashIndex.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+TEST(PerfectHashIndex, EmptyIndex)
+{
+    PerfectHashIndex<int> index;
+
+    EXPECT_TRUE(index.build());
+    EXPECT_EQ(0u, index.size());
+    EXPECT_EQ(nullptr, index.search("key", 3));
+}
+
+TEST(PerfectHashIndex, EveryKeyIsFound)
+{
+    PerfectHashIndex<int>    index;
+    std::vector<int>         values(5000);
+    std::vector<std::string> keys;
+    for (int i = 0; i < 5000; i++)
+    {
+        keys.push_back("menu" + std::to_string(i % 17) + "/setting" + std::to_string(i));
+        index.add(keys.back().c_str(), static_cast<uint32_t>(keys.back().size()), &values[i]);
+    }
+
+    // When
+    ASSERT_TRUE(index.build());
+
+    // Then
+    EXPECT_EQ(5000u, index.size());
+    for (int i = 0; i < 5000; i++)
+    {
+        EXPECT_EQ(&values[i], index.search(keys[i].c_str(), static_cast<uint32_t>(keys[i].size())));
+    }
+}
+
+TEST(PerfectHashIndex, UnknownKeysAreNotFound)
+{
+    PerfectHashIndex<int> index;
+    int                   value = 1;
+    index.add("menu1/setting1", 14, &value);
+    index.add("menu1/setting2", 14, &value);
+    ASSERT_TRUE(index.build());
+
+    EXPECT_EQ(&value, index.search("menu1/setting1", 14));
+    EXPECT_EQ(nullptr, index.search("menu1/setting", 13));
+    EXPECT_EQ(nullptr, index.search("menu1/setting3", 14));
+    EXPECT_EQ(nullptr, index.search("menu1/setting10", 15));
+    EXPECT_EQ(nullptr, index.search("", 0));
+}
@@ -0,0 +1,91 @@
+#include "Setting.h"
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface settingOSInterface;
+
+static_assert(Setting<"menu1/setting2", int64_t>::keyLength() == 14);
+static_assert(Setting<"menu1/setting2", int64_t>::TYPE == SettingsStorage::INTEGER);
+static_assert(Setting<"menu1/setting1", double>::TYPE == SettingsStorage::REAL);
+static_assert(Setting<"menu2/setting3", const char*>::TYPE == SettingsStorage::STRING);
+static_assert(SettingKey("menu1/setting1").isValid());
+static_assert(!SettingKey("menu1\tsetting1").isValid());
+static_assert(!SettingKey("menu1\0setting1").isValid());
+static_assert(!SettingKey("").isValid());
+
+TEST(Setting, IntegerAndReal)
+{
+    SettingsStorage                    settingsStorage(settingOSInterface);
+    Setting<"menu1/setting1", double>  setting1(settingsStorage);
+    Setting<"menu1/setting2", int64_t> setting2(settingsStorage);
+    double                             outputReal;
+    int64_t                            outputInt;
+    SettingPermissions_t               outputPermissions;
+
+    // When: the settings are not registered yet
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, setting2.get(outputInt));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, setting2.put(1));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting1.registerSetting(SettingPermissions_t::USER, 1.23));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting2.registerSetting(SettingPermissions_t::ADMIN, 45));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting1.get(outputReal));
+    EXPECT_EQ(1.23, outputReal);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting2.get(outputInt, &outputPermissions));
+    EXPECT_EQ(45, outputInt);
+    EXPECT_EQ(SettingPermissions_t::ADMIN, outputPermissions);
+
+    // When: the settings are updated through the accessors and through the storage
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting2.put(46));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsReal("menu1/setting1", 3.21));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(46, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting1.get(outputReal));
+    EXPECT_EQ(3.21, outputReal);
+}
+
+TEST(Setting, String)
+{
+    SettingsStorage                        settingsStorage(settingOSInterface);
+    Setting<"menu2/setting3", const char*> setting3(settingsStorage);
+    char                                   outputValue[64];
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting3.registerSetting(SettingPermissions_t::USER, "string3"));
+    EXPECT_EQ(SettingsStorage::KEY_EXISTS_ERROR, setting3.registerSetting(SettingPermissions_t::USER, "string4"));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting3.get(outputValue, sizeof(outputValue)));
+    EXPECT_STREQ("string3", outputValue);
+    EXPECT_EQ(SettingsStorage::INSUFFICIENT_BUFFER_SIZE_ERROR, setting3.get(outputValue, 7));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, setting3.put(nullptr));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting3.put("a string that does not fit in the setting itself"));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting3.get(outputValue, sizeof(outputValue)));
+    EXPECT_STREQ("a string that does not fit in the setting itself", outputValue);
+    SettingsStorage::SettingStringLease lease;
+    EXPECT_EQ(SettingsStorage::NO_ERROR, setting3.lease(lease));
+    EXPECT_EQ("a string that does not fit in the setting itself", lease.view());
+}
+
+TEST(Setting, TypeMismatch)
+{
+    SettingsStorage                   settingsStorage(settingOSInterface);
+    Setting<"menu1/setting2", double> setting2(settingsStorage);
+    double                            outputReal;
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("menu1/setting2", SettingPermissions_t::USER, 45));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, setting2.get(outputReal));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, setting2.put(1.0));
+}
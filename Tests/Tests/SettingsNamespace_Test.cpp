@@ -0,0 +1,88 @@
+#include "SettingsNamespace.h"
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+static LinuxOSInterface namespaceOSInterface;
+
+TEST(SettingsNamespace, GetsAndPutsRelativeKeys)
+{
+    SettingsStorage   settingsStorage(namespaceOSInterface);
+    SettingsNamespace eth0(settingsStorage, "network/eth0/");
+    int64_t           outputInt;
+    double            outputReal;
+    char              outputString[64];
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("network/eth0/mtu", SettingPermissions_t::USER, 1500));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("network/eth0/gain", SettingPermissions_t::USER, 0.5));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("network/eth0/name", SettingPermissions_t::USER, "lan"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("network/eth1/mtu", SettingPermissions_t::USER, 9000));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, eth0.putSettingValueAsInt("mtu", 1400));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, eth0.putSettingValueAsReal("gain", 0.25));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, eth0.putSettingValueAsString("name", "uplink"));
+
+    // Then
+    EXPECT_STREQ("network/eth0/", eth0.getPrefix());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, eth0.getSettingAsInt("mtu", outputInt));
+    EXPECT_EQ(1400, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("network/eth1/mtu", outputInt));
+    EXPECT_EQ(9000, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, eth0.getSettingAsReal("gain", outputReal));
+    EXPECT_EQ(0.25, outputReal);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, eth0.getSettingAsString("name", outputString, sizeof(outputString)));
+    EXPECT_STREQ("uplink", outputString);
+
+    // When / Then
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, eth0.getSettingAsInt("mt", outputInt));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, eth0.getSettingAsInt("mtu2", outputInt));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, eth0.getSettingAsInt("../eth1/mtu", outputInt));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, eth0.getSettingAsInt("gain", outputInt));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, eth0.getSettingAsInt(nullptr, outputInt));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, eth0.getSettingAsInt("", outputInt));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, eth0.putSettingValueAsString("name", nullptr));
+}
+
+TEST(SettingsNamespace, SettingsRegisteredLaterAreFound)
+{
+    SettingsStorage   settingsStorage(namespaceOSInterface);
+    SettingsNamespace pid(settingsStorage, "control/pid/");
+    double            outputReal;
+
+    // Given: the namespace is anchored before any of its settings exists
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, pid.getSettingAsReal("kp", outputReal));
+
+    // When
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("control/pid/kp", SettingPermissions_t::USER, 1.5));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, pid.getSettingAsReal("kp", outputReal));
+    EXPECT_EQ(1.5, outputReal);
+
+    // When: the anchored subtree grows
+    for (int i = 0; i < 40; i++)
+    {
+        const std::string key = "control/pid/k" + std::to_string(i);
+        ASSERT_EQ(SettingsStorage::NO_ERROR,
+                  settingsStorage.registerSettingAsReal(key.c_str(), SettingPermissions_t::USER, i));
+    }
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, pid.getSettingAsReal("k39", outputReal));
+    EXPECT_EQ(39.0, outputReal);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, pid.getSettingAsReal("kp", outputReal));
+    EXPECT_EQ(1.5, outputReal);
+
+    // When: the settings are frozen
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.freeze());
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, pid.getSettingAsReal("k7", outputReal));
+    EXPECT_EQ(7.0, outputReal);
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, pid.getSettingAsReal("kd", outputReal));
+}
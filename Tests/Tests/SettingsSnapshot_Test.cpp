@@ -0,0 +1,132 @@
+#include "SettingsSnapshot.h"
+#include "LinuxOSInterface.h"
+#include "SettingsTransaction.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+static LinuxOSInterface snapshotOSInterface;
+
+static const char* const LONG_STRING = "a string long enough to be stored in a heap buffer shared with the snapshot";
+
+TEST(SettingsSnapshot, KeepsTheValuesOfWhenItWasTaken)
+{
+    SettingsStorage      settingsStorage(snapshotOSInterface);
+    SettingsSnapshot     snapshot;
+    int64_t              outputInt;
+    double               outputReal;
+    std::string_view     outputString;
+    SettingPermissions_t outputPermissions;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::ADMIN, 80));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, LONG_STRING));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/kp", SettingPermissions_t::USER, 1.5));
+
+    // When
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.snapshot(snapshot));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString("net/host", "other"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsReal("pid/kp", 2.5));
+
+    // Then
+    EXPECT_EQ(3u, snapshot.size());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, snapshot.getSettingAsInt("net/port", outputInt, &outputPermissions));
+    EXPECT_EQ(80, outputInt);
+    EXPECT_EQ(SettingPermissions_t::ADMIN, outputPermissions);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, snapshot.getSettingAsString("net/host", outputString));
+    EXPECT_EQ(LONG_STRING, outputString);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, snapshot.getSettingAsReal("pid/kp", outputReal));
+    EXPECT_EQ(1.5, outputReal);
+    EXPECT_LT(snapshot.getGeneration(), settingsStorage.getGeneration());
+
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, snapshot.getSettingAsInt(nullptr, outputInt));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, snapshot.getSettingAsInt("", outputInt));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, snapshot.getSettingAsInt("net/mask", outputInt));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, snapshot.getSettingAsInt("net/", outputInt));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, snapshot.getSettingAsReal("net/port", outputReal));
+}
+
+TEST(SettingsSnapshot, TakesTheSettingsMatchingThePrefixAndPermissions)
+{
+    SettingsStorage                     settingsStorage(snapshotOSInterface);
+    SettingsSnapshot                    snapshot;
+    SettingsStorage::SettingsKeysList_t keys;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::ADMIN, 80));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/mtu", SettingPermissions_t::USER, 1500));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("network", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/kp", SettingPermissions_t::USER, 1.5));
+
+    // When
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.snapshot(snapshot, "net", SettingPermissions_t::USER));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, snapshot.listSettingsKeys("", keys));
+    EXPECT_EQ((SettingsStorage::SettingsKeysList_t{"net/mtu", "network"}), keys);
+
+    // When: the snapshot is taken again
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.snapshot(snapshot));
+    keys.clear();
+
+    // Then
+    EXPECT_EQ(4u, snapshot.size());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, snapshot.listSettingsKeys("net/", keys));
+    EXPECT_EQ((SettingsStorage::SettingsKeysList_t{"net/mtu", "net/port"}), keys);
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, snapshot.listSettingsKeys(nullptr, keys));
+
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage.snapshot(snapshot, nullptr));
+    EXPECT_EQ(0u, snapshot.size());
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.snapshot(snapshot, "", static_cast<SettingPermissions_t>(0xFF)));
+}
+
+TEST(SettingsSnapshot, NeverHoldsPartOfATransaction)
+{
+    SettingsStorage   settingsStorage(snapshotOSInterface);
+    std::atomic<bool> stop{false};
+    uint32_t          errors = 0;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettingAsInt("pid/kp", SettingPermissions_t::USER, 0));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("pid/name", SettingPermissions_t::USER, "0"));
+
+    std::thread writer(
+        [&settingsStorage, &stop]
+        {
+            SettingsTransaction transaction(settingsStorage);
+            for (int64_t i = 1; !stop.load(); i++)
+            {
+                const std::string name = std::to_string(i) + LONG_STRING;
+                EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("pid/kp", i));
+                EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsString("pid/name", name.c_str()));
+                EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+            }
+        });
+
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        SettingsSnapshot snapshot;
+        int64_t          kp;
+        std::string_view name;
+        ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.snapshot(snapshot, "pid/"));
+        ASSERT_EQ(SettingsStorage::NO_ERROR, snapshot.getSettingAsInt("pid/kp", kp));
+        ASSERT_EQ(SettingsStorage::NO_ERROR, snapshot.getSettingAsString("pid/name", name));
+        if (kp == 0 ? name != "0" : name != std::to_string(kp) + LONG_STRING)
+        {
+            errors++;
+        }
+    }
+    stop.store(true);
+    writer.join();
+
+    // Then
+    EXPECT_EQ(0u, errors);
+}
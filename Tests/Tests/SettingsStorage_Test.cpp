@@ -1,8 +1,16 @@
 #include "SettingsStorage.h"
 #include "LinuxOSInterface.h"
 #include "SettingsFileMock.h"
+#include "SettingsTransaction.h"
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 constexpr char defaultSettingsFile[] =
     "menu1/setting1\t0\t1.23\nmenu1/setting2\t1\t45\nmenu2/setting3\t2\tstring3\n\r1874197929\n";
 constexpr int64_t defaultSettingsFileSize = sizeof(defaultSettingsFile) + 5000;
@@ -80,6 +88,87 @@ int populateSettingsCallback(void* data, const unsigned char* key, uint32_t key_
 
 static LinuxOSInterface linuxOSInterface;
 
+/// OS interface that keeps the primitives it creates, so a test can hold them as a writer of the settings.
+class HoldableOSInterface : public LinuxOSInterface
+{
+public:
+    OSInterface_BinarySemaphore* osCreateBinarySemaphore() override
+    {
+        OSInterface_BinarySemaphore* semaphore = LinuxOSInterface::osCreateBinarySemaphore();
+        semaphores.push_back(semaphore);
+        return semaphore;
+    }
+
+    OSInterface_Mutex* osCreateMutex() override
+    {
+        OSInterface_Mutex* mutex = LinuxOSInterface::osCreateMutex();
+        mutexes.push_back(mutex);
+        return mutex;
+    }
+
+    /// Hold the mutexes from another thread, as they are owned by the thread that takes them.
+    void holdMutexes()
+    {
+        std::atomic<bool> held{false};
+        releasing.store(false);
+        mutexHolder = std::thread(
+            [this, &held]
+            {
+                for (OSInterface_Mutex* mutex : mutexes)
+                {
+                    EXPECT_TRUE(mutex->wait(1000));
+                }
+                held.store(true);
+                while (!releasing.load())
+                {
+                    std::this_thread::yield();
+                }
+                for (OSInterface_Mutex* mutex : mutexes)
+                {
+                    mutex->signal();
+                }
+            });
+        while (!held.load())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void releaseMutexes()
+    {
+        releasing.store(true);
+        mutexHolder.join();
+    }
+
+    /// Take the semaphores that are available, the others being used as signals rather than as locks.
+    void hold()
+    {
+        for (OSInterface_BinarySemaphore* semaphore : semaphores)
+        {
+            if (semaphore->wait(0))
+            {
+                heldSemaphores.push_back(semaphore);
+            }
+        }
+    }
+
+    void release()
+    {
+        for (OSInterface_BinarySemaphore* semaphore : heldSemaphores)
+        {
+            semaphore->signal();
+        }
+        heldSemaphores.clear();
+    }
+
+private:
+    std::vector<OSInterface_BinarySemaphore*> semaphores;
+    std::vector<OSInterface_BinarySemaphore*> heldSemaphores;
+    std::vector<OSInterface_Mutex*>           mutexes;
+    std::thread                               mutexHolder;
+    std::atomic<bool>                         releasing{false};
+};
+
 TEST(SettingPermissions, OperatorOr)
 {
     SettingPermissions_t permission1 = SettingPermissions_t::SYSTEM;
@@ -863,6 +952,41 @@ TEST(SettingsStorage, PutSettingValueAsStringValid)
     TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
 }
 
+TEST(SettingsStorage, PutSettingValueAsStringShortAndLong)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+
+    // Want: strings on both sides of the inline storage limit
+    const std::string shortValue(SHORT_STRING_MAX_LENGTH, 's');
+    const std::string longValue(SHORT_STRING_MAX_LENGTH + 1, 'l');
+    const char*       key = "menu2/setting4";
+    char              outputValue[SHORT_STRING_MAX_LENGTH + 2];
+
+    result = settingsStorage->registerSettingAsString(key, SettingPermissions_t::USER, longValue.c_str());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+
+    // When: the value switches between the inline and the heap representations
+    for (const std::string* expectedValue : {&shortValue, &longValue, &shortValue, &shortValue, &longValue})
+    {
+        result = settingsStorage->putSettingValueAsString(key, expectedValue->c_str());
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+
+        // Then
+        result = settingsStorage->getSettingAsString(key, outputValue, sizeof(outputValue));
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+        EXPECT_STREQ(expectedValue->c_str(), outputValue);
+    }
+
+    result = settingsStorage->getSettingAsString(key, outputValue, longValue.size());
+    EXPECT_EQ(SettingsStorage::INSUFFICIENT_BUFFER_SIZE_ERROR, result);
+
+    result = settingsStorage->getDefaultSettingAsString(key, outputValue, sizeof(outputValue));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_STREQ(longValue.c_str(), outputValue);
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
 TEST(SettingsStorage, PutSettingValueAsStringInvalidKey)
 {
     NEW_POPULATED_SETTINGS_STORAGE;
@@ -1801,6 +1925,86 @@ TEST(SettingsStorage, restoreDefaultSettingsValidAllFilterByKey)
     TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
 }
 
+TEST(SettingsStorage, restoreDefaultSettingsLongStrings)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    const std::string defaultString(SHORT_STRING_MAX_LENGTH + 10, 'd');
+    const std::string newString(SHORT_STRING_MAX_LENGTH + 20, 'n');
+    const char*       key = "menu2/setting4";
+    char              outputValueString[SHORT_STRING_MAX_LENGTH + 32];
+
+    result = settingsStorage->registerSettingAsString(key, SettingPermissions_t::USER, defaultString.c_str());
+    ASSERT_EQ(SettingsStorage::NO_ERROR, result);
+
+    // When: the value diverges from its default, and is restored twice
+    for (int i = 0; i < 2; i++)
+    {
+        result = settingsStorage->putSettingValueAsString(key, newString.c_str());
+        ASSERT_EQ(SettingsStorage::NO_ERROR, result);
+        result = settingsStorage->getDefaultSettingAsString(key, outputValueString, sizeof(outputValueString));
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+        EXPECT_STREQ(defaultString.c_str(), outputValueString);
+
+        result = settingsStorage->restoreDefaultSettings(key, ALL_PERMISSIONS, MatchSettingsWithAnyPermissionsListed);
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+
+        // Then: both the value and the default hold the default string
+        result = settingsStorage->getSettingAsString(key, outputValueString, sizeof(outputValueString));
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+        EXPECT_STREQ(defaultString.c_str(), outputValueString);
+        result = settingsStorage->getDefaultSettingAsString(key, outputValueString, sizeof(outputValueString));
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+        EXPECT_STREQ(defaultString.c_str(), outputValueString);
+    }
+
+    result = settingsStorage->registerSettingAsString(key, SettingPermissions_t::USER, newString.c_str());
+    EXPECT_EQ(SettingsStorage::KEY_EXISTS_ERROR, result);
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, restoreDefaultSettingsIsAllOrNothing)
+{
+    HoldableOSInterface              osInterface;
+    SettingsStorage                  settingsStorage(osInterface);
+    SettingsStorage::SettingHandle_t countHandle = {};
+    SettingsStorage::SettingHandle_t nameHandle  = {};
+    int64_t                          count;
+    char                             name[16];
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("menu/count", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("menu/name", SettingPermissions_t::USER, "default"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("menu/count", SettingsStorage::INTEGER, countHandle));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("menu/name", SettingsStorage::STRING, nameHandle));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt(countHandle, 2));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString(nameHandle, "changed"));
+
+    // When: the values cannot be written in time
+    osInterface.holdMutexes();
+    const SettingsStorage::SettingError_t result = settingsStorage.restoreDefaultSettings("menu/");
+    osInterface.releaseMutexes();
+
+    // Then: no setting is restored
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, result);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt(countHandle, count));
+    EXPECT_EQ(2, count);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsString(nameHandle, name, sizeof(name)));
+    EXPECT_STREQ("changed", name);
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.restoreDefaultSettings("menu/"));
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt(countHandle, count));
+    EXPECT_EQ(1, count);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsString(nameHandle, name, sizeof(name)));
+    EXPECT_STREQ("default", name);
+}
+
 TEST(SettingsStorage, restoreDefaultSettingsValidSomeFilterByKey)
 {
     NEW_POPULATED_SETTINGS_STORAGE;
@@ -2450,6 +2654,28 @@ TEST(SettingsStorage, loadSettingsFromPersistentStorageValidVolatile)
     TEAR_DOWN_NEW_POPULATED_SETTINGS_T;
 }
 
+TEST(SettingsStorage, loadSettingsFromPersistentStorageFrozenSkipsUnknownSettings)
+{
+    SettingsFileMock settingsFileMock(
+        "menu1/setting1\t0\t1.23\nmenu1/setting2\t1\t45\nmenu2/setting3\t2\tstring3\n\r1874197929\n");
+    SettingsStorage settingsStorage(linuxOSInterface, &settingsFileMock);
+    int64_t         outputInt;
+    double          outputReal;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("menu1/setting2", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.freeze());
+
+    // When
+    const SettingsStorage::SettingError_t result = settingsStorage.loadSettingsFromPersistentStorage();
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(45, outputInt);
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage.getSettingAsReal("menu1/setting1", outputReal));
+}
+
 TEST(SettingsStorage, loadSettingsFromPersistentStorageValidNoVolatile)
 {
     NEW_POPULATED_SETTINGS_STORAGE;
@@ -2852,3 +3078,1073 @@ TEST(SettingsStorage, storeSettingsFromPersistentStorageValidNoVolatile)
 
     TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
 }
+
+TEST(SettingsStorage, GetSettingsTreeMemoryStats)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+
+    // When
+    NodeAllocatorStats_t before = settingsStorage->getSettingsTreeMemoryStats();
+    result                      = settingsStorage->registerSettingAsInt("menu3/setting4", SettingPermissions_t::USER, 4);
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    NodeAllocatorStats_t after = settingsStorage->getSettingsTreeMemoryStats();
+    EXPECT_GT(before.allocations, 0u);
+    EXPECT_GT(after.allocations, before.allocations);
+    EXPECT_GT(after.usedBytes, before.usedBytes);
+    EXPECT_LE(after.usedBytes, after.reservedBytes);
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, GetSettingsTreeLockStats)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    int64_t outputInt;
+
+    // When
+    const LockStats_t before = settingsStorage->getSettingsTreeLockStats();
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage->getSettingAsInt("menu1/missing", outputInt));
+
+    // Then
+    const LockStats_t after = settingsStorage->getSettingsTreeLockStats();
+    EXPECT_EQ(0u, after.readers.timeouts);
+    EXPECT_EQ(0u, after.writers.timeouts);
+    if (LockStatistics::ENABLED && !CONFIG_SETTINGS_STORAGE_CONCURRENT_WRITES)
+    {
+        EXPECT_GT(before.writers.acquisitions, 0u);
+        EXPECT_EQ(before.readers.acquisitions + 2, after.readers.acquisitions);
+    }
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, ResolveSettingValid)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    SettingsStorage::SettingHandle_t realHandle = {}, intHandle = {}, stringHandle = {};
+    double                           outputReal;
+    int64_t                          outputInt;
+    char                             outputString[32];
+    SettingPermissions_t             outputPermissions;
+
+    // When
+    result = settingsStorage->resolveSetting("menu1/setting1", SettingsStorage::REAL, realHandle);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    result = settingsStorage->resolveSetting("menu1/setting2", SettingsStorage::INTEGER, intHandle);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    result = settingsStorage->resolveSetting("menu2/setting3", SettingsStorage::STRING, stringHandle);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+
+    // Then: the handles survive the registration of other settings
+    for (int i = 0; i < 300; i++)
+    {
+        const std::string key = "menu1/setting" + std::to_string(i + 10);
+        result                = settingsStorage->registerSettingAsInt(key.c_str(), SettingPermissions_t::USER, i);
+        ASSERT_EQ(SettingsStorage::NO_ERROR, result);
+    }
+
+    result = settingsStorage->getSettingAsReal(realHandle, outputReal, &outputPermissions);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(_valueSetting1.settingValueData.real, outputReal);
+    EXPECT_EQ(_valueSetting1.settingPermissions, outputPermissions);
+
+    result = settingsStorage->putSettingValueAsInt(intHandle, 99);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    result = settingsStorage->getSettingAsInt("menu1/setting2", outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(99, outputInt);
+    result = settingsStorage->getDefaultSettingAsInt(intHandle, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(_int2_default, outputInt);
+
+    result = settingsStorage->putSettingValueAsString(stringHandle, "through the handle");
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    result = settingsStorage->getSettingAsString(stringHandle, outputString, sizeof(outputString));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_STREQ("through the handle", outputString);
+    result = settingsStorage->getDefaultSettingAsString(stringHandle, outputString, sizeof(outputString));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_STREQ(_string3_default, outputString);
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, ResolveSettingInvalid)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    SettingsStorage::SettingHandle_t handle = {};
+    int64_t                          outputInt;
+    double                           outputReal;
+    char                             outputString[4];
+
+    // When / Then: the key is checked when the handle is resolved
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage->resolveSetting(nullptr, SettingsStorage::REAL, handle));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage->resolveSetting("", SettingsStorage::REAL, handle));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR,
+              settingsStorage->resolveSetting("menu1/setting9", SettingsStorage::REAL, handle));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR,
+              settingsStorage->resolveSetting("menu1/setting1", SettingsStorage::INTEGER, handle));
+    EXPECT_EQ(nullptr, handle.settingValue);
+
+    // When / Then: an unresolved handle is rejected
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage->getSettingAsInt(handle, outputInt));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage->putSettingValueAsReal(handle, 1.0));
+
+    // When / Then: a handle can only be used for the type it was resolved for
+    result = settingsStorage->resolveSetting("menu2/setting3", SettingsStorage::STRING, handle);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, settingsStorage->getSettingAsReal(handle, outputReal));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, settingsStorage->putSettingValueAsInt(handle, 1));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage->putSettingValueAsString(handle, nullptr));
+    EXPECT_EQ(SettingsStorage::INSUFFICIENT_BUFFER_SIZE_ERROR,
+              settingsStorage->getSettingAsString(handle, outputString, sizeof(outputString)));
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, FreezeServesSettingsByKey)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    int64_t                             outputInt;
+    char                                outputString[32];
+    SettingsStorage::SettingsKeysList_t outputKeys;
+
+    // When
+    EXPECT_FALSE(settingsStorage->isFrozen());
+    result = settingsStorage->freeze();
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_TRUE(settingsStorage->isFrozen());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->freeze());
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->putSettingValueAsInt("menu1/setting2", 7));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(7, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage->getSettingAsString("menu2/setting3", outputString, sizeof(outputString)));
+    EXPECT_STREQ(_string3, outputString);
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage->getSettingAsInt("menu1/setting", outputInt));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, settingsStorage->getSettingAsInt("menu1/setting1", outputInt));
+
+    // Then: prefix operations still use the settings tree
+    result = settingsStorage->listSettingsKeys("menu1", ALL_PERMISSIONS, MatchSettingsWithAnyPermissionsListed,
+                                               outputKeys);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(2u, outputKeys.size());
+    result = settingsStorage->restoreDefaultSettings("menu1", ALL_PERMISSIONS, MatchSettingsWithAnyPermissionsListed);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(_int2_default, outputInt);
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, RegisterAfterFreezeFails)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    int64_t outputInt;
+
+    result = settingsStorage->freeze();
+    ASSERT_EQ(SettingsStorage::NO_ERROR, result);
+
+    // When / Then
+    EXPECT_EQ(SettingsStorage::SETTINGS_FROZEN_ERROR,
+              settingsStorage->registerSettingAsInt("menu3/setting4", SettingPermissions_t::USER, 4));
+    EXPECT_EQ(SettingsStorage::SETTINGS_FROZEN_ERROR,
+              settingsStorage->registerSettingAsReal("menu3/setting5", SettingPermissions_t::USER, 5.0));
+    EXPECT_EQ(SettingsStorage::SETTINGS_FROZEN_ERROR,
+              settingsStorage->registerSettingAsString("menu3/setting6", SettingPermissions_t::USER, "6"));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage->registerSettingAsInt(nullptr, SettingPermissions_t::USER, 4));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage->getSettingAsInt("menu3/setting4", outputInt));
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, ConcurrentFreezes)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    int64_t outputInt;
+
+    // When
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&] { EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->freeze()); });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Then
+    EXPECT_TRUE(settingsStorage->isFrozen());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(_valueSetting2.settingValueData.integer, outputInt);
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, FreezeKeepsEverySettingRegisteredMeanwhile)
+{
+    SettingsStorage          settingsStorage(linuxOSInterface);
+    std::vector<std::string> registeredKeys;
+    std::atomic<bool>        started{false};
+    int64_t                  outputInt;
+
+    // When: settings are registered until the storage is frozen
+    std::thread registrar(
+        [&]
+        {
+            for (int i = 0;; i++)
+            {
+                const std::string                     key    = "menu/setting" + std::to_string(i);
+                const SettingsStorage::SettingError_t result =
+                    settingsStorage.registerSettingAsInt(key.c_str(), SettingPermissions_t::USER, i);
+                started.store(true);
+                if (result == SettingsStorage::NO_ERROR)
+                {
+                    registeredKeys.push_back(key);
+                }
+                else if (result == SettingsStorage::SETTINGS_FROZEN_ERROR)
+                {
+                    return;
+                }
+            }
+        });
+    while (!started.load())
+    {
+        std::this_thread::yield();
+    }
+    SettingsStorage::SettingError_t result;
+    do
+    {
+        result = settingsStorage.freeze();
+    } while (result == SettingsStorage::LOCK_TIMEOUT_ERROR);
+    registrar.join();
+
+    // Then: the index serves every setting that was registered
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    for (const std::string& key : registeredKeys)
+    {
+        EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt(key.c_str(), outputInt)) << key;
+    }
+}
+
+TEST(SettingsStorage, ScalarPutsAndGetsRunConcurrently)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    SettingsStorage::SettingHandle_t intHandle = {}, realHandle = {};
+    std::atomic<bool>                stop{false};
+    std::atomic<uint32_t>            tornReads{0};
+
+    result = settingsStorage->resolveSetting("menu1/setting2", SettingsStorage::INTEGER, intHandle);
+    ASSERT_EQ(SettingsStorage::NO_ERROR, result);
+    result = settingsStorage->resolveSetting("menu1/setting1", SettingsStorage::REAL, realHandle);
+    ASSERT_EQ(SettingsStorage::NO_ERROR, result);
+    // The readers may run before the first put of the writer, so they must already see one of its values.
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage->putSettingValueAsInt(intHandle, 0));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage->putSettingValueAsReal(realHandle, 1.5));
+
+    // When: a writer flips every bit of the values while readers get them
+    std::thread writer(
+        [&]
+        {
+            for (int i = 0; i < 100000; i++)
+            {
+                EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->putSettingValueAsInt(intHandle, i % 2 ? -1 : 0));
+                EXPECT_EQ(SettingsStorage::NO_ERROR,
+                          settingsStorage->putSettingValueAsReal(realHandle, i % 2 ? -1.5 : 1.5));
+            }
+            stop = true;
+        });
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back(
+            [&]
+            {
+                int64_t outputInt;
+                double  outputReal;
+                while (!stop)
+                {
+                    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingAsInt(intHandle, outputInt));
+                    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingAsReal(realHandle, outputReal));
+                    if ((outputInt != 0 && outputInt != -1) || (outputReal != 1.5 && outputReal != -1.5))
+                    {
+                        tornReads++;
+                    }
+                }
+            });
+    }
+    writer.join();
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    // Then
+    EXPECT_EQ(0u, tornReads.load());
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+TEST(SettingsStorage, GetSettingsBatch)
+{
+    NEW_POPULATED_SETTINGS_STORAGE;
+    double                             outputReal;
+    int64_t                            outputInt;
+    char                               outputString[32];
+    char                               shortOutputString[4];
+    SettingPermissions_t               outputPermissions;
+    SettingsStorage::SettingBatchGet_t gets[] = {
+        {"menu1/setting1", SettingsStorage::REAL, {.real = &outputReal}, 0, &outputPermissions, {}},
+        {"menu1/setting2", SettingsStorage::INTEGER, {.integer = &outputInt}, 0, nullptr, {}},
+        {"menu1/setting9", SettingsStorage::INTEGER, {.integer = &outputInt}, 0, nullptr, {}},
+        {"menu2/setting3", SettingsStorage::STRING, {.string = outputString}, sizeof(outputString), nullptr, {}},
+        {"menu2/setting3", SettingsStorage::STRING, {.string = shortOutputString}, sizeof(shortOutputString), nullptr,
+         {}},
+        {"menu2/setting3", SettingsStorage::REAL, {.real = &outputReal}, 0, nullptr, {}},
+        {"", SettingsStorage::REAL, {.real = &outputReal}, 0, nullptr, {}},
+        {"menu1/setting2", SettingsStorage::INTEGER, {.integer = nullptr}, 0, nullptr, {}},
+    };
+
+    for (const bool frozen : {false, true})
+    {
+        if (frozen)
+        {
+            EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->freeze());
+        }
+
+        // When
+        result = settingsStorage->getSettingsBatch(gets, sizeof(gets) / sizeof(gets[0]));
+
+        // Then
+        EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+        EXPECT_EQ(SettingsStorage::NO_ERROR, gets[0].result);
+        EXPECT_EQ(_valueSetting1.settingValueData.real, outputReal);
+        EXPECT_EQ(_valueSetting1.settingPermissions, outputPermissions);
+        EXPECT_EQ(SettingsStorage::NO_ERROR, gets[1].result);
+        EXPECT_EQ(_valueSetting2.settingValueData.integer, outputInt);
+        EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, gets[2].result);
+        EXPECT_EQ(SettingsStorage::NO_ERROR, gets[3].result);
+        EXPECT_STREQ(_string3, outputString);
+        EXPECT_EQ(SettingsStorage::INSUFFICIENT_BUFFER_SIZE_ERROR, gets[4].result);
+        EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, gets[5].result);
+        EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, gets[6].result);
+        EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, gets[7].result);
+    }
+
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage->getSettingsBatch(nullptr, 1));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage->getSettingsBatch(nullptr, 0));
+
+    TEAR_DOWN_NEW_POPULATED_SETTINGS_STORAGE;
+}
+
+static constexpr char LONG_DEFAULT_STRING[] = "a default string that is too long to be stored in the setting";
+
+static const SettingsStorage::SettingDescriptor_t SETTING_DESCRIPTORS[] = {
+    {"menu1/setting1", SettingsStorage::REAL, SettingPermissions_t::USER, {.real = 1.23}},
+    {"menu1/setting2", SettingsStorage::INTEGER, SettingPermissions_t::ADMIN, {.integer = 45}},
+    {"menu1/setting2", SettingsStorage::INTEGER, SettingPermissions_t::ADMIN, {.integer = 46}},
+    {"menu2/setting3", SettingsStorage::STRING, SettingPermissions_t::USER, {.string = "string3"}},
+    {"menu2/setting4", SettingsStorage::STRING, SettingPermissions_t::USER, {.string = LONG_DEFAULT_STRING}},
+    {"menu2/setting5", SettingsStorage::STRING, SettingPermissions_t::USER, {.string = nullptr}},
+    {"", SettingsStorage::INTEGER, SettingPermissions_t::USER, {.integer = 1}},
+};
+
+TEST(SettingsStorage, RegisterSettingsFromDescriptors)
+{
+    SettingsStorage                 settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingError_t result;
+    SettingsStorage::SettingError_t results[std::size(SETTING_DESCRIPTORS)];
+    double                          outputReal;
+    int64_t                         outputInt;
+    char                            outputString[128];
+
+    // When
+    result = settingsStorage.registerSettings(SETTING_DESCRIPTORS, results);
+
+    // Then
+    EXPECT_EQ(SettingsStorage::KEY_EXISTS_ERROR, result);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, results[0]);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, results[1]);
+    EXPECT_EQ(SettingsStorage::KEY_EXISTS_ERROR, results[2]);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, results[3]);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, results[4]);
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, results[5]);
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, results[6]);
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsReal("menu1/setting1", outputReal));
+    EXPECT_EQ(1.23, outputReal);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu1/setting2", outputInt));
+    EXPECT_EQ(45, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingAsString("menu2/setting3", outputString, sizeof(outputString)));
+    EXPECT_STREQ("string3", outputString);
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingAsString("menu2/setting4", outputString, sizeof(outputString)));
+    EXPECT_STREQ(LONG_DEFAULT_STRING, outputString);
+
+    // When: the long string setting is updated and restored
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString("menu2/setting4", "string4"));
+    result = settingsStorage.restoreDefaultSettings("menu2/");
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingAsString("menu2/setting4", outputString, sizeof(outputString)));
+    EXPECT_STREQ(LONG_DEFAULT_STRING, outputString);
+
+    // When / Then: the descriptors can be registered in a non empty storage, but not in a frozen one
+    const SettingsStorage::SettingDescriptor_t moreDescriptors[] = {
+        {"menu3/setting6", SettingsStorage::INTEGER, SettingPermissions_t::USER, {.integer = 6}},
+        {"menu0/setting7", SettingsStorage::INTEGER, SettingPermissions_t::USER, {.integer = 7}},
+    };
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettings(moreDescriptors));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu0/setting7", outputInt));
+    EXPECT_EQ(7, outputInt);
+
+    // When / Then: registering settings that all exist already does not advance the store generation
+    const uint64_t generation = settingsStorage.getGeneration();
+    EXPECT_EQ(SettingsStorage::KEY_EXISTS_ERROR, settingsStorage.registerSettings(moreDescriptors));
+    EXPECT_EQ(generation, settingsStorage.getGeneration());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.freeze());
+    EXPECT_EQ(SettingsStorage::SETTINGS_FROZEN_ERROR, settingsStorage.registerSettings(moreDescriptors));
+}
+
+TEST(SettingsStorage, LeaseSettingAsString)
+{
+    SettingsStorage                     settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingHandle_t    handle = {};
+    SettingsStorage::SettingStringLease shortLease, longLease;
+    SettingPermissions_t                outputPermissions;
+    const std::string                   longString(100, 'l');
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("menu/short", SettingPermissions_t::USER, "short"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("menu/long", SettingPermissions_t::ADMIN, longString.c_str()));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("menu/int", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.resolveSetting("menu/long", SettingsStorage::STRING, handle));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.leaseSettingAsString("menu/short", shortLease));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.leaseSettingAsString(handle, longLease, &outputPermissions));
+
+    // Then
+    EXPECT_EQ("short", shortLease.view());
+    EXPECT_EQ(longString, longLease.view());
+    EXPECT_EQ(SettingPermissions_t::ADMIN, outputPermissions);
+
+    // When: the settings are updated while leased
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString("menu/short", "updated"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString(handle, "updated"));
+
+    // Then: the leases keep the values they were taken with
+    EXPECT_EQ("short", shortLease.view());
+    EXPECT_EQ(longString, longLease.view());
+
+    // When: a lease is moved and reused
+    SettingsStorage::SettingStringLease movedLease(std::move(longLease));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.leaseSettingAsString(handle, longLease));
+
+    // Then
+    EXPECT_EQ(longString, movedLease.view());
+    EXPECT_EQ("updated", longLease.view());
+    movedLease.release();
+    EXPECT_TRUE(movedLease.view().empty());
+
+    // When / Then: the errors are those of getSettingAsString()
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage.leaseSettingAsString(nullptr, shortLease));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage.leaseSettingAsString("", shortLease));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage.leaseSettingAsString("menu/none", shortLease));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, settingsStorage.leaseSettingAsString("menu/int", shortLease));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.leaseSettingAsString(SettingsStorage::SettingHandle_t{}, shortLease));
+    EXPECT_EQ("short", shortLease.view());
+}
+
+TEST(SettingsStorage, LeasesAndPutsOfStringsRunConcurrently)
+{
+    SettingsStorage                  settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingHandle_t handle = {};
+    std::atomic<bool>                stop{false};
+    std::atomic<uint32_t>            tornReads{0};
+    const std::string                strings[] = {std::string(64, 'a'), std::string(200, 'b'), "c"};
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("menu/string", SettingPermissions_t::USER, strings[0].c_str()));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("menu/string", SettingsStorage::STRING, handle));
+
+    // When: a writer replaces the string while readers lease and copy it
+    std::thread writer(
+        [&]
+        {
+            for (int i = 0; i < 50000; i++)
+            {
+                EXPECT_EQ(SettingsStorage::NO_ERROR,
+                          settingsStorage.putSettingValueAsString(handle, strings[i % 3].c_str()));
+            }
+            stop = true;
+        });
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back(
+            [&]
+            {
+                SettingsStorage::SettingStringLease lease;
+                char                                outputString[256];
+                while (!stop)
+                {
+                    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.leaseSettingAsString(handle, lease));
+                    const std::string_view leased = lease.view();
+                    EXPECT_EQ(SettingsStorage::NO_ERROR,
+                              settingsStorage.getSettingAsString(handle, outputString, sizeof(outputString)));
+                    if ((leased != strings[0] && leased != strings[1] && leased != strings[2]) ||
+                        (outputString != strings[0] && outputString != strings[1] && outputString != strings[2]))
+                    {
+                        tornReads++;
+                    }
+                }
+            });
+    }
+    writer.join();
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    // Then
+    EXPECT_EQ(0u, tornReads.load());
+}
+
+TEST(SettingsStorage, ForEachSetting)
+{
+    SettingsStorage          settingsStorage(linuxOSInterface);
+    std::vector<std::string> keys;
+    int64_t                  sum = 0;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("menu/b", SettingPermissions_t::ADMIN, 2));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettingAsInt("menu/a", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("menu/c", SettingPermissions_t::USER, "c"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("other/d", SettingPermissions_t::USER, 4));
+
+    // When
+    SettingsStorage::SettingError_t result = settingsStorage.forEachSetting(
+        "menu/",
+        [&](const std::string_view key, const SettingsStorage::SettingHandle_t& handle)
+        {
+            int64_t value;
+            keys.emplace_back(key);
+            if (handle.settingValueType == SettingsStorage::INTEGER &&
+                settingsStorage.getSettingAsInt(handle, value) == SettingsStorage::NO_ERROR)
+            {
+                sum += value;
+            }
+            return true;
+        });
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ((std::vector<std::string>{"menu/a", "menu/b", "menu/c"}), keys);
+    EXPECT_EQ(3, sum);
+
+    // When: the settings are filtered by permissions and the visitor stops early
+    keys.clear();
+    result = settingsStorage.forEachSetting(
+        "",
+        [&](const std::string_view key, const SettingsStorage::SettingHandle_t&)
+        {
+            keys.emplace_back(key);
+            return keys.size() < 2;
+        },
+        SettingPermissions_t::ADMIN, ExcludeSettingsWithAnyPermissionsListed);
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    EXPECT_EQ((std::vector<std::string>{"menu/a", "menu/c"}), keys);
+
+    // When / Then
+    const auto visitAll = [](std::string_view, const SettingsStorage::SettingHandle_t&) { return true; };
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage.forEachSetting(nullptr, visitAll));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.forEachSetting("", visitAll, static_cast<SettingPermissions_t>(0xFF)));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.forEachSetting("", visitAll, SettingPermissions_t::USER,
+                                             static_cast<SettingPermissionsFilterMode_t>(-1)));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.forEachSetting("none/", visitAll));
+}
+
+TEST(SettingsStorage, IterationsReportLockTimeouts)
+{
+    if (CONFIG_SETTINGS_STORAGE_CONCURRENT_WRITES || CONFIG_SETTINGS_STORAGE_LOCK_FREE_READS ||
+        CONFIG_SETTINGS_STORAGE_BIG_READER_LOCK)
+    {
+        GTEST_SKIP() << "The settings readers do not wait for the writers in this configuration";
+    }
+
+    HoldableOSInterface                    osInterface;
+    SettingsStorage                        settingsStorage(osInterface);
+    SettingsStorage::SettingsKeysList_t    keys;
+    SettingsStorage::SettingChildrenList_t children;
+    int64_t                                outputInt;
+    SettingsStorage::SettingBatchGet_t     get = {"menu/a", SettingsStorage::INTEGER, {.integer = &outputInt}, 0,
+                                                  nullptr, {}};
+    const SettingsStorage::SettingDescriptor_t descriptor = {"menu/b", SettingsStorage::INTEGER,
+                                                             SettingPermissions_t::USER, {.integer = 1}};
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettingAsInt("menu/a", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("menu/a", 2));
+
+    // When: the settings tree is held by a writer
+    osInterface.hold();
+
+    // Then
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR,
+              settingsStorage.listSettingsKeys("", ALL_PERMISSIONS, MatchSettingsWithAnyPermissionsListed, keys));
+    EXPECT_TRUE(keys.empty());
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.listChildren("menu/", children));
+    EXPECT_TRUE(children.empty());
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.restoreDefaultSettings("menu/"));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.getSettingsBatch(&get, 1));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR,
+              settingsStorage.registerSettingAsInt("menu/b", SettingPermissions_t::USER, 1));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR,
+              settingsStorage.registerSettingAsString("menu/c", SettingPermissions_t::USER, "a long string value"));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.registerSettings({&descriptor, 1}));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.freeze());
+    EXPECT_FALSE(settingsStorage.isFrozen());
+
+    // When
+    osInterface.release();
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu/a", outputInt));
+    EXPECT_EQ(2, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.restoreDefaultSettings("menu/"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu/a", outputInt));
+    EXPECT_EQ(1, outputInt);
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage.getSettingAsInt("menu/b", outputInt));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettingAsInt("menu/b", SettingPermissions_t::USER, 1));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.freeze());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("menu/b", outputInt));
+}
+
+TEST(SettingsStorage, ValueWritesReportLockTimeouts)
+{
+    HoldableOSInterface                 osInterface;
+    SettingsStorage                     settingsStorage(osInterface);
+    SettingsStorage::SettingHandle_t    handle      = {};
+    SettingsStorage::SettingHandle_t    countHandle = {};
+    SettingsStorage::SettingHandle_t    ratioHandle = {};
+    SettingsStorage::SettingStringLease lease;
+    SettingsTransaction                 transaction(settingsStorage);
+    int64_t                             outputInt;
+    double                              outputReal;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("menu/name", SettingPermissions_t::USER, "first"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("menu/count", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("menu/ratio", SettingPermissions_t::USER, 1.5));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.resolveSetting("menu/name", SettingsStorage::STRING, handle));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("menu/count", SettingsStorage::INTEGER, countHandle));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("menu/ratio", SettingsStorage::REAL, ratioHandle));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsString("menu/name", "third"));
+
+    // When: the values are held by another writer
+    osInterface.holdMutexes();
+
+    // Then: the writes give up, while the reads go on
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.putSettingValueAsString(handle, "second"));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.putSettingValueAsInt(countHandle, 2));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.putSettingValueAsReal(ratioHandle, 2.5));
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, transaction.commit());
+    EXPECT_EQ(0u, transaction.size());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.leaseSettingAsString(handle, lease));
+    EXPECT_EQ("first", lease.view());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt(countHandle, outputInt));
+    EXPECT_EQ(1, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsReal(ratioHandle, outputReal));
+    EXPECT_EQ(1.5, outputReal);
+
+    // When
+    osInterface.releaseMutexes();
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString(handle, "second"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.leaseSettingAsString(handle, lease));
+    EXPECT_EQ("second", lease.view());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt(countHandle, 2));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt(countHandle, outputInt));
+    EXPECT_EQ(2, outputInt);
+}
+
+TEST(SettingsStorage, StoreKeepsTheFileWhenTheSettingsCannotBeRead)
+{
+    if (CONFIG_SETTINGS_STORAGE_CONCURRENT_WRITES || CONFIG_SETTINGS_STORAGE_LOCK_FREE_READS ||
+        CONFIG_SETTINGS_STORAGE_BIG_READER_LOCK)
+    {
+        GTEST_SKIP() << "The settings readers do not wait for the writers in this configuration";
+    }
+
+    constexpr char      storedSettings[] = "menu/a\t1\t1\n\r1874197929\n";
+    SettingsFileMock    settingsFileMock(storedSettings, sizeof(storedSettings) + 100);
+    HoldableOSInterface osInterface;
+    SettingsStorage     settingsStorage(osInterface, &settingsFileMock);
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettingAsInt("menu/a", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("menu/a", 2));
+
+    // When: the settings tree is held by a writer
+    osInterface.hold();
+    const SettingsStorage::SettingError_t result = settingsStorage.storeSettingsInPersistentStorage();
+    osInterface.release();
+
+    // Then: the stored settings are left untouched, and the file is not left open
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, result);
+    EXPECT_STREQ(storedSettings, settingsFileMock._getInternalBuffer());
+    EXPECT_EQ(SettingsFile::FileClosed, settingsFileMock.getOpenStatus());
+
+    // Then: the settings are still unsaved, and can be stored once the tree is released
+    EXPECT_TRUE(settingsStorage.hasUnsavedChanges());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.storeSettingsInPersistentStorage());
+    EXPECT_STRNE(storedSettings, settingsFileMock._getInternalBuffer());
+    EXPECT_FALSE(settingsStorage.hasUnsavedChanges());
+}
+
+TEST(SettingsStorage, ListChildren)
+{
+    SettingsStorage                        settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingChildrenList_t children;
+
+    for (const char* key : {"menu1/b", "menu1/a", "menu1/sub/x", "menu1/sub/y/z", "menu1/sub", "menu10/c", "other"})
+    {
+        ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettingAsInt(key, SettingPermissions_t::USER, 1));
+    }
+
+    // When
+    SettingsStorage::SettingError_t result = settingsStorage.listChildren("menu1/", children);
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    std::vector<std::pair<std::string, bool>> listed;
+    for (const SettingsStorage::SettingChild_t& child : children)
+    {
+        listed.emplace_back(child.name, child.isDirectory);
+    }
+    EXPECT_EQ((std::vector<std::pair<std::string, bool>>{{"a", false}, {"b", false}, {"sub", false}, {"sub", true}}),
+              listed);
+
+    // When
+    children.clear();
+    result = settingsStorage.listChildren("", children);
+
+    // Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, result);
+    listed.clear();
+    for (const SettingsStorage::SettingChild_t& child : children)
+    {
+        listed.emplace_back(child.name, child.isDirectory);
+    }
+    EXPECT_EQ((std::vector<std::pair<std::string, bool>>{{"menu1", true}, {"menu10", true}, {"other", false}}),
+              listed);
+
+    // When / Then
+    children.clear();
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.listChildren("none/", children));
+    EXPECT_TRUE(children.empty());
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage.listChildren(nullptr, children));
+}
+
+/// Changes received by a subscriber, one list of keys per callback.
+struct ChangeRecorder
+{
+    std::mutex                            mutex;
+    std::vector<std::vector<std::string>> calls;
+};
+
+static void recordChangesCallback(void* userData, const char* const* keys, const size_t count)
+{
+    auto*                 recorder = static_cast<ChangeRecorder*>(userData);
+    const std::lock_guard lock(recorder->mutex);
+    recorder->calls.emplace_back(keys, keys + count);
+}
+
+TEST(SettingsStorage, SubscribeCoalescesChangesPerKey)
+{
+    SettingsStorage settingsStorage(linuxOSInterface);
+    ChangeRecorder  netRecorder;
+    ChangeRecorder  allRecorder;
+    uint32_t        netSubscription;
+    uint32_t        allSubscription;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, "host"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/kp", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.subscribe("net/", recordChangesCallback, &netRecorder, netSubscription));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.subscribe("", recordChangesCallback, &allRecorder, allSubscription));
+
+    // When: a burst of puts
+    for (int64_t i = 0; i < 20; i++)
+    {
+        EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", i));
+    }
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsString("net/host", "other"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsReal("pid/kp", 2));
+    ASSERT_TRUE(settingsStorage.dispatchChangeNotifications(1000));
+
+    // Then
+    using Calls = std::vector<std::vector<std::string>>;
+    EXPECT_EQ((Calls{{"net/host", "net/port"}}), netRecorder.calls);
+    EXPECT_EQ((Calls{{"net/host", "net/port", "pid/kp"}}), allRecorder.calls);
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.unsubscribe(allSubscription));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.restoreDefaultSettings("pid/"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.restoreDefaultSettings("net/"));
+    ASSERT_TRUE(settingsStorage.dispatchChangeNotifications(1000));
+
+    // Then
+    EXPECT_EQ((Calls{{"net/host", "net/port"}, {"net/host", "net/port"}}), netRecorder.calls);
+    EXPECT_EQ(1u, allRecorder.calls.size());
+    EXPECT_FALSE(settingsStorage.dispatchChangeNotifications(0));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, settingsStorage.unsubscribe(allSubscription));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.subscribe(nullptr, recordChangesCallback, &allRecorder, allSubscription));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.subscribe("net/", nullptr, &allRecorder, allSubscription));
+}
+
+TEST(SettingsStorage, SubscribeIsNotifiedOfHandlePutsAndLateSettings)
+{
+    SettingsStorage                  settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingHandle_t handle = {};
+    ChangeRecorder                   recorder;
+    uint32_t                         subscription;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.subscribe("pid/k", recordChangesCallback, &recorder, subscription));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/kp", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/ti", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.resolveSetting("pid/kp", SettingsStorage::REAL, handle));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsReal(handle, 3));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsReal("pid/ti", 3));
+    ASSERT_TRUE(settingsStorage.dispatchChangeNotifications(1000));
+
+    // Then
+    ASSERT_EQ(1u, recorder.calls.size());
+    EXPECT_EQ(std::vector<std::string>{"pid/kp"}, recorder.calls[0]);
+}
+
+TEST(SettingsStorage, DispatchWithoutTimeoutDoesNotWaitForTheCoalescingDelay)
+{
+    if (CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS == 0)
+    {
+        GTEST_SKIP() << "The changes are not coalesced";
+    }
+    SettingsStorage settingsStorage(linuxOSInterface);
+    ChangeRecorder  recorder;
+    uint32_t        subscription;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.subscribe("net/", recordChangesCallback, &recorder, subscription));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", 2));
+
+    // When
+    const auto start     = std::chrono::steady_clock::now();
+    const bool delivered = settingsStorage.dispatchChangeNotifications(0);
+    const auto elapsed   = std::chrono::steady_clock::now() - start;
+
+    // Then
+    EXPECT_TRUE(delivered);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(CONFIG_SETTINGS_STORAGE_CHANGE_COALESCING_MS));
+    ASSERT_EQ(1u, recorder.calls.size());
+    EXPECT_EQ(std::vector<std::string>{"net/port"}, recorder.calls[0]);
+}
+
+TEST(SettingsStorage, SubscribeReportsLockTimeouts)
+{
+    HoldableOSInterface osInterface;
+    SettingsStorage     settingsStorage(osInterface);
+    ChangeRecorder      recorder;
+    uint32_t            subscription;
+    uint32_t            otherSubscription = 0;
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 1));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.subscribe("net/", recordChangesCallback, &recorder, subscription));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", 2));
+
+    // When: the dispatcher is held by another task
+    osInterface.holdMutexes();
+
+    // Then: nothing is changed, and the change stays queued
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR,
+              settingsStorage.subscribe("net/", recordChangesCallback, &recorder, otherSubscription));
+    EXPECT_EQ(0u, otherSubscription);
+    EXPECT_EQ(SettingsStorage::LOCK_TIMEOUT_ERROR, settingsStorage.unsubscribe(subscription));
+    EXPECT_FALSE(settingsStorage.dispatchChangeNotifications(1000));
+    EXPECT_TRUE(recorder.calls.empty());
+
+    // When
+    osInterface.releaseMutexes();
+
+    // Then
+    ASSERT_TRUE(settingsStorage.dispatchChangeNotifications(0));
+    ASSERT_EQ(1u, recorder.calls.size());
+    EXPECT_EQ(std::vector<std::string>{"net/port"}, recorder.calls[0]);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.unsubscribe(subscription));
+}
+
+TEST(SettingsStorage, GenerationsFollowEveryWrite)
+{
+    SettingsStorage                  settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingHandle_t    portHandle = {};
+    SettingsStorage::SettingHandle_t    hostHandle = {};
+    SettingsStorage::SettingStringLease lease;
+    int64_t                             port;
+    uint64_t                            portGeneration;
+    uint64_t                            hostGeneration;
+    uint64_t                            generation;
+
+    EXPECT_EQ(0u, settingsStorage.getGeneration());
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 80));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, "localhost"));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("net/port", SettingsStorage::INTEGER, portHandle));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.resolveSetting("net/host", SettingsStorage::STRING, hostHandle));
+    const uint64_t registeredGeneration = settingsStorage.getGeneration();
+    EXPECT_EQ(2u, registeredGeneration);
+    EXPECT_EQ(SettingsStorage::KEY_EXISTS_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 8080));
+    EXPECT_EQ(registeredGeneration, settingsStorage.getGeneration());
+
+    // When
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingWithGenerationAsInt(portHandle, port, portGeneration));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.leaseSettingWithGenerationAsString(hostHandle, lease, hostGeneration));
+
+    // Then
+    EXPECT_EQ(80, port);
+    EXPECT_EQ(1u, portGeneration);
+    EXPECT_EQ("localhost", lease.view());
+    EXPECT_EQ(2u, hostGeneration);
+
+    // When: only the port is written
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", 8080));
+
+    // Then
+    EXPECT_EQ(registeredGeneration + 1, settingsStorage.getGeneration());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingGeneration(portHandle, generation));
+    EXPECT_EQ(settingsStorage.getGeneration(), generation);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingGeneration(hostHandle, generation));
+    EXPECT_EQ(hostGeneration, generation);
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.restoreDefaultSettings("net/"));
+
+    // Then
+    EXPECT_EQ(registeredGeneration + 3, settingsStorage.getGeneration());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingGeneration(hostHandle, generation));
+    EXPECT_LT(hostGeneration, generation);
+}
+
+TEST(SettingsStorage, GenerationsByKey)
+{
+    SettingsStorage                            settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingStringLease        lease;
+    int64_t                                    port;
+    double                                     ratio;
+    uint64_t                                   portGeneration;
+    uint64_t                                   ratioGeneration;
+    uint64_t                                   hostGeneration;
+    const SettingsStorage::SettingDescriptor_t descriptors[] = {
+        {"net/port", SettingsStorage::INTEGER, SettingPermissions_t::USER, {.integer = 80}},
+        {"net/ratio", SettingsStorage::REAL, SettingPermissions_t::USER, {.real = 0.5}},
+    };
+
+    // The sorted descriptors build the whole tree at once.
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.registerSettings(descriptors));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, "localhost"));
+
+    // When
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingWithGenerationAsInt("net/port", port, portGeneration));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingWithGenerationAsReal("net/ratio", ratio, ratioGeneration));
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.leaseSettingWithGenerationAsString("net/host", lease, hostGeneration));
+
+    // Then: the settings registered together share the generation of their registration
+    EXPECT_EQ(80, port);
+    EXPECT_EQ(0.5, ratio);
+    EXPECT_EQ("localhost", lease.view());
+    EXPECT_EQ(1u, portGeneration);
+    EXPECT_EQ(1u, ratioGeneration);
+    EXPECT_EQ(2u, hostGeneration);
+    EXPECT_EQ(2u, settingsStorage.getGeneration());
+
+    // When / Then
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingWithGenerationAsInt("net/port", port, portGeneration));
+    EXPECT_EQ(8080, port);
+    EXPECT_EQ(3u, portGeneration);
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR,
+              settingsStorage.getSettingWithGenerationAsInt("net/none", port, portGeneration));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR,
+              settingsStorage.getSettingWithGenerationAsReal("net/port", ratio, ratioGeneration));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.leaseSettingWithGenerationAsString(nullptr, lease, hostGeneration));
+}
+
+TEST(SettingsStorage, GenerationsOfInvalidHandles)
+{
+    SettingsStorage                  settingsStorage(linuxOSInterface);
+    SettingsStorage::SettingHandle_t handle = {};
+    double                           value;
+    uint64_t                         generation;
+
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, settingsStorage.getSettingGeneration(handle, generation));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR,
+              settingsStorage.getSettingWithGenerationAsReal(handle, value, generation));
+
+    ASSERT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 80));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.resolveSetting("net/port", SettingsStorage::INTEGER, handle));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR,
+              settingsStorage.getSettingWithGenerationAsReal(handle, value, generation));
+}
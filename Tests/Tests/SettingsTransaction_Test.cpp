@@ -0,0 +1,222 @@
+#include "SettingsTransaction.h"
+#include "LinuxOSInterface.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+static LinuxOSInterface transactionOSInterface;
+
+TEST(SettingsTransaction, CommitAppliesAllPuts)
+{
+    SettingsStorage     settingsStorage(transactionOSInterface);
+    SettingsTransaction transaction(settingsStorage);
+    double              outputReal;
+    int64_t             outputInt;
+    char                outputString[64];
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/kp", SettingPermissions_t::USER, 1.0));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 80));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, "localhost"));
+    EXPECT_FALSE(settingsStorage.hasUnsavedChanges());
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsReal("pid/kp", 2.5));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              transaction.putSettingValueAsString("net/host", "a host name that does not fit in the setting"));
+    EXPECT_EQ(3u, transaction.size());
+
+    // Then: nothing is applied before the commit
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("net/port", outputInt));
+    EXPECT_EQ(80, outputInt);
+    EXPECT_FALSE(settingsStorage.hasUnsavedChanges());
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+
+    // Then
+    EXPECT_EQ(0u, transaction.size());
+    EXPECT_TRUE(settingsStorage.hasUnsavedChanges());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsReal("pid/kp", outputReal));
+    EXPECT_EQ(2.5, outputReal);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("net/port", outputInt));
+    EXPECT_EQ(8080, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingAsString("net/host", outputString, sizeof(outputString)));
+    EXPECT_STREQ("a host name that does not fit in the setting", outputString);
+
+    // When / Then: the transaction can be reused
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsString("net/host", "host"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingAsString("net/host", outputString, sizeof(outputString)));
+    EXPECT_STREQ("host", outputString);
+}
+
+TEST(SettingsTransaction, FailedPutDiscardsTheWholeTransaction)
+{
+    SettingsStorage     settingsStorage(transactionOSInterface);
+    SettingsTransaction transaction(settingsStorage);
+    int64_t             outputInt;
+    char                outputString[64];
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 80));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, "localhost"));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              transaction.putSettingValueAsString("net/host", "a host name that does not fit in the setting"));
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, transaction.putSettingValueAsReal("net/port", 1.0));
+    EXPECT_EQ(SettingsStorage::KEY_NOT_FOUND_ERROR, transaction.putSettingValueAsInt("net/mask", 24));
+    EXPECT_EQ(SettingsStorage::INVALID_INPUT_ERROR, transaction.putSettingValueAsString("net/host", nullptr));
+
+    // Then: the first error is returned, and nothing is applied
+    EXPECT_EQ(SettingsStorage::TYPE_MISMATCH_ERROR, transaction.commit());
+    EXPECT_EQ(0u, transaction.size());
+    EXPECT_FALSE(settingsStorage.hasUnsavedChanges());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingAsInt("net/port", outputInt));
+    EXPECT_EQ(80, outputInt);
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.getSettingAsString("net/host", outputString, sizeof(outputString)));
+    EXPECT_STREQ("localhost", outputString);
+
+    // When / Then: the error is not kept after the commit
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+}
+
+TEST(SettingsTransaction, VolatileSettingsAreNotUnsavedChanges)
+{
+    SettingsStorage     settingsStorage(transactionOSInterface);
+    SettingsTransaction transaction(settingsStorage);
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::VOLATILE, 80));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.putSettingValueAsInt("net/port", 8081));
+
+    // Then
+    EXPECT_FALSE(settingsStorage.hasUnsavedChanges());
+}
+
+TEST(SettingsTransaction, BatchGetsNeverSeeHalfCommittedTransactions)
+{
+    SettingsStorage   settingsStorage(transactionOSInterface);
+    std::atomic<bool> stop       = false;
+    uint32_t          tornReads  = 0;
+    constexpr int     ITERATIONS = 20000;
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 0));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsReal("pid/kp", SettingPermissions_t::USER, 0));
+
+    std::thread writer(
+        [&settingsStorage, &stop]()
+        {
+            SettingsTransaction transaction(settingsStorage);
+            for (int i = 1; i <= ITERATIONS; i++)
+            {
+                EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", i));
+                EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsReal("pid/kp", i));
+                EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+            }
+            stop = true;
+        });
+
+    int64_t                            outputInt;
+    double                             outputReal;
+    SettingsStorage::SettingBatchGet_t gets[] = {
+        {"net/port", SettingsStorage::INTEGER, {.integer = &outputInt}, 0, nullptr, {}},
+        {"pid/kp", SettingsStorage::REAL, {.real = &outputReal}, 0, nullptr, {}},
+    };
+    while (!stop)
+    {
+        EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingsBatch(gets, 2));
+        if (static_cast<double>(outputInt) != outputReal)
+        {
+            tornReads++;
+        }
+    }
+    writer.join();
+
+    // Then
+    EXPECT_EQ(0u, tornReads);
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingsBatch(gets, 2));
+    EXPECT_EQ(ITERATIONS, outputInt);
+    EXPECT_EQ(ITERATIONS, outputReal);
+}
+
+TEST(SettingsTransaction, CommitNotifiesSubscribersOnce)
+{
+    SettingsStorage     settingsStorage(transactionOSInterface);
+    SettingsTransaction transaction(settingsStorage);
+    std::atomic<size_t> calls{0};
+    std::atomic<size_t> keys{0};
+    uint32_t            subscription;
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 80));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsString("net/host", SettingPermissions_t::USER, "localhost"));
+    std::pair<std::atomic<size_t>*, std::atomic<size_t>*> counters = {&calls, &keys};
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.subscribe(
+                                             "net/",
+                                             [](void* userData, const char* const*, const size_t count)
+                                             {
+                                                 auto* counted = static_cast<decltype(counters)*>(userData);
+                                                 counted->first->fetch_add(1);
+                                                 counted->second->fetch_add(count);
+                                             },
+                                             &counters, subscription));
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsString("net/host", "example"));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+    ASSERT_TRUE(settingsStorage.dispatchChangeNotifications(1000));
+
+    // Then
+    EXPECT_EQ(1u, calls.load());
+    EXPECT_EQ(2u, keys.load());
+}
+
+TEST(SettingsTransaction, CommitAdvancesTheGenerations)
+{
+    SettingsStorage                  settingsStorage(transactionOSInterface);
+    SettingsTransaction              transaction(settingsStorage);
+    SettingsStorage::SettingHandle_t handle = {};
+    uint64_t                         generation;
+
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/port", SettingPermissions_t::USER, 80));
+    EXPECT_EQ(SettingsStorage::NO_ERROR,
+              settingsStorage.registerSettingAsInt("net/timeout", SettingPermissions_t::USER, 5));
+    ASSERT_EQ(SettingsStorage::NO_ERROR, settingsStorage.resolveSetting("net/port", SettingsStorage::INTEGER, handle));
+    const uint64_t registeredGeneration = settingsStorage.getGeneration();
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/port", 8080));
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.putSettingValueAsInt("net/timeout", 10));
+
+    // Then: nothing changes before the commit
+    EXPECT_EQ(registeredGeneration, settingsStorage.getGeneration());
+
+    // When
+    EXPECT_EQ(SettingsStorage::NO_ERROR, transaction.commit());
+
+    // Then
+    EXPECT_EQ(registeredGeneration + 2, settingsStorage.getGeneration());
+    EXPECT_EQ(SettingsStorage::NO_ERROR, settingsStorage.getSettingGeneration(handle, generation));
+    EXPECT_LT(registeredGeneration, generation);
+}
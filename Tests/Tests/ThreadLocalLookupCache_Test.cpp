@@ -0,0 +1,101 @@
+#include "ThreadLocalLookupCache.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+typedef ThreadLocalLookupCache<int, 16, 8> TestCache_t;
+
+TEST(ThreadLocalLookupCache, HitsStoredKeysUntilInvalidated)
+{
+    TestCache_t cache;
+    int         value = 1;
+    uint64_t    generation;
+
+    // When
+    EXPECT_EQ(nullptr, cache.lookup("menu/setting", 12, generation));
+    cache.store("menu/setting", 12, &value, generation);
+
+    // Then
+    EXPECT_EQ(&value, cache.lookup("menu/setting", 12, generation));
+
+    // When
+    cache.invalidate();
+
+    // Then
+    EXPECT_EQ(nullptr, cache.lookup("menu/setting", 12, generation));
+}
+
+TEST(ThreadLocalLookupCache, ComparesTheKeys)
+{
+    TestCache_t cache;
+    int         value = 1;
+    uint64_t    generation;
+    char        key[]     = "menu/setting1";
+    const char* longKey   = "menu/a/setting/longer/than/the/cached/keys";
+    const auto  longLen   = static_cast<uint32_t>(strlen(longKey));
+    const auto  keyLength = static_cast<uint32_t>(strlen(key));
+
+    EXPECT_EQ(nullptr, cache.lookup(key, keyLength, generation));
+    cache.store(key, keyLength, &value, generation);
+
+    // When: the key buffer is reused for another key
+    key[keyLength - 1] = '2';
+
+    // Then
+    EXPECT_EQ(nullptr, cache.lookup(key, keyLength, generation));
+    EXPECT_EQ(nullptr, cache.lookup(key, keyLength - 1, generation));
+
+    // When
+    cache.store(longKey, longLen, &value, generation);
+
+    // Then
+    EXPECT_EQ(nullptr, cache.lookup(longKey, longLen, generation));
+}
+
+TEST(ThreadLocalLookupCache, EntriesArePrivateToTheCacheAndTheThread)
+{
+    TestCache_t firstCache;
+    TestCache_t secondCache;
+    int         value = 1;
+    uint64_t    generation;
+
+    EXPECT_EQ(nullptr, firstCache.lookup("menu/setting", 12, generation));
+    firstCache.store("menu/setting", 12, &value, generation);
+
+    // Then
+    EXPECT_EQ(nullptr, secondCache.lookup("menu/setting", 12, generation));
+    int* otherThreadValue = &value;
+    std::thread([&firstCache, &otherThreadValue] {
+        uint64_t otherGeneration;
+        otherThreadValue = firstCache.lookup("menu/setting", 12, otherGeneration);
+    }).join();
+    EXPECT_EQ(nullptr, otherThreadValue);
+    EXPECT_EQ(&value, firstCache.lookup("menu/setting", 12, generation));
+}
+
+TEST(ThreadLocalLookupCache, ValuesLookedUpBeforeAnInvalidationMiss)
+{
+    TestCache_t cache;
+    int         value = 1;
+    uint64_t    generation;
+
+    // When: the cache is invalidated while the key is looked up in the map
+    EXPECT_EQ(nullptr, cache.lookup("menu/setting", 12, generation));
+    cache.invalidate();
+    cache.store("menu/setting", 12, &value, generation);
+
+    // Then
+    EXPECT_EQ(nullptr, cache.lookup("menu/setting", 12, generation));
+}
+
+TEST(ThreadLocalLookupCache, DisabledCacheNeverHits)
+{
+    ThreadLocalLookupCache<int, 16, 0> cache;
+    int                                value = 1;
+    uint64_t                           generation;
+
+    EXPECT_FALSE(cache.ENABLED);
+    EXPECT_EQ(nullptr, cache.lookup("menu/setting", 12, generation));
+    cache.store("menu/setting", 12, &value, generation);
+    EXPECT_EQ(nullptr, cache.lookup("menu/setting", 12, generation));
+}